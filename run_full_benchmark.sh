@@ -11,9 +11,12 @@ echo "[1/4] Compiling DPU program with tasklets..."
 /opt/upmem-sdk-2025.1.0/bin/dpu-clang \
     -I/opt/upmem-sdk-2025.1.0/include \
     -I/opt/upmem-sdk-2025.1.0/include/dpu \
+    -I src/common \
     -O2 -D__DPU__ \
     -o build/dpu_tasklets \
-    src/dpu/swap_tasklets.c
+    src/dpu/swap_tasklets.c src/dpu/codec_kernel.c src/dpu/delta_kernel.c \
+    src/dpu/compact_kernel.c src/dpu/xfer_kernel.c src/dpu/scan_kernel.c \
+    src/common/page_codec.c src/common/page_scan.c
 echo "✓ DPU compiled"
 echo ""
 
@@ -0,0 +1,33 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Record the page accesses of a running process with perf mem and convert
+# them to a page trace for trace_replay
+# Usage: sudo ./scripts/capture_trace.sh <pid> [seconds] [out.trace]
+#
+# Needs perf with memory sampling (Intel PEBS, AMD IBS or Arm SPE). The raw
+# perf data stays next to the trace as <out>.perf.data.
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+BIN="$ROOT_DIR/build/trace_capture"
+PID=${1:-}
+SECONDS_RUN=${2:-10}
+OUT=${3:-trace_$PID.trace}
+
+if [ -z "$PID" ] || ! kill -0 "$PID" 2>/dev/null; then
+  echo "Usage: $0 <pid> [seconds] [out.trace]"
+  exit 2
+fi
+if [ ! -x "$BIN" ]; then
+  echo "Error: $BIN not found, run 'make trace_tools' first"
+  exit 2
+fi
+if ! command -v perf >/dev/null; then
+  echo "Error: perf not found"
+  exit 2
+fi
+
+echo "Sampling loads and stores of PID $PID for ${SECONDS_RUN}s..."
+perf mem record -o "$OUT.perf.data" -p "$PID" -- sleep "$SECONDS_RUN"
+perf script -i "$OUT.perf.data" -F time,event,addr | "$BIN" - "$OUT"
+echo "Replay with: ./build/trace_replay $OUT"
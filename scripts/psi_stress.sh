@@ -0,0 +1,72 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# PSI eviction daemon vs kernel swap, same stress workload in a cgroup v2
+# Usage: sudo ./scripts/psi_stress.sh [wss_mb] [limit_mb] [seconds]
+#
+# kswap: memory.max = limit_mb, a swap file takes the overflow
+# dpu:   memory.swap.max = 0, the daemon keeps the working set under limit_mb
+#        and evicts to the page store. Without the SDK the store lives in
+#        host memory and is charged to the cgroup, so the cgroup gets
+#        wss_mb of extra room and the daemon is capped with max_resident.
+#
+# Both runs are appended to psi_stress_results.csv.
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+BIN="$ROOT_DIR/build/benchmark_psi"
+WSS_MB=${1:-256}
+LIMIT_MB=${2:-128}
+SECONDS_RUN=${3:-10}
+SWAPFILE=${SWAPFILE:-/var/tmp/upmem-psi.swap}
+
+if [ ! -x "$BIN" ]; then
+  echo "Error: $BIN not found, run 'make bench_psi' first"
+  exit 2
+fi
+if [ "$(id -u)" -ne 0 ]; then
+  echo "Error: needs root to create the cgroup and the swap file"
+  exit 2
+fi
+
+if [ -f /sys/fs/cgroup/cgroup.controllers ]; then
+  CG_ROOT=/sys/fs/cgroup
+else
+  CG_ROOT=/sys/fs/cgroup/unified
+fi
+if ! grep -qw memory "$CG_ROOT/cgroup.controllers" 2>/dev/null; then
+  echo "Error: no memory controller on the cgroup v2 hierarchy ($CG_ROOT)"
+  echo "Run './build/benchmark_psi dpu $WSS_MB $SECONDS_RUN $LIMIT_MB' for the daemon alone"
+  exit 3
+fi
+
+CG="$CG_ROOT/upmem-psi"
+echo +memory > "$CG_ROOT/cgroup.subtree_control"
+mkdir -p "$CG"
+
+cleanup() {
+  swapoff "$SWAPFILE" 2>/dev/null || true
+  rm -f "$SWAPFILE"
+  rmdir "$CG" 2>/dev/null || true
+}
+trap cleanup EXIT
+
+run_in_cgroup() {
+  bash -c 'echo $$ > "$0/cgroup.procs"; exec "$@"' "$CG" "$@"
+}
+
+echo "=== Kernel swap: $WSS_MB MB working set, memory.max $LIMIT_MB MB ==="
+dd if=/dev/zero of="$SWAPFILE" bs=1M count="$WSS_MB" status=none
+chmod 600 "$SWAPFILE"
+mkswap "$SWAPFILE" > /dev/null
+swapon "$SWAPFILE"
+echo max > "$CG/memory.swap.max"
+echo $((LIMIT_MB << 20)) > "$CG/memory.max"
+run_in_cgroup "$BIN" kswap "$WSS_MB" "$SECONDS_RUN"
+swapoff "$SWAPFILE"
+
+echo "=== PSI daemon: $WSS_MB MB working set, $LIMIT_MB MB resident ==="
+echo 0 > "$CG/memory.swap.max"
+echo $(((LIMIT_MB + WSS_MB) << 20)) > "$CG/memory.max"
+run_in_cgroup "$BIN" dpu "$WSS_MB" "$SECONDS_RUN" "$LIMIT_MB"
+
+exit 0
@@ -143,6 +143,37 @@ plt.tight_layout()
 plt.savefig('plots/06_speedup.png', dpi=300)
 plt.close()
 
+# 7. Saturation curve (benchmark_throughput, if it was run)
+if os.path.exists('throughput_results.csv'):
+    tp = pd.read_csv('throughput_results.csv')
+    tp['outstanding'] = tp['threads'] * tp['queue_depth']
+    fig, (ax1, ax2) = plt.subplots(1, 2, figsize=(15, 6))
+
+    for key, data in tp.groupby(['nr_dpus', 'size', 'distribution', 'read_ratio']):
+        label = f'{key[0]} DPUs {key[1]}B {key[2]} {key[3]:.0%} reads'
+        data = data.groupby('outstanding', as_index=False).max().sort_values('outstanding')
+        ax1.plot(data['outstanding'], data['ops_per_sec'], marker='o', label=label)
+        data = data.sort_values('ops_per_sec')
+        ax2.plot(data['ops_per_sec'], data['p99_us'], marker='o', label=label)
+
+    ax1.set_xscale('log', base=2)
+    ax1.set_xlabel('Outstanding ops (threads × queue depth)')
+    ax1.set_ylabel('Throughput (ops/s)')
+    ax1.set_title('Throughput vs Concurrency')
+    ax1.legend()
+    ax1.grid(True)
+
+    ax2.set_yscale('log')
+    ax2.set_xlabel('Throughput (ops/s)')
+    ax2.set_ylabel('p99 Latency (µs)')
+    ax2.set_title('Tail Latency vs Throughput')
+    ax2.legend()
+    ax2.grid(True)
+
+    plt.tight_layout()
+    plt.savefig('plots/07_saturation.png', dpi=300)
+    plt.close()
+
 print("✓ All plots generated in ./plots/")
 print("\nGenerated plots:")
 print("  01_latency_vs_size.png - Latency scaling with transfer size")
@@ -151,3 +182,5 @@ print("  03_throughput_scaling.png - Aggregate throughput")
 print("  04_heatmap_write.png - Latency heatmap")
 print("  05_tasklets_impact.png - Impact of tasklets")
 print("  06_speedup.png - Parallel speedup")
+if os.path.exists('throughput_results.csv'):
+    print("  07_saturation.png - Concurrent throughput saturation curve")
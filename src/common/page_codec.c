@@ -0,0 +1,180 @@
+/**
+ * UPMEM Swap - WRAM-friendly page codec
+ *
+ * Zero runs plus a small greedy LZ over 1KB blocks. Written for the DPU:
+ * no library calls, no 32-bit multiplies (the DPU only has 8x8 multiply
+ * instructions), 16-bit hash table entries. See page_codec.h.
+ */
+
+#include "page_codec.h"
+
+#define MIN_RUN 4
+#define MAX_RUN (0x3F + MIN_RUN)
+#define MAX_LITERALS 0x80
+#define NO_POSITION 0xFFFF
+
+static inline uint32_t hash3(const uint8_t* p) {
+    uint32_t v = p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v ^ (v >> 9) ^ (v >> 17)) & (CODEC_HASH_SIZE - 1);
+}
+
+/* Emit pending literals [start, end). Returns the new output size, or -1
+ * if they don't fit. */
+static int32_t flush_literals(const uint8_t* in, uint32_t start, uint32_t end,
+                              uint8_t* out, uint32_t op, uint32_t cap) {
+    uint32_t len = end - start;
+    if (len == 0) {
+        return (int32_t)op;
+    }
+    if (op + 1 + len > cap) {
+        return -1;
+    }
+    out[op++] = (uint8_t)(len - 1);
+    for (uint32_t i = 0; i < len; i++) {
+        out[op++] = in[start + i];
+    }
+    return (int32_t)op;
+}
+
+uint32_t codec_compress_block(const uint8_t* in, uint32_t size,
+                              uint8_t* out, uint32_t cap, uint16_t* table) {
+    uint32_t ip = 0, anchor = 0;
+    int32_t op = 0;
+
+    for (uint32_t i = 0; i < CODEC_HASH_SIZE; i++) {
+        table[i] = NO_POSITION;
+    }
+
+    while (ip < size) {
+        uint32_t run = 0;
+        while (ip + run < size && run < MAX_RUN && in[ip + run] == 0) {
+            run++;
+        }
+        if (run >= MIN_RUN) {
+            if ((op = flush_literals(in, anchor, ip, out, op, cap)) < 0) return 0;
+            if ((uint32_t)op + 1 > cap) return 0;
+            out[op++] = (uint8_t)(0x80 | (run - MIN_RUN));
+            ip += run;
+            anchor = ip;
+            continue;
+        }
+
+        if (ip + MIN_RUN <= size) {
+            uint32_t h = hash3(in + ip);
+            uint32_t ref = table[h];
+            uint32_t len = 0;
+
+            table[h] = (uint16_t)ip;
+            if (ref != NO_POSITION) {
+                while (ip + len < size && len < MAX_RUN && in[ref + len] == in[ip + len]) {
+                    len++;
+                }
+            }
+            if (len >= MIN_RUN) {
+                if ((op = flush_literals(in, anchor, ip, out, op, cap)) < 0) return 0;
+                if ((uint32_t)op + 3 > cap) return 0;
+                out[op++] = (uint8_t)(0xC0 | (len - MIN_RUN));
+                out[op++] = (uint8_t)((ip - ref) & 0xFF);
+                out[op++] = (uint8_t)((ip - ref) >> 8);
+                ip += len;
+                anchor = ip;
+                continue;
+            }
+        }
+
+        ip++;
+        if (ip - anchor == MAX_LITERALS) {
+            if ((op = flush_literals(in, anchor, ip, out, op, cap)) < 0) return 0;
+            anchor = ip;
+        }
+    }
+
+    if ((op = flush_literals(in, anchor, ip, out, op, cap)) < 0) return 0;
+    return (uint32_t)op;
+}
+
+uint32_t codec_decompress_block(const uint8_t* in, uint32_t size,
+                                uint8_t* out, uint32_t cap) {
+    uint32_t ip = 0, op = 0;
+
+    while (ip < size) {
+        uint32_t t = in[ip++];
+        uint32_t len;
+
+        if (t < 0x80) {
+            len = t + 1;
+            if (ip + len > size || op + len > cap) return 0;
+            for (uint32_t i = 0; i < len; i++) {
+                out[op++] = in[ip++];
+            }
+        } else if (t < 0xC0) {
+            len = (t & 0x3F) + MIN_RUN;
+            if (op + len > cap) return 0;
+            for (uint32_t i = 0; i < len; i++) {
+                out[op++] = 0;
+            }
+        } else {
+            len = (t & 0x3F) + MIN_RUN;
+            if (ip + 2 > size) return 0;
+            uint32_t offset = in[ip] | ((uint32_t)in[ip + 1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > op || op + len > cap) return 0;
+            for (uint32_t i = 0; i < len; i++, op++) {
+                out[op] = out[op - offset];
+            }
+        }
+    }
+    return op;
+}
+
+uint32_t codec_compress_page(const uint8_t* page, uint8_t* record, uint32_t cap) {
+    uint16_t table[CODEC_HASH_SIZE];
+    uint8_t block[CODEC_BLOCK_SIZE];
+    uint32_t pos = CODEC_HEADER_SIZE;
+
+    if (cap < CODEC_HEADER_SIZE) {
+        return 0;
+    }
+    for (uint32_t b = 0; b < CODEC_NR_BLOCKS; b++) {
+        const uint8_t* in = page + b * CODEC_BLOCK_SIZE;
+        uint32_t len = codec_compress_block(in, CODEC_BLOCK_SIZE, block, CODEC_BLOCK_SIZE - 1, table);
+        const uint8_t* src = block;
+
+        if (len == 0) {
+            len = CODEC_BLOCK_SIZE;
+            src = in;
+        }
+        if (pos + CODEC_ALIGN8(len) > cap) {
+            return 0;
+        }
+        for (uint32_t i = 0; i < len; i++) {
+            record[pos + i] = src[i];
+        }
+        for (uint32_t i = len; i < CODEC_ALIGN8(len); i++) {
+            record[pos + i] = 0;
+        }
+        record[2 * b] = (uint8_t)(len & 0xFF);
+        record[2 * b + 1] = (uint8_t)(len >> 8);
+        pos += CODEC_ALIGN8(len);
+    }
+    return pos;
+}
+
+int codec_decompress_page(const uint8_t* record, uint8_t* page) {
+    uint32_t pos = CODEC_HEADER_SIZE;
+
+    for (uint32_t b = 0; b < CODEC_NR_BLOCKS; b++) {
+        uint32_t len = record[2 * b] | ((uint32_t)record[2 * b + 1] << 8);
+        uint8_t* out = page + b * CODEC_BLOCK_SIZE;
+
+        if (len == CODEC_BLOCK_SIZE) {
+            for (uint32_t i = 0; i < len; i++) {
+                out[i] = record[pos + i];
+            }
+        } else if (codec_decompress_block(record + pos, len, out, CODEC_BLOCK_SIZE) != CODEC_BLOCK_SIZE) {
+            return -1;
+        }
+        pos += CODEC_ALIGN8(len);
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef __UPMEM_SWAP_PAGE_CODEC_H__
+#define __UPMEM_SWAP_PAGE_CODEC_H__
+
+#include <stdint.h>
+
+/*
+ * WRAM-friendly page codec, run by the DPU kernel (and by the HOST when
+ * the store falls back to host memory).
+ *
+ * A page is cut into 4 blocks of 1KB compressed independently, so a
+ * tasklet only needs 1KB in + 1KB out + a 512B hash table of WRAM.
+ * Block format, one token byte followed by its payload:
+ *   0x00-0x7F  literal run of (t + 1) bytes
+ *   0x80-0xBF  zero run of ((t & 0x3F) + 4) bytes
+ *   0xC0-0xFF  match of ((t & 0x3F) + 4) bytes, then a 16-bit LE offset
+ *
+ * Record layout in MRAM:
+ *   [0..7]   compressed length of each block (uint16 LE), a length of
+ *            CODEC_BLOCK_SIZE means the block is stored raw
+ *   [8..]    blocks, each starting on an 8-byte boundary
+ */
+
+#define CODEC_BLOCK_SIZE 1024
+#define CODEC_NR_BLOCKS 4           /* STORE_PAGE_SIZE / CODEC_BLOCK_SIZE */
+#define CODEC_HEADER_SIZE 8
+#define CODEC_HASH_LOG 8
+#define CODEC_HASH_SIZE (1 << CODEC_HASH_LOG)
+
+#define CODEC_ALIGN8(x) (((x) + 7) & ~7u)
+
+/* Compress one block. table must hold CODEC_HASH_SIZE entries.
+ * Returns the compressed size, or 0 if it would exceed cap. */
+uint32_t codec_compress_block(const uint8_t* in, uint32_t size,
+                              uint8_t* out, uint32_t cap, uint16_t* table);
+
+/* Returns the decompressed size, or 0 on a corrupted block */
+uint32_t codec_decompress_block(const uint8_t* in, uint32_t size,
+                                uint8_t* out, uint32_t cap);
+
+/* Whole-page helpers for pages already in addressable memory.
+ * codec_compress_page returns the record length (8-byte aligned), or 0
+ * if the record would be larger than cap. */
+uint32_t codec_compress_page(const uint8_t* page, uint8_t* record, uint32_t cap);
+int codec_decompress_page(const uint8_t* record, uint8_t* page);
+
+#endif /* __UPMEM_SWAP_PAGE_CODEC_H__ */
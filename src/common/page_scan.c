@@ -0,0 +1,79 @@
+/**
+ * UPMEM Swap - Near-data scan predicates
+ *
+ * Shared by the DPU kernel and the HOST, so no library calls. See
+ * page_scan.h.
+ */
+
+#include "page_scan.h"
+
+int scan_check(const store_scan_t* scan) {
+    uint32_t rsize = scan_record_size(scan);
+
+    if (rsize % STORE_XFER_ALIGN || STORE_PAGE_SIZE % rsize) {
+        return -1;
+    }
+    switch (scan->op) {
+    case STORE_SCAN_PATTERN:
+        return (scan->size > 0 && scan->size <= STORE_SCAN_MAX_PATTERN &&
+                scan->size <= rsize) ? 0 : -1;
+    case STORE_SCAN_RANGE:
+        if (scan->size != 1 && scan->size != 2 && scan->size != 4 && scan->size != 8) return -1;
+        return scan->offset + scan->size <= rsize ? 0 : -1;
+    case STORE_SCAN_KEY:
+        if (scan->size == 0 || scan->size > STORE_SCAN_MAX_PATTERN) return -1;
+        return scan->offset + scan->size <= rsize ? 0 : -1;
+    default:
+        return -1;
+    }
+}
+
+int scan_match_field(const store_scan_t* scan, const uint8_t* field) {
+    if (scan->op == STORE_SCAN_RANGE) {
+        uint64_t v = 0;
+        for (uint32_t i = 0; i < scan->size; i++) {
+            v |= (uint64_t)field[i] << (8 * i);
+        }
+        return v >= scan->lo && v <= scan->hi;
+    }
+    for (uint32_t i = 0; i < scan->size; i++) {
+        if (field[i] != scan->pattern[i]) return 0;
+    }
+    return 1;
+}
+
+int scan_find_pattern(const store_scan_t* scan, const uint8_t* buf, uint32_t len) {
+    uint8_t first = scan->pattern[0];
+
+    for (uint32_t i = 0; i + scan->size <= len; i++) {
+        if (buf[i] != first) continue;
+        uint32_t k = 1;
+        while (k < scan->size && buf[i + k] == scan->pattern[k]) k++;
+        if (k == scan->size) return 1;
+    }
+    return 0;
+}
+
+int scan_match_record(const store_scan_t* scan, const uint8_t* rec) {
+    if (scan->op == STORE_SCAN_PATTERN) {
+        return scan_find_pattern(scan, rec, scan_record_size(scan));
+    }
+    return scan_match_field(scan, rec + scan->offset);
+}
+
+uint32_t scan_page(const store_scan_t* scan, const uint8_t* page, uint8_t* out) {
+    uint32_t rsize = scan_record_size(scan);
+    uint32_t matches = 0;
+
+    for (uint32_t off = 0; off < STORE_PAGE_SIZE; off += rsize) {
+        if (!scan_match_record(scan, page + off)) continue;
+        if (out) {
+            for (uint32_t i = 0; i < rsize; i++) {
+                out[i] = page[off + i];
+            }
+            out += rsize;
+        }
+        matches++;
+    }
+    return matches;
+}
@@ -0,0 +1,34 @@
+#ifndef __UPMEM_SWAP_PAGE_SCAN_H__
+#define __UPMEM_SWAP_PAGE_SCAN_H__
+
+#include <stdint.h>
+
+#include "swap_protocol.h"
+
+/*
+ * Predicate evaluation of STORE_CMD_SCAN (see store_scan_t), run by the
+ * DPU kernel on WRAM windows of MRAM records and by the HOST on pages in
+ * memory (fallback mode, pages it compressed itself).
+ */
+
+/* 0, or -1 if the predicate cannot be evaluated */
+int scan_check(const store_scan_t* scan);
+
+static inline uint32_t scan_record_size(const store_scan_t* scan) {
+    return scan->record_size ? scan->record_size : STORE_PAGE_SIZE;
+}
+
+/* RANGE, KEY: field points at the field bytes of a record */
+int scan_match_field(const store_scan_t* scan, const uint8_t* field);
+
+/* PATTERN: 1 if the pattern occurs in buf[0..len) */
+int scan_find_pattern(const store_scan_t* scan, const uint8_t* buf, uint32_t len);
+
+/* 1 if the record at rec (scan_record_size() bytes) matches */
+int scan_match_record(const store_scan_t* scan, const uint8_t* rec);
+
+/* Evaluate a whole page: the matching records are copied back to back to
+ * out (if not NULL). Returns how many matched. */
+uint32_t scan_page(const store_scan_t* scan, const uint8_t* page, uint8_t* out);
+
+#endif /* __UPMEM_SWAP_PAGE_SCAN_H__ */
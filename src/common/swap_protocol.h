@@ -0,0 +1,116 @@
+#ifndef __UPMEM_SWAP_PROTOCOL_H__
+#define __UPMEM_SWAP_PROTOCOL_H__
+
+#include <stdint.h>
+
+/*
+ * Definitions shared by the HOST store (src/host/swap_store.c) and the
+ * DPU kernel (src/dpu/swap_tasklets.c). Anything that describes the MRAM
+ * layout must live here so both sides agree on it.
+ */
+
+/* Linux standard page */
+#define STORE_PAGE_SIZE 4096
+
+/* MRAM region holding swapped pages, one per DPU */
+#define STORE_MRAM_SYMBOL "page_store"
+#define STORE_MRAM_SIZE (32 * 1024 * 1024)  /* 32MB of the 64MB MRAM */
+
+/* HOST<->MRAM transfers must be 8-byte aligned (offset and length) */
+#define STORE_XFER_ALIGN 8
+#define STORE_ALIGN_UP(x) (((x) + STORE_XFER_ALIGN - 1) & ~(STORE_XFER_ALIGN - 1))
+
+/* Cache lines, the unit of delta puts */
+#define STORE_LINE_SIZE 64
+#define STORE_LINES_PER_PAGE (STORE_PAGE_SIZE / STORE_LINE_SIZE)
+
+/* Per-DPU decompression output, read back by the HOST after a launch */
+#define STORE_STAGING_SYMBOL "page_staging"
+#define STORE_STAGING_PAGES 64
+
+/* Per-DPU landing area of uniform transfers: the records of a batch are
+ * packed there so that one push of the same length serves a whole rank,
+ * then scattered to their slots (or gathered from them) by the kernel */
+#define STORE_LANDING_SYMBOL "page_landing"
+#define STORE_LANDING_SIZE (64 * STORE_PAGE_SIZE)
+
+/* Data every DPU holds the same copy of (reference pages, dictionaries,
+ * configuration), written by the HOST with one broadcast per DPU set */
+#define STORE_SHARED_SYMBOL "shared_area"
+#define STORE_SHARED_SIZE (64 * 1024)
+
+/* Huge pages (2MB) are striped over the DPUs of a rank: stripe i at the
+ * same offset of huge_store on the i-th DPU, so that one push per rank
+ * moves the whole page (32KB per DPU on a full rank of 64) */
+#define STORE_HUGE_SYMBOL "huge_store"
+#define STORE_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define STORE_HUGE_AREA_SIZE (16 * 1024 * 1024)
+
+/*
+ * Kernel commands. The HOST writes store_args (WRAM) and a job list
+ * (MRAM) to every DPU, then launches. Tasklets split the jobs
+ * round-robin and write their results back into the job entries.
+ */
+#define STORE_ARGS_SYMBOL "store_args"
+#define STORE_JOBS_SYMBOL "store_jobs"
+#define STORE_MAX_JOBS 512
+
+#define STORE_CMD_NONE       0
+#define STORE_CMD_COMPRESS   1  /* src: page_store slot, in place */
+#define STORE_CMD_DECOMPRESS 2  /* src: page_store record, dst: page_staging */
+#define STORE_CMD_APPLY_DELTA 3 /* src: patch in delta_area, dst: page_store slot */
+#define STORE_CMD_MOVE 4        /* src: page_store slot, dst: free page_store slot */
+#define STORE_CMD_SCATTER 5     /* src: page_landing offset, dst: page_store slot */
+#define STORE_CMD_GATHER 6      /* src: page_store slot, dst: page_landing offset */
+#define STORE_CMD_SCAN 7        /* src: page_store record, dst: page_staging offset for the
+                                 * matching records (| STORE_SCAN_COMPRESSED),
+                                 * length out: records matched */
+
+/* Patches for STORE_CMD_APPLY_DELTA, per DPU. A patch is a uint64 mask
+ * of changed lines (bit i = line i) followed by those lines in order. */
+#define STORE_DELTA_SYMBOL "delta_area"
+#define STORE_DELTA_AREA_SIZE (64 * 1024)
+#define STORE_DELTA_MASK_SIZE 8
+
+typedef struct {
+    uint32_t command;
+    uint32_t nr_jobs;
+    uint32_t threshold;     /* COMPRESS: largest record worth keeping */
+    uint32_t reserved;
+} store_args_t;
+
+/*
+ * Predicate of STORE_CMD_SCAN, the same for every DPU (WRAM). A page is
+ * cut into records of record_size bytes (0: the page is one record);
+ * a record matches when
+ *   PATTERN  pattern[0..size) occurs anywhere in it
+ *   RANGE    the size-byte little-endian unsigned field at offset is
+ *            within [lo, hi]
+ *   KEY      the size bytes at offset equal pattern[0..size)
+ */
+#define STORE_SCAN_SYMBOL "store_scan"
+#define STORE_SCAN_PATTERN 1
+#define STORE_SCAN_RANGE   2
+#define STORE_SCAN_KEY     3
+#define STORE_SCAN_MAX_PATTERN 32
+#define STORE_SCAN_COMPRESSED 1     /* in job dst: DPU-compressed record */
+
+typedef struct {
+    uint32_t op;
+    uint32_t record_size;   /* multiple of 8 dividing STORE_PAGE_SIZE, or 0 */
+    uint32_t offset;        /* RANGE, KEY: field offset in the record */
+    uint32_t size;          /* pattern or field bytes (RANGE: 1, 2, 4 or 8) */
+    uint64_t lo, hi;
+    uint8_t pattern[STORE_SCAN_MAX_PATTERN];
+    uint32_t want_records;  /* copy the matching records to page_staging */
+    uint32_t reserved;
+} store_scan_t;
+
+typedef struct {
+    uint32_t src;           /* MRAM offsets, meaning depends on command */
+    uint32_t dst;
+    uint32_t length;        /* record length (0 = left untouched) */
+    uint32_t status;        /* 0 = OK */
+} store_job_t;
+
+#endif /* __UPMEM_SWAP_PROTOCOL_H__ */
@@ -0,0 +1,97 @@
+#include <stdint.h>
+#include <mram.h>
+#include <defs.h>
+
+#include "swap_kernel.h"
+#include "page_codec.h"
+
+// Buffers WRAM par tasklet: 1KB in + 1KB out + table de hash (2.5KB)
+// block_in est partage avec les autres kernels (une seule commande par launch)
+uint8_t block_in[NR_TASKLETS][CODEC_BLOCK_SIZE] __dma_aligned;
+static uint8_t block_out[NR_TASKLETS][CODEC_BLOCK_SIZE] __dma_aligned;
+static uint16_t hash_table[NR_TASKLETS][CODEC_HASH_SIZE];
+
+// Copie MRAM -> MRAM via un buffer WRAM
+static void mram_copy(__mram_ptr uint8_t* dst, __mram_ptr const uint8_t* src,
+                      uint32_t len, uint8_t* wram) {
+    for (uint32_t off = 0; off < len; off += CODEC_BLOCK_SIZE) {
+        uint32_t chunk = (len - off) > CODEC_BLOCK_SIZE ? CODEC_BLOCK_SIZE : (len - off);
+        mram_read(src + off, wram, chunk);
+        mram_write(wram, dst + off, chunk);
+    }
+}
+
+void compress_job(store_job_t* job) {
+    sysname_t id = me();
+    uint8_t* in = block_in[id];
+    uint8_t* out = block_out[id];
+    __mram_ptr uint8_t* slot = page_store + job->src;
+    __mram_ptr uint8_t* scratch = codec_scratch + id * STORE_PAGE_SIZE;
+    uint8_t header[CODEC_HEADER_SIZE] __dma_aligned;
+    uint32_t pos = CODEC_HEADER_SIZE;
+
+    // The record is built in scratch: the slot is only overwritten once
+    // we know the page is worth keeping compressed
+    for (uint32_t b = 0; b < CODEC_NR_BLOCKS; b++) {
+        mram_read(slot + b * CODEC_BLOCK_SIZE, in, CODEC_BLOCK_SIZE);
+
+        uint32_t len = codec_compress_block(in, CODEC_BLOCK_SIZE, out,
+                                            CODEC_BLOCK_SIZE - 1, hash_table[id]);
+        uint8_t* src = out;
+        if (len == 0) {
+            len = CODEC_BLOCK_SIZE;
+            src = in;
+        }
+        if (pos + CODEC_ALIGN8(len) > store_args.threshold) {
+            job->length = 0;
+            job->status = 0;
+            return;
+        }
+        for (uint32_t i = len; i < CODEC_ALIGN8(len); i++) {
+            src[i] = 0;
+        }
+        mram_write(src, scratch + pos, CODEC_ALIGN8(len));
+
+        header[2 * b] = (uint8_t)(len & 0xFF);
+        header[2 * b + 1] = (uint8_t)(len >> 8);
+        pos += CODEC_ALIGN8(len);
+    }
+    mram_write(header, scratch, CODEC_HEADER_SIZE);
+    mram_copy(slot, scratch, pos, in);
+
+    job->length = pos;
+    job->status = 0;
+}
+
+// Record MRAM de length octets -> page MRAM, 0 = OK
+int decompress_record(__mram_ptr uint8_t* record, uint32_t length, __mram_ptr uint8_t* page) {
+    sysname_t id = me();
+    uint8_t* in = block_in[id];
+    uint8_t* out = block_out[id];
+    uint8_t header[CODEC_HEADER_SIZE] __dma_aligned;
+    uint32_t pos = CODEC_HEADER_SIZE;
+
+    mram_read(record, header, CODEC_HEADER_SIZE);
+    for (uint32_t b = 0; b < CODEC_NR_BLOCKS; b++) {
+        uint32_t len = header[2 * b] | ((uint32_t)header[2 * b + 1] << 8);
+
+        if (len > CODEC_BLOCK_SIZE || pos + CODEC_ALIGN8(len) > length) {
+            return 1;
+        }
+        mram_read(record + pos, in, CODEC_ALIGN8(len));
+        if (len == CODEC_BLOCK_SIZE) {
+            mram_write(in, page + b * CODEC_BLOCK_SIZE, CODEC_BLOCK_SIZE);
+        } else if (codec_decompress_block(in, len, out, CODEC_BLOCK_SIZE) == CODEC_BLOCK_SIZE) {
+            mram_write(out, page + b * CODEC_BLOCK_SIZE, CODEC_BLOCK_SIZE);
+        } else {
+            return 1;
+        }
+        pos += CODEC_ALIGN8(len);
+    }
+    return 0;
+}
+
+void decompress_job(store_job_t* job) {
+    job->status = decompress_record(page_store + job->src, job->length,
+                                    page_staging + job->dst);
+}
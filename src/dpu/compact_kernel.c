@@ -0,0 +1,26 @@
+#include <stdint.h>
+#include <mram.h>
+#include <defs.h>
+
+#include "swap_kernel.h"
+
+// Deplace un record vers un slot libre, MRAM -> MRAM via le buffer WRAM
+// du tasklet. Le HOST garantit que dst ne recouvre aucun slot vivant.
+void move_job(store_job_t* job) {
+    uint8_t* buf = block_in[me()];
+    __mram_ptr uint8_t* src = page_store + job->src;
+    __mram_ptr uint8_t* dst = page_store + job->dst;
+
+    if ((job->length & (STORE_XFER_ALIGN - 1)) != 0 ||
+        job->src + job->length > STORE_MRAM_SIZE || job->dst + job->length > STORE_MRAM_SIZE) {
+        job->status = 1;
+        return;
+    }
+    for (uint32_t off = 0; off < job->length; off += sizeof(block_in[0])) {
+        uint32_t chunk = job->length - off;
+        if (chunk > sizeof(block_in[0])) chunk = sizeof(block_in[0]);
+        mram_read(src + off, buf, chunk);
+        mram_write(buf, dst + off, chunk);
+    }
+    job->status = 0;
+}
@@ -0,0 +1,44 @@
+#include <stdint.h>
+#include <mram.h>
+#include <defs.h>
+
+#include "swap_kernel.h"
+
+// Lignes copiees par DMA: le buffer WRAM du tasklet fait 1KB
+#define MAX_RUN_LINES (sizeof(block_in[0]) / STORE_LINE_SIZE)
+
+// Applique un patch (masque + lignes modifiees) au slot d'une page brute
+void apply_delta_job(store_job_t* job) {
+    uint8_t* buf = block_in[me()];
+    __mram_ptr uint8_t* patch = delta_area + job->src;
+    __mram_ptr uint8_t* slot = page_store + job->dst;
+    uint32_t pos = STORE_DELTA_MASK_SIZE;
+    uint64_t mask;
+
+    if (job->length < STORE_DELTA_MASK_SIZE || job->src + job->length > STORE_DELTA_AREA_SIZE) {
+        job->status = 1;
+        return;
+    }
+    mram_read(patch, buf, STORE_DELTA_MASK_SIZE);
+    mask = *(uint64_t*)buf;
+    if (job->length != STORE_DELTA_MASK_SIZE +
+                       (uint32_t)__builtin_popcountll(mask) * STORE_LINE_SIZE) {
+        job->status = 1;
+        return;
+    }
+
+    // Les lignes consecutives sont copiees ensemble
+    while (mask) {
+        uint32_t line = __builtin_ctzll(mask);
+        uint32_t run = 0;
+        while (line + run < STORE_LINES_PER_PAGE && run < MAX_RUN_LINES &&
+               (mask & (1ULL << (line + run)))) {
+            mask &= ~(1ULL << (line + run));
+            run++;
+        }
+        mram_read(patch + pos, buf, run * STORE_LINE_SIZE);
+        mram_write(buf, slot + line * STORE_LINE_SIZE, run * STORE_LINE_SIZE);
+        pos += run * STORE_LINE_SIZE;
+    }
+    job->status = 0;
+}
@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <mram.h>
+#include <defs.h>
+
+#include "swap_kernel.h"
+
+// Fenetres de 1KB qui se chevauchent de la taille max du motif
+#define SCAN_CHUNK CODEC_BLOCK_SIZE
+#define SCAN_STEP (SCAN_CHUNK - STORE_SCAN_MAX_PATTERN)
+
+// Motif dans un record MRAM
+static int record_has_pattern(__mram_ptr uint8_t* rec, uint32_t rsize, uint8_t* buf) {
+    for (uint32_t off = 0; off < rsize; off += SCAN_STEP) {
+        uint32_t len = rsize - off;
+        if (len > SCAN_CHUNK) len = SCAN_CHUNK;
+        mram_read(rec + off, buf, len);
+        if (scan_find_pattern(&store_scan, buf, len)) return 1;
+        if (off + len == rsize) break;
+    }
+    return 0;
+}
+
+// Champ d'un record MRAM, lu par une fenetre alignee sur 8 octets
+static int record_field_matches(__mram_ptr uint8_t* rec) {
+    uint8_t win[STORE_SCAN_MAX_PATTERN + 2 * STORE_XFER_ALIGN] __dma_aligned;
+    uint32_t start = store_scan.offset & ~(STORE_XFER_ALIGN - 1);
+    uint32_t skew = store_scan.offset - start;
+
+    mram_read(rec + start, win, STORE_ALIGN_UP(skew + store_scan.size));
+    return scan_match_field(&store_scan, win + skew);
+}
+
+// Page (ou record compresse par le DPU) -> records qui matchent, copies
+// dans page_staging si le HOST les veut
+void scan_job(store_job_t* job) {
+    sysname_t id = me();
+    uint32_t rsize = scan_record_size(&store_scan);
+    uint32_t out = job->dst & ~(uint32_t)STORE_SCAN_COMPRESSED;
+    uint32_t stored = (job->dst & STORE_SCAN_COMPRESSED) ? job->length : STORE_PAGE_SIZE;
+    __mram_ptr uint8_t* page = page_store + job->src;
+    uint32_t matches = 0;
+
+    if (scan_check(&store_scan) != 0 || job->src + stored > STORE_MRAM_SIZE ||
+        out + STORE_PAGE_SIZE > STORE_STAGING_PAGES * STORE_PAGE_SIZE) {
+        job->status = 1;
+        return;
+    }
+    if (job->dst & STORE_SCAN_COMPRESSED) {
+        page = codec_scratch + id * STORE_PAGE_SIZE;
+        if (decompress_record(page_store + job->src, job->length, page) != 0) {
+            job->status = 1;
+            return;
+        }
+    }
+    for (uint32_t off = 0; off < STORE_PAGE_SIZE; off += rsize) {
+        __mram_ptr uint8_t* rec = page + off;
+        int hit = store_scan.op == STORE_SCAN_PATTERN ? record_has_pattern(rec, rsize, block_in[id])
+                                                      : record_field_matches(rec);
+        if (!hit) continue;
+        if (store_scan.want_records) {
+            copy_record(rec, page_staging + out, rsize);
+            out += rsize;
+        }
+        matches++;
+    }
+    job->length = matches;
+    job->status = 0;
+}
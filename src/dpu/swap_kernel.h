@@ -0,0 +1,40 @@
+#ifndef __UPMEM_SWAP_KERNEL_H__
+#define __UPMEM_SWAP_KERNEL_H__
+
+#include <stdint.h>
+#include <mram.h>
+#include <defs.h>
+
+#include "swap_protocol.h"
+#include "page_codec.h"
+#include "page_scan.h"
+
+/* MRAM regions, defined in swap_tasklets.c */
+extern __mram_noinit uint8_t page_store[STORE_MRAM_SIZE];
+extern __mram_noinit uint8_t page_staging[STORE_STAGING_PAGES * STORE_PAGE_SIZE];
+extern __mram_noinit uint8_t codec_scratch[NR_TASKLETS * STORE_PAGE_SIZE];
+extern __mram_noinit uint8_t delta_area[STORE_DELTA_AREA_SIZE];
+extern __mram_noinit uint8_t page_landing[STORE_LANDING_SIZE];
+extern __mram_noinit uint8_t shared_area[STORE_SHARED_SIZE];
+extern __mram_noinit uint8_t huge_store[STORE_HUGE_AREA_SIZE];
+
+/* Per-tasklet WRAM buffer (codec_kernel.c), free for any command */
+extern uint8_t block_in[NR_TASKLETS][CODEC_BLOCK_SIZE];
+
+extern __host store_args_t store_args;
+extern __host store_scan_t store_scan;
+
+/* Job handlers, called by one tasklet per job */
+void compress_job(store_job_t* job);
+void decompress_job(store_job_t* job);
+void apply_delta_job(store_job_t* job);
+void move_job(store_job_t* job);
+void scatter_job(store_job_t* job);
+void gather_job(store_job_t* job);
+void scan_job(store_job_t* job);
+
+/* Helpers shared by the kernels (one tasklet buffer each, see block_in) */
+int decompress_record(__mram_ptr uint8_t* record, uint32_t length, __mram_ptr uint8_t* page);
+void copy_record(__mram_ptr uint8_t* src, __mram_ptr uint8_t* dst, uint32_t length);
+
+#endif /* __UPMEM_SWAP_KERNEL_H__ */
@@ -3,14 +3,69 @@
 #include <defs.h>
 #include <barrier.h>
 
+#include "swap_kernel.h"
+
 // Buffer MRAM pour swap (64KB max)
 __mram_noinit uint8_t mram_buffer[65536];
 
+// Page store: slots allocated by the HOST (src/host/swap_store.c)
+__mram_noinit uint8_t page_store[STORE_MRAM_SIZE];
+__mram_noinit uint8_t page_staging[STORE_STAGING_PAGES * STORE_PAGE_SIZE];
+__mram_noinit uint8_t codec_scratch[NR_TASKLETS * STORE_PAGE_SIZE];
+__mram_noinit uint8_t delta_area[STORE_DELTA_AREA_SIZE];
+__mram_noinit uint8_t page_landing[STORE_LANDING_SIZE];
+__mram_noinit uint8_t shared_area[STORE_SHARED_SIZE];
+__mram_noinit uint8_t huge_store[STORE_HUGE_AREA_SIZE];
+
+// Commande et liste de jobs, ecrites par le HOST avant chaque launch
+__host store_args_t store_args;
+__mram_noinit store_job_t store_jobs[STORE_MAX_JOBS];
+
+// Predicat de STORE_CMD_SCAN, le meme pour tous les DPUs
+__host store_scan_t store_scan;
+
 // Barrier pour synchronisation tasklets
 BARRIER_INIT(my_barrier, NR_TASKLETS);
 
+// Chaque tasklet traite les jobs me(), me() + NR_TASKLETS, ...
+static void run_jobs(void (*handler)(store_job_t*)) {
+    store_job_t job __dma_aligned;
+
+    for (uint32_t i = me(); i < store_args.nr_jobs; i += NR_TASKLETS) {
+        mram_read(&store_jobs[i], &job, sizeof(job));
+        handler(&job);
+        mram_write(&job, &store_jobs[i], sizeof(job));
+    }
+}
+
 int main() {
     uint32_t tasklet_id = me();
+
+    switch (store_args.command) {
+    case STORE_CMD_COMPRESS:
+        run_jobs(compress_job);
+        return 0;
+    case STORE_CMD_DECOMPRESS:
+        run_jobs(decompress_job);
+        return 0;
+    case STORE_CMD_APPLY_DELTA:
+        run_jobs(apply_delta_job);
+        return 0;
+    case STORE_CMD_MOVE:
+        run_jobs(move_job);
+        return 0;
+    case STORE_CMD_SCATTER:
+        run_jobs(scatter_job);
+        return 0;
+    case STORE_CMD_GATHER:
+        run_jobs(gather_job);
+        return 0;
+    case STORE_CMD_SCAN:
+        run_jobs(scan_job);
+        return 0;
+    default:
+        break;
+    }
     
     // Chaque tasklet traite sa portion
     // Pour swap pur, on fait juste une lecture minimale
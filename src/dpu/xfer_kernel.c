@@ -0,0 +1,42 @@
+#include <stdint.h>
+#include <mram.h>
+#include <defs.h>
+
+#include "swap_kernel.h"
+
+// Copie MRAM -> MRAM par le buffer WRAM du tasklet, length multiple de 8
+void copy_record(__mram_ptr uint8_t* src, __mram_ptr uint8_t* dst, uint32_t length) {
+    uint8_t* buf = block_in[me()];
+
+    for (uint32_t off = 0; off < length; off += sizeof(block_in[0])) {
+        uint32_t chunk = length - off;
+        if (chunk > sizeof(block_in[0])) chunk = sizeof(block_in[0]);
+        mram_read(src + off, buf, chunk);
+        mram_write(buf, dst + off, chunk);
+    }
+}
+
+static int job_fits(const store_job_t* job, uint32_t landing, uint32_t slot) {
+    return (job->length & (STORE_XFER_ALIGN - 1)) == 0 &&
+           landing + job->length <= STORE_LANDING_SIZE && slot + job->length <= STORE_MRAM_SIZE;
+}
+
+// Record pousse dans page_landing -> son slot de page_store
+void scatter_job(store_job_t* job) {
+    if (!job_fits(job, job->src, job->dst)) {
+        job->status = 1;
+        return;
+    }
+    copy_record(page_landing + job->src, page_store + job->dst, job->length);
+    job->status = 0;
+}
+
+// Slot de page_store -> page_landing, relu ensuite par le HOST
+void gather_job(store_job_t* job) {
+    if (!job_fits(job, job->dst, job->src)) {
+        job->status = 1;
+        return;
+    }
+    copy_record(page_store + job->src, page_landing + job->dst, job->length);
+    job->status = 0;
+}
@@ -0,0 +1,603 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "buffer_pool_ext.h"
+
+/*
+ * Buffer pool extension under a TPC-C-like block trace.
+ *
+ * The database is one local file holding the nine TPC-C tables, 4KB
+ * blocks, rows sized as in the spec. A generator produces the block
+ * accesses of the five transactions (standard mix, NURand skew on
+ * customers and items, append-only orders/order lines/history) and a
+ * small buffer pool serves them with CLOCK replacement:
+ *
+ *   file  pool misses read the data file (O_DIRECT when the filesystem
+ *         allows it, so the page cache does not stand in for the SSD)
+ *   bpx   clean blocks leaving the pool go to the buffer pool extension,
+ *         the misses of a transaction are looked up there in one batch
+ *         and only what is left goes to the file
+ *
+ * Dirty blocks are written back on eviction and invalidated in the
+ * extension when first modified. Every block carries (table, block,
+ * version) in its header, checked on every read.
+ *
+ * Usage: benchmark_bpx [warehouses] [pool_mb] [bpx_mb] [transactions]
+ */
+
+#define DEFAULT_WAREHOUSES 2
+#define DEFAULT_POOL_MB 16
+#define DEFAULT_BPX_MB 128
+#define DEFAULT_TRANSACTIONS 20000
+#define MAX_ACCESSES 512
+#define DATA_FILE "bpx_tpcc.db"
+
+enum {
+    T_WAREHOUSE, T_DISTRICT, T_CUSTOMER, T_HISTORY, T_NEW_ORDER,
+    T_ORDERS, T_ORDER_LINE, T_ITEM, T_STOCK, NR_TABLES
+};
+
+static const char* table_names[NR_TABLES] = {
+    "warehouse", "district", "customer", "history", "new_order",
+    "orders", "order_line", "item", "stock"
+};
+
+/* Row size (bytes) and rows per warehouse (item is not per warehouse) */
+static const uint32_t row_size[NR_TABLES] = {89, 95, 655, 46, 8, 24, 54, 82, 306};
+static const uint32_t rows_per_wh[NR_TABLES] = {1, 10, 30000, 30000, 9000, 30000, 300000, 0, 100000};
+#define ITEM_ROWS 100000
+
+typedef struct {
+    uint32_t table;
+    uint32_t pad;
+    uint64_t block;
+    uint64_t version;
+} block_header_t;
+
+typedef struct {
+    uint8_t table;
+    uint8_t write;
+    uint64_t block;
+} access_t;
+
+typedef struct {
+    long min, max, mean, stddev, p99;
+} stats_t;
+
+typedef struct {
+    int use_bpx;
+    int warehouses;
+    size_t pool_mb, bpx_mb;
+    int transactions;
+    int direct_io;
+    uint64_t accesses;
+    uint64_t pool_misses;
+    uint64_t bpx_hits;
+    uint64_t file_reads;
+    uint64_t writebacks;
+    bpx_stats_t bpx;
+    swap_store_stats_t store;
+    stats_t read_stats;         /* per missed block, ns */
+    double tps;
+    uint64_t errors;
+    int verified;
+} bpx_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+stats_t calculate_stats(long* latencies, size_t n) {
+    stats_t s = {0};
+    if (n == 0) return s;
+    s.min = latencies[0];
+    s.max = latencies[0];
+    double sum = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (latencies[i] < s.min) s.min = latencies[i];
+        if (latencies[i] > s.max) s.max = latencies[i];
+        sum += latencies[i];
+    }
+    s.mean = (long)(sum / n);
+
+    double variance_sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        double diff = (double)(latencies[i] - s.mean);
+        variance_sum += diff * diff;
+    }
+    s.stddev = (long)sqrt(variance_sum / n);
+
+    qsort(latencies, n, sizeof(long), cmp_long);
+    s.p99 = latencies[n * 99 / 100];
+
+    return s;
+}
+
+/* ========================================================================
+ * Database layout and trace generator
+ * ======================================================================== */
+
+typedef struct {
+    int warehouses;
+    uint64_t rows[NR_TABLES];
+    uint64_t blocks[NR_TABLES];
+    uint64_t first_block[NR_TABLES];    /* in the data file */
+    uint64_t total_blocks;
+
+    /* Append-only tables: next row, and oldest undelivered new order */
+    uint64_t orders_next, line_next, history_next, new_order_next, new_order_oldest;
+    unsigned seed;
+    uint32_t c_id, c_item;              /* NURand constants */
+} tpcc_t;
+
+static void tpcc_init(tpcc_t* db, int warehouses) {
+    memset(db, 0, sizeof(*db));
+    db->warehouses = warehouses;
+    for (int t = 0; t < NR_TABLES; t++) {
+        uint32_t per_block = STORE_PAGE_SIZE / row_size[t];
+        db->rows[t] = t == T_ITEM ? ITEM_ROWS : (uint64_t)rows_per_wh[t] * warehouses;
+        db->blocks[t] = (db->rows[t] + per_block - 1) / per_block;
+        db->first_block[t] = db->total_blocks;
+        db->total_blocks += db->blocks[t];
+    }
+    /* Tables start 90% full, the appends then wrap around */
+    db->orders_next = db->rows[T_ORDERS] * 9 / 10;
+    db->line_next = db->rows[T_ORDER_LINE] * 9 / 10;
+    db->history_next = db->rows[T_HISTORY] * 9 / 10;
+    db->new_order_next = db->rows[T_NEW_ORDER] * 9 / 10;
+    db->seed = 42;
+    db->c_id = 259;
+    db->c_item = 7911;
+}
+
+static uint32_t urand(tpcc_t* db, uint32_t lo, uint32_t hi) {
+    return lo + (uint32_t)rand_r(&db->seed) % (hi - lo + 1);
+}
+
+static uint32_t nurand(tpcc_t* db, uint32_t a, uint32_t c, uint32_t lo, uint32_t hi) {
+    return (((urand(db, 0, a) | urand(db, lo, hi)) + c) % (hi - lo + 1)) + lo;
+}
+
+static void add_row(const tpcc_t* db, access_t* acc, int* n, int table, uint64_t row, int write) {
+    if (*n == MAX_ACCESSES) return;
+    acc[*n].table = (uint8_t)table;
+    acc[*n].write = (uint8_t)write;
+    acc[*n].block = (row % db->rows[table]) / (STORE_PAGE_SIZE / row_size[table]);
+    (*n)++;
+}
+
+static uint64_t customer_row(tpcc_t* db, uint32_t w, uint32_t d) {
+    return ((uint64_t)w * 10 + d) * 3000 + nurand(db, 1023, db->c_id, 1, 3000) - 1;
+}
+
+/* Block accesses of one transaction, in order */
+static int tpcc_next(tpcc_t* db, access_t* acc) {
+    uint32_t w = urand(db, 0, db->warehouses - 1);
+    uint32_t d = urand(db, 0, 9);
+    uint32_t kind = urand(db, 1, 100);
+    int n = 0;
+
+    if (kind <= 45) {
+        /* New-Order */
+        uint32_t lines = urand(db, 5, 15);
+        add_row(db, acc, &n, T_WAREHOUSE, w, 0);
+        add_row(db, acc, &n, T_DISTRICT, (uint64_t)w * 10 + d, 1);
+        add_row(db, acc, &n, T_CUSTOMER, customer_row(db, w, d), 0);
+        for (uint32_t l = 0; l < lines; l++) {
+            uint32_t item = nurand(db, 8191, db->c_item, 1, ITEM_ROWS) - 1;
+            add_row(db, acc, &n, T_ITEM, item, 0);
+            add_row(db, acc, &n, T_STOCK, (uint64_t)w * ITEM_ROWS + item, 1);
+            add_row(db, acc, &n, T_ORDER_LINE, db->line_next++, 1);
+        }
+        add_row(db, acc, &n, T_ORDERS, db->orders_next++, 1);
+        add_row(db, acc, &n, T_NEW_ORDER, db->new_order_next++, 1);
+    } else if (kind <= 88) {
+        /* Payment */
+        add_row(db, acc, &n, T_WAREHOUSE, w, 1);
+        add_row(db, acc, &n, T_DISTRICT, (uint64_t)w * 10 + d, 1);
+        add_row(db, acc, &n, T_CUSTOMER, customer_row(db, w, d), 1);
+        add_row(db, acc, &n, T_HISTORY, db->history_next++, 1);
+    } else if (kind <= 92) {
+        /* Order-Status: a recent order of the customer */
+        uint32_t back = urand(db, 1, 3000);
+        add_row(db, acc, &n, T_CUSTOMER, customer_row(db, w, d), 0);
+        add_row(db, acc, &n, T_ORDERS, db->orders_next + db->rows[T_ORDERS] - back, 0);
+        for (uint32_t l = 0; l < 10; l++) {
+            add_row(db, acc, &n, T_ORDER_LINE, db->line_next + db->rows[T_ORDER_LINE] - back * 10 + l, 0);
+        }
+    } else if (kind <= 96) {
+        /* Delivery: oldest new order of every district */
+        for (uint32_t dd = 0; dd < 10; dd++) {
+            uint64_t age = db->new_order_next - db->new_order_oldest;
+            add_row(db, acc, &n, T_NEW_ORDER, db->new_order_oldest++, 1);
+            add_row(db, acc, &n, T_ORDERS, db->orders_next + db->rows[T_ORDERS] - age, 1);
+            for (uint32_t l = 0; l < 10; l++) {
+                add_row(db, acc, &n, T_ORDER_LINE, db->line_next + db->rows[T_ORDER_LINE] - age * 10 + l, 1);
+            }
+            add_row(db, acc, &n, T_CUSTOMER, customer_row(db, w, dd), 1);
+        }
+    } else {
+        /* Stock-Level: lines of the last 20 orders, then their stock */
+        add_row(db, acc, &n, T_DISTRICT, (uint64_t)w * 10 + d, 0);
+        for (uint32_t l = 0; l < 200; l += 8) {
+            add_row(db, acc, &n, T_ORDER_LINE, db->line_next + db->rows[T_ORDER_LINE] - 200 + l, 0);
+        }
+        for (uint32_t l = 0; l < 200; l++) {
+            uint32_t item = nurand(db, 8191, db->c_item, 1, ITEM_ROWS) - 1;
+            add_row(db, acc, &n, T_STOCK, (uint64_t)w * ITEM_ROWS + item, 0);
+        }
+    }
+    return n;
+}
+
+static void init_block(uint8_t* page, uint32_t table, uint64_t block, uint64_t version) {
+    block_header_t* h = (block_header_t*)page;
+    memset(page + sizeof(*h), (int)(table * 31 + block), STORE_PAGE_SIZE - sizeof(*h));
+    h->table = table;
+    h->pad = 0;
+    h->block = block;
+    h->version = version;
+}
+
+static int create_data_file(const tpcc_t* db, const char* path) {
+    uint8_t* chunk = aligned_alloc(STORE_PAGE_SIZE, 256 * STORE_PAGE_SIZE);
+    FILE* f = fopen(path, "wb");
+    int ret = 0;
+
+    if (!chunk || !f) {
+        fprintf(stderr, "Cannot create %s\n", path);
+        free(chunk);
+        if (f) fclose(f);
+        return -1;
+    }
+    for (int t = 0; t < NR_TABLES; t++) {
+        for (uint64_t b = 0; b < db->blocks[t]; b += 256) {
+            uint64_t n = db->blocks[t] - b < 256 ? db->blocks[t] - b : 256;
+            for (uint64_t i = 0; i < n; i++) {
+                init_block(chunk + i * STORE_PAGE_SIZE, t, b + i, 0);
+            }
+            if (fwrite(chunk, STORE_PAGE_SIZE, n, f) != n) ret = -1;
+        }
+    }
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) ret = -1;
+    fclose(f);
+    free(chunk);
+    return ret;
+}
+
+/* ========================================================================
+ * Buffer pool
+ * ======================================================================== */
+
+typedef struct {
+    uint8_t* frames;
+    uint32_t nr_frames;
+    uint64_t* frame_block;          /* global block, UINT64_MAX if free */
+    uint8_t* frame_ref;
+    uint8_t* frame_dirty;
+    uint8_t* frame_pinned;
+    int32_t* map;                   /* global block -> frame, -1 if absent */
+    uint64_t* versions;             /* expected version of every block */
+    uint32_t hand;
+} pool_t;
+
+static uint8_t* frame_addr(const pool_t* pool, uint32_t f) {
+    return pool->frames + (size_t)f * STORE_PAGE_SIZE;
+}
+
+static int32_t pool_victim(pool_t* pool) {
+    for (;;) {
+        uint32_t f = pool->hand;
+        pool->hand = (pool->hand + 1) % pool->nr_frames;
+        if (pool->frame_pinned[f]) continue;
+        if (pool->frame_ref[f]) {
+            pool->frame_ref[f] = 0;
+            continue;
+        }
+        return (int32_t)f;
+    }
+}
+
+static int table_of(const tpcc_t* db, uint64_t global) {
+    int t = 0;
+    while (t + 1 < NR_TABLES && global >= db->first_block[t + 1]) t++;
+    return t;
+}
+
+bpx_result_t run_benchmark(int use_bpx, int warehouses, size_t pool_mb, size_t bpx_mb,
+                           int transactions) {
+    bpx_result_t result = {0};
+    tpcc_t db;
+    pool_t pool = {0};
+    bpx_t bpx;
+
+    result.use_bpx = use_bpx;
+    result.warehouses = warehouses;
+    result.pool_mb = pool_mb;
+    result.bpx_mb = bpx_mb;
+    result.transactions = transactions;
+
+    tpcc_init(&db, warehouses);
+    if (create_data_file(&db, DATA_FILE) != 0) {
+        exit(1);
+    }
+    int fd = open(DATA_FILE, O_RDWR | O_DIRECT);
+    result.direct_io = fd >= 0;
+    if (fd < 0) {
+        fd = open(DATA_FILE, O_RDWR);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    pool.nr_frames = (uint32_t)((pool_mb << 20) / STORE_PAGE_SIZE);
+    pool.frames = aligned_alloc(STORE_PAGE_SIZE, (size_t)pool.nr_frames * STORE_PAGE_SIZE);
+    pool.frame_block = malloc(pool.nr_frames * sizeof(uint64_t));
+    pool.frame_ref = calloc(pool.nr_frames, 1);
+    pool.frame_dirty = calloc(pool.nr_frames, 1);
+    pool.frame_pinned = calloc(pool.nr_frames, 1);
+    pool.map = malloc(db.total_blocks * sizeof(int32_t));
+    pool.versions = calloc(db.total_blocks, sizeof(uint64_t));
+    if (fd < 0 || !pool.frames || !pool.frame_block || !pool.frame_ref || !pool.frame_dirty ||
+        !pool.frame_pinned || !pool.map || !pool.versions) {
+        fprintf(stderr, "Failed to set up the buffer pool\n");
+        exit(1);
+    }
+    memset(pool.frame_block, 0xff, pool.nr_frames * sizeof(uint64_t));
+    memset(pool.map, 0xff, db.total_blocks * sizeof(int32_t));
+
+    if (use_bpx) {
+        swap_store_config_t cfg;
+        swap_store_default_config(&cfg);
+        cfg.max_pages = (uint32_t)((bpx_mb << 20) / STORE_PAGE_SIZE);
+        cfg.delta = 1;
+        if (bpx_init(&bpx, &cfg) != 0) {
+            fprintf(stderr, "Failed to initialize buffer pool extension\n");
+            exit(1);
+        }
+    }
+
+    size_t lat_cap = 1 << 16, nr_lat = 0;
+    long* latencies = malloc(lat_cap * sizeof(long));
+    access_t acc[MAX_ACCESSES];
+    bpx_key_t keys[MAX_ACCESSES], evict_keys[MAX_ACCESSES];
+    uint8_t* dsts[MAX_ACCESSES];
+    const uint8_t* evict_pages[MAX_ACCESSES];
+    uint64_t miss_global[MAX_ACCESSES];
+    uint8_t hit[MAX_ACCESSES];
+    struct timespec t_begin, t_end, t_start, t_stop;
+
+    clock_gettime(CLOCK_MONOTONIC, &t_begin);
+    for (int tx = 0; tx < transactions; tx++) {
+        int n = tpcc_next(&db, acc);
+        int nr_miss = 0, nr_evict = 0;
+
+        /* Frames for the blocks not in the pool, victims leave first */
+        for (int i = 0; i < n; i++) {
+            uint64_t g = db.first_block[acc[i].table] + acc[i].block;
+            if (pool.map[g] >= 0) {
+                pool.frame_pinned[pool.map[g]] = 1;
+                continue;
+            }
+
+            int32_t f = pool_victim(&pool);
+            uint64_t old = pool.frame_block[f];
+            if (old != UINT64_MAX) {
+                int t = table_of(&db, old);
+                if (pool.frame_dirty[f]) {
+                    if (pwrite(fd, frame_addr(&pool, f), STORE_PAGE_SIZE,
+                               (off_t)old * STORE_PAGE_SIZE) != STORE_PAGE_SIZE) {
+                        result.errors++;
+                    }
+                    pool.frame_dirty[f] = 0;
+                    result.writebacks++;
+                }
+                if (use_bpx) {
+                    evict_keys[nr_evict].file = (uint32_t)t;
+                    evict_keys[nr_evict].block = old - db.first_block[t];
+                    evict_pages[nr_evict] = frame_addr(&pool, f);
+                    nr_evict++;
+                }
+                pool.map[old] = -1;
+            }
+            pool.frame_block[f] = g;
+            pool.frame_pinned[f] = 1;
+            pool.map[g] = f;
+            keys[nr_miss].file = acc[i].table;
+            keys[nr_miss].block = acc[i].block;
+            dsts[nr_miss] = frame_addr(&pool, f);
+            miss_global[nr_miss] = g;
+            nr_miss++;
+        }
+        if (nr_evict > 0) {
+            bpx_insert_batch(&bpx, evict_keys, evict_pages, nr_evict);
+        }
+        if (nr_miss + nr_lat > lat_cap) {
+            lat_cap *= 2;
+            latencies = realloc(latencies, lat_cap * sizeof(long));
+        }
+
+        /* Misses: one extension batch, the rest from the file */
+        memset(hit, 0, nr_miss);
+        if (use_bpx && nr_miss > 0) {
+            clock_gettime(CLOCK_MONOTONIC, &t_start);
+            int hits = bpx_lookup_batch(&bpx, keys, dsts, nr_miss, hit);
+            clock_gettime(CLOCK_MONOTONIC, &t_stop);
+            if (hits > 0) {
+                long per_block = timespec_to_ns(diff_time(t_start, t_stop)) / hits;
+                for (int h = 0; h < hits; h++) latencies[nr_lat++] = per_block;
+                result.bpx_hits += hits;
+            }
+        }
+        for (int i = 0; i < nr_miss; i++) {
+            if (hit[i]) continue;
+            clock_gettime(CLOCK_MONOTONIC, &t_start);
+            if (pread(fd, dsts[i], STORE_PAGE_SIZE, (off_t)miss_global[i] * STORE_PAGE_SIZE) != STORE_PAGE_SIZE) {
+                result.errors++;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &t_stop);
+            latencies[nr_lat++] = timespec_to_ns(diff_time(t_start, t_stop));
+            result.file_reads++;
+        }
+        for (int i = 0; i < nr_miss; i++) {
+            const block_header_t* h = (const block_header_t*)dsts[i];
+            if (h->table != keys[i].file || h->block != keys[i].block ||
+                h->version != pool.versions[miss_global[i]]) {
+                result.errors++;
+            }
+        }
+        result.pool_misses += nr_miss;
+
+        /* Run the transaction on the pool */
+        for (int i = 0; i < n; i++) {
+            uint64_t g = db.first_block[acc[i].table] + acc[i].block;
+            int32_t f = pool.map[g];
+            pool.frame_ref[f] = 1;
+            pool.frame_pinned[f] = 0;
+            if (!acc[i].write) continue;
+            if (!pool.frame_dirty[f] && use_bpx) {
+                bpx_invalidate(&bpx, acc[i].table, acc[i].block, 1);
+            }
+            pool.frame_dirty[f] = 1;
+            ((block_header_t*)frame_addr(&pool, f))->version = ++pool.versions[g];
+        }
+        result.accesses += n;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+    result.tps = transactions / (timespec_to_ns(diff_time(t_begin, t_end)) / 1e9);
+    result.read_stats = calculate_stats(latencies, nr_lat);
+    if (use_bpx) {
+        /* Dropping every table must leave the extension empty */
+        for (int t = 0; t < NR_TABLES; t++) {
+            bpx_invalidate(&bpx, t, 0, BPX_MAX_BLOCK + 1);
+        }
+        if (bpx.nr_used != 0) result.errors++;
+        result.bpx = bpx.stats;
+        result.store = bpx.store.stats;
+        bpx_free(&bpx);
+    }
+    result.verified = result.errors == 0;
+
+    free(latencies);
+    free(pool.frames);
+    free(pool.frame_block);
+    free(pool.frame_ref);
+    free(pool.frame_dirty);
+    free(pool.frame_pinned);
+    free(pool.map);
+    free(pool.versions);
+    close(fd);
+    unlink(DATA_FILE);
+    return result;
+}
+
+void print_result(const bpx_result_t* r) {
+    printf("%s:\n", r->use_bpx ? "BUFFER POOL EXTENSION" : "LOCAL FILE ONLY");
+    printf("  Accesses:     %llu, pool misses %llu (%.1f%%)\n",
+           (unsigned long long)r->accesses, (unsigned long long)r->pool_misses,
+           100.0 * r->pool_misses / r->accesses);
+    if (r->use_bpx) {
+        printf("  Extension:    %llu hits (hit rate %.1f%%), %llu inserts, %llu evictions, %llu invalidations\n",
+               (unsigned long long)r->bpx_hits, 100.0 * r->bpx_hits / r->pool_misses,
+               (unsigned long long)r->bpx.inserts, (unsigned long long)r->bpx.evictions,
+               (unsigned long long)r->bpx.invalidations);
+        printf("  Store:        %llu delta puts, %llu bytes to DPU, %llu from DPU\n",
+               (unsigned long long)r->store.delta_pages,
+               (unsigned long long)r->store.bus_bytes_to_dpu,
+               (unsigned long long)r->store.bus_bytes_from_dpu);
+    }
+    printf("  File:         %llu reads%s, %llu write-backs\n",
+           (unsigned long long)r->file_reads, r->direct_io ? " (O_DIRECT)" : " (page cache dropped)",
+           (unsigned long long)r->writebacks);
+    printf("  Miss latency: mean %.2f µs, p99 %.2f µs, max %.2f µs\n",
+           r->read_stats.mean / 1000.0, r->read_stats.p99 / 1000.0, r->read_stats.max / 1000.0);
+    printf("  Throughput:   %.0f tx/s\n", r->tps);
+    printf("  Verification: %s\n\n", r->verified ? "✓ OK" : "✗ FAIL");
+}
+
+void save_results_csv(bpx_result_t* results, int count, const char* filename) {
+    FILE* f = fopen(filename, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", filename);
+        return;
+    }
+    fprintf(f, "mode,warehouses,pool_mb,bpx_mb,transactions,accesses,pool_misses,bpx_hits,hit_rate,file_reads,read_mean_us,read_p99_us,tps\n");
+
+    for (int i = 0; i < count; i++) {
+        bpx_result_t* r = &results[i];
+        fprintf(f, "%s,%d,%zu,%zu,%d,%llu,%llu,%llu,%.3f,%llu,%.2f,%.2f,%.0f\n",
+                r->use_bpx ? "bpx" : "file", r->warehouses, r->pool_mb,
+                r->use_bpx ? r->bpx_mb : 0, r->transactions,
+                (unsigned long long)r->accesses, (unsigned long long)r->pool_misses,
+                (unsigned long long)r->bpx_hits,
+                r->pool_misses ? (double)r->bpx_hits / r->pool_misses : 0.0,
+                (unsigned long long)r->file_reads,
+                r->read_stats.mean / 1000.0, r->read_stats.p99 / 1000.0, r->tps);
+    }
+
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    int warehouses = argc > 1 ? atoi(argv[1]) : DEFAULT_WAREHOUSES;
+    size_t pool_mb = argc > 2 ? strtoul(argv[2], NULL, 0) : DEFAULT_POOL_MB;
+    size_t bpx_mb = argc > 3 ? strtoul(argv[3], NULL, 0) : DEFAULT_BPX_MB;
+    int transactions = argc > 4 ? atoi(argv[4]) : DEFAULT_TRANSACTIONS;
+
+    if (warehouses <= 0 || (pool_mb << 20) / STORE_PAGE_SIZE <= MAX_ACCESSES ||
+        bpx_mb == 0 || transactions <= 0) {
+        fprintf(stderr, "Usage: %s [warehouses] [pool_mb] [bpx_mb] [transactions]\n", argv[0]);
+        return 1;
+    }
+
+    tpcc_t db;
+    tpcc_init(&db, warehouses);
+    printf("=== UPMEM BUFFER POOL EXTENSION BENCHMARK ===\n");
+    printf("TPC-C-like trace: %d warehouses, %.0f MB in %s, %d transactions\n",
+           warehouses, db.total_blocks * STORE_PAGE_SIZE / 1048576.0, DATA_FILE, transactions);
+    printf("Buffer pool: %zu MB, extension: %zu MB\n", pool_mb, bpx_mb);
+    for (int t = 0; t < NR_TABLES; t++) {
+        printf("  %-10s %8llu blocks\n", table_names[t], (unsigned long long)db.blocks[t]);
+    }
+    printf("\n");
+
+    bpx_result_t results[2];
+    results[0] = run_benchmark(0, warehouses, pool_mb, bpx_mb, transactions);
+    print_result(&results[0]);
+    results[1] = run_benchmark(1, warehouses, pool_mb, bpx_mb, transactions);
+    print_result(&results[1]);
+
+    printf("=== SUMMARY ===\n");
+    printf("Extension hit rate: %.1f%%\n", 100.0 * results[1].bpx_hits / results[1].pool_misses);
+    printf("Miss latency:       %.2fx (extension / file)\n",
+           (double)results[1].read_stats.mean / results[0].read_stats.mean);
+    printf("Throughput:         %.2fx\n", results[1].tps / results[0].tps);
+
+    save_results_csv(results, 2, "bpx_results.csv");
+    printf("\n✓ Results saved to bpx_results.csv\n");
+
+    return (results[0].verified && results[1].verified) ? 0 : 1;
+}
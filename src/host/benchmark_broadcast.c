@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "swap_store.h"
+
+/*
+ * Replicated payloads: the same bytes written to the shared_area of every
+ * DPU (swap_store_broadcast), with one dpu_broadcast_to per DPU set
+ * against the same buffer prepared for each DPU and pushed, for 1 to 64
+ * DPUs and for all_dpus (every rank of the machine with the SDK).
+ *
+ * Payloads: a configuration block, a reference page and a full
+ * shared_area (dictionary-sized). Each write is checked on the first,
+ * middle and last DPU. Without the SDK both paths are host copies.
+ *
+ * Usage: benchmark_broadcast [all_dpus] [reps]
+ */
+
+#define MRAM_SIZE (1024 * 1024)
+
+static const uint32_t dpu_counts[] = {1, 2, 4, 8, 16, 32, 64};
+static const uint32_t payload_sizes[] = {64, STORE_PAGE_SIZE, STORE_SHARED_SIZE};
+
+#define NR_COUNTS (sizeof(dpu_counts) / sizeof(dpu_counts[0]))
+#define NR_SIZES (sizeof(payload_sizes) / sizeof(payload_sizes[0]))
+
+typedef struct {
+    uint32_t nr_dpus;
+    uint32_t size;
+    int broadcast;
+    double us_per_op;
+    double gbps;                    /* bytes landed on DPUs per second */
+    double calls_per_op;            /* transfer calls per swap_store_broadcast */
+    int ok;
+} broadcast_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int check_dpu(swap_store_t* store, uint32_t d, const uint8_t* expected, uint32_t size) {
+    static uint8_t back[STORE_SHARED_SIZE];
+    return swap_store_read_shared(store, d, 0, back, size) == 0 &&
+           memcmp(back, expected, size) == 0;
+}
+
+static int run_config(uint32_t nr_dpus, uint32_t size, int broadcast, uint32_t reps,
+                      broadcast_result_t* r) {
+    static uint8_t payload[STORE_SHARED_SIZE];
+    swap_store_config_t cfg;
+    swap_store_t store;
+    struct timespec t0, t1;
+
+    memset(r, 0, sizeof(*r));
+    r->nr_dpus = nr_dpus;
+    r->size = size;
+    r->broadcast = broadcast;
+
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.mram_size = MRAM_SIZE;
+    cfg.max_pages = 64;
+    cfg.broadcast_xfer = broadcast;
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        return -1;
+    }
+    r->ok = 1;
+
+    uint64_t calls = store.stats.broadcasts + store.stats.pushes;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t k = 0; k < reps; k++) {
+        memset(payload, (int)(k + 1), size);
+        if (swap_store_broadcast(&store, 0, payload, size) != 0) {
+            r->ok = 0;
+            break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    calls = store.stats.broadcasts + store.stats.pushes - calls;
+
+    double ns = (double)timespec_to_ns(diff_time(t0, t1));
+    r->us_per_op = ns / reps / 1e3;
+    r->gbps = ns > 0 ? (double)store.stats.replicated_bytes / ns : 0.0;
+    r->calls_per_op = (double)calls / reps;
+
+    uint32_t n = store.nr_dpus;
+    if (r->ok && (!check_dpu(&store, 0, payload, size) ||
+                  !check_dpu(&store, n / 2, payload, size) ||
+                  !check_dpu(&store, n - 1, payload, size))) {
+        r->ok = 0;
+    }
+    if (store.stats.errors > 0) r->ok = 0;
+    swap_store_free(&store);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t all_dpus = argc > 1 ? strtoul(argv[1], NULL, 0) : 512;
+    uint32_t reps = argc > 2 ? strtoul(argv[2], NULL, 0) : 200;
+    broadcast_result_t results[(NR_COUNTS + 1) * NR_SIZES * 2];
+    size_t nr_results = 0;
+    int ok = 1;
+
+    if (all_dpus == 0 || reps == 0) {
+        fprintf(stderr, "Usage: %s [all_dpus] [reps]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== UPMEM BROADCAST TRANSFER BENCHMARK ===\n");
+    printf("Payloads: %u, %u, %u bytes, %u writes each\n\n", payload_sizes[0],
+           payload_sizes[1], payload_sizes[2], reps);
+
+    printf("%6s %8s %-10s %10s %10s %8s\n", "DPUs", "bytes", "xfer", "us/op", "GB/s", "calls");
+    for (size_t c = 0; c <= NR_COUNTS; c++) {
+        uint32_t nr_dpus = c < NR_COUNTS ? dpu_counts[c] : all_dpus;
+        for (size_t s = 0; s < NR_SIZES; s++) {
+            for (int broadcast = 0; broadcast < 2; broadcast++) {
+                broadcast_result_t* r = &results[nr_results++];
+                if (run_config(nr_dpus, payload_sizes[s], broadcast, reps, r) != 0) {
+                    r->ok = 0;
+                }
+                printf("%6u %8u %-10s %10.2f %10.2f %8.1f %s\n", nr_dpus, r->size,
+                       broadcast ? "broadcast" : "per-dpu", r->us_per_op, r->gbps,
+                       r->calls_per_op, r->ok ? "✓ OK" : "✗ FAIL");
+                ok &= r->ok;
+            }
+            const broadcast_result_t* b = &results[nr_results - 1];
+            if (b->us_per_op > 0) {
+                printf("%6s %8s speedup %.2fx\n", "", "", results[nr_results - 2].us_per_op /
+                       b->us_per_op);
+            }
+        }
+    }
+
+    FILE* f = fopen("broadcast_results.csv", "w");
+    if (f) {
+        fprintf(f, "xfer,nr_dpus,bytes,reps,us_per_op,gbps,calls_per_op,ok\n");
+        for (size_t i = 0; i < nr_results; i++) {
+            const broadcast_result_t* r = &results[i];
+            fprintf(f, "%s,%u,%u,%u,%.3f,%.3f,%.2f,%d\n", r->broadcast ? "broadcast" : "per-dpu",
+                    r->nr_dpus, r->size, reps, r->us_per_op, r->gbps, r->calls_per_op, r->ok);
+        }
+        fclose(f);
+        printf("\n✓ Results saved to broadcast_results.csv\n");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+
+/*
+ * Checkpoint/restore: GB/s of saving a memory region into the DPU tier
+ * and restoring it, against writing the same region to a local file and
+ * reading it back (fsync'd, page cache dropped).
+ *
+ *  - save, serial: checksums computed inline before the pushes
+ *  - save, pipelined: worker threads checksum ahead of the pushes
+ *  - restore, eager: every chunk pulled, verified behind the pulls
+ *  - restore, lazy: the region is usable at once; one chunk in eight is
+ *    touched (each touch pulls its chunk), then the rest is completed
+ *
+ * Every restore is compared with the original region and the manifest
+ * goes through a file on the way. Without the SDK the pushes are host
+ * copies, so the numbers show the pipeline's own overhead.
+ *
+ * Usage: benchmark_checkpoint [region_mb] [nr_dpus]
+ */
+
+#define MRAM_SIZE (4 * 1024 * 1024)
+#define NR_WORKERS 2
+#define LAZY_TOUCH_EVERY 8
+#define MANIFEST_FILE "checkpoint_bench.manifest"
+#define DATA_FILE "checkpoint_bench.data"
+
+enum { RUN_SAVE_SERIAL, RUN_SAVE, RUN_RESTORE, RUN_LAZY, RUN_FILE_WRITE, RUN_FILE_READ, NR_RUNS };
+
+static const char* run_names[NR_RUNS] = {"save-serial",  "save",       "restore",
+                                         "restore-lazy", "file-write", "file-read"};
+
+typedef struct {
+    double seconds;
+    double gb_s;
+    int ok;
+    int skipped;
+} ckpt_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static double seconds_since(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_to_ns(diff_time(start, now)) / 1e9;
+}
+
+static void set_result(ckpt_result_t* r, double seconds, size_t size, int ok) {
+    r->seconds = seconds;
+    r->gb_s = seconds > 0 ? size / seconds / 1e9 : 0.0;
+    r->ok = ok;
+}
+
+/* Incompressible, position-dependent content */
+static void fill_region(uint8_t* region, size_t size) {
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    size_t i = 0;
+
+    for (; i + sizeof(x) <= size; i += sizeof(x)) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        memcpy(region + i, &x, sizeof(x));
+    }
+    for (; i < size; i++) {
+        region[i] = (uint8_t)i;
+    }
+}
+
+/* Smallest rank decides the stripe; room for every chunk plus one */
+static uint32_t huge_mram_for(size_t size, uint32_t nr_dpus) {
+    uint32_t nr_ranks = (nr_dpus + STORE_DPUS_PER_RANK - 1) / STORE_DPUS_PER_RANK;
+    uint32_t smallest = nr_dpus % STORE_DPUS_PER_RANK ? nr_dpus % STORE_DPUS_PER_RANK
+                                                      : STORE_DPUS_PER_RANK;
+    uint32_t stripe_dpus = 1;
+    uint64_t chunks = (size + CKPT_CHUNK_SIZE - 1) / CKPT_CHUNK_SIZE;
+    uint64_t bytes;
+
+    while (2 * stripe_dpus <= smallest) {
+        stripe_dpus *= 2;
+    }
+    bytes = ((chunks + nr_ranks - 1) / nr_ranks + 1) * (CKPT_CHUNK_SIZE / stripe_dpus);
+    return bytes > STORE_HUGE_AREA_SIZE ? 0 : (uint32_t)bytes;
+}
+
+static int open_store(swap_store_t* store, uint32_t nr_dpus, uint32_t huge_mram) {
+    swap_store_config_t cfg;
+
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.mram_size = MRAM_SIZE;
+    cfg.huge_mram_size = huge_mram;
+    if (swap_store_init(store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* ========================================================================
+ * DPU tier
+ * ======================================================================== */
+
+static int run_save(const uint8_t* region, size_t size, uint32_t nr_dpus, uint32_t huge_mram,
+                    int nr_workers, ckpt_result_t* r) {
+    swap_store_t store;
+    ckpt_manifest_t m;
+    struct timespec t0;
+    int ret;
+
+    if (open_store(&store, nr_dpus, huge_mram) != 0) {
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ret = ckpt_save(&store, region, size, 0, nr_workers, &m, NULL);
+    set_result(r, seconds_since(t0), size, ret == 0);
+    if (ret == 0) ckpt_manifest_free(&m);
+    swap_store_free(&store);
+    return 0;
+}
+
+/* Save, then restore eagerly and lazily from the manifest file */
+static int run_restores(const uint8_t* region, size_t size, uint32_t nr_dpus, uint32_t huge_mram,
+                        ckpt_result_t* eager, ckpt_result_t* lazy_r, double* first_touch_us) {
+    swap_store_t store;
+    ckpt_manifest_t saved, m;
+    ckpt_lazy_t lazy;
+    ckpt_stats_t stats;
+    struct timespec t0;
+    uint8_t* dst;
+    int ret;
+
+    dst = malloc(size);
+    if (!dst || open_store(&store, nr_dpus, huge_mram) != 0) {
+        free(dst);
+        return -1;
+    }
+    if (ckpt_save(&store, region, size, 0, NR_WORKERS, &saved, NULL) != 0) {
+        swap_store_free(&store);
+        free(dst);
+        return -1;
+    }
+    ret = ckpt_manifest_write(&saved, MANIFEST_FILE);
+    ckpt_manifest_free(&saved);
+    if (ret == 0) ret = ckpt_manifest_read(&m, MANIFEST_FILE);
+    unlink(MANIFEST_FILE);
+    if (ret != 0) {
+        swap_store_free(&store);
+        free(dst);
+        return -1;
+    }
+
+    memset(dst, 0, size);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ret = ckpt_restore(&store, &m, dst, NR_WORKERS, &stats);
+    set_result(eager, seconds_since(t0), size, ret == 0 && memcmp(dst, region, size) == 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (ckpt_lazy_start(&lazy, &store, &m) != 0) {
+        lazy_r->skipped = 1;
+    } else {
+        volatile uint8_t sink = 0;
+        double start_s = seconds_since(t0);
+        struct timespec t1;
+
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        sink ^= lazy.base[0];
+        *first_touch_us = seconds_since(t1) * 1e6;
+        for (uint32_t c = LAZY_TOUCH_EVERY; c < m.nr_chunks; c += LAZY_TOUCH_EVERY) {
+            sink ^= lazy.base[(size_t)c * CKPT_CHUNK_SIZE];
+        }
+        (void)sink;
+        ret = ckpt_lazy_complete(&lazy);
+        set_result(lazy_r, seconds_since(t0), size,
+                   ret == 0 && memcmp(lazy.base, region, size) == 0);
+        printf("lazy: usable after %.3f ms, %llu chunks faulted, %llu prefilled\n",
+               start_s * 1e3, (unsigned long long)lazy.stats.faults,
+               (unsigned long long)lazy.stats.prefilled);
+        ckpt_lazy_free(&lazy);
+    }
+
+    ckpt_manifest_free(&m);
+    swap_store_free(&store);
+    free(dst);
+    return 0;
+}
+
+/* ========================================================================
+ * Local file
+ * ======================================================================== */
+
+static int run_file(const uint8_t* region, size_t size, ckpt_result_t* wr, ckpt_result_t* rd) {
+    uint8_t* dst = malloc(size);
+    struct timespec t0;
+    FILE* f;
+    int fd, ok;
+
+    if (!dst) {
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    f = fopen(DATA_FILE, "wb");
+    if (!f) {
+        fprintf(stderr, "Cannot create %s\n", DATA_FILE);
+        free(dst);
+        return -1;
+    }
+    ok = fwrite(region, 1, size, f) == size;
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) ok = 0;
+    fclose(f);
+    set_result(wr, seconds_since(t0), size, ok);
+
+    /* Read from the device, not the page cache */
+    fd = open(DATA_FILE, O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+    memset(dst, 0, size);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    f = fopen(DATA_FILE, "rb");
+    ok = f && fread(dst, 1, size, f) == size;
+    if (f) fclose(f);
+    set_result(rd, seconds_since(t0), size, ok && memcmp(dst, region, size) == 0);
+
+    unlink(DATA_FILE);
+    free(dst);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    size_t region_mb = argc > 1 ? strtoul(argv[1], NULL, 0) : 256;
+    uint32_t nr_dpus = argc > 2 ? strtoul(argv[2], NULL, 0) : 64;
+    size_t size = region_mb << 20;
+    ckpt_result_t results[NR_RUNS];
+    double first_touch_us = 0.0;
+    uint32_t huge_mram;
+    uint8_t* region;
+    int ok = 1;
+
+    if (region_mb == 0 || nr_dpus == 0) {
+        fprintf(stderr, "Usage: %s [region_mb] [nr_dpus]\n", argv[0]);
+        return 1;
+    }
+    huge_mram = huge_mram_for(size, nr_dpus);
+    if (huge_mram == 0) {
+        fprintf(stderr, "%zu MB do not fit in the huge page area of %u DPUs\n", region_mb,
+                nr_dpus);
+        return 1;
+    }
+    region = malloc(size);
+    if (!region) {
+        fprintf(stderr, "Failed to allocate %zu MB\n", region_mb);
+        return 1;
+    }
+    fill_region(region, size);
+    memset(results, 0, sizeof(results));
+
+    printf("=== UPMEM CHECKPOINT/RESTORE BENCHMARK ===\n");
+    printf("Region: %zu MB in %zu chunks of 2MB, DPUs: %u (%u KB of huge pages each), "
+           "%d workers\n\n", region_mb, (size + CKPT_CHUNK_SIZE - 1) / CKPT_CHUNK_SIZE, nr_dpus,
+           huge_mram >> 10, NR_WORKERS);
+
+    if (run_save(region, size, nr_dpus, huge_mram, 0, &results[RUN_SAVE_SERIAL]) != 0 ||
+        run_save(region, size, nr_dpus, huge_mram, NR_WORKERS, &results[RUN_SAVE]) != 0 ||
+        run_restores(region, size, nr_dpus, huge_mram, &results[RUN_RESTORE],
+                     &results[RUN_LAZY], &first_touch_us) != 0 ||
+        run_file(region, size, &results[RUN_FILE_WRITE], &results[RUN_FILE_READ]) != 0) {
+        fprintf(stderr, "Benchmark setup failed\n");
+        free(region);
+        return 1;
+    }
+    if (!results[RUN_LAZY].skipped) {
+        printf("lazy: first touch served in %.1f us\n", first_touch_us);
+    }
+
+    printf("\n%-13s %10s %10s\n", "run", "seconds", "GB/s");
+    for (int i = 0; i < NR_RUNS; i++) {
+        const ckpt_result_t* r = &results[i];
+        if (r->skipped) {
+            printf("%-13s %10s %10s (no userfaultfd)\n", run_names[i], "-", "-");
+            continue;
+        }
+        printf("%-13s %10.3f %10.2f %s\n", run_names[i], r->seconds, r->gb_s,
+               r->ok ? "✓ OK" : "✗ FAIL");
+        ok &= r->ok;
+    }
+    if (results[RUN_SAVE].seconds > 0 && results[RUN_RESTORE].seconds > 0) {
+        printf("\nDPU tier vs file: save %.2fx, restore %.2fx\n",
+               results[RUN_FILE_WRITE].seconds / results[RUN_SAVE].seconds,
+               results[RUN_FILE_READ].seconds / results[RUN_RESTORE].seconds);
+    }
+
+    FILE* f = fopen("checkpoint_results.csv", "w");
+    if (f) {
+        fprintf(f, "run,region_mb,nr_dpus,workers,seconds,gb_s,ok\n");
+        for (int i = 0; i < NR_RUNS; i++) {
+            const ckpt_result_t* r = &results[i];
+            if (r->skipped) continue;
+            fprintf(f, "%s,%zu,%u,%d,%.6f,%.3f,%d\n", run_names[i], region_mb, nr_dpus,
+                    i == RUN_SAVE || i == RUN_RESTORE ? NR_WORKERS : 0, r->seconds, r->gb_s, r->ok);
+        }
+        fclose(f);
+        printf("\n✓ Results saved to checkpoint_results.csv\n");
+    }
+    free(region);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "swap_store.h"
+
+/*
+ * MRAM compaction: the store is filled with pages of mixed compressed
+ * sizes, half of them are invalidated at random, then idle compaction runs
+ * in calls bounded by the latency budget until nothing can move.
+ *
+ * Usage: benchmark_compaction [nr_dpus] [mram_kb_per_dpu] [budget_us]
+ */
+
+#define DEFAULT_MRAM_KB 2048
+#define BATCH_PAGES 64
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/* Random head, zero tail: compresses to roughly the head length */
+static void fill_page(uint8_t* page, size_t index) {
+    unsigned seed = (unsigned)index * 2654435761U;
+    size_t head = (rand_r(&seed) % STORE_NR_CLASSES) * STORE_CLASS_SIZE + 200;
+
+    if (head > STORE_PAGE_SIZE) head = STORE_PAGE_SIZE;
+    for (size_t i = 0; i < head; i++) {
+        page[i] = (uint8_t)rand_r(&seed);
+    }
+    memset(page + head, 0, STORE_PAGE_SIZE - head);
+}
+
+/* Full-page slots the allocator could hand out right now */
+static uint64_t full_slots(const swap_store_t* store) {
+    uint64_t free_bytes = (uint64_t)store->nr_dpus * store->cfg.mram_size -
+                          swap_store_mram_used(store);
+    return (uint64_t)((1.0 - swap_store_fragmentation(store)) * free_bytes) / STORE_PAGE_SIZE;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t nr_dpus = argc > 1 ? strtoul(argv[1], NULL, 0) : 8;
+    uint32_t mram_kb = argc > 2 ? strtoul(argv[2], NULL, 0) : DEFAULT_MRAM_KB;
+    uint32_t budget_us = argc > 3 ? strtoul(argv[3], NULL, 0) : 1000;
+
+    swap_store_config_t cfg;
+    swap_store_t store;
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.mram_size = mram_kb * 1024;
+    cfg.compress = 1;
+    cfg.compact_budget_us = budget_us;
+    /* At most one page per 512B slot */
+    cfg.max_pages = (uint32_t)((uint64_t)cfg.mram_size * nr_dpus / STORE_CLASS_SIZE);
+
+    printf("=== UPMEM MRAM COMPACTION BENCHMARK ===\n");
+    printf("DPUs: %u, MRAM: %u KB per DPU, budget: %u µs\n\n", nr_dpus, mram_kb, budget_us);
+
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        return 1;
+    }
+    uint64_t capacity = (uint64_t)store.nr_dpus * cfg.mram_size;
+    uint8_t* pages = malloc((size_t)cfg.max_pages * STORE_PAGE_SIZE);
+    if (!pages) {
+        fprintf(stderr, "Failed to allocate %u pages\n", cfg.max_pages);
+        return 1;
+    }
+
+    /* Fill to 90% */
+    size_t nr_pages = 0;
+    while (swap_store_mram_used(&store) < capacity * 9 / 10 && nr_pages + BATCH_PAGES <= cfg.max_pages) {
+        const uint8_t* src[BATCH_PAGES];
+        uint64_t ids[BATCH_PAGES];
+        for (size_t i = 0; i < BATCH_PAGES; i++) {
+            ids[i] = nr_pages + i;
+            src[i] = pages + (nr_pages + i) * STORE_PAGE_SIZE;
+            fill_page(pages + (nr_pages + i) * STORE_PAGE_SIZE, nr_pages + i);
+        }
+        if (swap_store_put_batch(&store, ids, src, BATCH_PAGES) != 0) break;
+        nr_pages += BATCH_PAGES;
+    }
+
+    /* Free half of them at random */
+    uint8_t* live = malloc(nr_pages);
+    unsigned seed = 42;
+    size_t nr_live = 0;
+    for (size_t i = 0; i < nr_pages; i++) {
+        live[i] = rand_r(&seed) % 2;
+        if (!live[i]) swap_store_invalidate(&store, i);
+        else nr_live++;
+    }
+
+    double frag_before = swap_store_fragmentation(&store);
+    uint64_t slots_before = full_slots(&store);
+    uint64_t used = swap_store_mram_used(&store);
+
+    /* Idle windows: one bounded call each */
+    long max_call_ns = 0, total_ns = 0;
+    int calls = 0, moved;
+    for (;;) {
+        struct timespec t_start, t_end;
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        moved = swap_store_compact(&store);
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        long ns = timespec_to_ns(diff_time(t_start, t_end));
+        total_ns += ns;
+        if (ns > max_call_ns) max_call_ns = ns;
+        calls++;
+        if (moved <= 0) break;
+    }
+
+    double frag_after = swap_store_fragmentation(&store);
+    uint64_t slots_after = full_slots(&store);
+
+    /* Every live page must still read back */
+    int ok = moved == 0;
+    uint8_t page[STORE_PAGE_SIZE];
+    for (size_t i = 0; i < nr_pages && ok; i++) {
+        if (!live[i]) continue;
+        if (swap_store_get(&store, i, page) != 0 ||
+            memcmp(page, pages + i * STORE_PAGE_SIZE, STORE_PAGE_SIZE) != 0) {
+            ok = 0;
+        }
+    }
+
+    const swap_store_stats_t* s = &store.stats;
+    double mb_s = s->compact_ns ? (s->compact_bytes / (1024.0 * 1024.0)) / (s->compact_ns / 1e9) : 0.0;
+
+    printf("Live pages:       %zu of %zu, %llu bytes of MRAM slots\n",
+           nr_live, nr_pages, (unsigned long long)used);
+    printf("Fragmentation:    %.1f%% -> %.1f%% of free MRAM unusable for a full page\n",
+           frag_before * 100.0, frag_after * 100.0);
+    printf("Full-page slots:  %llu -> %llu\n",
+           (unsigned long long)slots_before, (unsigned long long)slots_after);
+    printf("Moves:            %llu records, %llu bytes in %llu launches\n",
+           (unsigned long long)s->compact_moves, (unsigned long long)s->compact_bytes,
+           (unsigned long long)s->compact_rounds);
+    printf("Throughput:       %.1f MB/s moved (kernel time %.2f ms)\n",
+           mb_s, s->compact_ns / 1e6);
+    printf("Calls:            %d, total %.2f ms, longest %.2f ms (budget %.2f ms)\n",
+           calls, total_ns / 1e6, max_call_ns / 1e6, budget_us / 1e3);
+    printf("Verification:     %s\n", ok ? "✓ OK" : "✗ FAIL");
+
+    FILE* f = fopen("compaction_results.csv", "w");
+    if (f) {
+        fprintf(f, "nr_dpus,mram_kb,live_pages,frag_before,frag_after,full_slots_before,full_slots_after,moves,moved_bytes,launches,throughput_mb_s,calls,max_call_us,budget_us\n");
+        fprintf(f, "%u,%u,%zu,%.4f,%.4f,%llu,%llu,%llu,%llu,%llu,%.1f,%d,%.1f,%u\n",
+                store.nr_dpus, mram_kb, nr_live, frag_before, frag_after,
+                (unsigned long long)slots_before, (unsigned long long)slots_after,
+                (unsigned long long)s->compact_moves, (unsigned long long)s->compact_bytes,
+                (unsigned long long)s->compact_rounds, mb_s, calls,
+                max_call_ns / 1e3, budget_us);
+        fclose(f);
+        printf("\n✓ Results saved to compaction_results.csv\n");
+    }
+
+    swap_store_free(&store);
+    free(live);
+    free(pages);
+    return ok ? 0 : 1;
+}
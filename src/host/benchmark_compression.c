@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "swap_store.h"
+
+/*
+ * Compressed vs uncompressed put/get through the page store.
+ *
+ * Pages are a mix of the content found in real swap: zero pages, text,
+ * small integers in structs and incompressible data.
+ *
+ * Usage: benchmark_compression [nr_pages] [nr_dpus] [nr_workers]
+ */
+
+#define DEFAULT_PAGES 4096
+#define BATCH_PAGES 64
+
+typedef struct {
+    long min, max, mean, stddev, p99;
+} stats_t;
+
+typedef struct {
+    int compress;
+    uint32_t nr_dpus;
+    int nr_workers;
+    size_t nr_pages;
+    swap_store_stats_t store;
+    uint64_t mram_bytes;
+    stats_t put_stats;      /* per page, ns */
+    stats_t get_stats;
+    int verified;
+} compression_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+stats_t calculate_stats(long* latencies, int n) {
+    stats_t s;
+    s.min = latencies[0];
+    s.max = latencies[0];
+    long sum = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (latencies[i] < s.min) s.min = latencies[i];
+        if (latencies[i] > s.max) s.max = latencies[i];
+        sum += latencies[i];
+    }
+    s.mean = sum / n;
+
+    long variance_sum = 0;
+    for (int i = 0; i < n; i++) {
+        long diff = latencies[i] - s.mean;
+        variance_sum += diff * diff;
+    }
+    s.stddev = (long)sqrt(variance_sum / n);
+
+    qsort(latencies, n, sizeof(long), cmp_long);
+    s.p99 = latencies[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1];
+
+    return s;
+}
+
+/* Fill a page with swap-like content, chosen by page index */
+static void fill_page(uint8_t* page, size_t index) {
+    static const char* words[] = {"swap ", "page ", "memory ", "tier ", "dpu ", "rank ", "host "};
+    unsigned seed = (unsigned)index * 2654435761U;
+
+    switch (index % 10) {
+    case 0:
+        memset(page, 0, STORE_PAGE_SIZE);
+        break;
+    case 1: case 2: case 3: case 4: {
+        /* Text */
+        size_t off = 0;
+        while (off < STORE_PAGE_SIZE) {
+            const char* w = words[rand_r(&seed) % 7];
+            size_t len = strlen(w);
+            if (off + len > STORE_PAGE_SIZE) len = STORE_PAGE_SIZE - off;
+            memcpy(page + off, w, len);
+            off += len;
+        }
+        break;
+    }
+    case 5: case 6: case 7: {
+        /* Array of structs: id, small counter, pointer-like value */
+        uint32_t* words32 = (uint32_t*)page;
+        for (size_t i = 0; i < STORE_PAGE_SIZE / 16; i++) {
+            words32[i * 4 + 0] = (uint32_t)(index * 256 + i);
+            words32[i * 4 + 1] = rand_r(&seed) % 16;
+            words32[i * 4 + 2] = 0x7f00a000 + (uint32_t)i * 64;
+            words32[i * 4 + 3] = 0;
+        }
+        break;
+    }
+    default:
+        /* Incompressible */
+        for (size_t i = 0; i < STORE_PAGE_SIZE; i++) {
+            page[i] = (uint8_t)rand_r(&seed);
+        }
+        break;
+    }
+}
+
+compression_result_t run_benchmark(int compress, uint32_t nr_dpus, int nr_workers,
+                                   uint8_t* pages, size_t nr_pages) {
+    compression_result_t result = {0};
+    swap_store_config_t cfg;
+    swap_store_t store;
+
+    result.compress = compress;
+    result.nr_dpus = nr_dpus;
+    result.nr_workers = nr_workers;
+    result.nr_pages = nr_pages;
+
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.compress = compress;
+    cfg.nr_workers = nr_workers;
+    cfg.max_pages = nr_pages;
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        exit(1);
+    }
+
+    int nr_batches = (int)((nr_pages + BATCH_PAGES - 1) / BATCH_PAGES);
+    long* put_latencies = malloc(nr_batches * sizeof(long));
+    long* get_latencies = malloc(nr_batches * sizeof(long));
+    uint8_t* readback = malloc(nr_pages * STORE_PAGE_SIZE);
+    const uint8_t* src[BATCH_PAGES];
+    uint8_t* dst[BATCH_PAGES];
+    uint64_t ids[BATCH_PAGES];
+
+    for (int b = 0; b < nr_batches; b++) {
+        size_t first = (size_t)b * BATCH_PAGES;
+        size_t n = nr_pages - first < BATCH_PAGES ? nr_pages - first : BATCH_PAGES;
+        struct timespec t_start, t_end;
+
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = first + i;
+            src[i] = pages + (first + i) * STORE_PAGE_SIZE;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        swap_store_put_batch(&store, ids, src, n);
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        put_latencies[b] = timespec_to_ns(diff_time(t_start, t_end)) / (long)n;
+    }
+
+    for (int b = 0; b < nr_batches; b++) {
+        size_t first = (size_t)b * BATCH_PAGES;
+        size_t n = nr_pages - first < BATCH_PAGES ? nr_pages - first : BATCH_PAGES;
+        struct timespec t_start, t_end;
+
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = first + i;
+            dst[i] = readback + (first + i) * STORE_PAGE_SIZE;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        swap_store_get_batch(&store, ids, dst, n);
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        get_latencies[b] = timespec_to_ns(diff_time(t_start, t_end)) / (long)n;
+    }
+
+    result.verified = memcmp(pages, readback, nr_pages * STORE_PAGE_SIZE) == 0;
+    result.store = store.stats;
+    result.mram_bytes = swap_store_mram_used(&store);
+    result.put_stats = calculate_stats(put_latencies, nr_batches);
+    result.get_stats = calculate_stats(get_latencies, nr_batches);
+
+    free(put_latencies);
+    free(get_latencies);
+    free(readback);
+    swap_store_free(&store);
+    return result;
+}
+
+void print_result(const compression_result_t* r) {
+    const swap_store_stats_t* s = &r->store;
+
+    printf("%s:\n", r->compress ? "COMPRESSED" : "UNCOMPRESSED");
+    printf("  Pages:        %llu zero, %llu compressed, %llu raw\n",
+           (unsigned long long)s->zero_pages, (unsigned long long)s->compressed_pages,
+           (unsigned long long)s->raw_pages);
+    printf("  Ratio:        %.2fx (%llu -> %llu bytes)\n",
+           s->record_bytes ? (double)s->page_bytes / s->record_bytes : 0.0,
+           (unsigned long long)s->page_bytes, (unsigned long long)s->record_bytes);
+    printf("  Bus bytes:    %llu to DPU, %llu from DPU\n",
+           (unsigned long long)s->bus_bytes_to_dpu, (unsigned long long)s->bus_bytes_from_dpu);
+    printf("  MRAM slots:   %llu bytes\n", (unsigned long long)r->mram_bytes);
+    printf("  Put / page:   mean %.2f µs, p99 %.2f µs\n",
+           r->put_stats.mean / 1000.0, r->put_stats.p99 / 1000.0);
+    printf("  Get / page:   mean %.2f µs, p99 %.2f µs\n",
+           r->get_stats.mean / 1000.0, r->get_stats.p99 / 1000.0);
+    printf("  Verification: %s\n\n", r->verified ? "✓ OK" : "✗ FAIL");
+}
+
+void save_results_csv(compression_result_t* results, int count, const char* filename) {
+    FILE* f = fopen(filename, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", filename);
+        return;
+    }
+    fprintf(f, "mode,nr_dpus,nr_workers,nr_pages,compression_ratio,page_bytes,bus_bytes_to_dpu,bus_bytes_from_dpu,mram_bytes,put_mean_us,put_p99_us,get_mean_us,get_p99_us\n");
+
+    for (int i = 0; i < count; i++) {
+        compression_result_t* r = &results[i];
+        fprintf(f, "%s,%u,%d,%zu,%.3f,%llu,%llu,%llu,%llu,%.2f,%.2f,%.2f,%.2f\n",
+                r->compress ? "compressed" : "uncompressed",
+                r->nr_dpus, r->nr_workers, r->nr_pages,
+                r->store.record_bytes ? (double)r->store.page_bytes / r->store.record_bytes : 0.0,
+                (unsigned long long)r->store.page_bytes,
+                (unsigned long long)r->store.bus_bytes_to_dpu,
+                (unsigned long long)r->store.bus_bytes_from_dpu,
+                (unsigned long long)r->mram_bytes,
+                r->put_stats.mean / 1000.0, r->put_stats.p99 / 1000.0,
+                r->get_stats.mean / 1000.0, r->get_stats.p99 / 1000.0);
+    }
+
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    size_t nr_pages = argc > 1 ? strtoul(argv[1], NULL, 0) : DEFAULT_PAGES;
+    uint32_t nr_dpus = argc > 2 ? strtoul(argv[2], NULL, 0) : 8;
+    int nr_workers = argc > 3 ? atoi(argv[3]) : 4;
+
+    printf("=== UPMEM PAGE COMPRESSION BENCHMARK ===\n");
+    printf("Pages: %zu x %d bytes, DPUs: %u, workers: %d, batch: %d\n\n",
+           nr_pages, STORE_PAGE_SIZE, nr_dpus, nr_workers, BATCH_PAGES);
+
+    uint8_t* pages = malloc(nr_pages * STORE_PAGE_SIZE);
+    if (!pages) {
+        fprintf(stderr, "Failed to allocate %zu pages\n", nr_pages);
+        return 1;
+    }
+    for (size_t i = 0; i < nr_pages; i++) {
+        fill_page(pages + i * STORE_PAGE_SIZE, i);
+    }
+
+    compression_result_t results[2];
+    results[0] = run_benchmark(0, nr_dpus, nr_workers, pages, nr_pages);
+    print_result(&results[0]);
+    results[1] = run_benchmark(1, nr_dpus, nr_workers, pages, nr_pages);
+    print_result(&results[1]);
+
+    printf("=== SUMMARY ===\n");
+    printf("Bus bytes saved: %.1f%%\n",
+           100.0 * (1.0 - (double)results[1].store.bus_bytes_to_dpu /
+                          results[0].store.bus_bytes_to_dpu));
+    printf("Put latency:     %.2fx, get latency: %.2fx (compressed / uncompressed)\n",
+           (double)results[1].put_stats.mean / results[0].put_stats.mean,
+           (double)results[1].get_stats.mean / results[0].get_stats.mean);
+
+    save_results_csv(results, 2, "compression_results.csv");
+    printf("\n✓ Results saved to compression_results.csv\n");
+
+    free(pages);
+    return (results[0].verified && results[1].verified) ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "swap_store.h"
+
+/*
+ * Delta puts of re-evicted pages.
+ *
+ * Every round swaps all pages in, dirties some of their cache lines and
+ * swaps them out again, with and without delta puts. Page i % 4 decides
+ * how dirty it gets: clean, 1 line, 4 lines or 32 lines (too many for a
+ * delta at the default threshold).
+ *
+ * Usage: benchmark_delta [nr_pages] [nr_dpus] [rounds]
+ */
+
+#define DEFAULT_PAGES 4096
+#define DEFAULT_ROUNDS 4
+#define BATCH_PAGES 64
+
+typedef struct {
+    long min, max, mean, stddev, p99;
+} stats_t;
+
+typedef struct {
+    int delta;
+    uint32_t nr_dpus;
+    size_t nr_pages;
+    int rounds;
+    swap_store_stats_t store;
+    uint64_t reput_bus_bytes;       /* to DPU, re-eviction rounds only */
+    stats_t put_stats;              /* per page, ns, re-eviction rounds */
+    int verified;
+} delta_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+stats_t calculate_stats(long* latencies, int n) {
+    stats_t s;
+    s.min = latencies[0];
+    s.max = latencies[0];
+    long sum = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (latencies[i] < s.min) s.min = latencies[i];
+        if (latencies[i] > s.max) s.max = latencies[i];
+        sum += latencies[i];
+    }
+    s.mean = sum / n;
+
+    long variance_sum = 0;
+    for (int i = 0; i < n; i++) {
+        long diff = latencies[i] - s.mean;
+        variance_sum += diff * diff;
+    }
+    s.stddev = (long)sqrt(variance_sum / n);
+
+    qsort(latencies, n, sizeof(long), cmp_long);
+    s.p99 = latencies[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1];
+
+    return s;
+}
+
+static void fill_page(uint8_t* page, size_t index) {
+    unsigned seed = (unsigned)index * 2654435761U;
+    for (size_t i = 0; i < STORE_PAGE_SIZE; i++) {
+        page[i] = (uint8_t)rand_r(&seed);
+    }
+}
+
+/* Dirty the page as the application would between two evictions */
+static void touch_page(uint8_t* page, size_t index, int round) {
+    static const int dirty_lines[4] = {0, 1, 4, 32};
+    unsigned seed = (unsigned)(index * 31 + round) * 2654435761U;
+    int lines = dirty_lines[index % 4];
+
+    for (int l = 0; l < lines; l++) {
+        int line = rand_r(&seed) % STORE_LINES_PER_PAGE;
+        uint64_t* word = (uint64_t*)(page + line * STORE_LINE_SIZE) + rand_r(&seed) % 8;
+        *word += 1 + (uint64_t)round;
+    }
+}
+
+static int put_all(swap_store_t* store, uint8_t* pages, size_t nr_pages, long* latencies) {
+    int ret = 0;
+    for (size_t first = 0; first < nr_pages; first += BATCH_PAGES) {
+        size_t n = nr_pages - first < BATCH_PAGES ? nr_pages - first : BATCH_PAGES;
+        const uint8_t* src[BATCH_PAGES];
+        uint64_t ids[BATCH_PAGES];
+        struct timespec t_start, t_end;
+
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = first + i;
+            src[i] = pages + (first + i) * STORE_PAGE_SIZE;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        if (swap_store_put_batch(store, ids, src, n) != 0) ret = -1;
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        if (latencies) {
+            latencies[first / BATCH_PAGES] = timespec_to_ns(diff_time(t_start, t_end)) / (long)n;
+        }
+    }
+    return ret;
+}
+
+static int get_all(swap_store_t* store, uint8_t* pages, size_t nr_pages) {
+    int ret = 0;
+    for (size_t first = 0; first < nr_pages; first += BATCH_PAGES) {
+        size_t n = nr_pages - first < BATCH_PAGES ? nr_pages - first : BATCH_PAGES;
+        uint8_t* dst[BATCH_PAGES];
+        uint64_t ids[BATCH_PAGES];
+
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = first + i;
+            dst[i] = pages + (first + i) * STORE_PAGE_SIZE;
+        }
+        if (swap_store_get_batch(store, ids, dst, n) != 0) ret = -1;
+    }
+    return ret;
+}
+
+delta_result_t run_benchmark(int delta, uint32_t nr_dpus, size_t nr_pages, int rounds) {
+    delta_result_t result = {0};
+    swap_store_config_t cfg;
+    swap_store_t store;
+
+    result.delta = delta;
+    result.nr_dpus = nr_dpus;
+    result.nr_pages = nr_pages;
+    result.rounds = rounds;
+
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.max_pages = nr_pages;
+    cfg.delta = delta;
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        exit(1);
+    }
+
+    /* pages: what the application sees, resident: swapped-in copy */
+    uint8_t* pages = malloc(nr_pages * STORE_PAGE_SIZE);
+    uint8_t* resident = malloc(nr_pages * STORE_PAGE_SIZE);
+    int nr_batches = (int)((nr_pages + BATCH_PAGES - 1) / BATCH_PAGES);
+    long* latencies = malloc((size_t)rounds * nr_batches * sizeof(long));
+    int ok = 1;
+
+    for (size_t i = 0; i < nr_pages; i++) {
+        fill_page(pages + i * STORE_PAGE_SIZE, i);
+    }
+    if (put_all(&store, pages, nr_pages, NULL) != 0) ok = 0;
+    uint64_t bus_before = store.stats.bus_bytes_to_dpu;
+
+    for (int r = 0; r < rounds; r++) {
+        if (get_all(&store, resident, nr_pages) != 0 ||
+            memcmp(pages, resident, nr_pages * STORE_PAGE_SIZE) != 0) {
+            ok = 0;
+        }
+        for (size_t i = 0; i < nr_pages; i++) {
+            touch_page(resident + i * STORE_PAGE_SIZE, i, r);
+        }
+        memcpy(pages, resident, nr_pages * STORE_PAGE_SIZE);
+        if (put_all(&store, resident, nr_pages, latencies + (size_t)r * nr_batches) != 0) ok = 0;
+    }
+
+    memset(resident, 0, nr_pages * STORE_PAGE_SIZE);
+    if (get_all(&store, resident, nr_pages) != 0 ||
+        memcmp(pages, resident, nr_pages * STORE_PAGE_SIZE) != 0) {
+        ok = 0;
+    }
+
+    result.verified = ok;
+    result.store = store.stats;
+    result.reput_bus_bytes = store.stats.bus_bytes_to_dpu - bus_before;
+    result.put_stats = calculate_stats(latencies, rounds * nr_batches);
+
+    free(latencies);
+    free(resident);
+    free(pages);
+    swap_store_free(&store);
+    return result;
+}
+
+void print_result(const delta_result_t* r) {
+    const swap_store_stats_t* s = &r->store;
+    uint64_t reputs = (uint64_t)r->nr_pages * r->rounds;
+
+    printf("%s:\n", r->delta ? "DELTA" : "FULL PAGES");
+    printf("  Re-puts:      %llu, %llu candidates, %llu sent as delta (hit rate %.1f%%)\n",
+           (unsigned long long)reputs, (unsigned long long)s->delta_candidates,
+           (unsigned long long)s->delta_pages, 100.0 * s->delta_pages / reputs);
+    printf("  Patch bytes:  %llu, saved %llu bytes\n",
+           (unsigned long long)s->delta_bytes, (unsigned long long)s->delta_saved_bytes);
+    printf("  Bus bytes:    %llu to DPU (%.0f per re-put)\n",
+           (unsigned long long)r->reput_bus_bytes, (double)r->reput_bus_bytes / reputs);
+    printf("  Launches:     %llu\n", (unsigned long long)s->kernel_launches);
+    printf("  Put / page:   mean %.2f µs, p99 %.2f µs\n",
+           r->put_stats.mean / 1000.0, r->put_stats.p99 / 1000.0);
+    printf("  Verification: %s\n\n", r->verified ? "✓ OK" : "✗ FAIL");
+}
+
+void save_results_csv(delta_result_t* results, int count, const char* filename) {
+    FILE* f = fopen(filename, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", filename);
+        return;
+    }
+    fprintf(f, "mode,nr_dpus,nr_pages,rounds,delta_candidates,delta_pages,hit_rate,delta_bytes,saved_bytes,reput_bus_bytes,put_mean_us,put_p99_us\n");
+
+    for (int i = 0; i < count; i++) {
+        delta_result_t* r = &results[i];
+        uint64_t reputs = (uint64_t)r->nr_pages * r->rounds;
+        fprintf(f, "%s,%u,%zu,%d,%llu,%llu,%.3f,%llu,%llu,%llu,%.2f,%.2f\n",
+                r->delta ? "delta" : "full",
+                r->nr_dpus, r->nr_pages, r->rounds,
+                (unsigned long long)r->store.delta_candidates,
+                (unsigned long long)r->store.delta_pages,
+                (double)r->store.delta_pages / reputs,
+                (unsigned long long)r->store.delta_bytes,
+                (unsigned long long)r->store.delta_saved_bytes,
+                (unsigned long long)r->reput_bus_bytes,
+                r->put_stats.mean / 1000.0, r->put_stats.p99 / 1000.0);
+    }
+
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    size_t nr_pages = argc > 1 ? strtoul(argv[1], NULL, 0) : DEFAULT_PAGES;
+    uint32_t nr_dpus = argc > 2 ? strtoul(argv[2], NULL, 0) : 8;
+    int rounds = argc > 3 ? atoi(argv[3]) : DEFAULT_ROUNDS;
+
+    if (nr_pages == 0 || rounds <= 0) {
+        fprintf(stderr, "Usage: %s [nr_pages] [nr_dpus] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== UPMEM DELTA PUT BENCHMARK ===\n");
+    printf("Pages: %zu x %d bytes, DPUs: %u, rounds: %d, batch: %d\n\n",
+           nr_pages, STORE_PAGE_SIZE, nr_dpus, rounds, BATCH_PAGES);
+
+    delta_result_t results[2];
+    results[0] = run_benchmark(0, nr_dpus, nr_pages, rounds);
+    print_result(&results[0]);
+    results[1] = run_benchmark(1, nr_dpus, nr_pages, rounds);
+    print_result(&results[1]);
+
+    printf("=== SUMMARY ===\n");
+    printf("Bus bytes saved: %.1f%%\n",
+           100.0 * (1.0 - (double)results[1].reput_bus_bytes / results[0].reput_bus_bytes));
+    printf("Put latency:     %.2fx (delta / full)\n",
+           (double)results[1].put_stats.mean / results[0].put_stats.mean);
+
+    save_results_csv(results, 2, "delta_results.csv");
+    printf("\n✓ Results saved to delta_results.csv\n");
+
+    return (results[0].verified && results[1].verified) ? 0 : 1;
+}
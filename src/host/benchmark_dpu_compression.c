@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "swap_store.h"
+
+/*
+ * On-DPU compression: pages are stored raw, then the DPUs compress them
+ * in place during an idle window. Measures how many pages fit per MRAM
+ * byte before/after, and what decompress-on-get costs.
+ *
+ * Usage: benchmark_dpu_compression [nr_pages] [nr_dpus]
+ */
+
+#define DEFAULT_PAGES 4096
+#define BATCH_PAGES 64
+
+typedef struct {
+    long min, max, mean, stddev;
+} stats_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+stats_t calculate_stats(long* latencies, int n) {
+    stats_t s;
+    s.min = latencies[0];
+    s.max = latencies[0];
+    long sum = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (latencies[i] < s.min) s.min = latencies[i];
+        if (latencies[i] > s.max) s.max = latencies[i];
+        sum += latencies[i];
+    }
+    s.mean = sum / n;
+
+    long variance_sum = 0;
+    for (int i = 0; i < n; i++) {
+        long diff = latencies[i] - s.mean;
+        variance_sum += diff * diff;
+    }
+    s.stddev = (long)sqrt(variance_sum / n);
+
+    return s;
+}
+
+/* Same content mix as benchmark_compression */
+static void fill_page(uint8_t* page, size_t index) {
+    static const char* words[] = {"swap ", "page ", "memory ", "tier ", "dpu ", "rank ", "host "};
+    unsigned seed = (unsigned)index * 2654435761U;
+
+    switch (index % 10) {
+    case 0:
+        memset(page, 0, STORE_PAGE_SIZE);
+        break;
+    case 1: case 2: case 3: case 4: {
+        size_t off = 0;
+        while (off < STORE_PAGE_SIZE) {
+            const char* w = words[rand_r(&seed) % 7];
+            size_t len = strlen(w);
+            if (off + len > STORE_PAGE_SIZE) len = STORE_PAGE_SIZE - off;
+            memcpy(page + off, w, len);
+            off += len;
+        }
+        break;
+    }
+    case 5: case 6: case 7: {
+        uint32_t* words32 = (uint32_t*)page;
+        for (size_t i = 0; i < STORE_PAGE_SIZE / 16; i++) {
+            words32[i * 4 + 0] = (uint32_t)(index * 256 + i);
+            words32[i * 4 + 1] = rand_r(&seed) % 16;
+            words32[i * 4 + 2] = 0x7f00a000 + (uint32_t)i * 64;
+            words32[i * 4 + 3] = 0;
+        }
+        break;
+    }
+    default:
+        for (size_t i = 0; i < STORE_PAGE_SIZE; i++) {
+            page[i] = (uint8_t)rand_r(&seed);
+        }
+        break;
+    }
+}
+
+/* Read every page back in batches, returns per-page latency stats */
+static stats_t get_all(swap_store_t* store, uint8_t* readback, size_t nr_pages) {
+    int nr_batches = (int)((nr_pages + BATCH_PAGES - 1) / BATCH_PAGES);
+    long* latencies = malloc(nr_batches * sizeof(long));
+    uint8_t* dst[BATCH_PAGES];
+    uint64_t ids[BATCH_PAGES];
+
+    for (int b = 0; b < nr_batches; b++) {
+        size_t first = (size_t)b * BATCH_PAGES;
+        size_t n = nr_pages - first < BATCH_PAGES ? nr_pages - first : BATCH_PAGES;
+        struct timespec t_start, t_end;
+
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = first + i;
+            dst[i] = readback + (first + i) * STORE_PAGE_SIZE;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        swap_store_get_batch(store, ids, dst, n);
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        latencies[b] = timespec_to_ns(diff_time(t_start, t_end)) / (long)n;
+    }
+
+    stats_t s = calculate_stats(latencies, nr_batches);
+    free(latencies);
+    return s;
+}
+
+int main(int argc, char* argv[]) {
+    size_t nr_pages = argc > 1 ? strtoul(argv[1], NULL, 0) : DEFAULT_PAGES;
+    uint32_t nr_dpus = argc > 2 ? strtoul(argv[2], NULL, 0) : 8;
+
+    printf("=== UPMEM ON-DPU COMPRESSION BENCHMARK ===\n");
+    printf("Pages: %zu x %d bytes, DPUs: %u\n\n", nr_pages, STORE_PAGE_SIZE, nr_dpus);
+
+    uint8_t* pages = malloc(nr_pages * STORE_PAGE_SIZE);
+    uint8_t* readback = malloc(nr_pages * STORE_PAGE_SIZE);
+    if (!pages || !readback) {
+        fprintf(stderr, "Failed to allocate %zu pages\n", nr_pages);
+        return 1;
+    }
+    for (size_t i = 0; i < nr_pages; i++) {
+        fill_page(pages + i * STORE_PAGE_SIZE, i);
+    }
+
+    swap_store_config_t cfg;
+    swap_store_t store;
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.max_pages = nr_pages;
+    cfg.compress = 0;       /* pages land raw, the DPUs compress them later */
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        return 1;
+    }
+
+    /* Swap everything out raw */
+    for (size_t first = 0; first < nr_pages; first += BATCH_PAGES) {
+        size_t n = nr_pages - first < BATCH_PAGES ? nr_pages - first : BATCH_PAGES;
+        const uint8_t* src[BATCH_PAGES];
+        uint64_t ids[BATCH_PAGES];
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = first + i;
+            src[i] = pages + (first + i) * STORE_PAGE_SIZE;
+        }
+        swap_store_put_batch(&store, ids, src, n);
+    }
+    uint64_t mram_before = swap_store_mram_used(&store);
+    stats_t get_raw = get_all(&store, readback, nr_pages);
+    int ok_raw = memcmp(pages, readback, nr_pages * STORE_PAGE_SIZE) == 0;
+
+    /* Idle window: let the DPUs compress until nothing is left to try */
+    struct timespec t_start, t_end;
+    uint32_t compressed = 0, pass_compressed;
+    int passes = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    while (swap_store_dpu_compress(&store, STORE_MAX_JOBS, &pass_compressed) > 0) {
+        compressed += pass_compressed;
+        passes++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    long compress_ns = timespec_to_ns(diff_time(t_start, t_end));
+    uint64_t mram_after = swap_store_mram_used(&store);
+
+    memset(readback, 0, nr_pages * STORE_PAGE_SIZE);
+    stats_t get_dpu = get_all(&store, readback, nr_pages);
+    int ok_dpu = memcmp(pages, readback, nr_pages * STORE_PAGE_SIZE) == 0;
+
+    double per_mb_before = nr_pages / (mram_before / (1024.0 * 1024.0));
+    double per_mb_after = nr_pages / (mram_after / (1024.0 * 1024.0));
+
+    printf("Idle compression: %u pages in %d passes, %.2f ms (%.0f pages/s)\n",
+           compressed, passes, compress_ns / 1e6, compressed / (compress_ns / 1e9));
+    printf("MRAM used:        %llu -> %llu bytes\n",
+           (unsigned long long)mram_before, (unsigned long long)mram_after);
+    printf("Pages per MB:     %.1f -> %.1f (%.2fx capacity)\n",
+           per_mb_before, per_mb_after, per_mb_after / per_mb_before);
+    printf("Get / page raw:   mean %.2f µs (stddev %.2f)\n",
+           get_raw.mean / 1000.0, get_raw.stddev / 1000.0);
+    printf("Get / page DPU:   mean %.2f µs (stddev %.2f), overhead %+.2f µs\n",
+           get_dpu.mean / 1000.0, get_dpu.stddev / 1000.0,
+           (get_dpu.mean - get_raw.mean) / 1000.0);
+    printf("Kernel launches:  %llu\n", (unsigned long long)store.stats.kernel_launches);
+    printf("Verification:     raw %s, DPU-compressed %s\n",
+           ok_raw ? "✓ OK" : "✗ FAIL", ok_dpu ? "✓ OK" : "✗ FAIL");
+
+    FILE* f = fopen("dpu_compression_results.csv", "w");
+    if (f) {
+        fprintf(f, "nr_dpus,nr_pages,compressed_pages,mram_before,mram_after,pages_per_mb_before,pages_per_mb_after,compress_ms,get_raw_mean_us,get_dpu_mean_us\n");
+        fprintf(f, "%u,%zu,%u,%llu,%llu,%.1f,%.1f,%.2f,%.2f,%.2f\n",
+                store.nr_dpus, nr_pages, compressed,
+                (unsigned long long)mram_before, (unsigned long long)mram_after,
+                per_mb_before, per_mb_after, compress_ns / 1e6,
+                get_raw.mean / 1000.0, get_dpu.mean / 1000.0);
+        fclose(f);
+        printf("\n✓ Results saved to dpu_compression_results.csv\n");
+    }
+
+    swap_store_free(&store);
+    free(pages);
+    free(readback);
+    return (ok_raw && ok_dpu) ? 0 : 1;
+}
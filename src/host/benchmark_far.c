@@ -0,0 +1,433 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "far_memory.h"
+#include "psi_daemon.h"
+
+/*
+ * Far memory objects vs RAM vs transparent swap.
+ *
+ * A session table of nr_objects objects (70% of 100-400B, 25% of
+ * 0.5-2KB, 5% of 8-16KB); every request touches REQUEST_OBJECTS of them,
+ * 10% of the objects getting 90% of the requests, and updates 30% of the
+ * ones it touches.
+ *
+ *   ram     objects malloc'ed, all in host memory
+ *   far     far_alloc'ed, one far_pin_batch() per request
+ *   single  far_alloc'ed, one far_pin() per object
+ *   swap    objects packed in a userfaultfd region, the PSI daemon keeps
+ *           it under cache_mb and evicts the rest to the page store
+ *
+ * far, single and swap keep at most cache_mb on the host.
+ *
+ * Usage: benchmark_far [nr_objects] [cache_mb] [requests]
+ */
+
+#define DEFAULT_OBJECTS 100000
+#define DEFAULT_CACHE_MB 16
+#define DEFAULT_REQUESTS 50000
+#define REQUEST_OBJECTS 16
+#define HOT_PERCENT 10
+#define HOT_OPS_PERCENT 90
+#define WRITE_PERCENT 30
+
+typedef struct {
+    uint64_t id;
+    uint64_t version;
+} object_header_t;
+
+typedef struct {
+    long min, max, mean, stddev, p99;
+} stats_t;
+
+typedef struct {
+    const char* mode;
+    size_t nr_objects;
+    size_t cache_mb;
+    int requests;
+    uint64_t object_bytes;
+    stats_t req_stats;              /* per request, ns */
+    double req_per_sec;
+    uint64_t fetched_pages;         /* far: pages fetched, swap: swap-ins */
+    uint64_t written_pages;         /* far: write-backs, swap: evictions */
+    uint64_t bus_bytes;             /* both directions */
+    int verified;
+} far_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+stats_t calculate_stats(long* latencies, int n) {
+    stats_t s;
+    s.min = latencies[0];
+    s.max = latencies[0];
+    long sum = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (latencies[i] < s.min) s.min = latencies[i];
+        if (latencies[i] > s.max) s.max = latencies[i];
+        sum += latencies[i];
+    }
+    s.mean = sum / n;
+
+    double variance_sum = 0;
+    for (int i = 0; i < n; i++) {
+        double diff = (double)(latencies[i] - s.mean);
+        variance_sum += diff * diff;
+    }
+    s.stddev = (long)sqrt(variance_sum / n);
+
+    qsort(latencies, n, sizeof(long), cmp_long);
+    s.p99 = latencies[(size_t)n * 99 / 100];
+
+    return s;
+}
+
+static size_t object_size(size_t i) {
+    unsigned seed = (unsigned)i * 2654435761U;
+    int kind = rand_r(&seed) % 100;
+    if (kind < 70) return 100 + rand_r(&seed) % 301;
+    if (kind < 95) return 512 + rand_r(&seed) % 1537;
+    return 8192 + rand_r(&seed) % 8193;
+}
+
+static size_t pick_object(unsigned* seed, size_t nr_objects) {
+    size_t hot = nr_objects * HOT_PERCENT / 100 ? nr_objects * HOT_PERCENT / 100 : 1;
+    if (rand_r(seed) % 100 < HOT_OPS_PERCENT) {
+        return (size_t)rand_r(seed) % hot;
+    }
+    return (size_t)rand_r(seed) % nr_objects;
+}
+
+/* Check the object, maybe update it. Returns 1 if written, -1 if corrupted */
+static int touch_object(uint8_t* obj, size_t i, size_t size, uint64_t* versions, unsigned* seed) {
+    object_header_t* h = (object_header_t*)obj;
+    if (h->id != i || h->version != versions[i] || obj[size - 1] != (uint8_t)(i + h->version)) {
+        return -1;
+    }
+    if (rand_r(seed) % 100 >= WRITE_PERCENT) {
+        return 0;
+    }
+    h->version = ++versions[i];
+    obj[size - 1] = (uint8_t)(i + h->version);
+    return 1;
+}
+
+static void init_object(uint8_t* obj, size_t i, size_t size) {
+    object_header_t* h = (object_header_t*)obj;
+    h->id = i;
+    h->version = 0;
+    obj[size - 1] = (uint8_t)i;
+}
+
+/* Pointers to the objects of one request; far modes pin, others look up */
+typedef struct {
+    far_heap_t* heap;
+    far_handle_t* handles;
+    uint8_t** addrs;                /* ram and swap */
+    int single;
+} object_set_t;
+
+static int access_objects(object_set_t* set, const size_t* idx, int n, void** ptrs) {
+    far_handle_t h[REQUEST_OBJECTS];
+
+    if (!set->heap) {
+        for (int k = 0; k < n; k++) ptrs[k] = set->addrs[idx[k]];
+        return 0;
+    }
+    for (int k = 0; k < n; k++) h[k] = set->handles[idx[k]];
+    if (!set->single) {
+        return far_pin_batch(set->heap, h, n, ptrs);
+    }
+    for (int k = 0; k < n; k++) {
+        ptrs[k] = far_pin(set->heap, h[k]);
+        if (!ptrs[k]) return -1;
+    }
+    return 0;
+}
+
+static void release_objects(object_set_t* set, const size_t* idx, int n, const int* dirty) {
+    if (!set->heap) return;
+    for (int k = 0; k < n; k++) {
+        far_unpin(set->heap, set->handles[idx[k]], dirty[k] > 0);
+    }
+}
+
+static int run_requests(object_set_t* set, const size_t* sizes, size_t nr_objects, int requests,
+                        uint64_t* versions, far_result_t* result) {
+    long* latencies = malloc(requests * sizeof(long));
+    unsigned seed = 7;
+    struct timespec t_begin, t_end, t_start, t_stop;
+    int errors = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t_begin);
+    for (int r = 0; r < requests; r++) {
+        size_t idx[REQUEST_OBJECTS];
+        void* ptrs[REQUEST_OBJECTS];
+        int dirty[REQUEST_OBJECTS];
+
+        for (int k = 0; k < REQUEST_OBJECTS; k++) {
+            idx[k] = pick_object(&seed, nr_objects);
+            /* Same object twice in a request: touch it once */
+            for (int j = 0; j < k; j++) {
+                if (idx[j] == idx[k]) {
+                    idx[k] = (idx[k] + 1) % nr_objects;
+                    j = -1;
+                }
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        if (access_objects(set, idx, REQUEST_OBJECTS, ptrs) != 0) {
+            errors++;
+            continue;
+        }
+        for (int k = 0; k < REQUEST_OBJECTS; k++) {
+            dirty[k] = touch_object(ptrs[k], idx[k], sizes[idx[k]], versions, &seed);
+            if (dirty[k] < 0) errors++;
+        }
+        release_objects(set, idx, REQUEST_OBJECTS, dirty);
+        clock_gettime(CLOCK_MONOTONIC, &t_stop);
+        latencies[r] = timespec_to_ns(diff_time(t_start, t_stop));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+    result->req_stats = calculate_stats(latencies, requests);
+    result->req_per_sec = requests / (timespec_to_ns(diff_time(t_begin, t_end)) / 1e9);
+    free(latencies);
+
+    /* Every object, in request-sized groups */
+    for (size_t first = 0; first < nr_objects; first += REQUEST_OBJECTS) {
+        int n = nr_objects - first < REQUEST_OBJECTS ? (int)(nr_objects - first) : REQUEST_OBJECTS;
+        size_t idx[REQUEST_OBJECTS];
+        void* ptrs[REQUEST_OBJECTS];
+        int dirty[REQUEST_OBJECTS] = {0};
+
+        for (int k = 0; k < n; k++) idx[k] = first + k;
+        if (access_objects(set, idx, n, ptrs) != 0) {
+            errors++;
+            continue;
+        }
+        for (int k = 0; k < n; k++) {
+            const object_header_t* h = ptrs[k];
+            if (h->id != idx[k] || h->version != versions[idx[k]]) errors++;
+        }
+        release_objects(set, idx, n, dirty);
+    }
+    return errors;
+}
+
+far_result_t run_benchmark(const char* mode, size_t nr_objects, size_t cache_mb, int requests) {
+    far_result_t result = {0};
+    size_t* sizes = malloc(nr_objects * sizeof(size_t));
+    uint64_t* versions = calloc(nr_objects, sizeof(uint64_t));
+    object_set_t set = {0};
+    int errors = 0;
+
+    set.addrs = malloc(nr_objects * sizeof(uint8_t*));
+    set.handles = malloc(nr_objects * sizeof(far_handle_t));
+    if (!sizes || !versions || !set.addrs || !set.handles) {
+        fprintf(stderr, "Failed to allocate %zu object descriptors\n", nr_objects);
+        exit(1);
+    }
+
+    result.mode = mode;
+    result.nr_objects = nr_objects;
+    result.cache_mb = cache_mb;
+    result.requests = requests;
+    for (size_t i = 0; i < nr_objects; i++) {
+        sizes[i] = object_size(i);
+        result.object_bytes += sizes[i];
+    }
+
+    if (strcmp(mode, "ram") == 0) {
+        for (size_t i = 0; i < nr_objects; i++) {
+            set.addrs[i] = malloc(sizes[i]);
+            if (!set.addrs[i]) {
+                fprintf(stderr, "Failed to allocate object %zu\n", i);
+                exit(1);
+            }
+            init_object(set.addrs[i], i, sizes[i]);
+        }
+        errors = run_requests(&set, sizes, nr_objects, requests, versions, &result);
+        for (size_t i = 0; i < nr_objects; i++) free(set.addrs[i]);
+    } else if (strcmp(mode, "far") == 0 || strcmp(mode, "single") == 0) {
+        far_config_t cfg;
+        far_heap_t heap;
+
+        far_default_config(&cfg);
+        cfg.max_bytes = result.object_bytes * 2 + (64ULL << 20);
+        cfg.cache_bytes = (uint64_t)cache_mb << 20;
+        if (far_init(&heap, &cfg) != 0) {
+            exit(1);
+        }
+        for (size_t i = 0; i < nr_objects; i++) {
+            set.handles[i] = far_alloc(&heap, sizes[i]);
+            uint8_t* obj = far_pin(&heap, set.handles[i]);
+            if (!obj) {
+                fprintf(stderr, "Failed to populate far memory\n");
+                exit(1);
+            }
+            init_object(obj, i, sizes[i]);
+            far_unpin(&heap, set.handles[i], 1);
+        }
+        uint64_t bus_before = heap.store.stats.bus_bytes_to_dpu + heap.store.stats.bus_bytes_from_dpu;
+        far_stats_t before = heap.stats;
+
+        set.heap = &heap;
+        set.single = strcmp(mode, "single") == 0;
+        errors = run_requests(&set, sizes, nr_objects, requests, versions, &result);
+
+        result.fetched_pages = heap.stats.fetched_pages - before.fetched_pages;
+        result.written_pages = heap.stats.written_pages - before.written_pages;
+        result.bus_bytes = heap.store.stats.bus_bytes_to_dpu + heap.store.stats.bus_bytes_from_dpu - bus_before;
+        for (size_t i = 0; i < nr_objects; i++) {
+            if (far_free(&heap, set.handles[i]) != 0) errors++;
+        }
+        if (heap.stats.objects != 0 || heap.resident_bytes != 0) errors++;
+        far_destroy(&heap);
+    } else {
+        swap_store_config_t store_cfg;
+        psi_daemon_config_t cfg;
+        swap_store_t store;
+        uffd_region_t region;
+        psi_daemon_t daemon;
+        size_t offset = 0;
+
+        swap_store_default_config(&store_cfg);
+        store_cfg.max_pages = (uint32_t)(result.object_bytes / STORE_PAGE_SIZE + nr_objects / 2 + 1);
+        store_cfg.delta = 1;
+        if (swap_store_init(&store, &store_cfg) != 0 ||
+            uffd_region_init(&region, result.object_bytes + nr_objects * 16, 0) != 0) {
+            fprintf(stderr, "Failed to initialize page store or region\n");
+            exit(1);
+        }
+        psi_daemon_default_config(&cfg);
+        cfg.psi_stall_us = 0;
+        cfg.psi_threshold = 100.0;      /* the resident cap alone drives eviction */
+        cfg.interval_ms = 5;
+        cfg.max_resident = (uint64_t)cache_mb << 20;
+        if (psi_daemon_start(&daemon, &cfg, &region, &store) != 0) {
+            exit(1);
+        }
+        for (size_t i = 0; i < nr_objects; i++) {
+            set.addrs[i] = region.base + offset;
+            init_object(set.addrs[i], i, sizes[i]);
+            offset += (sizes[i] + 15) & ~(size_t)15;
+        }
+        psi_daemon_stats_t before = daemon.stats;
+        uint64_t swapins = region.stats.swapins;
+        uint64_t bus_before = store.stats.bus_bytes_to_dpu + store.stats.bus_bytes_from_dpu;
+
+        errors = run_requests(&set, sizes, nr_objects, requests, versions, &result);
+
+        psi_daemon_stop(&daemon);
+        result.fetched_pages = region.stats.swapins - swapins;
+        result.written_pages = daemon.stats.evicted_pages - before.evicted_pages;
+        result.bus_bytes = store.stats.bus_bytes_to_dpu + store.stats.bus_bytes_from_dpu - bus_before;
+        uffd_region_free(&region);
+        swap_store_free(&store);
+    }
+
+    result.verified = errors == 0;
+    free(set.addrs);
+    free(set.handles);
+    free(versions);
+    free(sizes);
+    return result;
+}
+
+void print_result(const far_result_t* r) {
+    printf("%s:\n", r->mode);
+    printf("  Requests:     %.0f req/s\n", r->req_per_sec);
+    printf("  Latency:      mean %.2f µs, p99 %.2f µs, max %.2f µs\n",
+           r->req_stats.mean / 1000.0, r->req_stats.p99 / 1000.0, r->req_stats.max / 1000.0);
+    if (strcmp(r->mode, "ram") != 0) {
+        printf("  Pages:        %llu in, %llu out (%.2f in per request)\n",
+               (unsigned long long)r->fetched_pages, (unsigned long long)r->written_pages,
+               (double)r->fetched_pages / r->requests);
+        printf("  Bus bytes:    %llu\n", (unsigned long long)r->bus_bytes);
+    }
+    printf("  Verification: %s\n\n", r->verified ? "✓ OK" : "✗ FAIL");
+}
+
+void save_results_csv(far_result_t* results, int count, const char* filename) {
+    FILE* f = fopen(filename, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", filename);
+        return;
+    }
+    fprintf(f, "mode,nr_objects,object_mb,cache_mb,requests,req_per_sec,mean_us,p99_us,pages_in,pages_out,bus_bytes\n");
+
+    for (int i = 0; i < count; i++) {
+        far_result_t* r = &results[i];
+        fprintf(f, "%s,%zu,%.1f,%zu,%d,%.0f,%.2f,%.2f,%llu,%llu,%llu\n",
+                r->mode, r->nr_objects, r->object_bytes / 1048576.0, r->cache_mb, r->requests,
+                r->req_per_sec, r->req_stats.mean / 1000.0, r->req_stats.p99 / 1000.0,
+                (unsigned long long)r->fetched_pages, (unsigned long long)r->written_pages,
+                (unsigned long long)r->bus_bytes);
+    }
+
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    size_t nr_objects = argc > 1 ? strtoul(argv[1], NULL, 0) : DEFAULT_OBJECTS;
+    size_t cache_mb = argc > 2 ? strtoul(argv[2], NULL, 0) : DEFAULT_CACHE_MB;
+    int requests = argc > 3 ? atoi(argv[3]) : DEFAULT_REQUESTS;
+    static const char* modes[] = {"ram", "far", "single", "swap"};
+    far_result_t results[4];
+    int ok = 1;
+
+    if (nr_objects < REQUEST_OBJECTS || cache_mb == 0 || requests <= 0) {
+        fprintf(stderr, "Usage: %s [nr_objects] [cache_mb] [requests]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== UPMEM FAR MEMORY OBJECT BENCHMARK ===\n");
+    printf("Objects: %zu, host cache: %zu MB, requests: %d x %d objects\n\n",
+           nr_objects, cache_mb, requests, REQUEST_OBJECTS);
+
+    for (int m = 0; m < 4; m++) {
+        results[m] = run_benchmark(modes[m], nr_objects, cache_mb, requests);
+        if (m == 0) {
+            printf("Object data: %.1f MB\n\n", results[0].object_bytes / 1048576.0);
+        }
+        print_result(&results[m]);
+        ok &= results[m].verified;
+    }
+
+    printf("=== SUMMARY ===\n");
+    printf("Request latency vs RAM: far %.2fx, single %.2fx, swap %.2fx\n",
+           (double)results[1].req_stats.mean / results[0].req_stats.mean,
+           (double)results[2].req_stats.mean / results[0].req_stats.mean,
+           (double)results[3].req_stats.mean / results[0].req_stats.mean);
+    printf("Batched pins vs one by one: %.2fx faster\n",
+           (double)results[2].req_stats.mean / results[1].req_stats.mean);
+
+    save_results_csv(results, 4, "far_results.csv");
+    printf("\n✓ Results saved to far_results.csv\n");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "swap_store.h"
+
+/*
+ * Huge pages: swap-out and swap-in latency of 2MB, as one huge page
+ * striped over a rank (one push per direction) against the same 2MB as
+ * 512 pages of 4KB: one put/get per page, one batch, and one uniform
+ * batch (cfg.uniform_xfer).
+ *
+ * A few page ids are swapped out and in round-robin, so stripes and slots
+ * are recycled; every swap-in is checked against the last swap-out of
+ * that id. Without the SDK the pushes are host copies, so the numbers
+ * show the store's own overhead per 2MB.
+ *
+ * Usage: benchmark_huge [nr_dpus] [reps]
+ */
+
+#define NR_HUGE 4
+#define SMALL_PER_HUGE (STORE_HUGE_PAGE_SIZE / STORE_PAGE_SIZE)
+#define MRAM_SIZE (4 * 1024 * 1024)
+
+enum { PATH_PAGES, PATH_BATCH, PATH_UNIFORM, PATH_HUGE, NR_PATHS };
+
+static const char* path_names[NR_PATHS] = {"4k-pages", "4k-batch", "4k-uniform", "huge"};
+
+typedef struct {
+    int path;
+    double out_us, out_p99_us;      /* swap-out of 2MB */
+    double in_us, in_p99_us;        /* swap-in of 2MB */
+    double out_pushes, in_pushes;   /* transfer calls per 2MB */
+    int ok;
+} huge_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static double us_since(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_to_ns(diff_time(start, now)) / 1e3;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void summarize(double* lat, uint32_t n, double* mean, double* p99) {
+    double sum = 0.0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        sum += lat[i];
+    }
+    qsort(lat, n, sizeof(double), cmp_double);
+    *mean = n ? sum / n : 0.0;
+    *p99 = n ? lat[(n * 99) / 100] : 0.0;
+}
+
+/* Content of huge page id after its version-th swap-out */
+static void fill_huge(uint8_t* buf, uint32_t id, uint32_t version) {
+    unsigned seed = (id * 31 + version) * 2654435761U;
+    for (size_t i = 0; i < STORE_HUGE_PAGE_SIZE; i += sizeof(uint32_t)) {
+        uint32_t v = (uint32_t)rand_r(&seed);
+        memcpy(buf + i, &v, sizeof(v));
+    }
+}
+
+/* 2MB to or from the store through path, as huge page id */
+static int swap_2mb(swap_store_t* store, int path, uint32_t id, uint8_t* buf, int out) {
+    uint64_t ids[SMALL_PER_HUGE];
+    uint8_t* ptrs[SMALL_PER_HUGE];
+
+    if (path == PATH_HUGE) {
+        return out ? swap_store_put_huge(store, id, buf) : swap_store_get_huge(store, id, buf);
+    }
+    for (uint32_t i = 0; i < SMALL_PER_HUGE; i++) {
+        ids[i] = (uint64_t)id * SMALL_PER_HUGE + i;
+        ptrs[i] = buf + (size_t)i * STORE_PAGE_SIZE;
+    }
+    if (path == PATH_PAGES) {
+        for (uint32_t i = 0; i < SMALL_PER_HUGE; i++) {
+            int ret = out ? swap_store_put(store, ids[i], ptrs[i])
+                          : swap_store_get(store, ids[i], ptrs[i]);
+            if (ret != 0) return -1;
+        }
+        return 0;
+    }
+    return out ? swap_store_put_batch(store, ids, (const uint8_t* const*)ptrs, SMALL_PER_HUGE)
+               : swap_store_get_batch(store, ids, ptrs, SMALL_PER_HUGE);
+}
+
+static int run_path(uint32_t nr_dpus, uint32_t reps, int path, huge_result_t* r) {
+    uint8_t* buf = malloc(STORE_HUGE_PAGE_SIZE);
+    uint8_t* expected = malloc(STORE_HUGE_PAGE_SIZE);
+    double* out_lat = calloc(reps, sizeof(double));
+    double* in_lat = calloc(reps, sizeof(double));
+    uint32_t version[NR_HUGE] = {0};
+    uint32_t stripe_dpus = 1;
+    swap_store_config_t cfg;
+    swap_store_t store;
+    uint64_t out_pushes = 0, in_pushes = 0;
+
+    memset(r, 0, sizeof(*r));
+    r->path = path;
+    if (!buf || !expected || !out_lat || !in_lat) {
+        free(buf); free(expected); free(out_lat); free(in_lat);
+        return -1;
+    }
+
+    /* Room for every id plus the copy being replaced, twice over in case
+     * a rank has fewer DPUs than a full one */
+    while (2 * stripe_dpus <= nr_dpus && 2 * stripe_dpus <= STORE_DPUS_PER_RANK) {
+        stripe_dpus *= 2;
+    }
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.mram_size = MRAM_SIZE;
+    cfg.max_pages = 2 * NR_HUGE * SMALL_PER_HUGE;
+    cfg.uniform_xfer = path == PATH_UNIFORM;
+    cfg.huge_mram_size = path == PATH_HUGE ? 2 * (NR_HUGE + 1) * (STORE_HUGE_PAGE_SIZE / stripe_dpus)
+                                           : 0;
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        free(buf); free(expected); free(out_lat); free(in_lat);
+        return -1;
+    }
+    r->ok = 1;
+
+    for (uint32_t k = 0; k < reps && r->ok; k++) {
+        uint32_t id = k % NR_HUGE;
+        uint64_t pushes;
+        struct timespec t0;
+
+        fill_huge(buf, id, ++version[id]);
+        pushes = store.stats.pushes;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (swap_2mb(&store, path, id, buf, 1) != 0) {
+            r->ok = 0;
+            break;
+        }
+        out_lat[k] = us_since(t0);
+        out_pushes += store.stats.pushes - pushes;
+
+        /* Swap in the oldest id, not the one just written */
+        id = (k + 1) % NR_HUGE;
+        if (version[id] == 0) id = k % NR_HUGE;
+        memset(buf, 0, STORE_HUGE_PAGE_SIZE);
+        pushes = store.stats.pushes;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (swap_2mb(&store, path, id, buf, 0) != 0) {
+            r->ok = 0;
+            break;
+        }
+        in_lat[k] = us_since(t0);
+        in_pushes += store.stats.pushes - pushes;
+
+        fill_huge(expected, id, version[id]);
+        if (memcmp(buf, expected, STORE_HUGE_PAGE_SIZE) != 0) r->ok = 0;
+    }
+
+    summarize(out_lat, reps, &r->out_us, &r->out_p99_us);
+    summarize(in_lat, reps, &r->in_us, &r->in_p99_us);
+    r->out_pushes = (double)out_pushes / reps;
+    r->in_pushes = (double)in_pushes / reps;
+    if (store.stats.errors > 0) r->ok = 0;
+    swap_store_free(&store);
+    free(buf); free(expected); free(out_lat); free(in_lat);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t nr_dpus = argc > 1 ? strtoul(argv[1], NULL, 0) : 64;
+    uint32_t reps = argc > 2 ? strtoul(argv[2], NULL, 0) : 50;
+    huge_result_t results[NR_PATHS];
+    int ok = 1;
+
+    if (nr_dpus == 0 || reps == 0) {
+        fprintf(stderr, "Usage: %s [nr_dpus] [reps]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== UPMEM HUGE PAGE BENCHMARK ===\n");
+    printf("DPUs: %u, %u swap-outs and swap-ins of 2MB over %d page ids\n\n", nr_dpus, reps,
+           NR_HUGE);
+
+    printf("%-11s %10s %10s %10s %10s %10s %10s\n", "path", "out us", "out p99", "in us",
+           "in p99", "push/out", "push/in");
+    for (int p = 0; p < NR_PATHS; p++) {
+        huge_result_t* r = &results[p];
+        if (run_path(nr_dpus, reps, p, r) != 0) {
+            r->ok = 0;
+        }
+        printf("%-11s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %s\n", path_names[p], r->out_us,
+               r->out_p99_us, r->in_us, r->in_p99_us, r->out_pushes, r->in_pushes,
+               r->ok ? "✓ OK" : "✗ FAIL");
+        ok &= r->ok;
+    }
+    const huge_result_t* h = &results[PATH_HUGE];
+    if (h->out_us > 0 && h->in_us > 0) {
+        printf("\nhuge vs 4k-batch: swap-out %.2fx, swap-in %.2fx\n",
+               results[PATH_BATCH].out_us / h->out_us, results[PATH_BATCH].in_us / h->in_us);
+    }
+
+    FILE* f = fopen("huge_results.csv", "w");
+    if (f) {
+        fprintf(f, "path,nr_dpus,reps,out_us,out_p99_us,in_us,in_p99_us,out_pushes,in_pushes,ok\n");
+        for (int p = 0; p < NR_PATHS; p++) {
+            const huge_result_t* r = &results[p];
+            fprintf(f, "%s,%u,%u,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,%d\n", path_names[p], nr_dpus,
+                    reps, r->out_us, r->out_p99_us, r->in_us, r->in_p99_us, r->out_pushes,
+                    r->in_pushes, r->ok);
+        }
+        fclose(f);
+        printf("\n✓ Results saved to huge_results.csv\n");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "swap_store.h"
+
+/*
+ * What-if scaling on the cost model: the host memory store charges what
+ * the DPUs would have cost (cost_model.h), so servers of up to max_ranks
+ * full ranks run in seconds. Each point puts and gets batches of random
+ * pages spread over every DPU, per page (one push per record) and with
+ * uniform_xfer (one push per set and round), and checks every page
+ * against its last put.
+ *
+ * Modeled MB/s is the page bytes moved over the modeled transfer and
+ * launch time; wall ms is what the emulation itself took. The model is
+ * model_file (cost_fit -o), else the default one fitted on the simulator
+ * runs of the repository.
+ *
+ * Usage: benchmark_model [max_ranks] [batch] [nr_batches] [model_file]
+ */
+
+#define PAGES_PER_DPU 16
+#define MRAM_SIZE (1024 * 1024)
+
+typedef struct {
+    uint32_t ranks;
+    int uniform;
+    double put_model_ms, get_model_ms;
+    double wall_ms;
+    uint64_t pages_put, pages_got;
+    uint64_t pushes, launches;
+    int ok;
+} model_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static double ms_since(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_to_ns(diff_time(start, now)) / 1e6;
+}
+
+static void fill_page(uint8_t* page, uint64_t id, uint32_t version) {
+    unsigned seed = (unsigned)(id * 31 + version) * 2654435761U;
+    for (size_t i = 0; i < STORE_PAGE_SIZE; i += sizeof(uint32_t)) {
+        uint32_t v = (uint32_t)rand_r(&seed);
+        memcpy(page + i, &v, sizeof(v));
+    }
+}
+
+static double model_ms(const swap_store_t* store) {
+    return (store->stats.model_xfer_ns + store->stats.model_launch_ns) / 1e6;
+}
+
+static int run_point(const cost_model_t* model, uint32_t ranks, uint32_t batch,
+                     uint32_t nr_batches, int uniform, model_result_t* r) {
+    uint32_t nr_dpus = ranks * STORE_DPUS_PER_RANK;
+    uint32_t nr_pages = nr_dpus * PAGES_PER_DPU;
+    uint32_t* version = calloc(nr_pages, sizeof(uint32_t));
+    uint8_t* pages = malloc((size_t)batch * STORE_PAGE_SIZE);
+    uint8_t** ptrs = malloc(batch * sizeof(uint8_t*));
+    uint64_t* ids = malloc(batch * sizeof(uint64_t));
+    uint8_t expected[STORE_PAGE_SIZE];
+    swap_store_config_t cfg;
+    swap_store_t store;
+    struct timespec t0;
+    unsigned seed = 42;
+
+    memset(r, 0, sizeof(*r));
+    r->ranks = ranks;
+    r->uniform = uniform;
+    if (!version || !pages || !ptrs || !ids) {
+        free(version); free(pages); free(ptrs); free(ids);
+        return -1;
+    }
+    for (uint32_t i = 0; i < batch; i++) {
+        ptrs[i] = pages + (size_t)i * STORE_PAGE_SIZE;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.mram_size = MRAM_SIZE;
+    cfg.max_pages = nr_pages;
+    cfg.uniform_xfer = uniform;
+    cfg.cost_model = model;
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        free(version); free(pages); free(ptrs); free(ids);
+        return -1;
+    }
+    r->ok = store.modeled;
+    if (!store.modeled) {
+        fprintf(stderr, "The store runs on DPUs: nothing to model\n");
+    }
+
+    for (uint32_t b = 0; b < nr_batches && r->ok; b++) {
+        double before;
+
+        /* Puts: distinct pages, so the expected content is unambiguous */
+        uint64_t base = (uint64_t)rand_r(&seed) % nr_pages;
+        for (uint32_t i = 0; i < batch; i++) {
+            ids[i] = (base + (uint64_t)i * 7919) % nr_pages;
+            fill_page(ptrs[i], ids[i], version[ids[i]] + 1);
+        }
+        before = model_ms(&store);
+        if (swap_store_put_batch(&store, ids, (const uint8_t* const*)ptrs, batch) != 0) {
+            r->ok = 0;
+            break;
+        }
+        r->put_model_ms += model_ms(&store) - before;
+        r->pages_put += batch;
+        for (uint32_t i = 0; i < batch; i++) {
+            version[ids[i]]++;
+        }
+
+        /* Gets: a random subset of what is stored */
+        uint32_t m = 0;
+        for (uint32_t tries = 0; m < batch && tries < 4 * batch; tries++) {
+            uint64_t id = (uint64_t)rand_r(&seed) % nr_pages;
+            if (version[id] > 0) ids[m++] = id;
+        }
+        before = model_ms(&store);
+        if (swap_store_get_batch(&store, ids, ptrs, m) != 0) {
+            r->ok = 0;
+            break;
+        }
+        r->get_model_ms += model_ms(&store) - before;
+        r->pages_got += m;
+        for (uint32_t i = 0; i < m; i++) {
+            fill_page(expected, ids[i], version[ids[i]]);
+            if (memcmp(ptrs[i], expected, STORE_PAGE_SIZE) != 0) r->ok = 0;
+        }
+    }
+
+    r->pushes = store.stats.pushes;
+    r->launches = store.stats.kernel_launches;
+    if (store.stats.errors > 0) r->ok = 0;
+    swap_store_free(&store);
+    r->wall_ms = ms_since(t0);
+    free(version); free(pages); free(ptrs); free(ids);
+    return 0;
+}
+
+static double mb_s(uint64_t pages, double ms) {
+    return ms > 0 ? pages * (double)STORE_PAGE_SIZE / (1024.0 * 1024.0) / (ms / 1e3) : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t max_ranks = argc > 1 ? strtoul(argv[1], NULL, 0) : 40;
+    uint32_t batch = argc > 2 ? strtoul(argv[2], NULL, 0) : 256;
+    uint32_t nr_batches = argc > 3 ? strtoul(argv[3], NULL, 0) : 50;
+    const char* model_path = argc > 4 ? argv[4] : NULL;
+    uint32_t ranks_list[16];
+    int nr_points = 0, nr_results = 0, ok = 1;
+    model_result_t* results;
+    cost_model_t model;
+
+    if (max_ranks == 0 || batch == 0 || batch > STORE_PAGE_SIZE) {
+        fprintf(stderr, "Usage: %s [max_ranks] [batch] [nr_batches] [model_file]\n", argv[0]);
+        return 1;
+    }
+    cost_model_default(&model);
+    if (model_path && cost_model_load(&model, model_path) != 0) {
+        return 1;
+    }
+    for (uint32_t ranks = 1; ranks < max_ranks && nr_points < 15; ranks *= 2) {
+        ranks_list[nr_points++] = ranks;
+    }
+    ranks_list[nr_points++] = max_ranks;
+    results = calloc(2 * nr_points, sizeof(model_result_t));
+    if (!results) return 1;
+
+    printf("=== UPMEM COST MODEL SCALING BENCHMARK ===\n");
+    printf("Model: %s (push %.1f µs + %.2f µs/DPU + %.4f ns/B, launch %.1f µs, "
+           "%u ranks at once)\n", model_path ? model_path : "default", model.push_ns / 1e3,
+           model.dpu_ns / 1e3, model.byte_ns, model.launch_ns / 1e3, model.rank_parallelism);
+    printf("Batches of %u pages, %u put + %u get batches, %d pages per DPU\n\n", batch,
+           nr_batches, nr_batches, PAGES_PER_DPU);
+
+    printf("%6s %6s %-8s %12s %12s %10s %10s %10s\n", "ranks", "DPUs", "xfer", "put MB/s",
+           "get MB/s", "pushes", "launches", "wall ms");
+    for (int p = 0; p < nr_points; p++)
+    for (int uniform = 0; uniform < 2; uniform++) {
+        model_result_t* r = &results[nr_results++];
+        if (run_point(&model, ranks_list[p], batch, nr_batches, uniform, r) != 0) {
+            r->ok = 0;
+        }
+        printf("%6u %6u %-8s %12.1f %12.1f %10llu %10llu %10.1f %s\n", r->ranks,
+               r->ranks * STORE_DPUS_PER_RANK, uniform ? "uniform" : "per-page",
+               mb_s(r->pages_put, r->put_model_ms), mb_s(r->pages_got, r->get_model_ms),
+               (unsigned long long)r->pushes, (unsigned long long)r->launches, r->wall_ms,
+               r->ok ? "✓ OK" : "✗ FAIL");
+        ok &= r->ok;
+    }
+
+    FILE* f = fopen("model_results.csv", "w");
+    if (f) {
+        fprintf(f, "ranks,nr_dpus,xfer,batch,nr_batches,push_ns,dpu_ns,byte_ns,launch_ns,rank_parallelism,put_model_ms,get_model_ms,put_mbps,get_mbps,pushes,launches,wall_ms,ok\n");
+        for (int i = 0; i < nr_results; i++) {
+            const model_result_t* r = &results[i];
+            fprintf(f, "%u,%u,%s,%u,%u,%.1f,%.1f,%.6f,%.1f,%u,%.3f,%.3f,%.2f,%.2f,%llu,%llu,%.1f,%d\n",
+                    r->ranks, r->ranks * STORE_DPUS_PER_RANK,
+                    r->uniform ? "uniform" : "per-page", batch, nr_batches, model.push_ns,
+                    model.dpu_ns, model.byte_ns, model.launch_ns, model.rank_parallelism,
+                    r->put_model_ms, r->get_model_ms, mb_s(r->pages_put, r->put_model_ms),
+                    mb_s(r->pages_got, r->get_model_ms), (unsigned long long)r->pushes,
+                    (unsigned long long)r->launches, r->wall_ms, r->ok);
+        }
+        fclose(f);
+        printf("\n✓ Results saved to model_results.csv\n");
+    }
+    free(results);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "swap_store.h"
+#include "numa_topo.h"
+
+/*
+ * NUMA placement: the benchmark thread and its pages live on node 0, and
+ * the same put/get workload runs with the store's staging buffers, workers
+ * and pages on node 0 (local), on another node (remote), and with NUMA
+ * placement off (the store's buffers land wherever they are first touched).
+ *
+ * Without the SDK the emulated MRAM of each rank is bound to the rank's
+ * node, so a remote store pays the interconnect on every page like a
+ * remote DIMM would. A single-node box can be tested by booting with
+ * numa=fake=2; with one node, remote is the same node as local.
+ *
+ * Usage: benchmark_numa [nr_dpus] [dpus_per_rank] [nr_pages] [batch]
+ */
+
+#define THREAD_NODE 0
+
+typedef enum { MODE_OFF, MODE_LOCAL, MODE_REMOTE, NR_MODES } numa_mode_t;
+
+static const char* const mode_names[NR_MODES] = {"off", "local", "remote"};
+
+typedef struct {
+    long min;
+    long max;
+    long mean;
+    long p50;
+    long p99;
+} stats_t;
+
+typedef struct {
+    int home_node;
+    double put_mb_s;
+    double get_mb_s;
+    stats_t get_stats;              /* per batch */
+    uint64_t local_puts;
+    uint64_t remote_puts;
+    uint32_t placed_ok;             /* DPUs whose MRAM is on their rank's node */
+    uint32_t placed_checked;
+    int ok;
+} numa_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+stats_t calculate_stats(long* latencies, size_t n) {
+    stats_t s;
+    long sum = 0;
+
+    qsort(latencies, n, sizeof(long), cmp_long);
+    for (size_t i = 0; i < n; i++) {
+        sum += latencies[i];
+    }
+    s.min = latencies[0];
+    s.max = latencies[n - 1];
+    s.mean = sum / (long)n;
+    s.p50 = latencies[n / 2];
+    s.p99 = latencies[n * 99 / 100 < n ? n * 99 / 100 : n - 1];
+    return s;
+}
+
+static void fill_page(uint8_t* page, size_t index) {
+    unsigned seed = (unsigned)index * 2654435761U;
+    for (size_t i = 0; i < STORE_PAGE_SIZE; i += sizeof(uint32_t)) {
+        uint32_t v = (uint32_t)rand_r(&seed);
+        memcpy(page + i, &v, sizeof(v));
+    }
+}
+
+/* Put all pages once, in batches; returns the elapsed ns or -1 */
+static long put_all(swap_store_t* store, uint8_t* pages, size_t nr_pages, size_t batch,
+                    uint64_t* ids, const uint8_t** src) {
+    struct timespec t_start, t_end;
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    for (size_t first = 0; first < nr_pages; first += batch) {
+        size_t n = nr_pages - first < batch ? nr_pages - first : batch;
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = first + i;
+            src[i] = pages + (first + i) * STORE_PAGE_SIZE;
+        }
+        if (swap_store_put_batch(store, ids, src, n) != 0) return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    return timespec_to_ns(diff_time(t_start, t_end));
+}
+
+static int run_mode(numa_mode_t mode, uint32_t nr_dpus, uint32_t dpus_per_rank,
+                    uint8_t* pages, size_t nr_pages, size_t batch, numa_result_t* r) {
+    int nr_nodes = numa_topo_nr_nodes();
+    size_t nr_batches = (nr_pages + batch - 1) / batch;
+    swap_store_config_t cfg;
+    swap_store_t store;
+
+    memset(r, 0, sizeof(*r));
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.max_pages = (uint32_t)nr_pages;
+    cfg.dpus_per_rank = dpus_per_rank;
+    cfg.numa = mode != MODE_OFF;
+    cfg.numa_node = mode == MODE_REMOTE ? (THREAD_NODE + 1) % nr_nodes : THREAD_NODE;
+    /* Room for every page on the home node's ranks, plus the rewrite */
+    cfg.mram_size = STORE_MRAM_SIZE;
+
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store (%s)\n", mode_names[mode]);
+        return -1;
+    }
+    r->home_node = store.home_node;
+
+    uint64_t* ids = malloc(batch * sizeof(uint64_t));
+    const uint8_t** src = malloc(batch * sizeof(uint8_t*));
+    uint8_t** dst = malloc(batch * sizeof(uint8_t*));
+    uint8_t* out = numa_topo_alloc(batch * STORE_PAGE_SIZE, THREAD_NODE);
+    long* latencies = malloc(nr_batches * sizeof(long));
+    if (!ids || !src || !dst || !out || !latencies) {
+        fprintf(stderr, "Failed to allocate batch buffers\n");
+        swap_store_free(&store);
+        return -1;
+    }
+    for (size_t i = 0; i < batch; i++) {
+        dst[i] = out + i * STORE_PAGE_SIZE;
+    }
+
+    /* First pass faults the store in; the timed one rewrites every page */
+    long put_ns = -1;
+    if (put_all(&store, pages, nr_pages, batch, ids, src) >= 0) {
+        put_ns = put_all(&store, pages, nr_pages, batch, ids, src);
+    }
+    r->ok = put_ns > 0;
+
+    /* Random batches of gets, each checked */
+    unsigned seed = 7;
+    long get_ns = 0;
+    for (size_t b = 0; b < nr_batches && r->ok; b++) {
+        struct timespec t_start, t_end;
+        for (size_t i = 0; i < batch; i++) {
+            ids[i] = (uint64_t)rand_r(&seed) % nr_pages;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        if (swap_store_get_batch(&store, ids, dst, batch) != 0) r->ok = 0;
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+        latencies[b] = timespec_to_ns(diff_time(t_start, t_end));
+        get_ns += latencies[b];
+        for (size_t i = 0; i < batch && r->ok; i++) {
+            if (memcmp(dst[i], pages + ids[i] * STORE_PAGE_SIZE, STORE_PAGE_SIZE) != 0) {
+                r->ok = 0;
+            }
+        }
+    }
+
+    if (r->ok) {
+        double mb = (double)nr_pages * STORE_PAGE_SIZE / (1024.0 * 1024.0);
+        r->put_mb_s = mb / (put_ns / 1e9);
+        r->get_mb_s = (double)nr_batches * batch * STORE_PAGE_SIZE / (1024.0 * 1024.0) /
+                      (get_ns / 1e9);
+        r->get_stats = calculate_stats(latencies, nr_batches);
+    }
+    r->local_puts = store.stats.local_puts;
+    r->remote_puts = store.stats.remote_puts;
+
+    /* Where the emulated MRAM really is (host memory fallback only) */
+    if (cfg.numa && !store.dpu_backed) {
+        for (uint32_t d = 0; d < store.nr_dpus; d++) {
+            if (store.dpu_node[d] < 0) continue;
+            r->placed_checked++;
+            if (numa_topo_page_node(store.ram_mram[d]) == store.dpu_node[d]) r->placed_ok++;
+        }
+    }
+
+    swap_store_free(&store);
+    free(ids);
+    free(src);
+    free(dst);
+    numa_topo_free(out, batch * STORE_PAGE_SIZE);
+    free(latencies);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t nr_dpus = argc > 1 ? strtoul(argv[1], NULL, 0) : 16;
+    uint32_t dpus_per_rank = argc > 2 ? strtoul(argv[2], NULL, 0) : 4;
+    size_t nr_pages = argc > 3 ? strtoul(argv[3], NULL, 0) : 16384;
+    size_t batch = argc > 4 ? strtoul(argv[4], NULL, 0) : 64;
+    int nr_nodes = numa_topo_nr_nodes();
+    numa_result_t results[NR_MODES];
+    int ok = 1;
+
+    if (nr_dpus == 0 || dpus_per_rank == 0 || nr_pages == 0 || batch == 0) {
+        fprintf(stderr, "Usage: %s [nr_dpus] [dpus_per_rank] [nr_pages] [batch]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== UPMEM NUMA PLACEMENT BENCHMARK ===\n");
+    printf("Nodes: %d, DPUs: %u (%u per rank), pages: %zu (%.0f MB), batch: %zu\n",
+           nr_nodes, nr_dpus, dpus_per_rank, nr_pages,
+           nr_pages * STORE_PAGE_SIZE / (1024.0 * 1024.0), batch);
+    if (nr_nodes < 2) {
+        printf("Single node: remote runs on node %d too (boot with numa=fake=2 to test)\n",
+               THREAD_NODE);
+    }
+    if (numa_topo_bind_thread(pthread_self(), THREAD_NODE) != 0) {
+        printf("Could not bind the benchmark thread to node %d\n", THREAD_NODE);
+    }
+    printf("\n");
+
+    uint8_t* pages = numa_topo_alloc(nr_pages * STORE_PAGE_SIZE, THREAD_NODE);
+    if (!pages) {
+        fprintf(stderr, "Failed to allocate %zu pages\n", nr_pages);
+        return 1;
+    }
+    for (size_t i = 0; i < nr_pages; i++) {
+        fill_page(pages + i * STORE_PAGE_SIZE, i);
+    }
+
+    printf("%-7s %5s %10s %10s %10s %10s %12s %9s\n",
+           "mode", "home", "put MB/s", "get MB/s", "p50 µs", "p99 µs", "local/remote", "placed");
+    for (int m = 0; m < NR_MODES; m++) {
+        numa_result_t* r = &results[m];
+        if (run_mode((numa_mode_t)m, nr_dpus, dpus_per_rank, pages, nr_pages, batch, r) != 0) {
+            r->ok = 0;
+        }
+        printf("%-7s %5d %10.1f %10.1f %10.1f %10.1f %6llu/%-5llu %4u/%-4u %s\n",
+               mode_names[m], r->home_node, r->put_mb_s, r->get_mb_s,
+               r->get_stats.p50 / 1e3, r->get_stats.p99 / 1e3,
+               (unsigned long long)r->local_puts, (unsigned long long)r->remote_puts,
+               r->placed_ok, r->placed_checked, r->ok ? "✓ OK" : "✗ FAIL");
+        ok &= r->ok;
+    }
+    if (results[MODE_LOCAL].ok && results[MODE_REMOTE].ok && results[MODE_REMOTE].get_mb_s > 0) {
+        printf("\nLocal vs remote: %.2fx put, %.2fx get throughput\n",
+               results[MODE_LOCAL].put_mb_s / results[MODE_REMOTE].put_mb_s,
+               results[MODE_LOCAL].get_mb_s / results[MODE_REMOTE].get_mb_s);
+    }
+
+    FILE* f = fopen("numa_results.csv", "w");
+    if (f) {
+        fprintf(f, "mode,nodes,thread_node,home_node,nr_dpus,dpus_per_rank,pages,batch,put_mb_s,get_mb_s,get_p50_us,get_p99_us,local_puts,remote_puts,placed_ok,placed_checked,ok\n");
+        for (int m = 0; m < NR_MODES; m++) {
+            const numa_result_t* r = &results[m];
+            fprintf(f, "%s,%d,%d,%d,%u,%u,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%llu,%llu,%u,%u,%d\n",
+                    mode_names[m], nr_nodes, THREAD_NODE, r->home_node, nr_dpus, dpus_per_rank,
+                    nr_pages, batch, r->put_mb_s, r->get_mb_s,
+                    r->get_stats.p50 / 1e3, r->get_stats.p99 / 1e3,
+                    (unsigned long long)r->local_puts, (unsigned long long)r->remote_puts,
+                    r->placed_ok, r->placed_checked, r->ok);
+        }
+        fclose(f);
+        printf("\n✓ Results saved to numa_results.csv\n");
+    }
+
+    numa_topo_free(pages, nr_pages * STORE_PAGE_SIZE);
+    return ok ? 0 : 1;
+}
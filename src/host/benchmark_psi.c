@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "psi_daemon.h"
+
+/*
+ * Application latency under memory pressure.
+ *
+ * A stress loop read-modify-writes 8-byte counters spread over a working
+ * set of wss_mb; 10% of the pages get 90% of the operations. Every
+ * operation is timed, page faults included.
+ *
+ *   dpu    the working set is a userfaultfd region, the PSI daemon evicts
+ *          its cold pages to the page store (compression and delta puts on)
+ *   kswap  plain anonymous memory, left to the kernel: run it in a cgroup
+ *          with memory.max below wss_mb and a swap file to compare
+ *
+ * max_resident_mb caps the region in dpu mode when the cgroup has no
+ * memory limit (or no memory controller). scripts/psi_stress.sh sets up
+ * the cgroup and runs both modes.
+ *
+ * Usage: benchmark_psi <dpu|kswap> [wss_mb] [seconds] [max_resident_mb]
+ */
+
+#define DEFAULT_WSS_MB 256
+#define DEFAULT_SECONDS 10
+#define HOT_PERCENT 10
+#define HOT_OPS_PERCENT 90
+#define MAX_SAMPLES (1 << 22)
+#define SLOTS_PER_PAGE (STORE_PAGE_SIZE / sizeof(uint64_t))
+
+typedef struct {
+    long min, max, mean, stddev, p50, p99, p999;
+} stats_t;
+
+typedef struct {
+    const char* mode;
+    size_t wss_mb;
+    size_t max_resident_mb;
+    int seconds;
+    uint64_t ops;
+    double ops_per_sec;
+    stats_t lat;
+    uffd_region_stats_t region;
+    psi_daemon_stats_t daemon;
+    int verified;
+} psi_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+stats_t calculate_stats(long* latencies, int n) {
+    stats_t s;
+    s.min = latencies[0];
+    s.max = latencies[0];
+    long sum = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (latencies[i] < s.min) s.min = latencies[i];
+        if (latencies[i] > s.max) s.max = latencies[i];
+        sum += latencies[i];
+    }
+    s.mean = sum / n;
+
+    double variance_sum = 0;
+    for (int i = 0; i < n; i++) {
+        double diff = (double)(latencies[i] - s.mean);
+        variance_sum += diff * diff;
+    }
+    s.stddev = (long)sqrt(variance_sum / n);
+
+    qsort(latencies, n, sizeof(long), cmp_long);
+    s.p50 = latencies[n / 2];
+    s.p99 = latencies[(size_t)n * 99 / 100];
+    s.p999 = latencies[(size_t)n * 999 / 1000];
+
+    return s;
+}
+
+static uint64_t xorshift(uint64_t* x) {
+    *x ^= *x << 13;
+    *x ^= *x >> 7;
+    *x ^= *x << 17;
+    return *x;
+}
+
+/* Stress loop over mem; shadow holds the expected sum of every page */
+static void run_stress(uint8_t* mem, size_t nr_pages, int seconds,
+                       uint64_t* shadow, long* samples, psi_result_t* result) {
+    size_t hot_pages = nr_pages * HOT_PERCENT / 100 ? nr_pages * HOT_PERCENT / 100 : 1;
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    struct timespec t_begin, t_start, t_end;
+    uint64_t ops = 0;
+    long deadline = (long)seconds * 1000000000L;
+
+    clock_gettime(CLOCK_MONOTONIC, &t_begin);
+    t_end = t_begin;
+    while (timespec_to_ns(diff_time(t_begin, t_end)) < deadline) {
+        uint64_t r = xorshift(&rng);
+        size_t page = (r % 100) < HOT_OPS_PERCENT ? (r >> 8) % hot_pages : (r >> 8) % nr_pages;
+        size_t slot = (r >> 40) % SLOTS_PER_PAGE;
+        uint64_t* word = (uint64_t*)(mem + page * STORE_PAGE_SIZE) + slot;
+
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        *word += 1;
+        clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+        shadow[page]++;
+        samples[ops % MAX_SAMPLES] = timespec_to_ns(diff_time(t_start, t_end));
+        ops++;
+    }
+
+    result->ops = ops;
+    result->ops_per_sec = ops / (timespec_to_ns(diff_time(t_begin, t_end)) / 1e9);
+    result->lat = calculate_stats(samples, ops < MAX_SAMPLES ? (int)ops : MAX_SAMPLES);
+
+    result->verified = 1;
+    for (size_t p = 0; p < nr_pages; p++) {
+        const uint64_t* words = (const uint64_t*)(mem + p * STORE_PAGE_SIZE);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < SLOTS_PER_PAGE; i++) sum += words[i];
+        if (sum != shadow[p]) {
+            result->verified = 0;
+            break;
+        }
+    }
+}
+
+psi_result_t run_benchmark(const char* mode, size_t wss_mb, int seconds, size_t max_resident_mb,
+                           const char* trace_file) {
+    psi_result_t result = {0};
+    size_t size = wss_mb << 20;
+    size_t nr_pages = size / STORE_PAGE_SIZE;
+    uint64_t* shadow = calloc(nr_pages, sizeof(uint64_t));
+    long* samples = malloc(MAX_SAMPLES * sizeof(long));
+
+    result.mode = mode;
+    result.wss_mb = wss_mb;
+    result.max_resident_mb = max_resident_mb;
+    result.seconds = seconds;
+    if (!shadow || !samples) {
+        fprintf(stderr, "Failed to allocate benchmark state\n");
+        exit(1);
+    }
+
+    if (strcmp(mode, "dpu") == 0) {
+        swap_store_config_t store_cfg;
+        psi_daemon_config_t cfg;
+        swap_store_t store;
+        uffd_region_t region;
+        psi_daemon_t daemon;
+        page_trace_t trace;
+
+        swap_store_default_config(&store_cfg);
+        store_cfg.max_pages = nr_pages;
+        store_cfg.compress = 1;
+        store_cfg.delta = 1;
+        if (swap_store_init(&store, &store_cfg) != 0 || uffd_region_init(&region, size, 0) != 0) {
+            fprintf(stderr, "Failed to initialize page store or region\n");
+            exit(1);
+        }
+        if (trace_file) {
+            if (page_trace_create(&trace, trace_file, STORE_PAGE_SIZE, PAGE_TRACE_SRC_UFFD,
+                                  (uint64_t)time(NULL) * 1000000000ULL) != 0) {
+                exit(1);
+            }
+            uffd_region_set_trace(&region, &trace);
+        }
+        psi_daemon_default_config(&cfg);
+        cfg.max_resident = (uint64_t)max_resident_mb << 20;
+        if (psi_daemon_start(&daemon, &cfg, &region, &store) != 0) {
+            exit(1);
+        }
+
+        run_stress(region.base, nr_pages, seconds, shadow, samples, &result);
+
+        psi_daemon_stop(&daemon);
+        if (trace_file) {
+            uint64_t records = trace.records, bytes = trace.bytes;
+            int closed = page_trace_close(&trace) == 0;
+            if (region.trace == NULL || !closed) {
+                fprintf(stderr, "Trace %s is incomplete\n", trace_file);
+            }
+            printf("Trace: %llu records, %.2f bytes each, in %s\n\n", (unsigned long long)records,
+                   records ? (double)bytes / records : 0.0, trace_file);
+        }
+        result.region = region.stats;
+        result.daemon = daemon.stats;
+        uffd_region_free(&region);
+        swap_store_free(&store);
+    } else {
+        uint8_t* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            fprintf(stderr, "Failed to map %zu MB\n", wss_mb);
+            exit(1);
+        }
+        run_stress(mem, nr_pages, seconds, shadow, samples, &result);
+        munmap(mem, size);
+    }
+
+    free(samples);
+    free(shadow);
+    return result;
+}
+
+void print_result(const psi_result_t* r) {
+    printf("%s:\n", strcmp(r->mode, "dpu") == 0 ? "PSI DAEMON + PAGE STORE" : "KERNEL SWAP");
+    printf("  Ops:          %llu (%.0f ops/s)\n", (unsigned long long)r->ops, r->ops_per_sec);
+    printf("  Latency:      p50 %.2f µs, p99 %.2f µs, p99.9 %.2f µs, max %.2f ms\n",
+           r->lat.p50 / 1000.0, r->lat.p99 / 1000.0, r->lat.p999 / 1000.0, r->lat.max / 1e6);
+    if (strcmp(r->mode, "dpu") == 0) {
+        printf("  Faults:       %llu (%llu zero fills, %llu swap-ins, %llu on write-protect)\n",
+               (unsigned long long)r->region.faults, (unsigned long long)r->region.zero_fills,
+               (unsigned long long)r->region.swapins, (unsigned long long)r->region.wp_faults);
+        printf("  Fault time:   %.2f µs per swap-in\n",
+               r->region.faults ? r->region.fault_ns / 1000.0 / r->region.faults : 0.0);
+        printf("  Evicted:      %llu pages in %llu batches (%.2f ms evicting)\n",
+               (unsigned long long)r->daemon.evicted_pages, (unsigned long long)r->daemon.batches,
+               r->daemon.evict_ns / 1e6);
+        printf("  Daemon:       %llu checks, %llu under pressure, %llu PSI triggers, max avg10 %.2f\n",
+               (unsigned long long)r->daemon.ticks, (unsigned long long)r->daemon.pressure_ticks,
+               (unsigned long long)r->daemon.trigger_events, r->daemon.max_psi);
+    }
+    printf("  Verification: %s\n\n", r->verified ? "✓ OK" : "✗ FAIL");
+}
+
+/* Appends, so that both modes of scripts/psi_stress.sh end up in one file */
+void save_results_csv(const psi_result_t* r, const char* filename) {
+    int new_file = access(filename, F_OK) != 0;
+    FILE* f = fopen(filename, "a");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", filename);
+        return;
+    }
+    if (new_file) {
+        fprintf(f, "mode,wss_mb,max_resident_mb,seconds,ops,ops_per_sec,p50_us,p99_us,p999_us,max_us,faults,swapins,evicted_pages,batches,max_psi_avg10\n");
+    }
+    fprintf(f, "%s,%zu,%zu,%d,%llu,%.0f,%.2f,%.2f,%.2f,%.2f,%llu,%llu,%llu,%llu,%.2f\n",
+            r->mode, r->wss_mb, r->max_resident_mb, r->seconds,
+            (unsigned long long)r->ops, r->ops_per_sec,
+            r->lat.p50 / 1000.0, r->lat.p99 / 1000.0, r->lat.p999 / 1000.0, r->lat.max / 1000.0,
+            (unsigned long long)r->region.faults, (unsigned long long)r->region.swapins,
+            (unsigned long long)r->daemon.evicted_pages, (unsigned long long)r->daemon.batches,
+            r->daemon.max_psi);
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    const char* mode = argc > 1 ? argv[1] : "";
+    size_t wss_mb = argc > 2 ? strtoul(argv[2], NULL, 0) : DEFAULT_WSS_MB;
+    int seconds = argc > 3 ? atoi(argv[3]) : DEFAULT_SECONDS;
+    size_t max_resident_mb = argc > 4 ? strtoul(argv[4], NULL, 0) : 0;
+    const char* trace_file = argc > 5 ? argv[5] : NULL;
+
+    if ((strcmp(mode, "dpu") != 0 && strcmp(mode, "kswap") != 0) || wss_mb == 0 || seconds <= 0) {
+        fprintf(stderr, "Usage: %s <dpu|kswap> [wss_mb] [seconds] [max_resident_mb] [trace_file]\n",
+                argv[0]);
+        return 1;
+    }
+
+    printf("=== UPMEM PSI EVICTION BENCHMARK ===\n");
+    printf("Mode: %s, working set: %zu MB (%d%% hot for %d%% of ops), %d s",
+           mode, wss_mb, HOT_PERCENT, HOT_OPS_PERCENT, seconds);
+    if (max_resident_mb) printf(", max resident: %zu MB", max_resident_mb);
+    printf("\n\n");
+
+    psi_result_t result = run_benchmark(mode, wss_mb, seconds, max_resident_mb, trace_file);
+    print_result(&result);
+
+    save_results_csv(&result, "psi_stress_results.csv");
+    printf("✓ Results appended to psi_stress_results.csv\n");
+
+    return result.verified ? 0 : 1;
+}
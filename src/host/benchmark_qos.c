@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "swap_store.h"
+#include "qos_sched.h"
+
+/*
+ * Multi-tenant QoS: four tenants share one store, through the QoS
+ * scheduler (qos_sched.h), under contention:
+ *
+ *   interactive  weight 4, demand faults of one page
+ *   prefetch     weight 2, prefetch reads of 16 pages
+ *   batch        weight 1, writeback of 64 pages, several threads
+ *   quota        weight 1, writeback of new pages against a 2MB quota
+ *
+ * Three policies: fifo (arrival order, the store with no arbitration),
+ * qos (priority + weighted fair queuing + quota), and qos with a bandwidth
+ * cap on the batch tenant. Latency is measured from submission to
+ * completion, so queueing behind other tenants counts. Reads are checked
+ * against what was written.
+ *
+ * Usage: benchmark_qos [nr_dpus] [seconds] [batch_cap_mb_s]
+ */
+
+#define WORKING_SET 1024            /* pages per tenant, preloaded */
+#define QUOTA_IDS 2048              /* ids the quota tenant cycles through */
+#define QUOTA_BYTES (2 * 1024 * 1024)
+#define MAX_BATCH 64
+#define MAX_SAMPLES (1 << 17)
+#define MRAM_SIZE (8 * 1024 * 1024)
+
+enum { T_INTERACTIVE, T_PREFETCH, T_BATCH, T_QUOTA, NR_TENANTS };
+enum { POLICY_FIFO, POLICY_QOS, POLICY_CAP, NR_POLICIES };
+
+typedef struct {
+    const char* name;
+    int cls;
+    int op;
+    uint32_t batch;
+    uint32_t weight;
+    int nr_threads;
+} tenant_spec_t;
+
+static const tenant_spec_t specs[NR_TENANTS] = {
+    {"interactive", QOS_DEMAND, QOS_OP_GET, 1, 4, 2},
+    {"prefetch", QOS_PREFETCH, QOS_OP_GET, 16, 2, 2},
+    {"batch", QOS_WRITEBACK, QOS_OP_PUT, MAX_BATCH, 1, 4},
+    {"quota", QOS_WRITEBACK, QOS_OP_PUT, 16, 1, 1},
+};
+
+static const char* policy_names[NR_POLICIES] = {"fifo", "qos", "qos+cap"};
+
+typedef struct {
+    qos_sched_t* sched;
+    int tenant;
+    const tenant_spec_t* spec;
+    unsigned seed;
+    volatile int* stop;
+    uint64_t next_id;               /* quota tenant: next id to write */
+    long* lat_ns;
+    size_t nr_lat;
+    uint64_t ops;
+    uint64_t bad_pages;
+} client_t;
+
+typedef struct {
+    int policy;
+    int tenant;
+    double ops_s;
+    double mb_s;
+    long p50_us, p99_us;
+    uint64_t throttled;
+    uint64_t quota_rejects;
+    uint64_t mram_kb;
+    int ok;
+} qos_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+static long percentile(const long* sorted, size_t n, size_t per_mille) {
+    size_t i = n * per_mille / 1000;
+    return n ? sorted[i < n ? i : n - 1] : 0;
+}
+
+static void fill_page(uint8_t* page, int tenant, uint64_t id) {
+    uint64_t* w = (uint64_t*)page;
+    for (size_t i = 0; i < STORE_PAGE_SIZE / sizeof(uint64_t); i++) {
+        w[i] = ((uint64_t)tenant << 56) ^ (id * 0x9E3779B97F4A7C15ULL) ^ i;
+    }
+}
+
+static void* client_main(void* arg) {
+    client_t* c = arg;
+    const tenant_spec_t* spec = c->spec;
+    uint8_t* data = malloc((size_t)spec->batch * STORE_PAGE_SIZE);
+    uint8_t* ptrs[MAX_BATCH];
+    uint64_t ids[MAX_BATCH];
+    uint8_t expected[STORE_PAGE_SIZE];
+
+    if (!data) return NULL;
+    for (uint32_t i = 0; i < spec->batch; i++) {
+        ptrs[i] = data + (size_t)i * STORE_PAGE_SIZE;
+    }
+    while (!*c->stop) {
+        qos_req_t req;
+        uint64_t base = (uint64_t)rand_r(&c->seed) % WORKING_SET;
+
+        for (uint32_t i = 0; i < spec->batch; i++) {
+            if (c->tenant == T_QUOTA) ids[i] = c->next_id++ % QUOTA_IDS;
+            else ids[i] = (base + i) % WORKING_SET;
+            if (spec->op == QOS_OP_PUT) fill_page(ptrs[i], c->tenant, ids[i]);
+        }
+        memset(&req, 0, sizeof(req));
+        req.op = spec->op;
+        req.cls = spec->cls;
+        req.page_ids = ids;
+        req.pages = ptrs;
+        req.n = spec->batch;
+        int ret = qos_sched_submit(c->sched, c->tenant, &req);
+
+        if (c->nr_lat < MAX_SAMPLES) c->lat_ns[c->nr_lat++] = (long)(req.done_ns - req.submit_ns);
+        c->ops++;
+        if (ret == 0 && spec->op == QOS_OP_GET) {
+            for (uint32_t i = 0; i < spec->batch; i++) {
+                fill_page(expected, c->tenant, ids[i]);
+                if (memcmp(ptrs[i], expected, STORE_PAGE_SIZE) != 0) c->bad_pages++;
+            }
+        }
+    }
+    free(data);
+    return NULL;
+}
+
+/* Working sets of every tenant but quota, as writeback */
+static int preload(qos_sched_t* sched, const int* tenant_ids) {
+    uint8_t* data = malloc((size_t)MAX_BATCH * STORE_PAGE_SIZE);
+    uint8_t* ptrs[MAX_BATCH];
+    uint64_t ids[MAX_BATCH];
+    int ret = 0;
+
+    if (!data) return -1;
+    for (int t = 0; t < NR_TENANTS && ret == 0; t++) {
+        if (t == T_QUOTA) continue;
+        for (uint64_t first = 0; first < WORKING_SET && ret == 0; first += MAX_BATCH) {
+            qos_req_t req;
+            for (uint32_t i = 0; i < MAX_BATCH; i++) {
+                ids[i] = first + i;
+                ptrs[i] = data + (size_t)i * STORE_PAGE_SIZE;
+                fill_page(ptrs[i], t, ids[i]);
+            }
+            memset(&req, 0, sizeof(req));
+            req.op = QOS_OP_PUT;
+            req.cls = QOS_WRITEBACK;
+            req.page_ids = ids;
+            req.pages = ptrs;
+            req.n = MAX_BATCH;
+            ret = qos_sched_submit(sched, tenant_ids[t], &req);
+        }
+    }
+    free(data);
+    return ret;
+}
+
+static int run_policy(uint32_t nr_dpus, double seconds, uint64_t batch_cap, int policy,
+                      qos_result_t* results) {
+    client_t clients[16];
+    pthread_t threads[16];
+    int tenant_ids[NR_TENANTS];
+    int nr_clients = 0;
+    volatile int stop = 0;
+    swap_store_config_t cfg;
+    swap_store_t store;
+    qos_sched_t sched;
+    int ret = 0;
+
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.mram_size = MRAM_SIZE;
+    cfg.max_pages = 4 * (NR_TENANTS * WORKING_SET + QUOTA_IDS);
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        return -1;
+    }
+    if (qos_sched_init(&sched, &store, policy == POLICY_FIFO) != 0) {
+        swap_store_free(&store);
+        return -1;
+    }
+    for (int t = 0; t < NR_TENANTS; t++) {
+        qos_tenant_config_t tc = {specs[t].weight, 0, 0};
+        if (t == T_QUOTA) tc.mram_quota = QUOTA_BYTES;
+        if (t == T_BATCH && policy == POLICY_CAP) tc.bw_cap = batch_cap;
+        tenant_ids[t] = qos_sched_add_tenant(&sched, &tc);
+    }
+    if (preload(&sched, tenant_ids) != 0) {
+        fprintf(stderr, "Failed to preload working sets\n");
+        ret = -1;
+    }
+
+    for (int t = 0; t < NR_TENANTS && ret == 0; t++) {
+        for (int k = 0; k < specs[t].nr_threads; k++) {
+            client_t* c = &clients[nr_clients];
+            memset(c, 0, sizeof(*c));
+            c->sched = &sched;
+            c->tenant = tenant_ids[t];
+            c->spec = &specs[t];
+            c->seed = (unsigned)(t * 100 + k + 1);
+            c->stop = &stop;
+            c->next_id = (uint64_t)k * QUOTA_IDS / specs[t].nr_threads;
+            c->lat_ns = malloc(MAX_SAMPLES * sizeof(long));
+            if (!c->lat_ns || pthread_create(&threads[nr_clients], NULL, client_main, c) != 0) {
+                free(c->lat_ns);
+                ret = -1;
+                break;
+            }
+            nr_clients++;
+        }
+    }
+    usleep((useconds_t)(seconds * 1e6));
+    stop = 1;
+    for (int i = 0; i < nr_clients; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int t = 0; t < NR_TENANTS; t++) {
+        qos_result_t* r = &results[t];
+        qos_tenant_stats_t st;
+        long* lat = malloc((size_t)MAX_SAMPLES * specs[t].nr_threads * sizeof(long));
+        size_t nr_lat = 0;
+        uint64_t ops = 0, bad = 0;
+
+        memset(r, 0, sizeof(*r));
+        r->policy = policy;
+        r->tenant = t;
+        for (int i = 0; i < nr_clients; i++) {
+            if (clients[i].tenant != tenant_ids[t]) continue;
+            if (lat) {
+                memcpy(lat + nr_lat, clients[i].lat_ns, clients[i].nr_lat * sizeof(long));
+                nr_lat += clients[i].nr_lat;
+            }
+            ops += clients[i].ops;
+            bad += clients[i].bad_pages;
+        }
+        if (lat) qsort(lat, nr_lat, sizeof(long), cmp_long);
+        qos_sched_tenant_stats(&sched, tenant_ids[t], &st);
+        r->ops_s = ops / seconds;
+        r->mb_s = (double)st.bytes / seconds / (1024.0 * 1024.0);
+        r->p50_us = lat ? percentile(lat, nr_lat, 500) / 1000 : 0;
+        r->p99_us = lat ? percentile(lat, nr_lat, 990) / 1000 : 0;
+        r->throttled = st.throttled;
+        r->quota_rejects = st.quota_rejects;
+        r->mram_kb = st.mram_used / 1024;
+        r->ok = ret == 0 && lat && bad == 0 && st.errors == 0;
+        if (policy != POLICY_FIFO && t == T_QUOTA && st.mram_used > QUOTA_BYTES) r->ok = 0;
+        free(lat);
+    }
+    for (int i = 0; i < nr_clients; i++) {
+        free(clients[i].lat_ns);
+    }
+    qos_sched_destroy(&sched);
+    swap_store_free(&store);
+    return ret;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t nr_dpus = argc > 1 ? strtoul(argv[1], NULL, 0) : 16;
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+    uint64_t cap_mb = argc > 3 ? strtoull(argv[3], NULL, 0) : 64;
+    qos_result_t results[NR_POLICIES][NR_TENANTS];
+    int ok = 1;
+
+    if (nr_dpus == 0 || seconds <= 0 || cap_mb == 0) {
+        fprintf(stderr, "Usage: %s [nr_dpus] [seconds] [batch_cap_mb_s]\n", argv[0]);
+        return 1;
+    }
+    memset(results, 0, sizeof(results));
+
+    printf("=== UPMEM MULTI-TENANT QOS BENCHMARK ===\n");
+    printf("DPUs: %u, %.1fs per policy, batch cap %llu MB/s, quota %d KB\n\n", nr_dpus,
+           seconds, (unsigned long long)cap_mb, QUOTA_BYTES / 1024);
+
+    printf("%-8s %-12s %10s %9s %9s %9s %9s %9s %9s\n", "policy", "tenant", "ops/s", "MB/s",
+           "p50 us", "p99 us", "throttled", "rejects", "mram KB");
+    for (int p = 0; p < NR_POLICIES; p++) {
+        if (run_policy(nr_dpus, seconds, cap_mb * 1024 * 1024, p, results[p]) != 0) {
+            for (int t = 0; t < NR_TENANTS; t++) results[p][t].ok = 0;
+        }
+        for (int t = 0; t < NR_TENANTS; t++) {
+            const qos_result_t* r = &results[p][t];
+            printf("%-8s %-12s %10.0f %9.1f %9ld %9ld %9llu %9llu %9llu %s\n", policy_names[p],
+                   specs[t].name, r->ops_s, r->mb_s, r->p50_us, r->p99_us,
+                   (unsigned long long)r->throttled, (unsigned long long)r->quota_rejects,
+                   (unsigned long long)r->mram_kb, r->ok ? "✓ OK" : "✗ FAIL");
+            ok &= r->ok;
+        }
+    }
+    if (results[POLICY_QOS][T_INTERACTIVE].p99_us > 0) {
+        printf("\ninteractive p99: fifo %ld us, qos %ld us (%.1fx)\n",
+               results[POLICY_FIFO][T_INTERACTIVE].p99_us,
+               results[POLICY_QOS][T_INTERACTIVE].p99_us,
+               (double)results[POLICY_FIFO][T_INTERACTIVE].p99_us /
+                   results[POLICY_QOS][T_INTERACTIVE].p99_us);
+    }
+
+    FILE* f = fopen("qos_results.csv", "w");
+    if (f) {
+        fprintf(f, "policy,tenant,nr_dpus,seconds,ops_s,mb_s,p50_us,p99_us,throttled,quota_rejects,mram_kb,ok\n");
+        for (int p = 0; p < NR_POLICIES; p++) {
+            for (int t = 0; t < NR_TENANTS; t++) {
+                const qos_result_t* r = &results[p][t];
+                fprintf(f, "%s,%s,%u,%.1f,%.1f,%.2f,%ld,%ld,%llu,%llu,%llu,%d\n",
+                        policy_names[p], specs[t].name, nr_dpus, seconds, r->ops_s, r->mb_s,
+                        r->p50_us, r->p99_us, (unsigned long long)r->throttled,
+                        (unsigned long long)r->quota_rejects, (unsigned long long)r->mram_kb,
+                        r->ok);
+            }
+        }
+        fclose(f);
+        printf("\n✓ Results saved to qos_results.csv\n");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "swap_store.h"
+#include "page_scan.h"
+
+/*
+ * Near-data scan of a cold table: swap_store_scan() against swapping
+ * every page in and scanning it on the HOST.
+ *
+ * The table is 64-byte rows (8-byte key, 4-byte value, 52 bytes of
+ * text), stored raw, compressed by the DPUs after the put (scanned by the
+ * DPUs either way) or compressed by the HOST (which has to scan those
+ * itself). Queries: a value range (~1% of rows, page ids), a key lookup
+ * (one row, records back) and a rare text pattern (page ids).
+ *
+ * Usage: benchmark_scan [nr_dpus] [nr_pages]
+ */
+
+#define ROW_SIZE 64
+#define ROWS_PER_PAGE (STORE_PAGE_SIZE / ROW_SIZE)
+#define BATCH_PAGES 256
+#define MRAM_SIZE (16 * 1024 * 1024)
+
+#define LAYOUT_RAW 0
+#define LAYOUT_DPU_COMPRESSED 1
+#define LAYOUT_HOST_COMPRESSED 2
+
+static const char* const layout_names[] = {"raw", "dpu-compressed", "host-compressed"};
+
+typedef struct {
+    int layout;
+    const char* query;
+    size_t pages_scanned;
+    size_t matching_pages;
+    size_t matching_rows;
+    double offload_ms, swapin_ms;
+    uint64_t offload_bytes;         /* bytes back over the bus */
+    uint64_t swapin_bytes;
+    uint64_t host_pages;            /* offload: pages the HOST had to scan */
+    int ok;
+} scan_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static double ms_since(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_to_ns(diff_time(start, now)) / 1e6;
+}
+
+/* Row r of the table: key r, pseudo-random value, text that sometimes
+ * names a rare item */
+static void fill_page(uint8_t* page, uint64_t page_id) {
+    static const char* const words[] = {"alpha", "bravo", "delta", "kilo", "lima", "sierra"};
+
+    memset(page, 0, STORE_PAGE_SIZE);
+    for (uint32_t i = 0; i < ROWS_PER_PAGE; i++) {
+        uint8_t* row = page + i * ROW_SIZE;
+        uint64_t key = page_id * ROWS_PER_PAGE + i;
+        uint32_t value = (uint32_t)((key * 2654435761ULL) >> 7) % 100000;
+
+        memcpy(row, &key, sizeof(key));
+        memcpy(row + 8, &value, sizeof(value));
+        snprintf((char*)row + 16, ROW_SIZE - 16, "%s-%s-%llu",
+                 key % 997 == 0 ? "zulu" : words[key % 6], words[(key / 6) % 6],
+                 (unsigned long long)(key % 1000));
+    }
+}
+
+static void make_queries(store_scan_t* q, uint64_t nr_rows) {
+    memset(q, 0, 3 * sizeof(store_scan_t));
+
+    q[0].op = STORE_SCAN_RANGE;
+    q[0].record_size = ROW_SIZE;
+    q[0].offset = 8;
+    q[0].size = 4;
+    q[0].lo = 0;
+    q[0].hi = 999;
+
+    uint64_t key = nr_rows / 3;
+    q[1].op = STORE_SCAN_KEY;
+    q[1].record_size = ROW_SIZE;
+    q[1].offset = 0;
+    q[1].size = sizeof(key);
+    memcpy(q[1].pattern, &key, sizeof(key));
+    q[1].want_records = 1;
+
+    q[2].op = STORE_SCAN_PATTERN;
+    q[2].size = 4;
+    memcpy(q[2].pattern, "zulu", 4);
+}
+
+static const char* const query_names[] = {"range", "key", "pattern"};
+
+static int load_table(swap_store_t* store, uint32_t nr_pages, int layout) {
+    static uint8_t pages[BATCH_PAGES][STORE_PAGE_SIZE];
+    const uint8_t* src[BATCH_PAGES];
+    uint64_t ids[BATCH_PAGES];
+
+    for (uint32_t base = 0; base < nr_pages; base += BATCH_PAGES) {
+        uint32_t n = nr_pages - base < BATCH_PAGES ? nr_pages - base : BATCH_PAGES;
+        for (uint32_t i = 0; i < n; i++) {
+            ids[i] = base + i;
+            fill_page(pages[i], ids[i]);
+            src[i] = pages[i];
+        }
+        if (swap_store_put_batch(store, ids, src, n) != 0) return -1;
+    }
+    if (layout == LAYOUT_DPU_COMPRESSED) {
+        int tried;
+        while ((tried = swap_store_dpu_compress(store, STORE_MAX_JOBS, NULL)) > 0) {
+        }
+        if (tried < 0) return -1;
+    }
+    return 0;
+}
+
+/* Swap everything in, scan it here */
+static int swapin_scan(swap_store_t* store, const store_scan_t* q, const uint64_t* ids,
+                       uint32_t nr_pages, size_t* pages_out, size_t* rows_out) {
+    static uint8_t pages[BATCH_PAGES][STORE_PAGE_SIZE];
+    uint8_t* dst[BATCH_PAGES];
+
+    *pages_out = 0;
+    *rows_out = 0;
+    for (uint32_t i = 0; i < BATCH_PAGES; i++) {
+        dst[i] = pages[i];
+    }
+    for (uint32_t base = 0; base < nr_pages; base += BATCH_PAGES) {
+        uint32_t n = nr_pages - base < BATCH_PAGES ? nr_pages - base : BATCH_PAGES;
+        if (swap_store_get_batch(store, ids + base, dst, n) != 0) return -1;
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t m = scan_page(q, pages[i], NULL);
+            if (m) {
+                (*pages_out)++;
+                *rows_out += m;
+            }
+        }
+    }
+    return 0;
+}
+
+static int run_layout(uint32_t nr_dpus, uint32_t nr_pages, int layout, scan_result_t* results) {
+    uint64_t* ids = malloc(nr_pages * sizeof(uint64_t));
+    uint64_t* match_ids = malloc(nr_pages * sizeof(uint64_t));
+    uint32_t* matches = malloc(nr_pages * sizeof(uint32_t));
+    size_t records_cap = 64 * STORE_PAGE_SIZE;
+    uint8_t* records = malloc(records_cap);
+    store_scan_t queries[3];
+    swap_store_config_t cfg;
+    swap_store_t store;
+    int ret = 0;
+
+    if (!ids || !match_ids || !matches || !records) {
+        free(ids); free(match_ids); free(matches); free(records);
+        return -1;
+    }
+    for (uint32_t i = 0; i < nr_pages; i++) {
+        ids[i] = i;
+    }
+    make_queries(queries, (uint64_t)nr_pages * ROWS_PER_PAGE);
+
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.mram_size = MRAM_SIZE;
+    cfg.max_pages = nr_pages;
+    cfg.compress = layout == LAYOUT_HOST_COMPRESSED;
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        free(ids); free(match_ids); free(matches); free(records);
+        return -1;
+    }
+    if (load_table(&store, nr_pages, layout) != 0) {
+        fprintf(stderr, "Failed to load the table\n");
+        ret = -1;
+        goto out;
+    }
+
+    for (int q = 0; q < 3; q++) {
+        scan_result_t* r = &results[q];
+        swap_scan_result_t res = {match_ids, matches, records, records_cap, 0, 0, 0};
+        struct timespec t0;
+        size_t ref_pages, ref_rows;
+
+        memset(r, 0, sizeof(*r));
+        r->layout = layout;
+        r->query = query_names[q];
+        r->pages_scanned = nr_pages;
+
+        uint64_t returned = store.stats.scan_returned_bytes;
+        uint64_t host_pages = store.stats.scan_host_pages;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int found = swap_store_scan(&store, &queries[q], ids, nr_pages, &res);
+        r->offload_ms = ms_since(t0);
+        r->offload_bytes = store.stats.scan_returned_bytes - returned;
+        r->host_pages = store.stats.scan_host_pages - host_pages;
+
+        uint64_t from_dpu = store.stats.bus_bytes_from_dpu;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int swapped = swapin_scan(&store, &queries[q], ids, nr_pages, &ref_pages, &ref_rows);
+        r->swapin_ms = ms_since(t0);
+        r->swapin_bytes = store.stats.bus_bytes_from_dpu - from_dpu;
+
+        r->matching_pages = res.nr_pages;
+        for (size_t i = 0; i < res.nr_pages; i++) {
+            r->matching_rows += matches[i];
+        }
+        r->ok = found >= 0 && swapped == 0 && !res.truncated && ref_pages == res.nr_pages &&
+                ref_rows == r->matching_rows;
+        if (r->ok && queries[q].want_records) {
+            /* The key lookup brings the row itself back */
+            for (size_t k = 0; k < res.records_bytes; k += ROW_SIZE) {
+                if (memcmp(records + k, queries[q].pattern, queries[q].size) != 0) r->ok = 0;
+            }
+        }
+    }
+out:
+    swap_store_free(&store);
+    free(ids); free(match_ids); free(matches); free(records);
+    return ret;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t nr_dpus = argc > 1 ? strtoul(argv[1], NULL, 0) : 16;
+    uint32_t nr_pages = argc > 2 ? strtoul(argv[2], NULL, 0) : 8192;
+    scan_result_t results[3][3];
+    int ok = 1;
+
+    memset(results, 0, sizeof(results));
+
+    if (nr_dpus == 0 || nr_pages == 0) {
+        fprintf(stderr, "Usage: %s [nr_dpus] [nr_pages]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== UPMEM NEAR-DATA SCAN BENCHMARK ===\n");
+    printf("Table: %u pages of %d-byte rows (%.1f MB) on %u DPUs\n\n", nr_pages, ROW_SIZE,
+           nr_pages * (double)STORE_PAGE_SIZE / (1024 * 1024), nr_dpus);
+
+    printf("%-16s %-8s %7s %7s %11s %11s %11s %11s %9s\n", "layout", "query", "pages",
+           "rows", "offload ms", "swapin ms", "offload KB", "swapin KB", "returned");
+    for (int layout = 0; layout < 3; layout++) {
+        if (run_layout(nr_dpus, nr_pages, layout, results[layout]) != 0) {
+            ok = 0;
+            continue;
+        }
+        for (int q = 0; q < 3; q++) {
+            const scan_result_t* r = &results[layout][q];
+            double scanned = (double)r->pages_scanned * STORE_PAGE_SIZE;
+            printf("%-16s %-8s %7zu %7zu %11.2f %11.2f %11.1f %11.1f %8.3f%% %s\n",
+                   layout_names[layout], r->query, r->matching_pages, r->matching_rows,
+                   r->offload_ms, r->swapin_ms, r->offload_bytes / 1024.0,
+                   r->swapin_bytes / 1024.0, 100.0 * r->offload_bytes / scanned,
+                   r->ok ? "✓ OK" : "✗ FAIL");
+            ok &= r->ok;
+        }
+    }
+    printf("\nreturned = bytes back over the bus per byte scanned (offload)\n");
+
+    FILE* f = fopen("scan_results.csv", "w");
+    if (f) {
+        fprintf(f, "layout,query,nr_dpus,pages_scanned,matching_pages,matching_rows,offload_ms,swapin_ms,offload_bytes,swapin_bytes,host_pages,ok\n");
+        for (int layout = 0; layout < 3; layout++) {
+            for (int q = 0; q < 3; q++) {
+                const scan_result_t* r = &results[layout][q];
+                if (!r->query) continue;
+                fprintf(f, "%s,%s,%u,%zu,%zu,%zu,%.3f,%.3f,%llu,%llu,%llu,%d\n",
+                        layout_names[layout], r->query, nr_dpus, r->pages_scanned,
+                        r->matching_pages, r->matching_rows, r->offload_ms, r->swapin_ms,
+                        (unsigned long long)r->offload_bytes,
+                        (unsigned long long)r->swapin_bytes,
+                        (unsigned long long)r->host_pages, r->ok);
+            }
+        }
+        fclose(f);
+        printf("\n✓ Results saved to scan_results.csv\n");
+    }
+    return ok ? 0 : 1;
+}
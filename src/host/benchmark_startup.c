@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "swap_store.h"
+
+/*
+ * Store startup: time to the first operation and to full capacity, with
+ * every rank allocated and loaded before swap_store_init() returns
+ * (eager), and with ranks brought up in the background (lazy).
+ *
+ * A client puts pages from the start; in lazy mode the ones put before
+ * any rank is up land in host memory and move to the ranks afterwards.
+ * Without the SDK, rank_load_ms stands in for dpu_alloc + dpu_load of one
+ * rank.
+ *
+ * Usage: benchmark_startup [nr_dpus] [dpus_per_rank] [rank_load_ms] [rank_threads]
+ */
+
+#define NR_PAGES 512
+#define BATCH_PAGES 64
+#define MRAM_SIZE (4 * 1024 * 1024)
+
+typedef struct {
+    double init_ms;                 /* swap_store_init() */
+    double first_op_ms;             /* start to the first put done */
+    double first_rank_ms;
+    double full_capacity_ms;
+    uint64_t ops_during_startup;    /* pages put before full capacity */
+    uint64_t spilled_pages;
+    uint64_t migrated_pages;
+    uint32_t left_in_spill;
+    uint32_t dpus_online;
+    int ok;
+} startup_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static double ms_since(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_to_ns(diff_time(start, now)) / 1e6;
+}
+
+/* Content of page id after its version-th put */
+static void fill_page(uint8_t* page, uint64_t id, uint32_t version) {
+    unsigned seed = (unsigned)(id * 31 + version) * 2654435761U;
+    for (size_t i = 0; i < STORE_PAGE_SIZE; i += sizeof(uint32_t)) {
+        uint32_t v = (uint32_t)rand_r(&seed);
+        memcpy(page + i, &v, sizeof(v));
+    }
+}
+
+static int run_mode(int lazy, uint32_t nr_dpus, uint32_t dpus_per_rank, uint32_t rank_load_ms,
+                    int rank_threads, startup_result_t* r) {
+    static uint8_t pages[BATCH_PAGES][STORE_PAGE_SIZE];
+    uint32_t version[NR_PAGES] = {0};
+    swap_store_config_t cfg;
+    swap_store_t store;
+    struct timespec t_start;
+    uint64_t next = 0;
+
+    memset(r, 0, sizeof(*r));
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.dpus_per_rank = dpus_per_rank;
+    cfg.mram_size = MRAM_SIZE;
+    cfg.max_pages = NR_PAGES;
+    cfg.lazy_ranks = lazy;
+    cfg.rank_threads = rank_threads;
+    cfg.rank_load_us = rank_load_ms * 1000;
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        return -1;
+    }
+    r->init_ms = ms_since(t_start);
+    r->ok = 1;
+
+    /* Client: batches of puts over NR_PAGES pages until every rank is up */
+    for (;;) {
+        const uint8_t* src[BATCH_PAGES];
+        uint64_t ids[BATCH_PAGES];
+        size_t n = next == 0 ? 1 : BATCH_PAGES;     /* the first op is a single put */
+
+        for (size_t i = 0; i < n; i++) {
+            ids[i] = (next + i) % NR_PAGES;
+            fill_page(pages[i], ids[i], version[ids[i]] + 1);
+            src[i] = pages[i];
+        }
+        if (swap_store_put_batch(&store, ids, src, n) != 0) {
+            r->ok = 0;
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            version[ids[i]]++;
+        }
+        if (next == 0) {
+            r->first_op_ms = ms_since(t_start);
+        }
+        next += n;
+        if (!lazy || store.ranks_absorbed == store.nr_ranks) break;
+    }
+    r->ops_during_startup = next;
+    r->full_capacity_ms = lazy ? store.stats.full_capacity_ns / 1e6 : r->init_ms;
+    r->first_rank_ms = lazy ? store.stats.first_rank_ns / 1e6 : r->init_ms;
+    r->dpus_online = swap_store_wait_ranks(&store);
+
+    /* Reading everything back also drains what is left in host memory */
+    uint8_t expected[STORE_PAGE_SIZE], page[STORE_PAGE_SIZE];
+    for (int pass = 0; pass < 2 && r->ok; pass++) {
+        for (uint64_t id = 0; id < NR_PAGES && r->ok; id++) {
+            if (version[id] == 0) continue;
+            fill_page(expected, id, version[id]);
+            if (swap_store_get(&store, id, page) != 0 ||
+                memcmp(page, expected, STORE_PAGE_SIZE) != 0) {
+                r->ok = 0;
+            }
+        }
+    }
+    r->spilled_pages = store.stats.spilled_pages;
+    r->migrated_pages = store.stats.migrated_pages;
+    r->left_in_spill = store.nr_spilled;
+    swap_store_free(&store);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t nr_dpus = argc > 1 ? strtoul(argv[1], NULL, 0) : 64;
+    uint32_t dpus_per_rank = argc > 2 ? strtoul(argv[2], NULL, 0) : 8;
+    uint32_t rank_load_ms = argc > 3 ? strtoul(argv[3], NULL, 0) : 50;
+    int rank_threads = argc > 4 ? atoi(argv[4]) : 4;
+    static const char* const mode_names[2] = {"eager", "lazy"};
+    startup_result_t results[2];
+    int ok = 1;
+
+    if (nr_dpus == 0 || dpus_per_rank == 0) {
+        fprintf(stderr, "Usage: %s [nr_dpus] [dpus_per_rank] [rank_load_ms] [rank_threads]\n",
+                argv[0]);
+        return 1;
+    }
+    uint32_t nr_ranks = (nr_dpus + dpus_per_rank - 1) / dpus_per_rank;
+
+    printf("=== UPMEM STORE STARTUP BENCHMARK ===\n");
+    printf("DPUs: %u in %u ranks, rank bring-up: %u ms (emulated without SDK), "
+           "%d bring-up threads\n\n", nr_dpus, nr_ranks, rank_load_ms, rank_threads);
+
+    printf("%-6s %9s %10s %11s %10s %8s %8s %9s %6s\n", "mode", "init ms", "1st op ms",
+           "1st rank ms", "full ms", "early", "spilled", "migrated", "DPUs");
+    for (int lazy = 0; lazy < 2; lazy++) {
+        startup_result_t* r = &results[lazy];
+        if (run_mode(lazy, nr_dpus, dpus_per_rank, rank_load_ms, rank_threads, r) != 0) {
+            r->ok = 0;
+        }
+        printf("%-6s %9.2f %10.2f %11.2f %10.2f %8llu %8llu %9llu %6u %s\n",
+               mode_names[lazy], r->init_ms, r->first_op_ms, r->first_rank_ms,
+               r->full_capacity_ms, (unsigned long long)r->ops_during_startup,
+               (unsigned long long)r->spilled_pages, (unsigned long long)r->migrated_pages,
+               r->dpus_online, r->ok && r->left_in_spill == 0 ? "✓ OK" : "✗ FAIL");
+        ok &= r->ok && r->left_in_spill == 0;
+    }
+    if (results[1].first_op_ms > 0) {
+        printf("\nTime to first op: %.1fx faster lazy, full capacity %.2f -> %.2f ms\n",
+               results[0].first_op_ms / results[1].first_op_ms,
+               results[0].full_capacity_ms, results[1].full_capacity_ms);
+    }
+
+    FILE* f = fopen("startup_results.csv", "w");
+    if (f) {
+        fprintf(f, "mode,nr_dpus,dpus_per_rank,ranks,rank_load_ms,rank_threads,init_ms,first_op_ms,first_rank_ms,full_capacity_ms,ops_during_startup,spilled_pages,migrated_pages,dpus_online,ok\n");
+        for (int lazy = 0; lazy < 2; lazy++) {
+            const startup_result_t* r = &results[lazy];
+            fprintf(f, "%s,%u,%u,%u,%u,%d,%.3f,%.3f,%.3f,%.3f,%llu,%llu,%llu,%u,%d\n",
+                    mode_names[lazy], nr_dpus, dpus_per_rank, nr_ranks, rank_load_ms,
+                    rank_threads, r->init_ms, r->first_op_ms, r->first_rank_ms,
+                    r->full_capacity_ms, (unsigned long long)r->ops_during_startup,
+                    (unsigned long long)r->spilled_pages, (unsigned long long)r->migrated_pages,
+                    r->dpus_online, r->ok && r->left_in_spill == 0);
+        }
+        fclose(f);
+        printf("\n✓ Results saved to startup_results.csv\n");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,719 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "swap_store.h"
+
+/*
+ * Concurrent throughput: N client threads issue mixed puts and gets over
+ * the store API for a fixed time, after a warmup, and the run is repeated
+ * over every combination of the lists given (DPUs x page size x key
+ * distribution x read ratio x threads x queue depth).
+ *
+ * The store is not thread-safe: each shard (an independent store over its
+ * share of the DPUs, keys spread by hash) sits behind a mutex, and lock
+ * waits count in the latency. The store API is synchronous, so a queue
+ * depth of q means each client hands q operations to the store at once
+ * (one get batch and one put batch); an operation completes with its
+ * batch. Pages bigger than 4KB are runs of consecutive store pages moved
+ * in the same batch.
+ *
+ * Writes throughput_results.csv: the columns of benchmark_results.csv
+ * (mode "concurrent") followed by the concurrency parameters, ops/s and
+ * latency percentiles, one row per point of the saturation curve
+ * (scripts/visualize_results.py plots it).
+ *
+ * With -M the shards publish live metrics to that shared-memory segment
+ * while the benchmark runs (metrics_dump reads them); comparing runs with
+ * and without -M gives the cost of the instrumentation.
+ *
+ * Usage: benchmark_throughput [-d dpus] [-p page_bytes] [-k uniform,zipf,seq]
+ *                             [-r read_ratio] [-t threads] [-q queue_depth]
+ *                             [-s shards] [-w working_set_mb] [-D seconds] [-W seconds]
+ *                             [-M metrics_name]
+ * Every option but -s, -w, -D, -W and -M takes a comma-separated list.
+ */
+
+#define MAX_LIST 16
+#define MAX_SAMPLES (1 << 18)       /* latency samples kept per client and kind */
+#define PRELOAD_BATCH 64
+#define ZIPF_THETA 0.99
+#define KERNEL_TASKLETS 16          /* NR_TASKLETS of dpu_tasklets (Makefile default) */
+
+typedef enum { KEYS_UNIFORM, KEYS_ZIPF, KEYS_SEQ } key_dist_t;
+
+static const char* const dist_names[] = {"uniform", "zipf", "seq"};
+
+typedef enum { PHASE_WARMUP, PHASE_MEASURE, PHASE_STOP } phase_t;
+
+typedef struct {
+    long min, max, mean, stddev;
+    long p50, p95, p99, p999;
+} stats_t;
+
+/* Latency samples of one kind (reservoir once full) */
+typedef struct {
+    long* ns;
+    size_t n;
+    uint64_t seen;
+} samples_t;
+
+typedef struct {
+    uint64_t n;
+    double theta, alpha, zetan, eta;
+} zipf_t;
+
+typedef struct {
+    swap_store_t store;
+    pthread_mutex_t lock;
+} shard_t;
+
+typedef struct {
+    shard_t* shards;
+    int nr_shards;
+    uint64_t nr_keys;
+    uint32_t pages_per_key;         /* store pages per logical page */
+    key_dist_t dist;
+    const zipf_t* zipf;
+    double read_ratio;
+    int queue_depth;
+    int nr_threads;
+    int phase;                      /* phase_t, set by the main thread */
+} run_t;
+
+typedef struct {
+    run_t* run;
+    pthread_t thread;
+    int id;
+    uint64_t rng;
+    uint64_t seq_next;
+    uint64_t reads, writes;         /* operations completed while measuring */
+    uint64_t errors;
+    samples_t get_lat, put_lat;
+} client_t;
+
+typedef struct {
+    uint32_t nr_dpus;
+    size_t page_size;
+    key_dist_t dist;
+    double read_ratio;
+    int threads, queue_depth, shards;
+    double seconds;
+    uint64_t ops;
+    double ops_per_sec;
+    double read_mb_s, write_mb_s;
+    stats_t read_stats, write_stats, all_stats;
+    uint64_t errors;
+} result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+static long percentile(const long* sorted, size_t n, size_t per_mille) {
+    size_t i = n * per_mille / 1000;
+    return sorted[i < n ? i : n - 1];
+}
+
+stats_t calculate_stats(long* latencies, size_t n) {
+    stats_t s;
+    double sum = 0, variance_sum = 0;
+
+    memset(&s, 0, sizeof(s));
+    if (n == 0) return s;
+    qsort(latencies, n, sizeof(long), cmp_long);
+    for (size_t i = 0; i < n; i++) {
+        sum += latencies[i];
+    }
+    s.min = latencies[0];
+    s.max = latencies[n - 1];
+    s.mean = (long)(sum / n);
+    for (size_t i = 0; i < n; i++) {
+        double diff = (double)(latencies[i] - s.mean);
+        variance_sum += diff * diff;
+    }
+    s.stddev = (long)sqrt(variance_sum / n);
+    s.p50 = percentile(latencies, n, 500);
+    s.p95 = percentile(latencies, n, 950);
+    s.p99 = percentile(latencies, n, 990);
+    s.p999 = percentile(latencies, n, 999);
+    return s;
+}
+
+/* ========================================================================
+ * Keys
+ * ======================================================================== */
+
+static inline uint64_t next_rand(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static inline double next_unit(uint64_t* state) {
+    return (next_rand(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Zipfian ranks as in YCSB (Gray et al., "Quickly generating billion-record
+ * synthetic databases") */
+static void zipf_init(zipf_t* z, uint64_t n, double theta) {
+    double zeta2 = 1.0 + pow(0.5, theta);
+
+    z->n = n;
+    z->theta = theta;
+    z->alpha = 1.0 / (1.0 - theta);
+    z->zetan = 0.0;
+    for (uint64_t i = 1; i <= n; i++) {
+        z->zetan += 1.0 / pow((double)i, theta);
+    }
+    z->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / z->zetan);
+}
+
+static uint64_t zipf_next(const zipf_t* z, uint64_t* rng) {
+    double u = next_unit(rng);
+    double uz = u * z->zetan;
+
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + pow(0.5, z->theta)) return 1;
+    uint64_t rank = (uint64_t)(z->n * pow(z->eta * u - z->eta + 1.0, z->alpha));
+    return rank < z->n ? rank : z->n - 1;
+}
+
+/* Spread the hot ranks over the key space (and so over DPUs and shards) */
+static inline uint64_t scramble(uint64_t rank, uint64_t n) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < 8; i++) {
+        h ^= (rank >> (i * 8)) & 0xff;
+        h *= 0x100000001b3ULL;
+    }
+    return h % n;
+}
+
+static uint64_t next_key(client_t* c) {
+    const run_t* run = c->run;
+
+    switch (run->dist) {
+    case KEYS_ZIPF:
+        return scramble(zipf_next(run->zipf, &c->rng), run->nr_keys);
+    case KEYS_SEQ:
+        return c->seq_next++ % run->nr_keys;
+    default:
+        return next_rand(&c->rng) % run->nr_keys;
+    }
+}
+
+/* ========================================================================
+ * Clients
+ * ======================================================================== */
+
+static void add_sample(samples_t* s, long ns, uint64_t* rng) {
+    if (s->n < MAX_SAMPLES) {
+        s->ns[s->n++] = ns;
+    } else {
+        uint64_t j = next_rand(rng) % (s->seen + 1);
+        if (j < MAX_SAMPLES) s->ns[j] = ns;
+    }
+    s->seen++;
+}
+
+/* Header word of store page i of a logical page: readers check it */
+static inline uint64_t page_tag(const run_t* run, uint64_t key, uint32_t i) {
+    return key * run->pages_per_key + i;
+}
+
+static void fill_page(uint8_t* page, uint64_t tag, uint64_t version) {
+    uint64_t* w = (uint64_t*)page;
+    w[0] = tag;
+    for (size_t i = 1; i < STORE_PAGE_SIZE / sizeof(uint64_t); i++) {
+        w[i] = version * 0x9E3779B97F4A7C15ULL + i;
+    }
+}
+
+/* One store call on a shard: lock, batch, unlock */
+static int shard_call(shard_t* shard, int put, const uint64_t* ids, uint8_t** bufs, size_t n) {
+    int ret;
+
+    pthread_mutex_lock(&shard->lock);
+    if (put) {
+        ret = swap_store_put_batch(&shard->store, ids, (const uint8_t* const*)bufs, n);
+    } else {
+        ret = swap_store_get_batch(&shard->store, ids, bufs, n);
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return ret;
+}
+
+/* Issue the ops of one kind of a request: one batch per shard */
+static int issue(client_t* c, int put, const uint64_t* keys, size_t nr_keys,
+                 uint64_t* ids, uint8_t** bufs, uint8_t* data) {
+    run_t* run = c->run;
+    uint32_t ppk = run->pages_per_key;
+
+    for (int sh = 0; sh < run->nr_shards; sh++) {
+        size_t n = 0;
+        for (size_t k = 0; k < nr_keys; k++) {
+            if ((int)(keys[k] % run->nr_shards) != sh) continue;
+            for (uint32_t i = 0; i < ppk; i++) {
+                ids[n] = page_tag(run, keys[k], i);
+                bufs[n] = data + (k * ppk + i) * STORE_PAGE_SIZE;
+                if (put) fill_page(bufs[n], ids[n], next_rand(&c->rng));
+                n++;
+            }
+        }
+        if (n == 0) continue;
+        if (shard_call(&run->shards[sh], put, ids, bufs, n) != 0) return -1;
+        if (!put) {
+            for (size_t i = 0; i < n; i++) {
+                if (*(const uint64_t*)bufs[i] != ids[i]) return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static inline int get_phase(const run_t* run) {
+    return __atomic_load_n(&run->phase, __ATOMIC_RELAXED);
+}
+
+static inline void set_phase(run_t* run, int phase) {
+    __atomic_store_n(&run->phase, phase, __ATOMIC_RELAXED);
+}
+
+static void* client_main(void* arg) {
+    client_t* c = arg;
+    run_t* run = c->run;
+    size_t max_pages = (size_t)run->queue_depth * run->pages_per_key;
+    uint64_t* get_keys = malloc(run->queue_depth * sizeof(uint64_t));
+    uint64_t* put_keys = malloc(run->queue_depth * sizeof(uint64_t));
+    uint64_t* ids = malloc(max_pages * sizeof(uint64_t));
+    uint8_t** bufs = malloc(max_pages * sizeof(uint8_t*));
+    uint8_t* data = malloc(max_pages * STORE_PAGE_SIZE);
+
+    if (!get_keys || !put_keys || !ids || !bufs || !data) {
+        c->errors++;
+        goto out;
+    }
+
+    while (get_phase(run) != PHASE_STOP) {
+        size_t nr_get = 0, nr_put = 0;
+        for (int i = 0; i < run->queue_depth; i++) {
+            uint64_t key = next_key(c);
+            if (next_unit(&c->rng) < run->read_ratio) get_keys[nr_get++] = key;
+            else put_keys[nr_put++] = key;
+        }
+
+        for (int put = 0; put < 2; put++) {
+            size_t n = put ? nr_put : nr_get;
+            struct timespec t_start, t_end;
+            int measured;
+
+            if (n == 0) continue;
+            measured = get_phase(run) == PHASE_MEASURE;
+            clock_gettime(CLOCK_MONOTONIC, &t_start);
+            if (issue(c, put, put ? put_keys : get_keys, n, ids, bufs, data) != 0) {
+                c->errors++;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+            /* Only calls that ran entirely inside the measured window count */
+            if (measured && get_phase(run) == PHASE_MEASURE) {
+                long ns = timespec_to_ns(diff_time(t_start, t_end));
+                add_sample(put ? &c->put_lat : &c->get_lat, ns, &c->rng);
+                if (put) c->writes += n;
+                else c->reads += n;
+            }
+        }
+    }
+out:
+    free(get_keys);
+    free(put_keys);
+    free(ids);
+    free(bufs);
+    free(data);
+    return NULL;
+}
+
+/* ========================================================================
+ * Runs
+ * ======================================================================== */
+
+static void sleep_s(double s) {
+    struct timespec ts = {(time_t)s, (long)((s - (time_t)s) * 1e9)};
+    nanosleep(&ts, NULL);
+}
+
+static int init_shards(shard_t* shards, int nr_shards, uint32_t nr_dpus, uint64_t nr_pages,
+                       swap_metrics_t* mx) {
+    for (int sh = 0; sh < nr_shards; sh++) {
+        swap_store_config_t cfg;
+        swap_store_default_config(&cfg);
+        cfg.nr_dpus = nr_dpus / nr_shards + ((uint32_t)sh < nr_dpus % nr_shards);
+        /* Room for every page plus the new copies of a batch in flight */
+        cfg.max_pages = (uint32_t)(nr_pages / nr_shards + 4096);
+        pthread_mutex_init(&shards[sh].lock, NULL);
+        if (swap_store_init(&shards[sh].store, &cfg) != 0) {
+            fprintf(stderr, "Failed to initialize page store (shard %d)\n", sh);
+            return -1;
+        }
+        if (mx && swap_store_set_metrics(&shards[sh].store, mx) != 0) return -1;
+    }
+    return 0;
+}
+
+static void free_shards(shard_t* shards, int nr_shards) {
+    for (int sh = 0; sh < nr_shards; sh++) {
+        swap_store_free(&shards[sh].store);
+        pthread_mutex_destroy(&shards[sh].lock);
+    }
+}
+
+/* Every key is written once, so that gets always hit */
+static int preload(run_t* run) {
+    static uint8_t pages[PRELOAD_BATCH][STORE_PAGE_SIZE];
+    uint64_t total = run->nr_keys * run->pages_per_key;
+
+    for (int sh = 0; sh < run->nr_shards; sh++) {
+        uint64_t ids[PRELOAD_BATCH];
+        const uint8_t* src[PRELOAD_BATCH];
+        size_t n = 0;
+
+        for (uint64_t tag = 0; tag < total; tag++) {
+            if ((int)((tag / run->pages_per_key) % run->nr_shards) != sh) continue;
+            fill_page(pages[n], tag, 0);
+            ids[n] = tag;
+            src[n] = pages[n];
+            if (++n == PRELOAD_BATCH || tag + 1 == total) {
+                if (swap_store_put_batch(&run->shards[sh].store, ids, src, n) != 0) return -1;
+                n = 0;
+            }
+        }
+        if (n > 0 && swap_store_put_batch(&run->shards[sh].store, ids, src, n) != 0) return -1;
+    }
+    return 0;
+}
+
+static int run_point(run_t* run, double warmup_s, double duration_s, result_t* r) {
+    client_t* clients = calloc(run->nr_threads, sizeof(client_t));
+    struct timespec t_start, t_end;
+    size_t nr_get = 0, nr_put = 0;
+    int ret = 0;
+
+    if (!clients) return -1;
+    set_phase(run, PHASE_WARMUP);
+    for (int i = 0; i < run->nr_threads; i++) {
+        client_t* c = &clients[i];
+        c->run = run;
+        c->id = i;
+        c->rng = 0x9E3779B97F4A7C15ULL * (i + 1) ^ (uint64_t)time(NULL);
+        c->seq_next = run->nr_keys * i / run->nr_threads;
+        c->get_lat.ns = malloc(MAX_SAMPLES * sizeof(long));
+        c->put_lat.ns = malloc(MAX_SAMPLES * sizeof(long));
+        if (!c->get_lat.ns || !c->put_lat.ns ||
+            pthread_create(&c->thread, NULL, client_main, c) != 0) {
+            fprintf(stderr, "Failed to start client %d\n", i);
+            set_phase(run, PHASE_STOP);
+            for (int j = 0; j < i; j++) pthread_join(clients[j].thread, NULL);
+            for (int j = 0; j <= i; j++) {
+                free(clients[j].get_lat.ns);
+                free(clients[j].put_lat.ns);
+            }
+            free(clients);
+            return -1;
+        }
+    }
+
+    sleep_s(warmup_s);
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    set_phase(run, PHASE_MEASURE);
+    sleep_s(duration_s);
+    set_phase(run, PHASE_STOP);
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    for (int i = 0; i < run->nr_threads; i++) {
+        pthread_join(clients[i].thread, NULL);
+    }
+
+    for (int i = 0; i < run->nr_threads; i++) {
+        nr_get += clients[i].get_lat.n;
+        nr_put += clients[i].put_lat.n;
+    }
+    long* get_ns = malloc((nr_get + 1) * sizeof(long));
+    long* put_ns = malloc((nr_put + 1) * sizeof(long));
+    long* all_ns = malloc((nr_get + nr_put + 1) * sizeof(long));
+    if (!get_ns || !put_ns || !all_ns) {
+        ret = -1;
+    } else {
+        size_t g = 0, p = 0;
+        double bytes_per_op = (double)run->pages_per_key * STORE_PAGE_SIZE;
+        double seconds = timespec_to_ns(diff_time(t_start, t_end)) / 1e9;
+        uint64_t reads = 0, writes = 0;
+
+        for (int i = 0; i < run->nr_threads; i++) {
+            client_t* c = &clients[i];
+            memcpy(get_ns + g, c->get_lat.ns, c->get_lat.n * sizeof(long));
+            memcpy(put_ns + p, c->put_lat.ns, c->put_lat.n * sizeof(long));
+            g += c->get_lat.n;
+            p += c->put_lat.n;
+            reads += c->reads;
+            writes += c->writes;
+            r->errors += c->errors;
+        }
+        memcpy(all_ns, get_ns, nr_get * sizeof(long));
+        memcpy(all_ns + nr_get, put_ns, nr_put * sizeof(long));
+
+        r->seconds = seconds;
+        r->ops = reads + writes;
+        r->ops_per_sec = r->ops / seconds;
+        r->read_mb_s = reads * bytes_per_op / (1024.0 * 1024.0) / seconds;
+        r->write_mb_s = writes * bytes_per_op / (1024.0 * 1024.0) / seconds;
+        r->read_stats = calculate_stats(get_ns, nr_get);
+        r->write_stats = calculate_stats(put_ns, nr_put);
+        r->all_stats = calculate_stats(all_ns, nr_get + nr_put);
+    }
+    free(get_ns);
+    free(put_ns);
+    free(all_ns);
+    for (int i = 0; i < run->nr_threads; i++) {
+        free(clients[i].get_lat.ns);
+        free(clients[i].put_lat.ns);
+    }
+    free(clients);
+    return ret;
+}
+
+/* ========================================================================
+ * Command line
+ * ======================================================================== */
+
+/* Split a comma-separated list into at most MAX_LIST items */
+static int split_list(const char* arg, char items[MAX_LIST][32]) {
+    int n = 0;
+    while (*arg && n < MAX_LIST) {
+        size_t len = strcspn(arg, ",");
+        snprintf(items[n++], 32, "%.*s", (int)len, arg);
+        arg += len;
+        if (*arg == ',') arg++;
+    }
+    return n;
+}
+
+static int parse_dist(const char* s, key_dist_t* dist) {
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(s, dist_names[i]) == 0) {
+            *dist = (key_dist_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [-d dpus] [-p page_bytes] [-k uniform,zipf,seq] [-r read_ratio]\n"
+            "          [-t threads] [-q queue_depth] [-s shards] [-w working_set_mb]\n"
+            "          [-D seconds] [-W warmup_seconds] [-M metrics_name]\n", prog);
+}
+
+static void write_csv(const char* path, const result_t* results, int n) {
+    FILE* f = fopen(path, "w");
+    if (!f) return;
+    fprintf(f, "nr_dpus,nr_tasklets,size,mode,write_mean_us,write_min_us,write_max_us,write_std_us,write_throughput_mbps,read_mean_us,read_min_us,read_max_us,read_std_us,read_throughput_mbps,"
+               "threads,queue_depth,shards,read_ratio,distribution,duration_s,ops,ops_per_sec,p50_us,p95_us,p99_us,p999_us,errors\n");
+    for (int i = 0; i < n; i++) {
+        const result_t* r = &results[i];
+        fprintf(f, "%u,%d,%zu,concurrent,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,"
+                   "%d,%d,%d,%.2f,%s,%.2f,%llu,%.0f,%.2f,%.2f,%.2f,%.2f,%llu\n",
+                r->nr_dpus, KERNEL_TASKLETS, r->page_size,
+                r->write_stats.mean / 1e3, r->write_stats.min / 1e3, r->write_stats.max / 1e3,
+                r->write_stats.stddev / 1e3, r->write_mb_s,
+                r->read_stats.mean / 1e3, r->read_stats.min / 1e3, r->read_stats.max / 1e3,
+                r->read_stats.stddev / 1e3, r->read_mb_s,
+                r->threads, r->queue_depth, r->shards, r->read_ratio, dist_names[r->dist],
+                r->seconds, (unsigned long long)r->ops, r->ops_per_sec,
+                r->all_stats.p50 / 1e3, r->all_stats.p95 / 1e3, r->all_stats.p99 / 1e3,
+                r->all_stats.p999 / 1e3, (unsigned long long)r->errors);
+    }
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    char dpus_arg[MAX_LIST][32], page_arg[MAX_LIST][32], dist_arg[MAX_LIST][32];
+    char ratio_arg[MAX_LIST][32], threads_arg[MAX_LIST][32], qd_arg[MAX_LIST][32];
+    int nr_dpus_list = split_list("8", dpus_arg);
+    int nr_page_list = split_list("4096", page_arg);
+    int nr_dist_list = split_list("uniform", dist_arg);
+    int nr_ratio_list = split_list("0.7", ratio_arg);
+    int nr_threads_list = split_list("1,2,4,8", threads_arg);
+    int nr_qd_list = split_list("1,8,32", qd_arg);
+    int nr_shards = 1;
+    double ws_mb = 32, duration_s = 2.0, warmup_s = 0.5;
+    const char* metrics_name = NULL;
+    swap_metrics_t metrics;
+    int opt, ok = 1;
+
+    while ((opt = getopt(argc, argv, "d:p:k:r:t:q:s:w:D:W:M:h")) != -1) {
+        switch (opt) {
+        case 'd': nr_dpus_list = split_list(optarg, dpus_arg); break;
+        case 'p': nr_page_list = split_list(optarg, page_arg); break;
+        case 'k': nr_dist_list = split_list(optarg, dist_arg); break;
+        case 'r': nr_ratio_list = split_list(optarg, ratio_arg); break;
+        case 't': nr_threads_list = split_list(optarg, threads_arg); break;
+        case 'q': nr_qd_list = split_list(optarg, qd_arg); break;
+        case 's': nr_shards = atoi(optarg); break;
+        case 'w': ws_mb = atof(optarg); break;
+        case 'D': duration_s = atof(optarg); break;
+        case 'W': warmup_s = atof(optarg); break;
+        case 'M': metrics_name = optarg; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nr_shards < 1 || ws_mb <= 0 || duration_s <= 0 || warmup_s < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int max_points = nr_dpus_list * nr_page_list * nr_dist_list * nr_ratio_list *
+                     nr_threads_list * nr_qd_list;
+    result_t* results = calloc(max_points, sizeof(result_t));
+    int nr_results = 0;
+    if (!results) return 1;
+    if (metrics_name && swap_metrics_create(&metrics, metrics_name) != 0) {
+        free(results);
+        return 1;
+    }
+
+    printf("=== UPMEM CONCURRENT THROUGHPUT BENCHMARK ===\n");
+    printf("Working set: %.0f MB, %d shard(s), %.1fs warmup + %.1fs per point\n",
+           ws_mb, nr_shards, warmup_s, duration_s);
+    if (metrics_name) printf("Live metrics: %s\n", metrics_name);
+    printf("\n");
+
+    for (int di = 0; di < nr_dpus_list; di++)
+    for (int pi = 0; pi < nr_page_list; pi++) {
+        uint32_t nr_dpus = strtoul(dpus_arg[di], NULL, 0);
+        size_t page_size = strtoul(page_arg[pi], NULL, 0);
+        if (page_size == 0 || page_size % STORE_PAGE_SIZE != 0 || nr_dpus < (uint32_t)nr_shards) {
+            fprintf(stderr, "Skipping %u DPUs / %zu-byte pages: pages are multiples of %d bytes, "
+                    "at least one DPU per shard\n", nr_dpus, page_size, STORE_PAGE_SIZE);
+            continue;
+        }
+
+        shard_t* shards = calloc(nr_shards, sizeof(shard_t));
+        run_t run;
+        memset(&run, 0, sizeof(run));
+        run.shards = shards;
+        run.nr_shards = nr_shards;
+        run.pages_per_key = (uint32_t)(page_size / STORE_PAGE_SIZE);
+        run.nr_keys = (uint64_t)(ws_mb * 1024 * 1024) / page_size;
+        if (run.nr_keys == 0) run.nr_keys = 1;
+
+        if (!shards || init_shards(shards, nr_shards, nr_dpus,
+                                   run.nr_keys * run.pages_per_key,
+                                   metrics_name ? &metrics : NULL) != 0 ||
+            preload(&run) != 0) {
+            fprintf(stderr, "Failed to set up %u DPUs / %zu-byte pages\n", nr_dpus, page_size);
+            if (shards) free_shards(shards, nr_shards);
+            free(shards);
+            ok = 0;
+            continue;
+        }
+        zipf_t zipf;
+        zipf_init(&zipf, run.nr_keys, ZIPF_THETA);
+        run.zipf = &zipf;
+
+        for (int ki = 0; ki < nr_dist_list; ki++)
+        for (int ri = 0; ri < nr_ratio_list; ri++) {
+            int first = nr_results;
+            double best = 0;
+
+            if (parse_dist(dist_arg[ki], &run.dist) != 0) {
+                fprintf(stderr, "Unknown key distribution %s\n", dist_arg[ki]);
+                continue;
+            }
+            run.read_ratio = atof(ratio_arg[ri]);
+            printf("--- %u DPUs, %zu-byte pages, %s keys, %.0f%% reads ---\n",
+                   nr_dpus, page_size, dist_names[run.dist], run.read_ratio * 100);
+            printf("%7s %5s %11s %10s %10s %10s %10s %10s\n", "threads", "qd", "outstanding",
+                   "ops/s", "MB/s", "p50 µs", "p99 µs", "p99.9 µs");
+
+            for (int ti = 0; ti < nr_threads_list; ti++)
+            for (int qi = 0; qi < nr_qd_list; qi++) {
+                result_t* r = &results[nr_results];
+                run.nr_threads = atoi(threads_arg[ti]);
+                run.queue_depth = atoi(qd_arg[qi]);
+                if (run.nr_threads < 1 || run.queue_depth < 1) continue;
+
+                memset(r, 0, sizeof(*r));
+                r->nr_dpus = nr_dpus;
+                r->page_size = page_size;
+                r->dist = run.dist;
+                r->read_ratio = run.read_ratio;
+                r->threads = run.nr_threads;
+                r->queue_depth = run.queue_depth;
+                r->shards = nr_shards;
+                if (run_point(&run, warmup_s, duration_s, r) != 0) {
+                    ok = 0;
+                    continue;
+                }
+                nr_results++;
+                if (r->errors) ok = 0;
+                if (r->ops_per_sec > best) best = r->ops_per_sec;
+                printf("%7d %5d %11d %10.0f %10.1f %10.1f %10.1f %10.1f%s\n",
+                       r->threads, r->queue_depth, r->threads * r->queue_depth,
+                       r->ops_per_sec, r->read_mb_s + r->write_mb_s,
+                       r->all_stats.p50 / 1e3, r->all_stats.p99 / 1e3, r->all_stats.p999 / 1e3,
+                       r->errors ? "  ✗ errors" : "");
+            }
+
+            /* Knee of the saturation curve: least concurrency within 90% of the best */
+            int knee = -1;
+            for (int i = first; i < nr_results; i++) {
+                if (results[i].ops_per_sec < 0.9 * best) continue;
+                if (knee < 0 || results[i].threads * results[i].queue_depth <
+                                results[knee].threads * results[knee].queue_depth) {
+                    knee = i;
+                }
+            }
+            if (knee >= 0) {
+                printf("Saturation: %.0f ops/s peak, 90%% reached at %d threads x qd %d "
+                       "(p99 %.1f µs)\n\n", best, results[knee].threads,
+                       results[knee].queue_depth, results[knee].all_stats.p99 / 1e3);
+            }
+        }
+
+        free_shards(shards, nr_shards);
+        free(shards);
+    }
+
+    if (metrics_name) swap_metrics_close(&metrics);
+    write_csv("throughput_results.csv", results, nr_results);
+    printf("Verification: %s\n", ok ? "✓ OK" : "✗ FAIL");
+    printf("✓ Results saved to throughput_results.csv\n");
+    free(results);
+    return ok ? 0 : 1;
+}
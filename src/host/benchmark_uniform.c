@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "swap_store.h"
+
+/*
+ * Uniform-shape batches: per-page transfers (one push per record) against
+ * uniform_xfer (records packed into per-DPU landing areas, one same-length
+ * push per DPU set and round, scattered/gathered by the kernel), with and
+ * without compression.
+ *
+ * Put batches are ragged: random sizes, pages spread over every DPU, half
+ * of them compressible. Gets read back random subsets. Every page is
+ * checked against its last put.
+ *
+ * Usage: benchmark_uniform [nr_dpus] [batch] [nr_batches]
+ */
+
+#define NR_PAGES 4096
+#define MRAM_SIZE (8 * 1024 * 1024)
+
+typedef struct {
+    int uniform;
+    int compress;
+    double put_ms, get_ms;
+    uint64_t put_batches, get_batches;
+    uint64_t put_pushes, get_pushes;
+    uint64_t rounds;
+    uint64_t padding_bytes;
+    uint64_t bus_bytes;
+    int ok;
+} uniform_result_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static double ms_since(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_to_ns(diff_time(start, now)) / 1e6;
+}
+
+/* Content of page id after its version-th put: odd ids compress well */
+static void fill_page(uint8_t* page, uint64_t id, uint32_t version) {
+    unsigned seed = (unsigned)(id * 31 + version) * 2654435761U;
+    for (size_t i = 0; i < STORE_PAGE_SIZE; i += sizeof(uint32_t)) {
+        uint32_t v = (uint32_t)rand_r(&seed);
+        if (id & 1) v &= 0x0000000f;
+        memcpy(page + i, &v, sizeof(v));
+    }
+}
+
+static int run_config(uint32_t nr_dpus, uint32_t batch, uint32_t nr_batches, int uniform,
+                      int compress, uniform_result_t* r) {
+    uint32_t* version = calloc(NR_PAGES, sizeof(uint32_t));
+    uint8_t* pages = malloc((size_t)batch * STORE_PAGE_SIZE);
+    uint8_t** ptrs = malloc(batch * sizeof(uint8_t*));
+    uint64_t* ids = malloc(batch * sizeof(uint64_t));
+    uint8_t expected[STORE_PAGE_SIZE];
+    swap_store_config_t cfg;
+    swap_store_t store;
+    unsigned seed = 42;
+
+    memset(r, 0, sizeof(*r));
+    r->uniform = uniform;
+    r->compress = compress;
+    if (!version || !pages || !ptrs || !ids) {
+        free(version); free(pages); free(ptrs); free(ids);
+        return -1;
+    }
+    for (uint32_t i = 0; i < batch; i++) {
+        ptrs[i] = pages + (size_t)i * STORE_PAGE_SIZE;
+    }
+
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = nr_dpus;
+    cfg.mram_size = MRAM_SIZE;
+    cfg.max_pages = NR_PAGES;
+    cfg.compress = compress;
+    cfg.uniform_xfer = uniform;
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        free(version); free(pages); free(ptrs); free(ids);
+        return -1;
+    }
+    r->ok = 1;
+
+    for (uint32_t b = 0; b < nr_batches && r->ok; b++) {
+        uint32_t n = 1 + (uint32_t)rand_r(&seed) % batch;
+        struct timespec t0;
+
+        /* Puts: distinct pages, so the expected content is unambiguous */
+        uint64_t base = (uint64_t)rand_r(&seed) % NR_PAGES;
+        for (uint32_t i = 0; i < n; i++) {
+            ids[i] = (base + (uint64_t)i * 7) % NR_PAGES;
+            fill_page(ptrs[i], ids[i], version[ids[i]] + 1);
+        }
+        uint64_t pushes = store.stats.pushes;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (swap_store_put_batch(&store, ids, (const uint8_t* const*)ptrs, n) != 0) {
+            r->ok = 0;
+            break;
+        }
+        r->put_ms += ms_since(t0);
+        r->put_pushes += store.stats.pushes - pushes;
+        r->put_batches++;
+        for (uint32_t i = 0; i < n; i++) {
+            version[ids[i]]++;
+        }
+
+        /* Gets: a random subset of what is stored */
+        n = 1 + (uint32_t)rand_r(&seed) % batch;
+        uint32_t m = 0;
+        for (uint32_t tries = 0; m < n && tries < 4 * n; tries++) {
+            uint64_t id = (uint64_t)rand_r(&seed) % NR_PAGES;
+            if (version[id] > 0) ids[m++] = id;
+        }
+        if (m == 0) continue;
+        pushes = store.stats.pushes;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (swap_store_get_batch(&store, ids, ptrs, m) != 0) {
+            r->ok = 0;
+            break;
+        }
+        r->get_ms += ms_since(t0);
+        r->get_pushes += store.stats.pushes - pushes;
+        r->get_batches++;
+        for (uint32_t i = 0; i < m; i++) {
+            fill_page(expected, ids[i], version[ids[i]]);
+            if (memcmp(ptrs[i], expected, STORE_PAGE_SIZE) != 0) r->ok = 0;
+        }
+    }
+
+    r->rounds = store.stats.uniform_rounds;
+    r->padding_bytes = store.stats.padding_bytes;
+    r->bus_bytes = store.stats.bus_bytes_to_dpu + store.stats.bus_bytes_from_dpu;
+    if (store.stats.errors > 0) r->ok = 0;
+    swap_store_free(&store);
+    free(version); free(pages); free(ptrs); free(ids);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t nr_dpus = argc > 1 ? strtoul(argv[1], NULL, 0) : 64;
+    uint32_t batch = argc > 2 ? strtoul(argv[2], NULL, 0) : 256;
+    uint32_t nr_batches = argc > 3 ? strtoul(argv[3], NULL, 0) : 200;
+    uniform_result_t results[4];
+    int ok = 1;
+
+    if (nr_dpus == 0 || batch == 0 || batch > NR_PAGES) {
+        fprintf(stderr, "Usage: %s [nr_dpus] [batch] [nr_batches]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== UPMEM UNIFORM TRANSFER BENCHMARK ===\n");
+    printf("DPUs: %u, batches of 1-%u pages, %u put + %u get batches\n\n", nr_dpus, batch,
+           nr_batches, nr_batches);
+
+    printf("%-8s %-8s %10s %10s %12s %12s %8s %9s\n", "xfer", "compress", "put ms", "get ms",
+           "pushes/put", "pushes/get", "rounds", "padding");
+    for (int c = 0; c < 4; c++) {
+        uniform_result_t* r = &results[c];
+        if (run_config(nr_dpus, batch, nr_batches, c & 1, c >> 1, r) != 0) {
+            r->ok = 0;
+        }
+        double padding = r->bus_bytes ? 100.0 * r->padding_bytes / r->bus_bytes : 0.0;
+        printf("%-8s %-8s %10.2f %10.2f %12.1f %12.1f %8llu %8.1f%% %s\n",
+               r->uniform ? "uniform" : "per-page", r->compress ? "on" : "off", r->put_ms,
+               r->get_ms, r->put_batches ? (double)r->put_pushes / r->put_batches : 0.0,
+               r->get_batches ? (double)r->get_pushes / r->get_batches : 0.0,
+               (unsigned long long)r->rounds, padding, r->ok ? "✓ OK" : "✗ FAIL");
+        ok &= r->ok;
+    }
+
+    FILE* f = fopen("uniform_results.csv", "w");
+    if (f) {
+        fprintf(f, "xfer,compress,nr_dpus,max_batch,nr_batches,put_ms,get_ms,put_batches,get_batches,put_pushes,get_pushes,rounds,padding_bytes,bus_bytes,ok\n");
+        for (int c = 0; c < 4; c++) {
+            const uniform_result_t* r = &results[c];
+            fprintf(f, "%s,%d,%u,%u,%u,%.3f,%.3f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%d\n",
+                    r->uniform ? "uniform" : "per-page", r->compress, nr_dpus, batch, nr_batches,
+                    r->put_ms, r->get_ms, (unsigned long long)r->put_batches,
+                    (unsigned long long)r->get_batches, (unsigned long long)r->put_pushes,
+                    (unsigned long long)r->get_pushes, (unsigned long long)r->rounds,
+                    (unsigned long long)r->padding_bytes, (unsigned long long)r->bus_bytes, r->ok);
+        }
+        fclose(f);
+        printf("\n✓ Results saved to uniform_results.csv\n");
+    }
+    return ok ? 0 : 1;
+}
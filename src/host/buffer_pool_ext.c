@@ -0,0 +1,302 @@
+/**
+ * UPMEM Swap - Buffer pool extension
+ *
+ * Block cache over the page store, see buffer_pool_ext.h. The store does
+ * the transfers; this file only maps (file, block) keys to page ids and
+ * decides which blocks stay.
+ */
+
+#include "buffer_pool_ext.h"
+
+#define SLOT_FREE       0
+#define SLOT_COLD       1
+#define SLOT_REFERENCED 2
+#define SLOT_PINNED     3   /* inserted by the batch in progress */
+
+static inline uint64_t make_id(uint32_t file, uint64_t block) {
+    return ((uint64_t)file << BPX_BLOCK_BITS) | block;
+}
+
+static inline uint32_t hash_id(uint64_t id) {
+    return (uint32_t)((id * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+/* ========================================================================
+ * Index: page id -> slot, linear probing with backward shift deletion
+ * ======================================================================== */
+
+static int64_t index_find(const bpx_t* bpx, uint64_t id) {
+    uint32_t i = hash_id(id) & bpx->index_mask;
+    while (bpx->index[i]) {
+        if (bpx->slot_ids[bpx->index[i] - 1] == id) {
+            return i;
+        }
+        i = (i + 1) & bpx->index_mask;
+    }
+    return -1;
+}
+
+static void index_add(bpx_t* bpx, uint64_t id, uint32_t slot) {
+    uint32_t i = hash_id(id) & bpx->index_mask;
+    while (bpx->index[i]) {
+        i = (i + 1) & bpx->index_mask;
+    }
+    bpx->index[i] = slot + 1;
+}
+
+static void index_remove(bpx_t* bpx, uint32_t pos) {
+    uint32_t i = pos, j = pos;
+
+    for (;;) {
+        j = (j + 1) & bpx->index_mask;
+        if (!bpx->index[j]) break;
+        uint32_t k = hash_id(bpx->slot_ids[bpx->index[j] - 1]) & bpx->index_mask;
+        /* Entries whose home is in (i, j] are still reachable */
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+        bpx->index[i] = bpx->index[j];
+        i = j;
+    }
+    bpx->index[i] = 0;
+}
+
+/* ========================================================================
+ * Slots
+ * ======================================================================== */
+
+static void drop_slot(bpx_t* bpx, uint32_t s) {
+    int64_t pos = index_find(bpx, bpx->slot_ids[s]);
+    if (pos >= 0) {
+        index_remove(bpx, (uint32_t)pos);
+    }
+    swap_store_invalidate(&bpx->store, bpx->slot_ids[s]);
+    bpx->slot_ref[s] = SLOT_FREE;
+    bpx->nr_used--;
+}
+
+/* A free slot, or the CLOCK victim once the cache is full. -1 if every
+ * slot is pinned by the current batch. */
+static int64_t take_slot(bpx_t* bpx) {
+    for (uint32_t scanned = 0; scanned < 2 * bpx->capacity + 1; scanned++) {
+        uint32_t s = bpx->hand;
+        bpx->hand = (bpx->hand + 1) % bpx->capacity;
+
+        switch (bpx->slot_ref[s]) {
+        case SLOT_FREE:
+            return s;
+        case SLOT_REFERENCED:
+            bpx->slot_ref[s] = SLOT_COLD;
+            break;
+        case SLOT_COLD:
+            if (bpx->nr_used < bpx->capacity) break;   /* a free slot is ahead */
+            drop_slot(bpx, s);
+            bpx->stats.evictions++;
+            return s;
+        default:
+            break;
+        }
+    }
+    return -1;
+}
+
+static int reserve_scratch(bpx_t* bpx, size_t n) {
+    if (n <= bpx->scratch_cap) return 0;
+
+    uint64_t* ids = realloc(bpx->ids, n * sizeof(uint64_t));
+    if (ids) bpx->ids = ids;
+    uint8_t** ptrs = ids ? realloc(bpx->ptrs, n * sizeof(uint8_t*)) : NULL;
+    if (!ids || !ptrs) {
+        fprintf(stderr, "ERROR: Failed to allocate block batch\n");
+        return -1;
+    }
+    bpx->ptrs = ptrs;
+    bpx->scratch_cap = n;
+    return 0;
+}
+
+/* ========================================================================
+ * API
+ * ======================================================================== */
+
+int bpx_init(bpx_t* bpx, const swap_store_config_t* store_cfg) {
+    uint32_t index_size = 1;
+
+    memset(bpx, 0, sizeof(*bpx));
+    if (swap_store_init(&bpx->store, store_cfg) != 0) {
+        return -1;
+    }
+
+    uint64_t mram_pages = (uint64_t)bpx->store.nr_dpus * (bpx->store.cfg.mram_size / STORE_PAGE_SIZE);
+    bpx->capacity = store_cfg->max_pages < mram_pages ? store_cfg->max_pages : (uint32_t)mram_pages;
+    if (bpx->capacity == 0) {
+        fprintf(stderr, "ERROR: buffer pool extension with no capacity\n");
+        swap_store_free(&bpx->store);
+        return -1;
+    }
+    while (index_size < 2 * bpx->capacity) {
+        index_size <<= 1;
+    }
+
+    bpx->slot_ids = calloc(bpx->capacity, sizeof(uint64_t));
+    bpx->slot_ref = calloc(bpx->capacity, sizeof(uint8_t));
+    bpx->index = calloc(index_size, sizeof(uint32_t));
+    bpx->index_mask = index_size - 1;
+    if (!bpx->slot_ids || !bpx->slot_ref || !bpx->index) {
+        fprintf(stderr, "ERROR: Failed to allocate buffer pool extension metadata\n");
+        bpx_free(bpx);
+        return -1;
+    }
+    return 0;
+}
+
+void bpx_free(bpx_t* bpx) {
+    swap_store_free(&bpx->store);
+    free(bpx->slot_ids);
+    free(bpx->slot_ref);
+    free(bpx->index);
+    free(bpx->ids);
+    free(bpx->ptrs);
+    memset(bpx, 0, sizeof(*bpx));
+}
+
+int bpx_insert_batch(bpx_t* bpx, const bpx_key_t* keys, const uint8_t* const* pages, size_t n) {
+    size_t m = 0;
+    int ret = 0;
+
+    if (n == 0) return 0;
+    if (reserve_scratch(bpx, n) != 0) return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        if (keys[i].file > BPX_MAX_FILE || keys[i].block > BPX_MAX_BLOCK) {
+            fprintf(stderr, "ERROR: block key (%u, %llu) out of range\n",
+                    keys[i].file, (unsigned long long)keys[i].block);
+            ret = -1;
+            continue;
+        }
+        uint64_t id = make_id(keys[i].file, keys[i].block);
+        int64_t pos = index_find(bpx, id);
+        uint32_t s;
+
+        if (pos >= 0) {
+            s = bpx->index[pos] - 1;
+            bpx->stats.reinserts++;
+        } else {
+            int64_t free_slot = take_slot(bpx);
+            if (free_slot < 0) {
+                bpx->stats.insert_failures++;
+                ret = -1;
+                continue;
+            }
+            s = (uint32_t)free_slot;
+            bpx->slot_ids[s] = id;
+            index_add(bpx, id, s);
+            bpx->nr_used++;
+        }
+        bpx->slot_ref[s] = SLOT_PINNED;
+        bpx->ids[m] = id;
+        bpx->ptrs[m] = (uint8_t*)pages[i];
+        m++;
+    }
+
+    const uint8_t* const* srcs = (const uint8_t* const*)bpx->ptrs;
+    int put = swap_store_put_batch(&bpx->store, bpx->ids, srcs, m);
+    if (put != 0) {
+        /* Most likely no full-page slot left: defragment and try once more */
+        swap_store_compact(&bpx->store);
+        put = swap_store_put_batch(&bpx->store, bpx->ids, srcs, m);
+    }
+
+    for (size_t j = 0; j < m; j++) {
+        int64_t pos = index_find(bpx, bpx->ids[j]);
+        if (pos < 0) continue;      /* named twice, already handled */
+        uint32_t s = bpx->index[pos] - 1;
+
+        if (put != 0) {
+            /* Some copies may be stale or missing: forget the whole batch */
+            drop_slot(bpx, s);
+            bpx->stats.insert_failures++;
+        } else if (bpx->slot_ref[s] == SLOT_PINNED) {
+            bpx->slot_ref[s] = SLOT_REFERENCED;
+            bpx->stats.inserts++;
+        }
+    }
+    return put != 0 ? -1 : ret;
+}
+
+int bpx_insert(bpx_t* bpx, uint32_t file, uint64_t block, const uint8_t* page) {
+    bpx_key_t key = {file, block};
+    return bpx_insert_batch(bpx, &key, &page, 1);
+}
+
+int bpx_lookup_batch(bpx_t* bpx, const bpx_key_t* keys, uint8_t* const* dsts,
+                     size_t n, uint8_t* hit) {
+    size_t m = 0;
+
+    if (n == 0) return 0;
+    if (reserve_scratch(bpx, n) != 0) return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        int64_t pos = -1;
+
+        if (keys[i].file <= BPX_MAX_FILE && keys[i].block <= BPX_MAX_BLOCK) {
+            pos = index_find(bpx, make_id(keys[i].file, keys[i].block));
+        }
+        bpx->stats.lookups++;
+        hit[i] = pos >= 0;
+        if (pos < 0) continue;
+
+        uint32_t s = bpx->index[pos] - 1;
+        bpx->slot_ref[s] = SLOT_REFERENCED;
+        bpx->ids[m] = bpx->slot_ids[s];
+        bpx->ptrs[m] = dsts[i];
+        m++;
+    }
+    if (m == 0) {
+        swap_metrics_cache(bpx->store.metrics, n, 0);
+        return 0;
+    }
+
+    if (swap_store_get_batch(&bpx->store, bpx->ids, bpx->ptrs, m) != 0) {
+        swap_metrics_cache(bpx->store.metrics, n, 0);
+        memset(hit, 0, n);
+        return -1;
+    }
+    bpx->stats.hits += m;
+    swap_metrics_cache(bpx->store.metrics, n, m);
+    return (int)m;
+}
+
+int bpx_lookup(bpx_t* bpx, uint32_t file, uint64_t block, uint8_t* dst) {
+    bpx_key_t key = {file, block};
+    uint8_t hit;
+    return bpx_lookup_batch(bpx, &key, &dst, 1, &hit);
+}
+
+uint64_t bpx_invalidate(bpx_t* bpx, uint32_t file, uint64_t first, uint64_t count) {
+    uint64_t dropped = 0;
+
+    if (file > BPX_MAX_FILE || first > BPX_MAX_BLOCK) return 0;
+    if (count > BPX_MAX_BLOCK + 1 - first) count = BPX_MAX_BLOCK + 1 - first;
+
+    if (count <= bpx->capacity / 8) {
+        /* Short range: probe each block */
+        for (uint64_t b = first; b < first + count; b++) {
+            int64_t pos = index_find(bpx, make_id(file, b));
+            if (pos < 0) continue;
+            drop_slot(bpx, bpx->index[pos] - 1);
+            dropped++;
+        }
+    } else {
+        for (uint32_t s = 0; s < bpx->capacity; s++) {
+            uint64_t id = bpx->slot_ids[s];
+            uint64_t block = id & BPX_MAX_BLOCK;
+            if (bpx->slot_ref[s] == SLOT_FREE || (id >> BPX_BLOCK_BITS) != file ||
+                block < first || block - first >= count) {
+                continue;
+            }
+            drop_slot(bpx, s);
+            dropped++;
+        }
+    }
+    bpx->stats.invalidations += dropped;
+    return dropped;
+}
@@ -0,0 +1,82 @@
+#ifndef __UPMEM_SWAP_BUFFER_POOL_EXT_H__
+#define __UPMEM_SWAP_BUFFER_POOL_EXT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "swap_store.h"
+
+/*
+ * Buffer pool extension: a second-level cache of database blocks in the
+ * page store, keyed by (file id, block number).
+ *
+ * Clean blocks evicted from the database's buffer pool are inserted; a
+ * lookup hit returns the block without going to storage. Blocks must be
+ * invalidated when the database modifies them, so the cache only ever
+ * holds what is on disk. Re-inserting a block that is still cached is
+ * nearly free with cfg.delta (clean pages send nothing).
+ *
+ * When full, CLOCK picks the block to drop. If MRAM is too fragmented to
+ * place a batch, the store is compacted once before the batch is dropped.
+ *
+ * Not thread-safe, like the store underneath.
+ */
+
+#define BPX_BLOCK_BITS 40   /* file id in the upper 24 bits of the page id */
+#define BPX_MAX_FILE ((1U << (64 - BPX_BLOCK_BITS)) - 1)
+#define BPX_MAX_BLOCK ((1ULL << BPX_BLOCK_BITS) - 1)
+
+typedef struct {
+    uint32_t file;
+    uint64_t block;
+} bpx_key_t;
+
+typedef struct {
+    uint64_t lookups;
+    uint64_t hits;
+    uint64_t inserts;
+    uint64_t reinserts;         /* ... of blocks already cached */
+    uint64_t evictions;         /* blocks dropped to make room */
+    uint64_t invalidations;
+    uint64_t insert_failures;   /* blocks dropped because the put failed */
+} bpx_stats_t;
+
+typedef struct {
+    swap_store_t store;         /* swap_store_set_metrics() also exports the hit ratio */
+    uint32_t capacity;          /* blocks */
+
+    uint64_t* slot_ids;         /* page id cached in each slot */
+    uint8_t* slot_ref;          /* 0 = free, 1 = cold, 2 = referenced */
+    uint32_t nr_used;
+    uint32_t hand;
+
+    uint32_t* index;            /* page id -> slot + 1, open addressing */
+    uint32_t index_mask;
+
+    uint64_t* ids;              /* batch scratch */
+    uint8_t** ptrs;
+    size_t scratch_cap;
+
+    bpx_stats_t stats;
+} bpx_t;
+
+/* Capacity: store_cfg->max_pages, bounded by the MRAM of the DPUs */
+int bpx_init(bpx_t* bpx, const swap_store_config_t* store_cfg);
+void bpx_free(bpx_t* bpx);
+
+/* Return 0 on success, -1 if the block could not be cached */
+int bpx_insert(bpx_t* bpx, uint32_t file, uint64_t block, const uint8_t* page);
+int bpx_insert_batch(bpx_t* bpx, const bpx_key_t* keys, const uint8_t* const* pages, size_t n);
+
+/* Return 1 on a hit (dst filled), 0 on a miss, -1 on error */
+int bpx_lookup(bpx_t* bpx, uint32_t file, uint64_t block, uint8_t* dst);
+
+/* Hits are fetched in one store batch. hit[i] tells which dst were filled.
+ * Returns the number of hits, or -1. */
+int bpx_lookup_batch(bpx_t* bpx, const bpx_key_t* keys, uint8_t* const* dsts,
+                     size_t n, uint8_t* hit);
+
+/* Drop blocks [first, first + count) of a file. Returns the number dropped. */
+uint64_t bpx_invalidate(bpx_t* bpx, uint32_t file, uint64_t first, uint64_t count);
+
+#endif /* __UPMEM_SWAP_BUFFER_POOL_EXT_H__ */
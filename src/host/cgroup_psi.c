@@ -0,0 +1,150 @@
+/**
+ * UPMEM Swap - cgroup v2 pressure
+ *
+ * Plain file parsing, see cgroup_psi.h. On hybrid hierarchies the v2 tree
+ * is mounted at /sys/fs/cgroup/unified instead of /sys/fs/cgroup.
+ */
+
+#include "cgroup_psi.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char* cgroup2_root(void) {
+    if (access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0) {
+        return "/sys/fs/cgroup";
+    }
+    return "/sys/fs/cgroup/unified";
+}
+
+/* The "0::<path>" line of /proc/self/cgroup. 0, or -1 (reported). */
+static int own_cgroup(char* out, size_t size) {
+    char line[512];
+    FILE* f = fopen("/proc/self/cgroup", "r");
+    int found = 0, ret = -1;
+
+    if (f) {
+        while (fgets(line, sizeof(line), f)) {
+            if (strncmp(line, "0::", 3) == 0) {
+                found = 1;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    if (!found) {
+        fprintf(stderr, "ERROR: no cgroup v2 entry in /proc/self/cgroup\n");
+        return -1;
+    }
+    line[strcspn(line, "\n")] = '\0';
+    /* "/" is the root cgroup */
+    int len = snprintf(out, size, "%s%s", cgroup2_root(), strcmp(line + 3, "/") ? line + 3 : "");
+    if (len < 0 || (size_t)len >= size) {
+        fprintf(stderr, "ERROR: cgroup path too long: %s\n", line + 3);
+    } else {
+        ret = 0;
+    }
+    return ret;
+}
+
+int cgroup_open(cgroup_t* cg, const char* path) {
+    memset(cg, 0, sizeof(*cg));
+    cg->trigger_fd = -1;
+    if (path) {
+        if ((size_t)snprintf(cg->path, sizeof(cg->path), "%s", path) >= sizeof(cg->path)) {
+            fprintf(stderr, "ERROR: cgroup path too long: %s\n", path);
+            return -1;
+        }
+    } else if (own_cgroup(cg->path, sizeof(cg->path)) != 0) {
+        return -1;
+    }
+    if (access(cg->path, F_OK) != 0) {
+        fprintf(stderr, "ERROR: cgroup %s: %s\n", cg->path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+void cgroup_close(cgroup_t* cg) {
+    if (cg->trigger_fd >= 0) {
+        close(cg->trigger_fd);
+        cg->trigger_fd = -1;
+    }
+}
+
+static FILE* open_file(const cgroup_t* cg, const char* name) {
+    char file[320];
+    snprintf(file, sizeof(file), "%s/%s", cg->path, name);
+    return fopen(file, "r");
+}
+
+/* Single value file: a number or "max" (returned as 0) */
+static int64_t read_value(const cgroup_t* cg, const char* name) {
+    char buf[64];
+    FILE* f = open_file(cg, name);
+    int64_t value = -1;
+
+    if (!f) return -1;
+    if (fgets(buf, sizeof(buf), f)) {
+        value = strncmp(buf, "max", 3) == 0 ? 0 : strtoll(buf, NULL, 10);
+    }
+    fclose(f);
+    return value;
+}
+
+int cgroup_read_pressure(const cgroup_t* cg, psi_stats_t* psi) {
+    char line[256];
+    FILE* f = open_file(cg, "memory.pressure");
+
+    if (!f) return -1;
+    memset(psi, 0, sizeof(*psi));
+    while (fgets(line, sizeof(line), f)) {
+        psi_line_t* l;
+        unsigned long long total;
+
+        if (strncmp(line, "some ", 5) == 0) l = &psi->some;
+        else if (strncmp(line, "full ", 5) == 0) l = &psi->full;
+        else continue;
+        if (sscanf(line + 5, "avg10=%lf avg60=%lf avg300=%lf total=%llu",
+                   &l->avg10, &l->avg60, &l->avg300, &total) == 4) {
+            l->total_us = total;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+int64_t cgroup_read_current(const cgroup_t* cg) {
+    return read_value(cg, "memory.current");
+}
+
+int64_t cgroup_read_limit(const cgroup_t* cg) {
+    int64_t high = read_value(cg, "memory.high");
+    if (high > 0) return high;
+    int64_t max = read_value(cg, "memory.max");
+    if (max >= 0) return max;
+    return high;
+}
+
+int cgroup_arm_trigger(cgroup_t* cg, uint32_t stall_us, uint32_t window_us) {
+    char file[320], trigger[64];
+    int fd;
+
+    snprintf(file, sizeof(file), "%s/memory.pressure", cg->path);
+    fd = open(file, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    int len = snprintf(trigger, sizeof(trigger), "some %u %u", stall_us, window_us);
+    if (write(fd, trigger, len + 1) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (cg->trigger_fd >= 0) close(cg->trigger_fd);
+    cg->trigger_fd = fd;
+    return 0;
+}
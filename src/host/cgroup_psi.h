@@ -0,0 +1,47 @@
+#ifndef __UPMEM_SWAP_CGROUP_PSI_H__
+#define __UPMEM_SWAP_CGROUP_PSI_H__
+
+#include <stdint.h>
+
+/*
+ * cgroup v2 memory accounting and pressure (PSI).
+ *
+ * Reads memory.pressure, memory.current and memory.high/max of one cgroup,
+ * and can arm a PSI trigger so that poll() wakes up (POLLPRI) when tasks
+ * of the cgroup stall on memory for more than stall_us per window_us.
+ */
+
+typedef struct {
+    double avg10;           /* % of time stalled, last 10s */
+    double avg60;
+    double avg300;
+    uint64_t total_us;
+} psi_line_t;
+
+typedef struct {
+    psi_line_t some;        /* at least one task stalled */
+    psi_line_t full;        /* all non-idle tasks stalled */
+} psi_stats_t;
+
+typedef struct {
+    char path[256];         /* cgroup directory */
+    int trigger_fd;         /* memory.pressure with a trigger armed, -1 if none */
+} cgroup_t;
+
+/* path NULL: the cgroup v2 of the calling process */
+int cgroup_open(cgroup_t* cg, const char* path);
+void cgroup_close(cgroup_t* cg);
+
+/* Return 0, or -1 if the file is missing (no memory controller) */
+int cgroup_read_pressure(const cgroup_t* cg, psi_stats_t* psi);
+
+/* Bytes charged to the cgroup, -1 if unknown */
+int64_t cgroup_read_current(const cgroup_t* cg);
+
+/* memory.high if set, else memory.max; 0 if unlimited, -1 if unknown */
+int64_t cgroup_read_limit(const cgroup_t* cg);
+
+/* Arm a "some" trigger; cg->trigger_fd is then polled for POLLPRI */
+int cgroup_arm_trigger(cgroup_t* cg, uint32_t stall_us, uint32_t window_us);
+
+#endif /* __UPMEM_SWAP_CGROUP_PSI_H__ */
@@ -0,0 +1,538 @@
+/**
+ * UPMEM Swap - Checkpoint/restore
+ *
+ * Streaming save of a memory region into huge pages of the store, eager
+ * and userfaultfd-driven lazy restore. See checkpoint.h.
+ */
+
+#include "checkpoint.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/userfaultfd.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "work_pool.h"
+
+/* The fault thread rechecks its flags this often (ms) */
+#define CKPT_POLL_MS 10
+
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t nr_chunks;
+    uint64_t size;
+    uint64_t first_page_id;
+    uint64_t chunk_size;
+} ckpt_file_header_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/* ========================================================================
+ * Chunks
+ * ======================================================================== */
+
+/* 64-bit checksum, four independent multiply-rotate lanes so it keeps up
+ * with memory bandwidth */
+static uint64_t chunk_checksum(const uint8_t* data, size_t length) {
+    uint64_t lanes[4] = {PRIME1, PRIME2, ~PRIME1, ~PRIME2};
+    size_t i = 0;
+    uint64_t h;
+
+    for (; i + 32 <= length; i += 32) {
+        for (int l = 0; l < 4; l++) {
+            uint64_t v;
+            memcpy(&v, data + i + 8 * l, sizeof(v));
+            lanes[l] = rotl64(lanes[l] + v * PRIME2, 31) * PRIME1;
+        }
+    }
+    h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+    for (; i < length; i++) {
+        h = rotl64(h ^ (data[i] * PRIME1), 11) * PRIME2;
+    }
+    h ^= length;
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME1;
+    h ^= h >> 32;
+    return h;
+}
+
+static size_t chunk_length(const ckpt_manifest_t* m, uint32_t i) {
+    size_t offset = (size_t)i * CKPT_CHUNK_SIZE;
+    return m->size - offset < CKPT_CHUNK_SIZE ? m->size - offset : CKPT_CHUNK_SIZE;
+}
+
+typedef struct {
+    const uint8_t* data;            /* the region */
+    const ckpt_manifest_t* m;
+    uint64_t* checksums;            /* save: written */
+    uint64_t errors;                /* restore: mismatches */
+} ckpt_job_t;
+
+static void checksum_chunk(void* ctx, size_t i) {
+    ckpt_job_t* job = ctx;
+    job->checksums[i] = chunk_checksum(job->data + i * CKPT_CHUNK_SIZE,
+                                       chunk_length(job->m, (uint32_t)i));
+}
+
+static void verify_chunk(void* ctx, size_t i) {
+    ckpt_job_t* job = ctx;
+    if (chunk_checksum(job->data + i * CKPT_CHUNK_SIZE, chunk_length(job->m, (uint32_t)i)) !=
+        job->m->checksums[i]) {
+        __atomic_fetch_add(&job->errors, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* ========================================================================
+ * Save and eager restore
+ * ======================================================================== */
+
+int ckpt_save(swap_store_t* store, const void* region, size_t size, uint64_t first_page_id,
+              int nr_workers, ckpt_manifest_t* m, ckpt_stats_t* stats) {
+    ckpt_stats_t local;
+    work_pool_t pool;
+    uint8_t* staging = NULL;
+    ckpt_job_t job;
+    int ret = 0;
+
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    memset(m, 0, sizeof(*m));
+    if (!store->huge) {
+        fprintf(stderr, "ERROR: checkpoints need cfg.huge_mram_size\n");
+        return -1;
+    }
+    if (size == 0 || (size + CKPT_CHUNK_SIZE - 1) / CKPT_CHUNK_SIZE > UINT32_MAX) {
+        fprintf(stderr, "ERROR: cannot checkpoint %zu bytes\n", size);
+        return -1;
+    }
+    m->size = size;
+    m->nr_chunks = (uint32_t)((size + CKPT_CHUNK_SIZE - 1) / CKPT_CHUNK_SIZE);
+    m->first_page_id = first_page_id;
+    m->checksums = calloc(m->nr_chunks, sizeof(uint64_t));
+    if (!m->checksums) {
+        fprintf(stderr, "ERROR: Failed to allocate manifest\n");
+        return -1;
+    }
+    if (work_pool_init(&pool, nr_workers) != 0) {
+        ckpt_manifest_free(m);
+        return -1;
+    }
+
+    /* Workers read ahead over the whole region while this thread pushes */
+    job.data = region;
+    job.m = m;
+    job.checksums = m->checksums;
+    job.errors = 0;
+    if (work_pool_start(&pool, checksum_chunk, &job, m->nr_chunks, m->nr_chunks) != 0) {
+        work_pool_destroy(&pool);
+        ckpt_manifest_free(m);
+        return -1;
+    }
+    for (uint32_t i = 0; i < m->nr_chunks; i++) {
+        const uint8_t* src = (const uint8_t*)region + (size_t)i * CKPT_CHUNK_SIZE;
+        size_t length = chunk_length(m, i);
+
+        /* The last chunk is padded with zeros to a whole huge page */
+        if (length < CKPT_CHUNK_SIZE) {
+            staging = calloc(1, CKPT_CHUNK_SIZE);
+            if (!staging) {
+                ret = -1;
+                break;
+            }
+            memcpy(staging, src, length);
+            src = staging;
+        }
+        uint64_t t0 = now_ns();
+        if (swap_store_put_huge(store, first_page_id + i, src) != 0) {
+            stats->errors++;
+            ret = -1;
+            break;
+        }
+        stats->xfer_ns += now_ns() - t0;
+        stats->chunks++;
+        stats->bytes += length;
+    }
+    work_pool_finish(&pool);
+    work_pool_destroy(&pool);
+    free(staging);
+    if (ret != 0) {
+        ckpt_manifest_free(m);
+    }
+    return ret;
+}
+
+int ckpt_restore(swap_store_t* store, const ckpt_manifest_t* m, void* dst, int nr_workers,
+                 ckpt_stats_t* stats) {
+    ckpt_stats_t local;
+    work_pool_t pool;
+    uint8_t* staging = NULL;
+    ckpt_job_t job;
+    int ret = 0;
+
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (work_pool_init(&pool, nr_workers) != 0) {
+        return -1;
+    }
+    job.data = dst;
+    job.m = m;
+    job.checksums = NULL;
+    job.errors = 0;
+    if (work_pool_start(&pool, verify_chunk, &job, m->nr_chunks, 0) != 0) {
+        work_pool_destroy(&pool);
+        return -1;
+    }
+    /* Chunk i is verified by the workers while chunk i + 1 comes in. On an
+     * error keep going so every gate opens. */
+    for (uint32_t i = 0; i < m->nr_chunks; i++) {
+        uint8_t* out = (uint8_t*)dst + (size_t)i * CKPT_CHUNK_SIZE;
+        size_t length = chunk_length(m, i);
+        uint8_t* into = out;
+
+        if (length < CKPT_CHUNK_SIZE) {
+            if (!staging) staging = malloc(CKPT_CHUNK_SIZE);
+            if (!staging) {
+                stats->errors++;
+                ret = -1;
+                work_pool_open_gate(&pool, i + 1);
+                continue;
+            }
+            into = staging;
+        }
+        uint64_t t0 = now_ns();
+        if (swap_store_get_huge(store, m->first_page_id + i, into) != 0) {
+            stats->errors++;
+            ret = -1;
+        } else {
+            if (into != out) memcpy(out, into, length);
+            stats->chunks++;
+            stats->bytes += length;
+        }
+        stats->xfer_ns += now_ns() - t0;
+        work_pool_open_gate(&pool, i + 1);
+    }
+    work_pool_finish(&pool);
+    work_pool_destroy(&pool);
+    free(staging);
+
+    stats->checksum_errors = job.errors;
+    if (job.errors) {
+        fprintf(stderr, "ERROR: %llu checkpoint chunks failed their checksum\n",
+                (unsigned long long)job.errors);
+        ret = -1;
+    }
+    return ret;
+}
+
+/* ========================================================================
+ * Manifest
+ * ======================================================================== */
+
+int ckpt_manifest_write(const ckpt_manifest_t* m, const char* path) {
+    ckpt_file_header_t h = {
+        .magic = CKPT_MAGIC,
+        .version = CKPT_VERSION,
+        .nr_chunks = m->nr_chunks,
+        .size = m->size,
+        .first_page_id = m->first_page_id,
+        .chunk_size = CKPT_CHUNK_SIZE,
+    };
+    FILE* f = fopen(path, "wb");
+    int ok;
+
+    if (!f) {
+        fprintf(stderr, "ERROR: cannot create %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+         fwrite(m->checksums, sizeof(uint64_t), m->nr_chunks, f) == m->nr_chunks;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "ERROR: writing %s failed\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int ckpt_manifest_read(ckpt_manifest_t* m, const char* path) {
+    ckpt_file_header_t h;
+    FILE* f = fopen(path, "rb");
+
+    memset(m, 0, sizeof(*m));
+    if (!f) {
+        fprintf(stderr, "ERROR: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (fread(&h, sizeof(h), 1, f) != 1 || h.magic != CKPT_MAGIC ||
+        h.version != CKPT_VERSION || h.chunk_size != CKPT_CHUNK_SIZE || h.size == 0 ||
+        (h.size + CKPT_CHUNK_SIZE - 1) / CKPT_CHUNK_SIZE != h.nr_chunks) {
+        fprintf(stderr, "ERROR: %s is not a checkpoint manifest\n", path);
+        fclose(f);
+        return -1;
+    }
+    m->checksums = malloc((size_t)h.nr_chunks * sizeof(uint64_t));
+    if (!m->checksums || fread(m->checksums, sizeof(uint64_t), h.nr_chunks, f) != h.nr_chunks) {
+        fprintf(stderr, "ERROR: %s is truncated\n", path);
+        free(m->checksums);
+        m->checksums = NULL;
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    m->size = h.size;
+    m->nr_chunks = h.nr_chunks;
+    m->first_page_id = h.first_page_id;
+    return 0;
+}
+
+void ckpt_manifest_free(ckpt_manifest_t* m) {
+    free(m->checksums);
+    memset(m, 0, sizeof(*m));
+}
+
+/* ========================================================================
+ * Lazy restore (fault thread)
+ * ======================================================================== */
+
+/* Map bytes [offset, offset + len) of the bounce buffer into the region.
+ * Pages some other path already mapped are skipped and their waiters
+ * woken. */
+static int map_range(ckpt_lazy_t* lazy, size_t offset, size_t len) {
+    size_t done = 0;
+    int skipped = 0;
+
+    while (done < len) {
+        struct uffdio_copy copy = {
+            .dst = (uintptr_t)(lazy->base + offset + done),
+            .src = (uintptr_t)(lazy->bounce + done),
+            .len = len - done,
+            .mode = 0,
+        };
+        if (ioctl(lazy->uffd, UFFDIO_COPY, &copy) == 0) {
+            break;
+        }
+        if (copy.copy > 0) {
+            done += (size_t)copy.copy;
+        } else if (errno == EEXIST) {
+            done += STORE_PAGE_SIZE;
+            skipped = 1;
+        } else if (errno != EAGAIN) {
+            fprintf(stderr, "ERROR: mapping checkpoint chunk: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+    if (skipped) {
+        struct uffdio_range range = {.start = (uintptr_t)(lazy->base + offset), .len = len};
+        ioctl(lazy->uffd, UFFDIO_WAKE, &range);
+    }
+    return 0;
+}
+
+/* Pull chunk c from the store and map all of it */
+static void pull_chunk(ckpt_lazy_t* lazy, uint32_t c) {
+    const ckpt_manifest_t* m = lazy->m;
+    size_t offset = (size_t)c * CKPT_CHUNK_SIZE;
+    size_t len = lazy->map_size - offset < CKPT_CHUNK_SIZE ? lazy->map_size - offset
+                                                           : CKPT_CHUNK_SIZE;
+
+    if (swap_store_get_huge(lazy->store, m->first_page_id + c, lazy->bounce) != 0) {
+        /* The faulting thread cannot be left waiting */
+        memset(lazy->bounce, 0, CKPT_CHUNK_SIZE);
+        lazy->stats.errors++;
+    } else if (chunk_checksum(lazy->bounce, chunk_length(m, c)) != m->checksums[c]) {
+        lazy->stats.checksum_errors++;
+    } else {
+        lazy->stats.chunks++;
+        lazy->stats.bytes += chunk_length(m, c);
+    }
+    if (map_range(lazy, offset, len) != 0) {
+        lazy->stats.errors++;
+    }
+    lazy->present[c] = 1;
+    lazy->nr_present++;
+}
+
+static void serve_faults(ckpt_lazy_t* lazy) {
+    struct uffd_msg msg;
+
+    while (read(lazy->uffd, &msg, sizeof(msg)) == (ssize_t)sizeof(msg)) {
+        if (msg.event != UFFD_EVENT_PAGEFAULT) continue;
+
+        uintptr_t addr = (uintptr_t)msg.arg.pagefault.address;
+        uint32_t c = (uint32_t)((addr - (uintptr_t)lazy->base) / CKPT_CHUNK_SIZE);
+        if (c >= lazy->m->nr_chunks) continue;
+
+        if (lazy->present[c]) {
+            /* Queued before the chunk was mapped */
+            struct uffdio_range range = {.start = addr & ~(uintptr_t)(STORE_PAGE_SIZE - 1),
+                                         .len = STORE_PAGE_SIZE};
+            ioctl(lazy->uffd, UFFDIO_WAKE, &range);
+            continue;
+        }
+        uint64_t start = now_ns();
+        pull_chunk(lazy, c);
+        lazy->stats.faults++;
+        lazy->stats.fault_ns += now_ns() - start;
+    }
+}
+
+static void* fault_main(void* arg) {
+    ckpt_lazy_t* lazy = arg;
+    struct pollfd pfd = {.fd = lazy->uffd, .events = POLLIN};
+
+    for (;;) {
+        pthread_mutex_lock(&lazy->lock);
+        int stop = lazy->stop, complete = lazy->complete;
+        pthread_mutex_unlock(&lazy->lock);
+
+        if (stop) break;
+        if (complete) {
+            serve_faults(lazy);
+            for (uint32_t c = 0; c < lazy->m->nr_chunks; c++) {
+                if (lazy->present[c]) continue;
+                pull_chunk(lazy, c);
+                lazy->stats.prefilled++;
+            }
+            break;
+        }
+        if (poll(&pfd, 1, CKPT_POLL_MS) > 0) {
+            serve_faults(lazy);
+        }
+    }
+
+    pthread_mutex_lock(&lazy->lock);
+    lazy->finished = 1;
+    pthread_cond_broadcast(&lazy->done_cv);
+    pthread_mutex_unlock(&lazy->lock);
+    return NULL;
+}
+
+/* ========================================================================
+ * Lazy restore (API)
+ * ======================================================================== */
+
+int ckpt_lazy_start(ckpt_lazy_t* lazy, swap_store_t* store, const ckpt_manifest_t* m) {
+    struct uffdio_api api = {.api = UFFD_API, .features = 0};
+    struct uffdio_register reg;
+
+    memset(lazy, 0, sizeof(*lazy));
+    lazy->uffd = -1;
+    lazy->store = store;
+    lazy->m = m;
+    pthread_mutex_init(&lazy->lock, NULL);
+    pthread_cond_init(&lazy->done_cv, NULL);
+    if (m->nr_chunks == 0) {
+        fprintf(stderr, "ERROR: empty checkpoint manifest\n");
+        ckpt_lazy_free(lazy);
+        return -1;
+    }
+    lazy->map_size = (m->size + STORE_PAGE_SIZE - 1) & ~(size_t)(STORE_PAGE_SIZE - 1);
+
+    lazy->base = mmap(NULL, lazy->map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0);
+    if (lazy->base == MAP_FAILED) {
+        fprintf(stderr, "ERROR: mmap of %zu bytes failed: %s\n", lazy->map_size, strerror(errno));
+        lazy->base = NULL;
+        ckpt_lazy_free(lazy);
+        return -1;
+    }
+    lazy->present = calloc(m->nr_chunks, sizeof(uint8_t));
+    if (!lazy->present ||
+        posix_memalign((void**)&lazy->bounce, STORE_PAGE_SIZE, CKPT_CHUNK_SIZE) != 0) {
+        fprintf(stderr, "ERROR: Failed to allocate lazy restore buffers\n");
+        ckpt_lazy_free(lazy);
+        return -1;
+    }
+    /* Tail of a short last chunk */
+    memset(lazy->bounce, 0, CKPT_CHUNK_SIZE);
+
+    /* Unprivileged processes only get faults from user mode */
+    lazy->uffd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+    if (lazy->uffd < 0 && errno == EPERM) {
+        lazy->uffd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+    }
+    if (lazy->uffd < 0) {
+        fprintf(stderr, "ERROR: userfaultfd: %s\n", strerror(errno));
+        ckpt_lazy_free(lazy);
+        return -1;
+    }
+    if (ioctl(lazy->uffd, UFFDIO_API, &api) != 0) {
+        fprintf(stderr, "ERROR: UFFDIO_API: %s\n", strerror(errno));
+        ckpt_lazy_free(lazy);
+        return -1;
+    }
+    reg.range.start = (uintptr_t)lazy->base;
+    reg.range.len = lazy->map_size;
+    reg.mode = UFFDIO_REGISTER_MODE_MISSING;
+    if (ioctl(lazy->uffd, UFFDIO_REGISTER, &reg) != 0) {
+        fprintf(stderr, "ERROR: UFFDIO_REGISTER: %s\n", strerror(errno));
+        ckpt_lazy_free(lazy);
+        return -1;
+    }
+
+    if (pthread_create(&lazy->thread, NULL, fault_main, lazy) != 0) {
+        fprintf(stderr, "ERROR: Failed to start checkpoint fault thread\n");
+        ckpt_lazy_free(lazy);
+        return -1;
+    }
+    lazy->started = 1;
+    return 0;
+}
+
+int ckpt_lazy_complete(ckpt_lazy_t* lazy) {
+    if (!lazy->started) {
+        return -1;
+    }
+    pthread_mutex_lock(&lazy->lock);
+    lazy->complete = 1;
+    while (!lazy->finished) {
+        pthread_cond_wait(&lazy->done_cv, &lazy->lock);
+    }
+    pthread_mutex_unlock(&lazy->lock);
+    pthread_join(lazy->thread, NULL);
+    lazy->started = 0;
+
+    /* Every page is mapped: the region is plain memory from now on */
+    close(lazy->uffd);
+    lazy->uffd = -1;
+    return lazy->stats.errors || lazy->stats.checksum_errors ? -1 : 0;
+}
+
+void ckpt_lazy_free(ckpt_lazy_t* lazy) {
+    if (lazy->started) {
+        pthread_mutex_lock(&lazy->lock);
+        lazy->stop = 1;
+        pthread_mutex_unlock(&lazy->lock);
+        pthread_join(lazy->thread, NULL);
+    }
+    if (lazy->uffd >= 0) close(lazy->uffd);
+    if (lazy->base) munmap(lazy->base, lazy->map_size);
+    free(lazy->present);
+    free(lazy->bounce);
+    pthread_cond_destroy(&lazy->done_cv);
+    pthread_mutex_destroy(&lazy->lock);
+    memset(lazy, 0, sizeof(*lazy));
+    lazy->uffd = -1;
+}
@@ -0,0 +1,97 @@
+#ifndef __UPMEM_SWAP_CHECKPOINT_H__
+#define __UPMEM_SWAP_CHECKPOINT_H__
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "swap_store.h"
+
+/*
+ * Checkpoint/restore of a memory region to the DPU tier, for service
+ * restarts and migrations.
+ *
+ * The region is cut into chunks of one huge page (2MB), so every chunk is
+ * a single rank-wide push and consecutive chunks go to different ranks
+ * (the store needs cfg.huge_mram_size). Chunk i is huge page
+ * first_page_id + i. Saving is a pipeline: worker threads read ahead
+ * through the region and checksum the chunks while the calling thread
+ * pushes the ones already read. The manifest (region size, chunk ids,
+ * checksums) is what a restore needs, and can go to a file.
+ *
+ * Restore is eager (every chunk pulled into a buffer, checksums verified
+ * by the workers while the next chunks come in) or lazy: the region is
+ * mapped at once and registered with userfaultfd, and the first touch of
+ * a chunk pulls that whole chunk in. While a lazy restore runs, its fault
+ * thread owns the store.
+ */
+
+#define CKPT_CHUNK_SIZE STORE_HUGE_PAGE_SIZE
+#define CKPT_MAGIC 0x54504B4350534D55ULL    /* "UMSPCKPT" */
+#define CKPT_VERSION 1
+
+typedef struct {
+    uint64_t size;                  /* region bytes */
+    uint32_t nr_chunks;
+    uint64_t first_page_id;         /* huge page of chunk 0 */
+    uint64_t* checksums;            /* per chunk */
+} ckpt_manifest_t;
+
+typedef struct {
+    uint64_t chunks;
+    uint64_t bytes;
+    uint64_t xfer_ns;               /* calling thread in the store */
+    uint64_t checksum_errors;
+    uint64_t errors;                /* chunks the store failed to move */
+    uint64_t faults;                /* lazy: chunks pulled on a fault */
+    uint64_t prefilled;             /* lazy: ... by ckpt_lazy_complete() */
+    uint64_t fault_ns;              /* lazy: time to serve those faults */
+} ckpt_stats_t;
+
+/* Save size bytes at region as chunks first_page_id.. of store, with
+ * nr_workers checksum threads (0: inline). Fills m (free with
+ * ckpt_manifest_free). 0, or -1. */
+int ckpt_save(swap_store_t* store, const void* region, size_t size, uint64_t first_page_id,
+              int nr_workers, ckpt_manifest_t* m, ckpt_stats_t* stats);
+
+/* Eager restore into dst (m->size bytes). -1 on a store error or a
+ * checksum mismatch. */
+int ckpt_restore(swap_store_t* store, const ckpt_manifest_t* m, void* dst, int nr_workers,
+                 ckpt_stats_t* stats);
+
+int ckpt_manifest_write(const ckpt_manifest_t* m, const char* path);
+int ckpt_manifest_read(ckpt_manifest_t* m, const char* path);
+void ckpt_manifest_free(ckpt_manifest_t* m);
+
+/* Lazy restore: base is usable as soon as ckpt_lazy_start() returns */
+typedef struct {
+    swap_store_t* store;
+    const ckpt_manifest_t* m;
+    uint8_t* base;
+    size_t map_size;                /* m->size rounded up to a page */
+    int uffd;
+    uint8_t* present;               /* per chunk */
+    uint32_t nr_present;
+    uint8_t* bounce;                /* one chunk, page aligned */
+
+    pthread_t thread;
+    int started;
+    pthread_mutex_t lock;
+    pthread_cond_t done_cv;
+    int complete;                   /* asked to pull every chunk */
+    int stop;
+    int finished;                   /* fault thread exited */
+
+    ckpt_stats_t stats;
+} ckpt_lazy_t;
+
+int ckpt_lazy_start(ckpt_lazy_t* lazy, swap_store_t* store, const ckpt_manifest_t* m);
+
+/* Pull every chunk not faulted in yet and wait for it. The region stays
+ * mapped and the store is the caller's again. 0, or -1 if a chunk failed. */
+int ckpt_lazy_complete(ckpt_lazy_t* lazy);
+
+/* Stop serving faults and unmap the region */
+void ckpt_lazy_free(ckpt_lazy_t* lazy);
+
+#endif /* __UPMEM_SWAP_CHECKPOINT_H__ */
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cost_model.h"
+
+/*
+ * Fit the cost model of the host memory store (cost_model.h) to measured
+ * runs and write it to a model file, for cfg.cost_model or
+ * UPMEM_SWAP_COST_MODEL.
+ *
+ *   cost_fit -l results_256b_simulator.csv -o sim.model benchmark_results.csv
+ *   UPMEM_SWAP_COST_MODEL=sim.model ./build/benchmark_throughput
+ *
+ * Transfer costs come from the serial and parallel rows of a
+ * benchmark_complete CSV, the launch cost from -l: a test_decompose output
+ * or the round trips main.c logs (-b bytes each way). Without -l the
+ * default launch cost stays. The runs do not span ranks, so -P sets how
+ * many ranks a transfer or launch drives at once; -i makes the store
+ * delay its callers by the modeled time instead of only counting it.
+ *
+ * Usage: cost_fit [-l launch_log] [-b round_trip_bytes] [-P rank_parallelism] [-i]
+ *                 [-o model_file] [benchmark_results.csv]
+ */
+
+int main(int argc, char* argv[]) {
+    const char* results = "benchmark_results.csv";
+    const char* launch_log = NULL;
+    const char* out_path = NULL;
+    uint32_t bytes = 256;
+    cost_model_t m;
+    cost_fit_t fit;
+    int opt;
+
+    cost_model_default(&m);
+    while ((opt = getopt(argc, argv, "l:b:P:io:h")) != -1) {
+        switch (opt) {
+        case 'l': launch_log = optarg; break;
+        case 'b': bytes = strtoul(optarg, NULL, 0); break;
+        case 'P': m.rank_parallelism = strtoul(optarg, NULL, 0); break;
+        case 'i': m.inject = 1; break;
+        case 'o': out_path = optarg; break;
+        default:
+            fprintf(stderr, "Usage: %s [-l launch_log] [-b round_trip_bytes] "
+                    "[-P rank_parallelism] [-i] [-o model_file] [benchmark_results.csv]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc) results = argv[optind];
+
+    if (cost_model_fit_results(&m, results, &fit) != 0) return 1;
+    if (launch_log && cost_model_fit_launch(&m, launch_log, bytes) != 0) return 1;
+
+    printf("=== COST MODEL FIT ===\n");
+    printf("Transfers: %s (%u samples)\n", results, fit.rows);
+    printf("Launch:    %s\n\n", launch_log ? launch_log : "default");
+    printf("  push_ns          %10.1f   fixed cost of a transfer\n", m.push_ns);
+    printf("  dpu_ns           %10.1f   per DPU of the busiest rank\n", m.dpu_ns);
+    printf("  byte_ns          %10.6f   per byte of the busiest rank\n", m.byte_ns);
+    printf("  launch_ns        %10.1f   per wave of ranks\n", m.launch_ns);
+    printf("  rank_parallelism %10u   %s\n", m.rank_parallelism,
+           m.rank_parallelism ? "ranks at once (not fitted)" : "all ranks at once (not fitted)");
+    printf("  inject           %10d\n\n", m.inject);
+    printf("Relative error of the modeled transfer times: median %.1f%%, p90 %.1f%%, "
+           "max %.1f%%\n", fit.median_err * 100, fit.p90_err * 100, fit.max_err * 100);
+    printf("  serial rows (one DPU per push):   median %.1f%%\n", fit.serial_median_err * 100);
+    printf("  parallel rows (push over the set): median %.1f%%\n",
+           fit.parallel_median_err * 100);
+
+    if (out_path) {
+        if (cost_model_save(&m, out_path) != 0) return 1;
+        printf("\n✓ Model saved to %s\n", out_path);
+    }
+    return 0;
+}
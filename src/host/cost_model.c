@@ -0,0 +1,413 @@
+/**
+ * UPMEM Swap - Cost model
+ *
+ * Modeled time of transfers and launches for the host memory store, and
+ * its fit to simulator or hardware runs. See cost_model.h.
+ */
+
+#include "cost_model.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FIT_PARAMS 3                /* push_ns, dpu_ns, byte_ns */
+#define MAX_LINE 1024
+#define MAX_FIELDS 64
+#define SPIN_NS 100000              /* below this, spin: nanosleep overshoots */
+
+void cost_model_default(cost_model_t* m) {
+    memset(m, 0, sizeof(*m));
+    m->push_ns = 12847;
+    m->dpu_ns = 3200;
+    m->byte_ns = 0;                 /* the simulator's time goes with DPUs, not bytes */
+    m->launch_ns = 131841;
+    m->rank_parallelism = 8;
+}
+
+/* ========================================================================
+ * Costs
+ * ======================================================================== */
+
+static void shape_close(cost_shape_t* s) {
+    if (s->dpus == 0) return;
+    s->nr_ranks++;
+    if (s->dpus > s->max_dpus) s->max_dpus = s->dpus;
+    if (s->bytes > s->max_bytes) s->max_bytes = s->bytes;
+    s->dpus = 0;
+    s->bytes = 0;
+}
+
+void cost_shape_add(cost_shape_t* s, uint32_t rank, uint64_t bytes) {
+    if (rank != s->rank) {
+        shape_close(s);
+        s->rank = rank;
+    }
+    s->dpus++;
+    s->bytes += bytes;
+}
+
+static uint32_t waves(const cost_model_t* m, uint32_t nr_ranks) {
+    if (m->rank_parallelism == 0) return nr_ranks ? 1 : 0;
+    return (nr_ranks + m->rank_parallelism - 1) / m->rank_parallelism;
+}
+
+uint64_t cost_model_xfer_ns(const cost_model_t* m, const cost_shape_t* s) {
+    cost_shape_t all = *s;
+
+    shape_close(&all);
+    if (all.nr_ranks == 0) return 0;
+    return (uint64_t)(m->push_ns + waves(m, all.nr_ranks) *
+                      (m->dpu_ns * all.max_dpus + m->byte_ns * all.max_bytes));
+}
+
+uint64_t cost_model_launch_ns(const cost_model_t* m, const cost_shape_t* s) {
+    cost_shape_t all = *s;
+
+    shape_close(&all);
+    return (uint64_t)(m->launch_ns * waves(m, all.nr_ranks));
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void cost_model_delay(uint64_t ns) {
+    uint64_t until = now_ns() + ns;
+
+    if (ns > SPIN_NS) {
+        uint64_t sleep = ns - SPIN_NS;
+        struct timespec ts = {(time_t)(sleep / 1000000000ULL), (long)(sleep % 1000000000ULL)};
+        nanosleep(&ts, NULL);
+    }
+    while (now_ns() < until) {
+    }
+}
+
+/* ========================================================================
+ * Fit
+ * ======================================================================== */
+
+typedef struct {
+    double x[FIT_PARAMS];           /* pushes, DPU transfers, bytes */
+    double ns;
+    int serial;                     /* one DPU per push */
+} sample_t;
+
+/* Split line at commas in place */
+static int split_csv(char* line, char** fields) {
+    int n = 0;
+    char* p = line;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    while (n < MAX_FIELDS) {
+        fields[n++] = p;
+        p = strchr(p, ',');
+        if (!p) break;
+        *p++ = '\0';
+    }
+    return n;
+}
+
+static int column(char** fields, int n, const char* name) {
+    for (int i = 0; i < n; i++) {
+        if (strcmp(fields[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+/* Solve a * x = b (n x n, Gaussian elimination with partial pivoting) */
+static int solve(double a[FIT_PARAMS][FIT_PARAMS], double* b, double* x, int n) {
+    for (int i = 0; i < n; i++) {
+        int p = i;
+        for (int j = i + 1; j < n; j++) {
+            if (fabs(a[j][i]) > fabs(a[p][i])) p = j;
+        }
+        if (fabs(a[p][i]) < 1e-300) return -1;
+        for (int k = 0; k < n; k++) {
+            double t = a[i][k];
+            a[i][k] = a[p][k];
+            a[p][k] = t;
+        }
+        double t = b[i];
+        b[i] = b[p];
+        b[p] = t;
+        for (int j = i + 1; j < n; j++) {
+            double f = a[j][i] / a[i][i];
+            for (int k = i; k < n; k++) a[j][k] -= f * a[i][k];
+            b[j] -= f * b[i];
+        }
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        x[i] = b[i];
+        for (int k = i + 1; k < n; k++) x[i] -= a[i][k] * x[k];
+        x[i] /= a[i][i];
+    }
+    return 0;
+}
+
+/* Least squares on the relative error, coefficients kept >= 0: a negative
+ * one is pinned to 0 and the others refitted */
+static int fit_nonneg(const sample_t* s, size_t n, double* coef) {
+    int free_param[FIT_PARAMS] = {1, 1, 1};
+
+    for (int pass = 0; pass < FIT_PARAMS; pass++) {
+        double a[FIT_PARAMS][FIT_PARAMS] = {{0}}, b[FIT_PARAMS] = {0}, x[FIT_PARAMS];
+        int idx[FIT_PARAMS], m = 0, negative = 0;
+
+        for (int p = 0; p < FIT_PARAMS; p++) {
+            if (free_param[p]) idx[m++] = p;
+        }
+        if (m == 0) break;
+        for (size_t r = 0; r < n; r++) {
+            double w = 1.0 / (s[r].ns * s[r].ns);
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < m; j++) a[i][j] += w * s[r].x[idx[i]] * s[r].x[idx[j]];
+                b[i] += w * s[r].x[idx[i]] * s[r].ns;
+            }
+        }
+        if (solve(a, b, x, m) != 0) return -1;
+        for (int p = 0; p < FIT_PARAMS; p++) coef[p] = 0;
+        for (int i = 0; i < m; i++) {
+            coef[idx[i]] = x[i];
+            if (x[i] < 0) {
+                free_param[idx[i]] = 0;
+                negative = 1;
+            }
+        }
+        if (!negative) return 0;
+    }
+    for (int p = 0; p < FIT_PARAMS; p++) {
+        if (coef[p] < 0) coef[p] = 0;
+    }
+    return 0;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Median of the relative errors of the samples whose mode is serial (-1: all) */
+static double median_err(const sample_t* s, size_t n, const double* coef, int serial,
+                         double* err) {
+    size_t m = 0;
+
+    for (size_t r = 0; r < n; r++) {
+        double model = 0;
+        if (serial >= 0 && s[r].serial != serial) continue;
+        for (int p = 0; p < FIT_PARAMS; p++) model += coef[p] * s[r].x[p];
+        err[m++] = fabs(model - s[r].ns) / s[r].ns;
+    }
+    if (m == 0) return 0;
+    qsort(err, m, sizeof(double), cmp_double);
+    return err[m / 2];
+}
+
+static void fit_quality(const sample_t* s, size_t n, const double* coef, cost_fit_t* fit) {
+    double* err = malloc(n * sizeof(double));
+
+    memset(fit, 0, sizeof(*fit));
+    fit->rows = (uint32_t)n;
+    if (!err) return;
+    fit->serial_median_err = median_err(s, n, coef, 1, err);
+    fit->parallel_median_err = median_err(s, n, coef, 0, err);
+    fit->median_err = median_err(s, n, coef, -1, err);
+    fit->p90_err = err[(size_t)(n * 0.9)];
+    fit->max_err = err[n - 1];
+    free(err);
+}
+
+int cost_model_fit_results(cost_model_t* m, const char* path, cost_fit_t* fit) {
+    FILE* f = fopen(path, "r");
+    char line[MAX_LINE];
+    char* fields[MAX_FIELDS];
+    sample_t* samples = NULL;
+    size_t n = 0, cap = 0;
+    double coef[FIT_PARAMS];
+    int c_dpus, c_size, c_mode, c_write, c_read, nf;
+
+    if (!f) {
+        fprintf(stderr, "ERROR: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (!fgets(line, sizeof(line), f)) {
+        fclose(f);
+        return -1;
+    }
+    nf = split_csv(line, fields);
+    c_dpus = column(fields, nf, "nr_dpus");
+    c_size = column(fields, nf, "size");
+    c_mode = column(fields, nf, "mode");
+    c_write = column(fields, nf, "write_mean_us");
+    c_read = column(fields, nf, "read_mean_us");
+    if (c_dpus < 0 || c_size < 0 || c_mode < 0 || c_write < 0 || c_read < 0) {
+        fprintf(stderr, "ERROR: %s has no benchmark_results.csv header\n", path);
+        fclose(f);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        nf = split_csv(line, fields);
+        if (nf <= c_dpus || nf <= c_size || nf <= c_mode || nf <= c_write || nf <= c_read) {
+            continue;
+        }
+        int serial = strcmp(fields[c_mode], "serial") == 0;
+        if (!serial && strcmp(fields[c_mode], "parallel") != 0) continue;
+
+        double dpus = atof(fields[c_dpus]), size = atof(fields[c_size]);
+        double chunks = ceil(size / COST_MODEL_CHUNK);
+        double us[2] = {atof(fields[c_write]), atof(fields[c_read])};
+        if (dpus <= 0 || size <= 0) continue;
+
+        for (int k = 0; k < 2; k++) {
+            if (us[k] <= 0) continue;
+            if (n == cap) {
+                cap = cap ? 2 * cap : 256;
+                sample_t* grown = realloc(samples, cap * sizeof(sample_t));
+                if (!grown) {
+                    free(samples);
+                    fclose(f);
+                    return -1;
+                }
+                samples = grown;
+            }
+            /* benchmark_complete: chunks pushes per DPU (serial) or over the set */
+            samples[n].x[0] = serial ? dpus * chunks : chunks;
+            samples[n].x[1] = dpus * chunks;
+            samples[n].x[2] = dpus * size;
+            samples[n].ns = us[k] * 1000;
+            samples[n].serial = serial;
+            n++;
+        }
+    }
+    fclose(f);
+
+    if (n < FIT_PARAMS || fit_nonneg(samples, n, coef) != 0) {
+        fprintf(stderr, "ERROR: %s: not enough serial/parallel rows to fit\n", path);
+        free(samples);
+        return -1;
+    }
+    m->push_ns = coef[0];
+    m->dpu_ns = coef[1];
+    m->byte_ns = coef[2];
+    if (fit) fit_quality(samples, n, coef, fit);
+    free(samples);
+    return 0;
+}
+
+int cost_model_fit_launch(cost_model_t* m, const char* path, uint32_t bytes) {
+    FILE* f = fopen(path, "r");
+    char line[MAX_LINE];
+    double* runs = NULL;
+    size_t n = 0, cap = 0;
+    double launch = -1;
+
+    if (!f) {
+        fprintf(stderr, "ERROR: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        double pct, ns;
+        int run;
+
+        /* test_decompose breakdown: "LAUNCH:     12.3% (45678 ns)" */
+        if (sscanf(line, "LAUNCH: %lf%% (%lf ns)", &pct, &ns) == 2) {
+            launch = ns;
+            break;
+        }
+        if (sscanf(line, "Run %d: %lf ns", &run, &ns) == 2) {
+            if (n == cap) {
+                cap = cap ? 2 * cap : 64;
+                double* grown = realloc(runs, cap * sizeof(double));
+                if (!grown) break;
+                runs = grown;
+            }
+            runs[n++] = ns;
+        }
+    }
+    fclose(f);
+
+    if (launch < 0 && n > 0) {
+        cost_shape_t one;
+
+        cost_shape_init(&one);
+        cost_shape_add(&one, 0, bytes);
+        qsort(runs, n, sizeof(double), cmp_double);
+        launch = runs[n / 2] - 2.0 * cost_model_xfer_ns(m, &one);
+        if (launch < 0) launch = 0;
+    }
+    free(runs);
+    if (launch < 0) {
+        fprintf(stderr, "ERROR: %s has no LAUNCH line or round trips\n", path);
+        return -1;
+    }
+    m->launch_ns = launch;
+    return 0;
+}
+
+/* ========================================================================
+ * Files
+ * ======================================================================== */
+
+int cost_model_load(cost_model_t* m, const char* path) {
+    FILE* f = fopen(path, "r");
+    char line[MAX_LINE];
+    cost_model_t loaded;
+    int ln = 0, ret = 0;
+
+    if (!f) {
+        fprintf(stderr, "ERROR: cannot open cost model %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    cost_model_default(&loaded);
+    while (fgets(line, sizeof(line), f)) {
+        char key[64];
+        double v;
+
+        ln++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        if (sscanf(line, " %63s", key) != 1) continue;
+        if (sscanf(line, " %63s %lf", key, &v) != 2 || v < 0) {
+            fprintf(stderr, "ERROR: %s:%d: expected \"key value\"\n", path, ln);
+            ret = -1;
+            break;
+        }
+        if (strcmp(key, "push_ns") == 0) loaded.push_ns = v;
+        else if (strcmp(key, "dpu_ns") == 0) loaded.dpu_ns = v;
+        else if (strcmp(key, "byte_ns") == 0) loaded.byte_ns = v;
+        else if (strcmp(key, "launch_ns") == 0) loaded.launch_ns = v;
+        else if (strcmp(key, "rank_parallelism") == 0) loaded.rank_parallelism = (uint32_t)v;
+        else if (strcmp(key, "inject") == 0) loaded.inject = v != 0;
+        else {
+            fprintf(stderr, "ERROR: %s:%d: unknown key %s\n", path, ln, key);
+            ret = -1;
+            break;
+        }
+    }
+    fclose(f);
+    if (ret == 0) *m = loaded;
+    return ret;
+}
+
+int cost_model_save(const cost_model_t* m, const char* path) {
+    FILE* f = fopen(path, "w");
+
+    if (!f) {
+        fprintf(stderr, "ERROR: cannot write cost model %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fprintf(f, "# UPMEM Swap cost model (cost_model.h)\n");
+    fprintf(f, "push_ns %.1f\n", m->push_ns);
+    fprintf(f, "dpu_ns %.1f\n", m->dpu_ns);
+    fprintf(f, "byte_ns %.6f\n", m->byte_ns);
+    fprintf(f, "launch_ns %.1f\n", m->launch_ns);
+    fprintf(f, "rank_parallelism %u\n", m->rank_parallelism);
+    fprintf(f, "inject %d\n", m->inject);
+    return fclose(f) == 0 ? 0 : -1;
+}
@@ -0,0 +1,93 @@
+#ifndef __UPMEM_SWAP_COST_MODEL_H__
+#define __UPMEM_SWAP_COST_MODEL_H__
+
+#include <stdint.h>
+
+/*
+ * Cost model of the HOST<->DPU path, for the host memory store to charge
+ * what the DPUs would have cost (what-if studies at server scale: ranks
+ * the simulator cannot run, batching, placement, schedulers).
+ *
+ * A transfer (one dpu_push_xfer or dpu_broadcast_to over a set) costs
+ *
+ *   push_ns + waves * (dpu_ns * dpus + byte_ns * bytes)
+ *
+ * with dpus and bytes those of the busiest rank of the set, and waves the
+ * number of rounds of rank_parallelism ranks needed to cover the ranks
+ * taking part. A launch costs launch_ns per wave. The data still moves
+ * through host memory, so results stay exact; only time is modeled.
+ *
+ * cost_model_fit_results() fits push_ns, dpu_ns and byte_ns to the serial
+ * and parallel rows of benchmark_results.csv (benchmark_complete), and
+ * cost_model_fit_launch() takes launch_ns from a test_decompose run, or
+ * from the round trips main.c logs. Those runs stay within one rank:
+ * rank_parallelism has to come from elsewhere (hardware, literature).
+ */
+
+#define COST_MODEL_CHUNK 2048           /* bytes per push in benchmark_complete */
+
+typedef struct {
+    double push_ns;                 /* fixed cost of a transfer */
+    double dpu_ns;                  /* per DPU of the busiest rank */
+    double byte_ns;                 /* per byte of the busiest rank */
+    double launch_ns;               /* synchronous launch of one wave of ranks */
+    uint32_t rank_parallelism;      /* ranks served at once, 0 = all */
+    int inject;                     /* delay the caller by the modeled time */
+} cost_model_t;
+
+/* Ranks and busiest rank of one transfer or launch. DPUs are added rank
+ * after rank, as they sit in a set. */
+typedef struct {
+    uint32_t nr_ranks;
+    uint32_t max_dpus;
+    uint64_t max_bytes;
+    uint32_t rank;                  /* rank being added */
+    uint32_t dpus;
+    uint64_t bytes;
+} cost_shape_t;
+
+/* Fit quality over the rows used: relative error of the modeled time */
+typedef struct {
+    uint32_t rows;
+    double median_err;
+    double p90_err;
+    double max_err;
+    double serial_median_err;       /* rows of single-DPU pushes */
+    double parallel_median_err;     /* rows of pushes over the whole set */
+} cost_fit_t;
+
+/* Model fitted on the simulator runs shipped with the repository
+ * (benchmark_results.csv, results_256b_simulator.csv), 8 ranks at once */
+void cost_model_default(cost_model_t* m);
+
+static inline void cost_shape_init(cost_shape_t* s) {
+    s->nr_ranks = 0;
+    s->max_dpus = 0;
+    s->max_bytes = 0;
+    s->rank = UINT32_MAX;
+    s->dpus = 0;
+    s->bytes = 0;
+}
+
+void cost_shape_add(cost_shape_t* s, uint32_t rank, uint64_t bytes);
+
+/* Modeled ns of a transfer / a launch of shape s (0 if nothing took part) */
+uint64_t cost_model_xfer_ns(const cost_model_t* m, const cost_shape_t* s);
+uint64_t cost_model_launch_ns(const cost_model_t* m, const cost_shape_t* s);
+
+/* Wait ns on the calling thread (sleep, then spin for the last stretch) */
+void cost_model_delay(uint64_t ns);
+
+/* Fit the transfer costs to a benchmark_results.csv. 0, or -1 (m unchanged). */
+int cost_model_fit_results(cost_model_t* m, const char* path, cost_fit_t* fit);
+
+/* launch_ns from a test_decompose output (its LAUNCH line), or else from
+ * main.c round trips ("Run i: N ns", push of bytes, launch, push back):
+ * their median minus the two modeled pushes. 0, or -1 (m unchanged). */
+int cost_model_fit_launch(cost_model_t* m, const char* path, uint32_t bytes);
+
+/* Model files: one "key value" per line, # comments */
+int cost_model_load(cost_model_t* m, const char* path);
+int cost_model_save(const cost_model_t* m, const char* path);
+
+#endif /* __UPMEM_SWAP_COST_MODEL_H__ */
@@ -0,0 +1,446 @@
+/**
+ * UPMEM Swap - Far memory objects
+ *
+ * Handle-based objects over the page store, see far_memory.h. Extents
+ * (a small-object page or the pages of one large object) are the unit
+ * of residency; their store page ids are (extent << 16) | page.
+ */
+
+#include "far_memory.h"
+
+#define EXTENT_PAGE_BITS 16
+#define FAR_MAX_OBJECT ((size_t)STORE_PAGE_SIZE << EXTENT_PAGE_BITS)
+#define EXTENT_VICTIM 2     /* far_extent_t.ref while picked by make_room() */
+
+static inline uint32_t class_size(uint8_t cls) {
+    return FAR_MIN_SMALL << cls;
+}
+
+static inline uint32_t class_slots(uint8_t cls) {
+    return STORE_PAGE_SIZE / class_size(cls);
+}
+
+static uint8_t class_of(size_t size) {
+    uint8_t cls = 0;
+    if (size > FAR_MAX_SMALL) return FAR_CLASS_LARGE;
+    while (class_size(cls) < size) cls++;
+    return cls;
+}
+
+static inline uint64_t page_id(uint32_t extent, uint32_t page) {
+    return ((uint64_t)extent << EXTENT_PAGE_BITS) | page;
+}
+
+static inline size_t extent_bytes(const far_extent_t* e) {
+    return (size_t)e->nr_pages * STORE_PAGE_SIZE;
+}
+
+static far_object_t* object_of(const far_heap_t* heap, far_handle_t h) {
+    if (h == 0 || h > heap->nr_objects || !heap->objects[h - 1].live) {
+        return NULL;
+    }
+    return &heap->objects[h - 1];
+}
+
+/* Grow a uint32_t array to hold at least n entries */
+static int grow_u32(uint32_t** array, uint32_t* cap, uint32_t n) {
+    if (n <= *cap) return 0;
+    uint32_t new_cap = *cap ? *cap : 64;
+    while (new_cap < n) new_cap *= 2;
+    uint32_t* a = realloc(*array, new_cap * sizeof(uint32_t));
+    if (!a) return -1;
+    *array = a;
+    *cap = new_cap;
+    return 0;
+}
+
+static int reserve_scratch(far_heap_t* heap, size_t n) {
+    if (n <= heap->scratch_cap) return 0;
+
+    uint64_t* ids = realloc(heap->ids, n * sizeof(uint64_t));
+    if (ids) heap->ids = ids;
+    uint8_t** ptrs = ids ? realloc(heap->ptrs, n * sizeof(uint8_t*)) : NULL;
+    if (!ids || !ptrs) {
+        fprintf(stderr, "ERROR: Failed to allocate far memory batch\n");
+        return -1;
+    }
+    heap->ptrs = ptrs;
+    heap->scratch_cap = n;
+    return 0;
+}
+
+/* ========================================================================
+ * Extents
+ * ======================================================================== */
+
+static int64_t extent_new(far_heap_t* heap, uint8_t cls, uint32_t nr_pages) {
+    uint32_t idx;
+
+    if (heap->nr_free_extents > 0) {
+        idx = heap->free_extents[--heap->nr_free_extents];
+    } else {
+        if (heap->nr_extents == heap->cap_extents) {
+            uint32_t cap = heap->cap_extents ? heap->cap_extents * 2 : 256;
+            far_extent_t* e = realloc(heap->extents, cap * sizeof(far_extent_t));
+            if (!e) return -1;
+            heap->extents = e;
+            heap->cap_extents = cap;
+        }
+        idx = heap->nr_extents++;
+    }
+    far_extent_t* e = &heap->extents[idx];
+    memset(e, 0, sizeof(*e));
+    e->cls = cls;
+    e->nr_pages = nr_pages;
+    if (cls != FAR_CLASS_LARGE) {
+        uint32_t slots = class_slots(cls);
+        e->free_slots = slots == 64 ? ~0ULL : (1ULL << slots) - 1;
+    }
+    return idx;
+}
+
+static void partial_add(far_heap_t* heap, uint32_t idx) {
+    uint8_t cls = heap->extents[idx].cls;
+    if (grow_u32(&heap->partial[cls], &heap->cap_partial[cls], heap->nr_partial[cls] + 1) != 0) {
+        return;     /* the page just won't be reused */
+    }
+    heap->extents[idx].partial_pos = heap->nr_partial[cls];
+    heap->partial[cls][heap->nr_partial[cls]++] = idx;
+}
+
+static void partial_remove(far_heap_t* heap, uint32_t idx) {
+    far_extent_t* e = &heap->extents[idx];
+    uint32_t pos = e->partial_pos;
+    uint32_t last = heap->partial[e->cls][--heap->nr_partial[e->cls]];
+
+    heap->partial[e->cls][pos] = last;
+    heap->extents[last].partial_pos = pos;
+}
+
+static void extent_release(far_heap_t* heap, uint32_t idx) {
+    far_extent_t* e = &heap->extents[idx];
+
+    if (e->stored) {
+        for (uint32_t p = 0; p < e->nr_pages; p++) {
+            swap_store_invalidate(&heap->store, page_id(idx, p));
+        }
+    }
+    if (e->data) {
+        free(e->data);
+        heap->resident_bytes -= extent_bytes(e);
+    }
+    memset(e, 0, sizeof(*e));
+    if (grow_u32(&heap->free_extents, &heap->cap_free_extents, heap->nr_free_extents + 1) == 0) {
+        heap->free_extents[heap->nr_free_extents++] = idx;
+    }
+}
+
+/* Write back or drop unpinned extents until the cache fits its budget */
+static int make_room(far_heap_t* heap) {
+    uint64_t resident = heap->resident_bytes;
+    uint32_t nr_victims = 0;
+    size_t nr_pages = 0, n = 0;
+    int ret = 0;
+
+    for (uint32_t scanned = 0; resident > heap->cfg.cache_bytes && scanned < 2 * heap->nr_extents; scanned++) {
+        uint32_t idx = heap->hand;
+        far_extent_t* e = &heap->extents[idx];
+        heap->hand = (heap->hand + 1) % heap->nr_extents;
+
+        if (!e->data || e->pins || e->ref == EXTENT_VICTIM) continue;
+        if (e->ref) {
+            e->ref = 0;
+            continue;
+        }
+        if (grow_u32(&heap->victims, &heap->cap_victims, nr_victims + 1) != 0) break;
+        heap->victims[nr_victims++] = idx;
+        e->ref = EXTENT_VICTIM;
+        resident -= extent_bytes(e);
+        if (e->dirty) nr_pages += e->nr_pages;
+    }
+    if (nr_victims == 0) return 0;
+    if (reserve_scratch(heap, nr_pages) != 0) return -1;
+
+    /* Dirty victims go back to the store in one batch */
+    for (uint32_t v = 0; v < nr_victims; v++) {
+        far_extent_t* e = &heap->extents[heap->victims[v]];
+        if (!e->dirty) continue;
+        for (uint32_t p = 0; p < e->nr_pages; p++) {
+            heap->ids[n] = page_id(heap->victims[v], p);
+            heap->ptrs[n] = e->data + (size_t)p * STORE_PAGE_SIZE;
+            n++;
+        }
+    }
+    if (n > 0 && swap_store_put_batch(&heap->store, heap->ids,
+                                      (const uint8_t* const*)heap->ptrs, n) != 0) {
+        fprintf(stderr, "ERROR: far memory write-back failed\n");
+        ret = -1;
+    }
+
+    for (uint32_t v = 0; v < nr_victims; v++) {
+        far_extent_t* e = &heap->extents[heap->victims[v]];
+        e->ref = 0;
+        if (e->dirty) {
+            if (ret != 0) continue;     /* keep the only copy */
+            e->dirty = 0;
+            e->stored = 1;
+            heap->stats.written_pages += e->nr_pages;
+        } else {
+            heap->stats.dropped_pages += e->nr_pages;
+        }
+        free(e->data);
+        e->data = NULL;
+        heap->resident_bytes -= extent_bytes(e);
+    }
+    return ret;
+}
+
+/* ========================================================================
+ * API
+ * ======================================================================== */
+
+void far_default_config(far_config_t* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->nr_dpus = 8;
+    cfg->max_bytes = 256ULL << 20;
+    cfg->cache_bytes = 16ULL << 20;
+    cfg->compress = 0;
+}
+
+int far_init(far_heap_t* heap, const far_config_t* cfg) {
+    swap_store_config_t store_cfg;
+
+    memset(heap, 0, sizeof(*heap));
+    heap->cfg = *cfg;
+
+    swap_store_default_config(&store_cfg);
+    store_cfg.nr_dpus = cfg->nr_dpus;
+    store_cfg.max_pages = (uint32_t)(cfg->max_bytes / STORE_PAGE_SIZE);
+    store_cfg.compress = cfg->compress;
+    store_cfg.delta = 1;            /* objects change a few lines at a time */
+    if (store_cfg.max_pages == 0 || swap_store_init(&heap->store, &store_cfg) != 0) {
+        fprintf(stderr, "ERROR: Failed to initialize far memory store\n");
+        return -1;
+    }
+    return 0;
+}
+
+void far_destroy(far_heap_t* heap) {
+    for (uint32_t i = 0; i < heap->nr_extents; i++) {
+        free(heap->extents[i].data);
+    }
+    for (int c = 0; c < FAR_NR_CLASSES; c++) {
+        free(heap->partial[c]);
+    }
+    swap_store_free(&heap->store);
+    free(heap->extents);
+    free(heap->free_extents);
+    free(heap->objects);
+    free(heap->free_objects);
+    free(heap->ids);
+    free(heap->ptrs);
+    free(heap->victims);
+    memset(heap, 0, sizeof(*heap));
+}
+
+far_handle_t far_alloc(far_heap_t* heap, size_t size) {
+    uint8_t cls = class_of(size);
+    uint32_t obj_idx, ext_idx, slot = 0;
+
+    if (size == 0 || size > FAR_MAX_OBJECT) {
+        fprintf(stderr, "ERROR: far object of %zu bytes\n", size);
+        return 0;
+    }
+    if (heap->nr_free_objects == 0 && heap->nr_objects == heap->cap_objects) {
+        uint32_t cap = heap->cap_objects ? heap->cap_objects * 2 : 1024;
+        far_object_t* o = realloc(heap->objects, cap * sizeof(far_object_t));
+        if (!o) return 0;
+        heap->objects = o;
+        heap->cap_objects = cap;
+    }
+
+    if (cls == FAR_CLASS_LARGE) {
+        int64_t e = extent_new(heap, cls, (uint32_t)((size + STORE_PAGE_SIZE - 1) / STORE_PAGE_SIZE));
+        if (e < 0) return 0;
+        ext_idx = (uint32_t)e;
+    } else {
+        if (heap->nr_partial[cls] == 0) {
+            int64_t e = extent_new(heap, cls, 1);
+            if (e < 0) return 0;
+            partial_add(heap, (uint32_t)e);
+            if (heap->nr_partial[cls] == 0) {
+                extent_release(heap, (uint32_t)e);
+                return 0;
+            }
+        }
+        ext_idx = heap->partial[cls][heap->nr_partial[cls] - 1];
+        far_extent_t* e = &heap->extents[ext_idx];
+        slot = (uint32_t)__builtin_ctzll(e->free_slots);
+        e->free_slots &= e->free_slots - 1;
+        if (e->free_slots == 0) {
+            partial_remove(heap, ext_idx);
+        }
+    }
+    heap->extents[ext_idx].nr_objects++;
+
+    if (heap->nr_free_objects > 0) {
+        obj_idx = heap->free_objects[--heap->nr_free_objects];
+    } else {
+        obj_idx = heap->nr_objects++;
+    }
+    far_object_t* o = &heap->objects[obj_idx];
+    o->extent = ext_idx;
+    o->size = (uint32_t)size;
+    o->slot = (uint16_t)slot;
+    o->pins = 0;
+    o->live = 1;
+    o->fresh = cls != FAR_CLASS_LARGE;      /* large extents start zeroed */
+
+    heap->stats.objects++;
+    heap->stats.object_bytes += size;
+    return (far_handle_t)obj_idx + 1;
+}
+
+int far_free(far_heap_t* heap, far_handle_t h) {
+    far_object_t* o = object_of(heap, h);
+    if (!o || o->pins) {
+        return -1;
+    }
+    uint32_t ext_idx = o->extent;
+    far_extent_t* e = &heap->extents[ext_idx];
+
+    heap->stats.objects--;
+    heap->stats.object_bytes -= o->size;
+    if (grow_u32(&heap->free_objects, &heap->cap_free_objects, heap->nr_free_objects + 1) == 0) {
+        heap->free_objects[heap->nr_free_objects++] = (uint32_t)(h - 1);
+    }
+    o->live = 0;
+
+    e->nr_objects--;
+    if (e->cls == FAR_CLASS_LARGE || e->nr_objects == 0) {
+        if (e->cls != FAR_CLASS_LARGE && e->free_slots != 0) {
+            partial_remove(heap, ext_idx);
+        }
+        extent_release(heap, ext_idx);
+        return 0;
+    }
+    if (e->free_slots == 0) {
+        partial_add(heap, ext_idx);
+    }
+    e->free_slots |= 1ULL << o->slot;
+    return 0;
+}
+
+int far_pin_batch(far_heap_t* heap, const far_handle_t* handles, size_t n, void** ptrs) {
+    size_t nr_pages = 0, nr_fetch = 0, pinned = 0;
+    uint32_t nr_loaded = 0;
+    uint64_t hits = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        far_object_t* o = object_of(heap, handles[i]);
+        if (!o || o->pins == UINT16_MAX) {
+            fprintf(stderr, "ERROR: cannot pin far handle %llu\n", (unsigned long long)handles[i]);
+            return -1;
+        }
+        nr_pages += heap->extents[o->extent].nr_pages;
+    }
+    if (reserve_scratch(heap, nr_pages) != 0 ||
+        grow_u32(&heap->victims, &heap->cap_victims, (uint32_t)n) != 0) {
+        return -1;
+    }
+
+    /* Buffers for the missing extents (listed in victims), one store batch to fill them */
+    for (; pinned < n; pinned++) {
+        far_object_t* o = object_of(heap, handles[pinned]);
+        far_extent_t* e = &heap->extents[o->extent];
+
+        o->pins++;
+        e->pins++;
+        if (e->data) {
+            hits++;
+            continue;
+        }
+        e->data = aligned_alloc(STORE_PAGE_SIZE, extent_bytes(e));
+        if (!e->data) {
+            fprintf(stderr, "ERROR: Failed to allocate far memory cache\n");
+            pinned++;
+            goto undo;
+        }
+        heap->resident_bytes += extent_bytes(e);
+        heap->victims[nr_loaded++] = o->extent;
+        if (!e->stored) {
+            memset(e->data, 0, extent_bytes(e));
+            continue;
+        }
+        for (uint32_t p = 0; p < e->nr_pages; p++) {
+            heap->ids[nr_fetch] = page_id(o->extent, p);
+            heap->ptrs[nr_fetch] = e->data + (size_t)p * STORE_PAGE_SIZE;
+            nr_fetch++;
+        }
+    }
+    if (nr_fetch > 0 && swap_store_get_batch(&heap->store, heap->ids, heap->ptrs, nr_fetch) != 0) {
+        fprintf(stderr, "ERROR: far memory fetch failed\n");
+        goto undo;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        far_object_t* o = object_of(heap, handles[i]);
+        far_extent_t* e = &heap->extents[o->extent];
+        uint8_t* ptr = e->data;
+
+        if (e->cls != FAR_CLASS_LARGE) {
+            ptr += (size_t)o->slot * class_size(e->cls);
+        }
+        if (o->fresh) {
+            memset(ptr, 0, class_size(e->cls));
+            o->fresh = 0;
+            e->dirty = 1;
+        }
+        e->ref = 1;
+        ptrs[i] = ptr;
+    }
+    heap->stats.pins += n;
+    heap->stats.pin_hits += hits;
+    if (nr_fetch > 0) {
+        heap->stats.pin_batches++;
+        heap->stats.fetched_pages += nr_fetch;
+    }
+    make_room(heap);
+    return 0;
+
+undo:
+    for (size_t i = 0; i < pinned; i++) {
+        far_object_t* o = object_of(heap, handles[i]);
+        o->pins--;
+        heap->extents[o->extent].pins--;
+    }
+    for (uint32_t v = 0; v < nr_loaded; v++) {
+        far_extent_t* e = &heap->extents[heap->victims[v]];
+        free(e->data);
+        e->data = NULL;
+        heap->resident_bytes -= extent_bytes(e);
+    }
+    return -1;
+}
+
+void* far_pin(far_heap_t* heap, far_handle_t h) {
+    void* ptr;
+    return far_pin_batch(heap, &h, 1, &ptr) == 0 ? ptr : NULL;
+}
+
+int far_unpin(far_heap_t* heap, far_handle_t h, int dirty) {
+    far_object_t* o = object_of(heap, h);
+    if (!o || o->pins == 0) {
+        return -1;
+    }
+    far_extent_t* e = &heap->extents[o->extent];
+    o->pins--;
+    e->pins--;
+    if (dirty) e->dirty = 1;
+    return 0;
+}
+
+size_t far_size(const far_heap_t* heap, far_handle_t h) {
+    const far_object_t* o = object_of(heap, h);
+    return o ? o->size : 0;
+}
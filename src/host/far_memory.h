@@ -0,0 +1,127 @@
+#ifndef __UPMEM_SWAP_FAR_MEMORY_H__
+#define __UPMEM_SWAP_FAR_MEMORY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "swap_store.h"
+
+/*
+ * Far memory objects: explicit placement of data on the DPU tier.
+ *
+ * far_alloc() returns a handle, not a pointer. far_pin() makes the object
+ * resident on the HOST and returns where it is; the pointer stays valid
+ * until the matching far_unpin(), which says whether the object was
+ * modified. Unpinned objects may go back to the page store at any time,
+ * the HOST only keeps cache_bytes of them.
+ *
+ * Objects up to FAR_MAX_SMALL bytes are packed into 4KB far pages, one
+ * size class per page; bigger objects get pages of their own. Pages move
+ * as a whole: pinning an object brings in its page, and its neighbours
+ * with it. far_pin_batch() fetches everything that is missing in one
+ * store batch.
+ *
+ * Not thread-safe.
+ */
+
+#define FAR_NR_CLASSES 6
+#define FAR_MIN_SMALL 64
+#define FAR_MAX_SMALL (FAR_MIN_SMALL << (FAR_NR_CLASSES - 1))  /* 2KB */
+#define FAR_CLASS_LARGE FAR_NR_CLASSES
+
+typedef uint64_t far_handle_t;     /* 0 = invalid */
+
+typedef struct {
+    uint64_t pins;
+    uint64_t pin_hits;              /* ... of objects already resident */
+    uint64_t pin_batches;           /* store batches fetching pages */
+    uint64_t fetched_pages;
+    uint64_t written_pages;         /* dirty pages put back to the store */
+    uint64_t dropped_pages;         /* clean pages just freed */
+    uint64_t objects;               /* live objects */
+    uint64_t object_bytes;          /* ... and their requested sizes */
+} far_stats_t;
+
+/* A run of far pages moved as a unit: one small-object page, or a large object */
+typedef struct {
+    uint8_t* data;                  /* resident copy, NULL if not resident */
+    uint32_t nr_pages;
+    uint32_t pins;
+    uint8_t cls;
+    uint8_t dirty;
+    uint8_t stored;                 /* the store has a copy */
+    uint8_t ref;
+    uint64_t free_slots;            /* small pages: bitmap of free slots */
+    uint32_t partial_pos;           /* index in its class's partial list */
+    uint32_t nr_objects;
+} far_extent_t;
+
+typedef struct {
+    uint32_t extent;
+    uint32_t size;
+    uint16_t slot;
+    uint16_t pins;
+    uint8_t live;
+    uint8_t fresh;                  /* zero the slot on first pin */
+} far_object_t;
+
+typedef struct {
+    uint32_t nr_dpus;
+    uint64_t max_bytes;             /* far memory capacity (store pages) */
+    uint64_t cache_bytes;           /* HOST copies of unpinned pages */
+    int compress;
+} far_config_t;
+
+typedef struct {
+    far_config_t cfg;
+    swap_store_t store;
+
+    far_extent_t* extents;
+    uint32_t nr_extents, cap_extents;
+    uint32_t* free_extents;
+    uint32_t nr_free_extents, cap_free_extents;
+
+    far_object_t* objects;
+    uint32_t nr_objects, cap_objects;
+    uint32_t* free_objects;
+    uint32_t nr_free_objects, cap_free_objects;
+
+    uint32_t* partial[FAR_NR_CLASSES];  /* small pages with free slots */
+    uint32_t nr_partial[FAR_NR_CLASSES];
+    uint32_t cap_partial[FAR_NR_CLASSES];
+
+    uint64_t resident_bytes;
+    uint32_t hand;                      /* CLOCK over extents */
+
+    /* Batch scratch */
+    uint64_t* ids;
+    uint8_t** ptrs;
+    size_t scratch_cap;
+    uint32_t* victims;
+    uint32_t cap_victims;
+
+    far_stats_t stats;
+} far_heap_t;
+
+void far_default_config(far_config_t* cfg);
+
+int far_init(far_heap_t* heap, const far_config_t* cfg);
+void far_destroy(far_heap_t* heap);
+
+/* Zero-filled object, 0 on failure */
+far_handle_t far_alloc(far_heap_t* heap, size_t size);
+/* Fails (-1) while the object is pinned */
+int far_free(far_heap_t* heap, far_handle_t h);
+
+/* NULL on failure. Pins nest. Unpinned pages beyond cache_bytes are
+ * written back (dirty) or dropped at the end of the call, so the budget
+ * can be exceeded by what one call pins. */
+void* far_pin(far_heap_t* heap, far_handle_t h);
+/* ptrs[i] receives the address of handles[i]. Returns 0, or -1 with
+ * nothing pinned. */
+int far_pin_batch(far_heap_t* heap, const far_handle_t* handles, size_t n, void** ptrs);
+int far_unpin(far_heap_t* heap, far_handle_t h, int dirty);
+
+size_t far_size(const far_heap_t* heap, far_handle_t h);
+
+#endif /* __UPMEM_SWAP_FAR_MEMORY_H__ */
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "swap_metrics.h"
+
+/*
+ * Export the live metrics of a running store (swap_store_set_metrics) as
+ * Prometheus text or JSON. The segment is mapped read-only: nothing here
+ * slows the process being watched.
+ *
+ *   benchmark_throughput -M /upmem_swap &
+ *   metrics_dump /upmem_swap                    one snapshot on stdout
+ *   metrics_dump -i 5 -o /var/lib/node_exporter/upmem_swap.prom /upmem_swap
+ *
+ * With -o the file is written next to its final name and renamed over it,
+ * so a scraper (node_exporter's textfile collector) never reads half of
+ * it. With -i the export is redone every interval until the process that
+ * created the segment exits.
+ *
+ * Usage: metrics_dump [-j] [-i interval_s] [-o file] [segment_name]
+ */
+
+static int write_snapshot(const swap_metrics_t* mx, int json, const char* out_path) {
+    char tmp_path[4096];
+    FILE* f = stdout;
+    int ret;
+
+    if (out_path) {
+        snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", out_path);
+        f = fopen(tmp_path, "w");
+        if (!f) {
+            fprintf(stderr, "Cannot open %s\n", tmp_path);
+            return -1;
+        }
+    }
+    ret = json ? swap_metrics_write_json(mx, f) : swap_metrics_write_prometheus(mx, f);
+    if (!out_path) {
+        return ret != 0 || fflush(f) != 0 ? -1 : 0;
+    }
+    if (fclose(f) != 0) ret = -1;
+    if (ret == 0 && rename(tmp_path, out_path) != 0) ret = -1;
+    if (ret != 0) {
+        fprintf(stderr, "Write to %s failed\n", out_path);
+        unlink(tmp_path);
+    }
+    return ret;
+}
+
+/* The creator still runs (or at least its pid does) */
+static int creator_alive(const swap_metrics_t* mx) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%llu", (unsigned long long)mx->shm->pid);
+    return access(path, F_OK) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* name = SWAP_METRICS_DEFAULT_NAME;
+    const char* out_path = NULL;
+    double interval_s = 0;
+    int json = 0, opt, ret;
+    swap_metrics_t mx;
+
+    while ((opt = getopt(argc, argv, "ji:o:h")) != -1) {
+        switch (opt) {
+        case 'j': json = 1; break;
+        case 'i': interval_s = atof(optarg); break;
+        case 'o': out_path = optarg; break;
+        default:
+            fprintf(stderr, "Usage: %s [-j] [-i interval_s] [-o file] [segment_name]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc) name = argv[optind];
+    if (interval_s < 0) {
+        fprintf(stderr, "Interval must be positive\n");
+        return 1;
+    }
+    if (swap_metrics_open(&mx, name) != 0) return 1;
+
+    ret = write_snapshot(&mx, json, out_path);
+    while (ret == 0 && interval_s > 0 && creator_alive(&mx)) {
+        struct timespec ts = {(time_t)interval_s,
+                              (long)((interval_s - (time_t)interval_s) * 1e9)};
+        nanosleep(&ts, NULL);
+        ret = write_snapshot(&mx, json, out_path);
+    }
+    swap_metrics_close(&mx);
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+/**
+ * UPMEM Swap - NUMA topology
+ *
+ * sysfs parsing and raw memory policy syscalls, see numa_topo.h. The
+ * syscalls are used directly so that the build does not depend on libnuma.
+ */
+
+#define _GNU_SOURCE
+#include "numa_topo.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* From <linux/mempolicy.h> */
+#define TOPO_MPOL_BIND   2
+#define TOPO_MPOL_F_NODE (1 << 0)
+#define TOPO_MPOL_F_ADDR (1 << 1)
+#define TOPO_MPOL_MF_MOVE (1 << 1)
+
+#define TOPO_MAX_NODES 1024
+#define TOPO_MASK_LONGS (TOPO_MAX_NODES / (8 * sizeof(unsigned long)))
+
+/* Read the first line of a sysfs file */
+static int read_line(const char* path, char* buf, size_t size) {
+    FILE* f = fopen(path, "r");
+
+    if (!f) return -1;
+    if (!fgets(buf, (int)size, f)) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+/* Walk a list like "0-3,8,10-11", calling fn on every id. Returns the
+ * highest id, or -1 for an empty list. */
+static int parse_list(const char* s, void (*fn)(void* ctx, int id), void* ctx) {
+    int highest = -1;
+
+    while (*s) {
+        char* end;
+        long lo = strtol(s, &end, 10), hi = lo;
+
+        if (end == s) break;
+        if (*end == '-') {
+            s = end + 1;
+            hi = strtol(s, &end, 10);
+        }
+        for (long id = lo; id <= hi && id < CPU_SETSIZE; id++) {
+            if (fn) fn(ctx, (int)id);
+        }
+        if (hi > highest) highest = (int)hi;
+        if (*end != ',') break;
+        s = end + 1;
+    }
+    return highest;
+}
+
+int numa_topo_nr_nodes(void) {
+    char buf[256];
+    int highest;
+
+    if (read_line("/sys/devices/system/node/online", buf, sizeof(buf)) != 0) {
+        return 1;
+    }
+    highest = parse_list(buf, NULL, NULL);
+    if (highest < 0) return 1;
+    return highest < TOPO_MAX_NODES ? highest + 1 : TOPO_MAX_NODES;
+}
+
+int numa_topo_current_node(void) {
+    unsigned cpu = 0, node = 0;
+
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) {
+        return 0;
+    }
+    return (int)node;
+}
+
+static void add_cpu(void* ctx, int cpu) {
+    CPU_SET(cpu, (cpu_set_t*)ctx);
+}
+
+int numa_topo_bind_thread(pthread_t thread, int node) {
+    char path[96], buf[4096];
+    cpu_set_t set;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    if (node < 0 || read_line(path, buf, sizeof(buf)) != 0) {
+        return -1;
+    }
+    CPU_ZERO(&set);
+    parse_list(buf, add_cpu, &set);
+    if (CPU_COUNT(&set) == 0) {
+        return -1;              /* memory-only node */
+    }
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+void* numa_topo_alloc(size_t size, int node) {
+    unsigned long mask[TOPO_MASK_LONGS] = {0};
+    void* p;
+
+    if (size == 0) return NULL;
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+    /* Before the first touch, so pages are faulted in on the node */
+    if (node >= 0 && node < TOPO_MAX_NODES) {
+        mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+        syscall(SYS_mbind, p, size, TOPO_MPOL_BIND, mask, TOPO_MAX_NODES + 1, 0);
+    }
+    return p;
+}
+
+void numa_topo_free(void* ptr, size_t size) {
+    if (ptr) munmap(ptr, size);
+}
+
+int numa_topo_move(void* ptr, size_t size, int node) {
+    unsigned long mask[TOPO_MASK_LONGS] = {0};
+
+    if (!ptr || node < 0 || node >= TOPO_MAX_NODES) {
+        return -1;
+    }
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    return syscall(SYS_mbind, ptr, size, TOPO_MPOL_BIND, mask, TOPO_MAX_NODES + 1,
+                   TOPO_MPOL_MF_MOVE) == 0 ? 0 : -1;
+}
+
+int numa_topo_page_node(const void* ptr) {
+    int node = -1;
+
+    (void)*(volatile const uint8_t*)ptr;
+    if (syscall(SYS_get_mempolicy, &node, NULL, 0, ptr,
+                TOPO_MPOL_F_NODE | TOPO_MPOL_F_ADDR) != 0) {
+        return -1;
+    }
+    return node;
+}
+
+int numa_topo_rank_node(uint32_t rank) {
+    static const char* const paths[] = {
+        "/sys/class/dpu_rank/dpu_rank%u/numa_node",
+        "/sys/class/dpu_rank/dpu_rank%u/device/numa_node",
+    };
+    char path[96], buf[32];
+
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        snprintf(path, sizeof(path), paths[i], rank);
+        if (read_line(path, buf, sizeof(buf)) == 0) {
+            return atoi(buf);   /* -1: no affinity */
+        }
+    }
+    return -1;
+}
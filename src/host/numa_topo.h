@@ -0,0 +1,43 @@
+#ifndef __UPMEM_SWAP_NUMA_TOPO_H__
+#define __UPMEM_SWAP_NUMA_TOPO_H__
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * NUMA topology and placement, without libnuma.
+ *
+ * Nodes and their CPUs come from /sys/devices/system/node, memory policy
+ * goes through the raw mbind/get_mempolicy syscalls. Everything degrades
+ * to "one node, no binding" when the kernel or the sandbox says no, so
+ * callers never have to check: placement is a hint, not a requirement.
+ * Works the same on a real multi-socket box and under numa=fake.
+ */
+
+/* Nodes online (highest node id + 1), at least 1 */
+int numa_topo_nr_nodes(void);
+
+/* Node of the CPU the caller runs on, 0 if unknown */
+int numa_topo_current_node(void);
+
+/* Restrict a thread to the CPUs of a node. 0, or -1 (thread unchanged). */
+int numa_topo_bind_thread(pthread_t thread, int node);
+
+/* Page-aligned, zero-filled memory bound to a node (mmap + mbind). Falls
+ * back to unbound memory when mbind fails; NULL only if mmap fails. */
+void* numa_topo_alloc(size_t size, int node);
+void numa_topo_free(void* ptr, size_t size);
+
+/* Move a numa_topo_alloc() buffer to node: pages already there migrate,
+ * later ones fault in on it. 0, or -1 if the kernel refuses. */
+int numa_topo_move(void* ptr, size_t size, int node);
+
+/* Node currently backing the page at ptr (touches it), -1 if unknown */
+int numa_topo_page_node(const void* ptr);
+
+/* Node of DIMM rank `rank` as reported by the UPMEM driver in sysfs,
+ * -1 if the driver does not say */
+int numa_topo_rank_node(uint32_t rank);
+
+#endif /* __UPMEM_SWAP_NUMA_TOPO_H__ */
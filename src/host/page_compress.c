@@ -0,0 +1,259 @@
+/**
+ * UPMEM Swap - Page compression
+ *
+ * Small LZ4 block compressor tuned for 4KB pages. The page is short
+ * enough that a single 4096-entry hash table covers it, so there is no
+ * window management. SSE2 is used to detect zero pages, to extend
+ * matches 16 bytes at a time and for the literal/match copies of the
+ * decoder.
+ */
+
+#include "page_compress.h"
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define MIN_MATCH 4
+#define MFLIMIT 12          /* a match cannot start in the last 12 bytes */
+#define LAST_LITERALS 5     /* the last 5 bytes are always literals */
+#define MAX_OFFSET 65535
+#define HASH_LOG 12
+#define SKIP_TRIGGER 6      /* search step grows every 64 bytes without a match */
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash32(uint32_t v) {
+    return (v * 2654435761U) >> (32 - HASH_LOG);
+}
+
+int page_is_zero(const uint8_t* page, size_t size) {
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i*)(page + i)));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF) {
+        return 0;
+    }
+#endif
+    for (; i < size; i++) {
+        if (page[i]) return 0;
+    }
+    return 1;
+}
+
+/* Number of equal bytes at a and b, stopping at b_end (a is always before b) */
+static size_t match_length(const uint8_t* a, const uint8_t* b, const uint8_t* b_end) {
+    const uint8_t* start = b;
+#ifdef __SSE2__
+    while (b + 16 <= b_end) {
+        __m128i va = _mm_loadu_si128((const __m128i*)a);
+        __m128i vb = _mm_loadu_si128((const __m128i*)b);
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+        if (mask != 0xFFFF) {
+            return (size_t)(b - start) + (size_t)__builtin_ctz(~mask);
+        }
+        a += 16;
+        b += 16;
+    }
+#endif
+    while (b < b_end && *a == *b) {
+        a++;
+        b++;
+    }
+    return (size_t)(b - start);
+}
+
+static uint8_t* write_length(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/* Worst-case bytes needed for a sequence with lit literals and an optional match */
+static size_t sequence_bound(size_t lit, size_t match) {
+    return 1 + lit / 255 + 1 + lit + (match ? 2 + match / 255 + 1 : 0);
+}
+
+size_t page_compress(const uint8_t* src, size_t size,
+                     uint8_t* dst, size_t dst_capacity) {
+    uint32_t table[1 << HASH_LOG];
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* const iend = src + size;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + dst_capacity;
+
+    if (size > MFLIMIT) {
+        const uint8_t* const mflimit = iend - MFLIMIT;
+        const uint8_t* const match_end = iend - LAST_LITERALS;
+
+        memset(table, 0, sizeof(table));
+        while (ip <= mflimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash32(seq);
+            const uint8_t* ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != seq) {
+                ip += 1 + ((size_t)(ip - anchor) >> SKIP_TRIGGER);
+                continue;
+            }
+
+            /* Extend backwards into pending literals */
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            size_t lit = (size_t)(ip - anchor);
+            size_t mlen = MIN_MATCH + match_length(ref + MIN_MATCH, ip + MIN_MATCH, match_end);
+            if (sequence_bound(lit, mlen) > (size_t)(oend - op)) {
+                return 0;
+            }
+
+            uint8_t* token = op++;
+            if (lit >= 15) {
+                *token = 15 << 4;
+                op = write_length(op, lit - 15);
+            } else {
+                *token = (uint8_t)(lit << 4);
+            }
+            memcpy(op, anchor, lit);
+            op += lit;
+
+            uint16_t offset = (uint16_t)(ip - ref);
+            *op++ = (uint8_t)(offset & 0xFF);
+            *op++ = (uint8_t)(offset >> 8);
+
+            size_t ml = mlen - MIN_MATCH;
+            if (ml >= 15) {
+                *token |= 15;
+                op = write_length(op, ml - 15);
+            } else {
+                *token |= (uint8_t)ml;
+            }
+
+            ip += mlen;
+            anchor = ip;
+        }
+    }
+
+    /* Last sequence: literals only */
+    size_t lit = (size_t)(iend - anchor);
+    if (sequence_bound(lit, 0) > (size_t)(oend - op)) {
+        return 0;
+    }
+    if (lit >= 15) {
+        *op++ = 15 << 4;
+        op = write_length(op, lit - 15);
+    } else {
+        *op++ = (uint8_t)(lit << 4);
+    }
+    memcpy(op, anchor, lit);
+    op += lit;
+
+    return (size_t)(op - dst);
+}
+
+static inline void copy16(uint8_t* dst, const uint8_t* src) {
+#ifdef __SSE2__
+    _mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+#else
+    memcpy(dst, src, 16);
+#endif
+}
+
+static void copy_match(uint8_t* op, const uint8_t* ref, size_t len, const uint8_t* oend) {
+    size_t offset = (size_t)(op - ref);
+
+    /* Wide copies may run past len, so they need 16 bytes of room.
+     * With offset >= 16 each 16-byte block only reads finished output. */
+    if (offset >= 16 && (size_t)(oend - op) >= len + 16) {
+        for (size_t i = 0; i < len; i += 16) {
+            copy16(op + i, ref + i);
+        }
+        return;
+    }
+    if (offset >= 8) {
+        while (len >= 8) {
+            memcpy(op, ref, 8);
+            op += 8;
+            ref += 8;
+            len -= 8;
+        }
+    }
+    while (len--) {
+        *op++ = *ref++;
+    }
+}
+
+size_t page_decompress(const uint8_t* src, size_t size,
+                       uint8_t* dst, size_t dst_capacity) {
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + size;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + dst_capacity;
+
+    while (ip < iend) {
+        unsigned token = *ip++;
+        unsigned b;
+
+        size_t lit = token >> 4;
+        if (lit == 15) {
+            do {
+                if (ip >= iend) return 0;
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op)) {
+            return 0;
+        }
+        if (lit <= 16 && iend - ip >= 16 && oend - op >= 16) {
+            copy16(op, ip);     /* short literal run, common case */
+        } else {
+            memcpy(op, ip, lit);
+        }
+        op += lit;
+        ip += lit;
+
+        if (ip == iend) {
+            break;  /* last sequence has no match */
+        }
+
+        if (iend - ip < 2) return 0;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return 0;
+        }
+
+        size_t mlen = token & 15;
+        if (mlen == 15) {
+            do {
+                if (ip >= iend) return 0;
+                b = *ip++;
+                mlen += b;
+            } while (b == 255);
+        }
+        mlen += MIN_MATCH;
+        if (mlen > (size_t)(oend - op)) {
+            return 0;
+        }
+        copy_match(op, op - offset, mlen, oend);
+        op += mlen;
+    }
+
+    return (size_t)(op - dst);
+}
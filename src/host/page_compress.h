@@ -0,0 +1,28 @@
+#ifndef __UPMEM_SWAP_PAGE_COMPRESS_H__
+#define __UPMEM_SWAP_PAGE_COMPRESS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Page compressor for the HOST put path.
+ *
+ * Output is a plain LZ4 block (token / literals / 16-bit offset / match
+ * length), so any LZ4 decoder can read it. The match search and copies
+ * use SSE2 when the compiler targets it, with a scalar fallback.
+ */
+
+/* Returns 1 if the page only contains zero bytes */
+int page_is_zero(const uint8_t* page, size_t size);
+
+/* Compress src into dst. Returns the compressed size, or 0 if the result
+ * would not fit in dst_capacity (caller then stores the page raw). */
+size_t page_compress(const uint8_t* src, size_t size,
+                     uint8_t* dst, size_t dst_capacity);
+
+/* Decompress an LZ4 block. Returns the number of bytes written to dst,
+ * or 0 if the block is corrupted or does not fit in dst_capacity. */
+size_t page_decompress(const uint8_t* src, size_t size,
+                       uint8_t* dst, size_t dst_capacity);
+
+#endif /* __UPMEM_SWAP_PAGE_COMPRESS_H__ */
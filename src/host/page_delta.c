@@ -0,0 +1,86 @@
+/**
+ * UPMEM Swap - Page deltas
+ *
+ * Per-line hashing and change detection for delta puts. The hash is a
+ * 64-bit multiply/rotate mix over the 8 words of a line; a 32-bit hash
+ * would let a changed line go unnoticed once every few billion lines,
+ * which for swap means silent corruption.
+ */
+
+#include "page_delta.h"
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t hash_line(const uint8_t* line) {
+    uint64_t h = PRIME2;
+    for (int i = 0; i < STORE_LINE_SIZE / 8; i++) {
+        uint64_t w;
+        memcpy(&w, line + i * 8, sizeof(w));
+        h = rotl64(h ^ (w * PRIME1), 31) * PRIME2;
+    }
+    h ^= h >> 33;
+    h *= PRIME1;
+    h ^= h >> 29;
+    return h;
+}
+
+void delta_hash_page(const uint8_t* page, uint64_t* hashes) {
+    for (int i = 0; i < STORE_LINES_PER_PAGE; i++) {
+        hashes[i] = hash_line(page + i * STORE_LINE_SIZE);
+    }
+}
+
+uint64_t delta_changed_lines(const uint64_t* old_hashes, const uint64_t* new_hashes) {
+    uint64_t changed = 0;
+    int i = 0;
+#ifdef __SSE2__
+    /* Two lines per compare: a line is unchanged when both 32-bit halves match */
+    for (; i < STORE_LINES_PER_PAGE; i += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(old_hashes + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(new_hashes + i));
+        int eq = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)));
+        if ((eq & 0x3) != 0x3) changed |= 1ULL << i;
+        if ((eq & 0xC) != 0xC) changed |= 1ULL << (i + 1);
+    }
+#endif
+    for (; i < STORE_LINES_PER_PAGE; i++) {
+        if (old_hashes[i] != new_hashes[i]) changed |= 1ULL << i;
+    }
+    return changed;
+}
+
+uint32_t delta_build_patch(const uint8_t* page, uint64_t mask, uint8_t* out) {
+    uint32_t pos = STORE_DELTA_MASK_SIZE;
+
+    memcpy(out, &mask, STORE_DELTA_MASK_SIZE);
+    while (mask) {
+        int line = __builtin_ctzll(mask);
+        memcpy(out + pos, page + line * STORE_LINE_SIZE, STORE_LINE_SIZE);
+        pos += STORE_LINE_SIZE;
+        mask &= mask - 1;
+    }
+    return pos;
+}
+
+void delta_apply_patch(uint8_t* page, const uint8_t* patch) {
+    uint64_t mask;
+    uint32_t pos = STORE_DELTA_MASK_SIZE;
+
+    memcpy(&mask, patch, STORE_DELTA_MASK_SIZE);
+    while (mask) {
+        int line = __builtin_ctzll(mask);
+        memcpy(page + line * STORE_LINE_SIZE, patch + pos, STORE_LINE_SIZE);
+        pos += STORE_LINE_SIZE;
+        mask &= mask - 1;
+    }
+}
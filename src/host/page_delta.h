@@ -0,0 +1,35 @@
+#ifndef __UPMEM_SWAP_PAGE_DELTA_H__
+#define __UPMEM_SWAP_PAGE_DELTA_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "swap_protocol.h"
+
+/*
+ * Sparse page diffs for re-evicted pages.
+ *
+ * The HOST keeps a 64-bit hash of every 64-byte line of the version
+ * stored in MRAM. On the next put of the same page only the lines whose
+ * hash changed are sent, as a patch (format in swap_protocol.h) that
+ * the DPU kernel copies into the page's slot.
+ */
+
+/* Hash every line of a page into hashes[STORE_LINES_PER_PAGE] */
+void delta_hash_page(const uint8_t* page, uint64_t* hashes);
+
+/* Bit i set when line i differs between the two hash arrays (SSE2) */
+uint64_t delta_changed_lines(const uint64_t* old_hashes, const uint64_t* new_hashes);
+
+/* Size of the patch for a mask of changed lines */
+static inline uint32_t delta_patch_size(uint64_t mask) {
+    return STORE_DELTA_MASK_SIZE + (uint32_t)__builtin_popcountll(mask) * STORE_LINE_SIZE;
+}
+
+/* Write the patch for page into out, returns its size */
+uint32_t delta_build_patch(const uint8_t* page, uint64_t mask, uint8_t* out);
+
+/* Apply a patch to a plain page (used in host memory fallback mode) */
+void delta_apply_patch(uint8_t* page, const uint8_t* patch);
+
+#endif /* __UPMEM_SWAP_PAGE_DELTA_H__ */
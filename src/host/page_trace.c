@@ -0,0 +1,163 @@
+/**
+ * UPMEM Swap - Page access traces
+ *
+ * Binary trace encoding and decoding, see page_trace.h.
+ */
+
+#include "page_trace.h"
+
+#include <errno.h>
+#include <string.h>
+
+#define HEADER_SIZE 32
+#define MAX_VARINT 10
+
+static void put_le(uint8_t* p, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint64_t get_le(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+static int put_varint(uint8_t* p, uint64_t v) {
+    int n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/* 1 and the value, or -1 on a truncated or overlong varint */
+static int get_varint(FILE* f, uint64_t* v) {
+    *v = 0;
+    for (int i = 0; i < MAX_VARINT; i++) {
+        int c = getc(f);
+        if (c == EOF) return -1;
+        *v |= (uint64_t)(c & 0x7f) << (7 * i);
+        if (!(c & 0x80)) return 1;
+    }
+    return -1;
+}
+
+int page_trace_create(page_trace_t* t, const char* path, uint32_t page_size,
+                      uint32_t source, uint64_t start_ns) {
+    uint8_t header[HEADER_SIZE] = {0};
+
+    memset(t, 0, sizeof(*t));
+    t->f = fopen(path, "wb");
+    if (!t->f) {
+        fprintf(stderr, "ERROR: Cannot create trace %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    t->writing = 1;
+    t->page_size = page_size;
+    t->source = source;
+    t->start_ns = start_ns;
+
+    memcpy(header, PAGE_TRACE_MAGIC, 8);
+    put_le(header + 8, PAGE_TRACE_VERSION, 4);
+    put_le(header + 12, page_size, 4);
+    put_le(header + 16, source, 4);
+    put_le(header + 24, start_ns, 8);
+    if (fwrite(header, 1, HEADER_SIZE, t->f) != HEADER_SIZE) {
+        fprintf(stderr, "ERROR: Cannot write trace %s\n", path);
+        fclose(t->f);
+        t->f = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int page_trace_append(page_trace_t* t, uint64_t ts_ns, uint64_t page_id, uint8_t op) {
+    uint8_t rec[1 + 2 * MAX_VARINT];
+    int64_t delta = (int64_t)(page_id - t->last_page);
+    int n = 0;
+
+    if (ts_ns < t->last_ts) ts_ns = t->last_ts;
+    rec[n++] = op;
+    n += put_varint(rec + n, ts_ns - t->last_ts);
+    n += put_varint(rec + n, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+    if (fwrite(rec, 1, n, t->f) != (size_t)n) {
+        return -1;
+    }
+    t->last_ts = ts_ns;
+    t->last_page = page_id;
+    t->records++;
+    t->bytes += n;
+    return 0;
+}
+
+int page_trace_open(page_trace_t* t, const char* path) {
+    uint8_t header[HEADER_SIZE];
+
+    memset(t, 0, sizeof(*t));
+    t->f = fopen(path, "rb");
+    if (!t->f) {
+        fprintf(stderr, "ERROR: Cannot open trace %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (fread(header, 1, HEADER_SIZE, t->f) != HEADER_SIZE ||
+        memcmp(header, PAGE_TRACE_MAGIC, 8) != 0) {
+        fprintf(stderr, "ERROR: %s is not a page trace\n", path);
+        fclose(t->f);
+        t->f = NULL;
+        return -1;
+    }
+    if (get_le(header + 8, 4) != PAGE_TRACE_VERSION) {
+        fprintf(stderr, "ERROR: %s: unsupported trace version %u\n", path,
+                (unsigned)get_le(header + 8, 4));
+        fclose(t->f);
+        t->f = NULL;
+        return -1;
+    }
+    t->page_size = (uint32_t)get_le(header + 12, 4);
+    t->source = (uint32_t)get_le(header + 16, 4);
+    t->start_ns = get_le(header + 24, 8);
+    return 0;
+}
+
+int page_trace_next(page_trace_t* t, page_trace_rec_t* rec) {
+    uint64_t dt, zz;
+    int op = getc(t->f);
+
+    if (op == EOF) return 0;
+    if (op > PAGE_TRACE_EVICT || get_varint(t->f, &dt) != 1 || get_varint(t->f, &zz) != 1) {
+        return -1;
+    }
+    t->last_ts += dt;
+    t->last_page += (zz >> 1) ^ (0 - (zz & 1));
+    t->records++;
+    rec->ts_ns = t->last_ts;
+    rec->page_id = t->last_page;
+    rec->op = (uint8_t)op;
+    return 1;
+}
+
+int page_trace_rewind(page_trace_t* t) {
+    if (t->writing || fseek(t->f, HEADER_SIZE, SEEK_SET) != 0) {
+        return -1;
+    }
+    t->last_ts = 0;
+    t->last_page = 0;
+    t->records = 0;
+    return 0;
+}
+
+int page_trace_close(page_trace_t* t) {
+    int ret = 0;
+
+    if (t->f && fclose(t->f) != 0 && t->writing) {
+        ret = -1;
+    }
+    t->f = NULL;
+    return ret;
+}
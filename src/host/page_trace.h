@@ -0,0 +1,69 @@
+#ifndef __UPMEM_SWAP_PAGE_TRACE_H__
+#define __UPMEM_SWAP_PAGE_TRACE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Page access traces: a compact binary log of (time, page, op) records,
+ * written by the capture side (userfaultfd regions, perf mem samples) and
+ * read back by the replayer.
+ *
+ * File layout: a 32-byte header (magic "UPMTRACE", version, page size,
+ * source, start time), then one record per access:
+ *
+ *   op byte | varint time delta (ns) | varint zigzag page id delta
+ *
+ * Deltas are against the previous record, so a fault stream with nearby
+ * pages takes 3-6 bytes per access. All integers are little-endian.
+ */
+
+#define PAGE_TRACE_MAGIC "UPMTRACE"
+#define PAGE_TRACE_VERSION 1
+
+/* Record ops */
+#define PAGE_TRACE_READ  0
+#define PAGE_TRACE_WRITE 1
+#define PAGE_TRACE_EVICT 2      /* the capturing side dropped the page */
+
+/* Where the trace comes from */
+#define PAGE_TRACE_SRC_UFFD 1
+#define PAGE_TRACE_SRC_PERF 2
+
+typedef struct {
+    uint64_t ts_ns;             /* since the start of the capture */
+    uint64_t page_id;
+    uint8_t op;
+} page_trace_rec_t;
+
+typedef struct {
+    FILE* f;
+    int writing;
+    uint32_t page_size;
+    uint32_t source;
+    uint64_t start_ns;          /* CLOCK_REALTIME at the start of the capture */
+    uint64_t last_ts;
+    uint64_t last_page;
+    uint64_t records;
+    uint64_t bytes;             /* record bytes, header excluded */
+} page_trace_t;
+
+/* Create a trace file. start_ns is wall-clock time, for the header only. */
+int page_trace_create(page_trace_t* t, const char* path, uint32_t page_size,
+                      uint32_t source, uint64_t start_ns);
+
+/* Records must come in time order; earlier timestamps are clamped */
+int page_trace_append(page_trace_t* t, uint64_t ts_ns, uint64_t page_id, uint8_t op);
+
+int page_trace_open(page_trace_t* t, const char* path);
+
+/* Next record: 1, 0 at the end of the trace, -1 on a corrupt record */
+int page_trace_next(page_trace_t* t, page_trace_rec_t* rec);
+
+/* Back to the first record of a trace opened for reading */
+int page_trace_rewind(page_trace_t* t);
+
+/* Flushes a trace being written. Returns 0, or -1 if a write failed. */
+int page_trace_close(page_trace_t* t);
+
+#endif /* __UPMEM_SWAP_PAGE_TRACE_H__ */
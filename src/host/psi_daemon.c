@@ -0,0 +1,180 @@
+/**
+ * UPMEM Swap - PSI eviction daemon
+ *
+ * One thread polls the region's userfaultfd, the PSI trigger and a stop
+ * eventfd. Faults are served as they come; every interval_ms (or right
+ * away on a PSI trigger, or while behind its target) the policy decides
+ * how many pages to evict and moves one batch. See psi_daemon.h.
+ */
+
+#include "psi_daemon.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void psi_daemon_default_config(psi_daemon_config_t* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->cgroup = NULL;
+    cfg->psi_threshold = 5.0;
+    cfg->psi_stall_us = 50000;          /* 50ms stalled per 1s window */
+    cfg->high_ratio = 0.90;
+    cfg->low_ratio = 0.80;
+    cfg->max_resident = 0;
+    cfg->batch_pages = 256;
+    cfg->interval_ms = 50;
+}
+
+/* Pages to evict now */
+static uint32_t eviction_target(psi_daemon_t* d, int triggered) {
+    uint64_t need = 0;
+    int pressure = triggered;
+
+    if (d->have_cgroup) {
+        psi_stats_t psi;
+        if (cgroup_read_pressure(&d->cg, &psi) == 0) {
+            if (psi.some.avg10 > d->stats.max_psi) d->stats.max_psi = psi.some.avg10;
+            if (psi.some.avg10 >= d->cfg.psi_threshold) pressure = 1;
+        }
+
+        int64_t limit = cgroup_read_limit(&d->cg);
+        int64_t current = cgroup_read_current(&d->cg);
+        if (limit > 0 && current > d->cfg.high_ratio * limit) {
+            need = (uint64_t)(current - d->cfg.low_ratio * limit) / STORE_PAGE_SIZE;
+        }
+    }
+    if (need == 0 && d->cfg.max_resident > 0) {
+        uint64_t resident = (uint64_t)d->region->nr_resident * STORE_PAGE_SIZE;
+        uint64_t low = (uint64_t)(d->cfg.max_resident * (d->cfg.low_ratio / d->cfg.high_ratio));
+        if (resident > d->cfg.max_resident) {
+            need = (resident - low) / STORE_PAGE_SIZE;
+        }
+    }
+    if (pressure) {
+        d->stats.pressure_ticks++;
+        if (need < d->cfg.batch_pages) need = d->cfg.batch_pages;
+    }
+    return need > d->cfg.batch_pages ? d->cfg.batch_pages : (uint32_t)need;
+}
+
+static void* daemon_main(void* arg) {
+    psi_daemon_t* d = arg;
+    uint64_t interval_ns = (uint64_t)d->cfg.interval_ms * 1000000;
+    uint64_t next_check = now_ns();
+    int behind = 0;
+
+    for (;;) {
+        struct pollfd fds[3];
+        int nfds = 2, triggered = 0;
+
+        fds[0].fd = d->region->uffd;
+        fds[0].events = POLLIN;
+        fds[1].fd = d->stop_fd;
+        fds[1].events = POLLIN;
+        if (d->cg.trigger_fd >= 0) {
+            fds[2].fd = d->cg.trigger_fd;
+            fds[2].events = POLLPRI;
+            nfds = 3;
+        }
+
+        uint64_t now = now_ns();
+        int timeout = behind || now >= next_check ? 0 : (int)((next_check - now) / 1000000) + 1;
+        if (poll(fds, nfds, timeout) < 0) {
+            continue;   /* EINTR */
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            uffd_region_handle_faults(d->region, d->store);
+        }
+        if (nfds == 3 && (fds[2].revents & POLLPRI)) {
+            d->stats.trigger_events++;
+            triggered = 1;
+        }
+
+        now = now_ns();
+        if (!triggered && !behind && now < next_check) {
+            continue;
+        }
+        next_check = now + interval_ns;
+        d->stats.ticks++;
+
+        uint32_t target = eviction_target(d, triggered);
+        uint32_t n = target ? uffd_region_pick_cold(d->region, d->batch, target) : 0;
+        behind = 0;
+        if (n > 0) {
+            uint64_t start = now_ns();
+            if (uffd_region_evict(d->region, d->store, d->batch, n) == 0) {
+                d->stats.evicted_pages += n;
+                d->stats.batches++;
+                /* Keep going until the target is met, faults in between */
+                behind = n == target;
+            }
+            d->stats.evict_ns += now_ns() - start;
+        }
+    }
+    return NULL;
+}
+
+int psi_daemon_start(psi_daemon_t* d, const psi_daemon_config_t* cfg,
+                     uffd_region_t* region, swap_store_t* store) {
+    memset(d, 0, sizeof(*d));
+    d->cfg = *cfg;
+    d->region = region;
+    d->store = store;
+    d->cg.trigger_fd = -1;
+
+    if (cgroup_open(&d->cg, cfg->cgroup) == 0) {
+        psi_stats_t psi;
+        d->have_cgroup = 1;
+        if (cgroup_read_pressure(&d->cg, &psi) != 0) {
+            fprintf(stderr, "WARNING: %s has no memory.pressure (memory controller off?)\n",
+                    d->cg.path);
+        }
+        if (cfg->psi_stall_us && cgroup_arm_trigger(&d->cg, cfg->psi_stall_us, 1000000) != 0) {
+            fprintf(stderr, "WARNING: no PSI trigger on %s, polling every %u ms\n",
+                    d->cg.path, cfg->interval_ms);
+        }
+    } else if (cfg->max_resident == 0) {
+        fprintf(stderr, "WARNING: no cgroup and no max_resident, only PSI can start eviction\n");
+    }
+
+    d->batch = malloc(cfg->batch_pages * sizeof(uint32_t));
+    d->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (!d->batch || d->stop_fd < 0) {
+        fprintf(stderr, "ERROR: Failed to set up PSI daemon\n");
+        psi_daemon_stop(d);
+        return -1;
+    }
+    if (pthread_create(&d->thread, NULL, daemon_main, d) != 0) {
+        fprintf(stderr, "ERROR: Failed to start PSI daemon thread\n");
+        psi_daemon_stop(d);
+        return -1;
+    }
+    d->running = 1;
+    return 0;
+}
+
+void psi_daemon_stop(psi_daemon_t* d) {
+    if (d->running) {
+        uint64_t one = 1;
+        if (write(d->stop_fd, &one, sizeof(one)) != sizeof(one)) {
+            fprintf(stderr, "ERROR: cannot wake PSI daemon\n");
+        }
+        pthread_join(d->thread, NULL);
+        d->running = 0;
+    }
+    if (d->stop_fd > 0) close(d->stop_fd);
+    d->stop_fd = -1;
+    cgroup_close(&d->cg);
+    free(d->batch);
+    d->batch = NULL;
+}
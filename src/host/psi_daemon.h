@@ -0,0 +1,69 @@
+#ifndef __UPMEM_SWAP_PSI_DAEMON_H__
+#define __UPMEM_SWAP_PSI_DAEMON_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "cgroup_psi.h"
+#include "swap_store.h"
+#include "uffd_region.h"
+
+/*
+ * Proactive eviction: a thread that watches the memory pressure of a
+ * cgroup v2 and moves cold pages of a userfaultfd region to the page
+ * store before the kernel starts reclaiming.
+ *
+ * Eviction starts when memory.current goes above high_ratio of the
+ * cgroup limit (memory.high, else memory.max) and goes on until it is
+ * back to low_ratio, or for one batch whenever PSI "some" avg10 reaches
+ * psi_threshold. Without a limit, max_resident caps the region itself.
+ *
+ * The thread also serves the region's faults, so it is the only user of
+ * the store while it runs.
+ */
+
+typedef struct {
+    const char* cgroup;             /* cgroup v2 directory, NULL = own cgroup */
+    double psi_threshold;           /* some avg10 (%) that forces a batch */
+    uint32_t psi_stall_us;          /* PSI trigger per second, 0 = polling only */
+    double high_ratio;
+    double low_ratio;
+    uint64_t max_resident;          /* bytes, used when the cgroup has no limit */
+    uint32_t batch_pages;
+    uint32_t interval_ms;
+} psi_daemon_config_t;
+
+typedef struct {
+    uint64_t ticks;                 /* policy checks */
+    uint64_t pressure_ticks;        /* ... that found PSI over the threshold */
+    uint64_t trigger_events;        /* PSI trigger wakeups */
+    uint64_t evicted_pages;
+    uint64_t batches;
+    uint64_t evict_ns;              /* time spent evicting */
+    double max_psi;                 /* highest some avg10 seen */
+} psi_daemon_stats_t;
+
+typedef struct {
+    psi_daemon_config_t cfg;
+    cgroup_t cg;
+    int have_cgroup;
+
+    uffd_region_t* region;
+    swap_store_t* store;
+
+    pthread_t thread;
+    int stop_fd;                    /* eventfd, wakes the thread to stop */
+    int running;
+    uint32_t* batch;
+
+    psi_daemon_stats_t stats;
+} psi_daemon_t;
+
+void psi_daemon_default_config(psi_daemon_config_t* cfg);
+
+/* The region and the store belong to the daemon until psi_daemon_stop() */
+int psi_daemon_start(psi_daemon_t* d, const psi_daemon_config_t* cfg,
+                     uffd_region_t* region, swap_store_t* store);
+void psi_daemon_stop(psi_daemon_t* d);
+
+#endif /* __UPMEM_SWAP_PSI_DAEMON_H__ */
@@ -0,0 +1,325 @@
+/**
+ * UPMEM Swap - QoS scheduler
+ *
+ * Per-tenant queues in front of the page store: strict priority for
+ * demand faults, weighted fair queuing between tenants, bandwidth caps
+ * and MRAM quotas. See qos_sched.h.
+ */
+
+#include "qos_sched.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* A capped tenant may run this far ahead of its rate */
+#define QOS_BURST_NS 10000000ULL
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Page bytes a request moves: its cost for WFQ and the cap */
+static uint64_t req_bytes(const qos_req_t* req) {
+    return req->op == QOS_OP_INVALIDATE ? 0 : (uint64_t)req->n * STORE_PAGE_SIZE;
+}
+
+/* ========================================================================
+ * Picking the next request (lock held)
+ * ======================================================================== */
+
+/* Refill the token bucket; a tenant in debt waits until it is paid back.
+ * *wake_ns is lowered to that time. */
+static int tenant_eligible(qos_tenant_t* t, uint64_t now, uint64_t* wake_ns) {
+    uint64_t cap = t->cfg.bw_cap;
+
+    if (cap == 0) {
+        return 1;
+    }
+    double burst = (double)cap * QOS_BURST_NS / 1e9;
+    t->tokens += (double)(now - t->refill_ns) * cap / 1e9;
+    if (t->tokens > burst) t->tokens = burst;
+    t->refill_ns = now;
+    if (t->tokens > 0) {
+        return 1;
+    }
+    uint64_t wake = now + (uint64_t)(-t->tokens * 1e9 / cap) + 1;
+    if (*wake_ns == 0 || wake < *wake_ns) *wake_ns = wake;
+    return 0;
+}
+
+static qos_req_t* pick_fifo(qos_sched_t* sched) {
+    qos_req_t* best = NULL;
+
+    for (int t = 0; t < sched->nr_tenants; t++) {
+        for (int c = 0; c < QOS_NR_CLASSES; c++) {
+            qos_req_t* r = sched->tenants[t].head[c];
+            if (r && (!best || r->seq < best->seq)) best = r;
+        }
+    }
+    return best;
+}
+
+/* Highest level with an eligible request, smallest finish tag in it */
+static qos_req_t* pick(qos_sched_t* sched, uint64_t now, uint64_t* wake_ns) {
+    qos_req_t* best = NULL;
+
+    *wake_ns = 0;
+    if (sched->fifo) {
+        return pick_fifo(sched);
+    }
+    for (int level = 0; level < QOS_NR_LEVELS && !best; level++) {
+        for (int t = 0; t < sched->nr_tenants; t++) {
+            qos_tenant_t* tenant = &sched->tenants[t];
+            int eligible = tenant_eligible(tenant, now, wake_ns);
+
+            for (int c = 0; c < QOS_NR_CLASSES; c++) {
+                qos_req_t* r = tenant->head[c];
+                if (!r || QOS_LEVEL(c) != level) continue;
+                if (!eligible) {
+                    if (!r->throttled) {
+                        r->throttled = 1;
+                        tenant->stats.throttled++;
+                    }
+                    continue;
+                }
+                if (!best || r->finish < best->finish ||
+                    (r->finish == best->finish && r->seq < best->seq)) {
+                    best = r;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+static void dequeue(qos_sched_t* sched, qos_req_t* req, uint64_t now) {
+    qos_tenant_t* t = &sched->tenants[req->tenant];
+
+    t->head[req->cls] = req->next;
+    if (!req->next) t->tail[req->cls] = NULL;
+    req->next = NULL;
+    req->start_ns = now;
+    sched->vtime[QOS_LEVEL(req->cls)] = req->finish;
+    if (t->cfg.bw_cap) {
+        t->tokens -= (double)req_bytes(req);
+    }
+}
+
+/* ========================================================================
+ * Serving a request (dispatcher thread, lock released)
+ * ======================================================================== */
+
+static int reserve_ids(qos_sched_t* sched, size_t n) {
+    if (n <= sched->ids_cap) return 0;
+    uint64_t* ids = realloc(sched->ids, n * sizeof(uint64_t));
+    if (!ids) {
+        fprintf(stderr, "ERROR: Failed to allocate %zu store ids\n", n);
+        return -1;
+    }
+    sched->ids = ids;
+    sched->ids_cap = n;
+    return 0;
+}
+
+/* Run req on the store. *mram_delta: change of the MRAM the tenant holds;
+ * *rejected: refused by the quota. */
+static int serve(qos_sched_t* sched, qos_req_t* req, int64_t* mram_delta, int* rejected) {
+    const qos_tenant_t* t = &sched->tenants[req->tenant];
+    swap_store_t* store = sched->store;
+    uint64_t before;
+    int ret = 0;
+
+    *mram_delta = 0;
+    *rejected = 0;
+    if (req->n == 0) {
+        return 0;
+    }
+    if (reserve_ids(sched, req->n) != 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < req->n; i++) {
+        sched->ids[i] = QOS_PAGE_ID(req->tenant, req->page_ids[i]);
+    }
+
+    if (req->op == QOS_OP_GET) {
+        return swap_store_get_batch(store, sched->ids, req->pages, req->n);
+    }
+    if (req->op == QOS_OP_PUT && !sched->fifo && t->cfg.mram_quota) {
+        uint64_t added = 0;
+        for (size_t i = 0; i < req->n; i++) {
+            if (!swap_store_lookup(store, sched->ids[i])) added += STORE_PAGE_SIZE;
+        }
+        if (t->stats.mram_used + added > t->cfg.mram_quota) {
+            *rejected = 1;
+            return -1;
+        }
+    }
+
+    before = swap_store_mram_used(store);
+    if (req->op == QOS_OP_PUT) {
+        ret = swap_store_put_batch(store, sched->ids, (const uint8_t* const*)req->pages, req->n);
+    } else {
+        for (size_t i = 0; i < req->n; i++) {
+            if (swap_store_invalidate(store, sched->ids[i]) != 0) ret = -1;
+        }
+    }
+    *mram_delta = (int64_t)swap_store_mram_used(store) - (int64_t)before;
+    return ret;
+}
+
+static void complete(qos_sched_t* sched, qos_req_t* req, int ret, int64_t mram_delta,
+                     int rejected) {
+    qos_tenant_stats_t* st = &sched->tenants[req->tenant].stats;
+
+    st->requests[req->cls]++;
+    st->wait_ns += req->start_ns - req->submit_ns;
+    if (rejected) {
+        st->quota_rejects++;
+    } else if (ret != 0) {
+        st->errors++;
+    } else {
+        st->pages += req->n;
+        st->bytes += req_bytes(req);
+    }
+    if (mram_delta < 0 && (uint64_t)-mram_delta > st->mram_used) st->mram_used = 0;
+    else st->mram_used += mram_delta;
+
+    req->status = ret;
+    req->done_ns = now_ns();
+    req->done = 1;
+    pthread_cond_broadcast(&sched->done_cv);
+}
+
+static void* dispatcher_main(void* arg) {
+    qos_sched_t* sched = arg;
+
+    pthread_mutex_lock(&sched->lock);
+    while (!sched->stop) {
+        uint64_t now = now_ns(), wake_ns;
+        qos_req_t* req = pick(sched, now, &wake_ns);
+
+        if (!req) {
+            if (wake_ns) {
+                struct timespec ts = {(time_t)(wake_ns / 1000000000ULL),
+                                      (long)(wake_ns % 1000000000ULL)};
+                pthread_cond_timedwait(&sched->work_cv, &sched->lock, &ts);
+            } else {
+                pthread_cond_wait(&sched->work_cv, &sched->lock);
+            }
+            continue;
+        }
+        dequeue(sched, req, now);
+
+        int64_t mram_delta;
+        int rejected;
+        pthread_mutex_unlock(&sched->lock);
+        int ret = serve(sched, req, &mram_delta, &rejected);
+        pthread_mutex_lock(&sched->lock);
+        complete(sched, req, ret, mram_delta, rejected);
+    }
+    pthread_mutex_unlock(&sched->lock);
+    return NULL;
+}
+
+/* ========================================================================
+ * API
+ * ======================================================================== */
+
+int qos_sched_init(qos_sched_t* sched, swap_store_t* store, int fifo) {
+    pthread_condattr_t attr;
+
+    memset(sched, 0, sizeof(*sched));
+    sched->store = store;
+    sched->fifo = fifo;
+    pthread_mutex_init(&sched->lock, NULL);
+    pthread_cond_init(&sched->done_cv, NULL);
+    /* Cap deadlines are on the monotonic clock */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sched->work_cv, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&sched->thread, NULL, dispatcher_main, sched) != 0) {
+        fprintf(stderr, "ERROR: Failed to start QoS dispatcher\n");
+        qos_sched_destroy(sched);
+        return -1;
+    }
+    sched->started = 1;
+    return 0;
+}
+
+void qos_sched_destroy(qos_sched_t* sched) {
+    if (sched->started) {
+        pthread_mutex_lock(&sched->lock);
+        sched->stop = 1;
+        pthread_cond_signal(&sched->work_cv);
+        pthread_mutex_unlock(&sched->lock);
+        pthread_join(sched->thread, NULL);
+    }
+    pthread_cond_destroy(&sched->work_cv);
+    pthread_cond_destroy(&sched->done_cv);
+    pthread_mutex_destroy(&sched->lock);
+    free(sched->ids);
+    memset(sched, 0, sizeof(*sched));
+}
+
+int qos_sched_add_tenant(qos_sched_t* sched, const qos_tenant_config_t* cfg) {
+    int t;
+
+    pthread_mutex_lock(&sched->lock);
+    if (sched->nr_tenants == QOS_MAX_TENANTS) {
+        pthread_mutex_unlock(&sched->lock);
+        fprintf(stderr, "ERROR: too many tenants (max %d)\n", QOS_MAX_TENANTS);
+        return -1;
+    }
+    t = sched->nr_tenants++;
+    memset(&sched->tenants[t], 0, sizeof(qos_tenant_t));
+    sched->tenants[t].cfg = *cfg;
+    if (sched->tenants[t].cfg.weight == 0) sched->tenants[t].cfg.weight = 1;
+    sched->tenants[t].tokens = (double)cfg->bw_cap * QOS_BURST_NS / 1e9;
+    sched->tenants[t].refill_ns = now_ns();
+    pthread_mutex_unlock(&sched->lock);
+    return t;
+}
+
+int qos_sched_submit(qos_sched_t* sched, int tenant, qos_req_t* req) {
+    if (tenant < 0 || tenant >= sched->nr_tenants || req->cls < 0 ||
+        req->cls >= QOS_NR_CLASSES || req->op < QOS_OP_PUT || req->op > QOS_OP_INVALIDATE) {
+        return -1;
+    }
+    pthread_mutex_lock(&sched->lock);
+    qos_tenant_t* t = &sched->tenants[tenant];
+    int level = QOS_LEVEL(req->cls);
+    double start = sched->vtime[level] > t->last_finish[req->cls] ? sched->vtime[level]
+                                                                   : t->last_finish[req->cls];
+
+    req->tenant = tenant;
+    req->status = 0;
+    req->done = 0;
+    req->throttled = 0;
+    req->seq = sched->seq++;
+    req->finish = start + (double)req_bytes(req) / t->cfg.weight;
+    req->submit_ns = now_ns();
+    req->next = NULL;
+    t->last_finish[req->cls] = req->finish;
+    if (t->tail[req->cls]) t->tail[req->cls]->next = req;
+    else t->head[req->cls] = req;
+    t->tail[req->cls] = req;
+    pthread_cond_signal(&sched->work_cv);
+
+    while (!req->done) {
+        pthread_cond_wait(&sched->done_cv, &sched->lock);
+    }
+    pthread_mutex_unlock(&sched->lock);
+    return req->status;
+}
+
+void qos_sched_tenant_stats(qos_sched_t* sched, int tenant, qos_tenant_stats_t* stats) {
+    pthread_mutex_lock(&sched->lock);
+    *stats = sched->tenants[tenant].stats;
+    pthread_mutex_unlock(&sched->lock);
+}
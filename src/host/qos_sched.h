@@ -0,0 +1,132 @@
+#ifndef __UPMEM_SWAP_QOS_SCHED_H__
+#define __UPMEM_SWAP_QOS_SCHED_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "swap_store.h"
+
+/*
+ * Multi-tenant QoS in front of one page store.
+ *
+ * The store is single-threaded and whoever calls it first wins. Here
+ * tenants (containers sharing the machine's ranks) submit requests into
+ * their own queues and one dispatcher thread feeds the store:
+ *
+ *  - demand faults go strictly before prefetch and writeback, whatever
+ *    tenant they come from;
+ *  - within a priority level, tenants share the store by weight (self-
+ *    clocked weighted fair queuing on page bytes), one queue per tenant
+ *    and class;
+ *  - a tenant may have a bandwidth cap (token bucket, bytes/s): its
+ *    requests wait while it is in debt, even if the store is idle;
+ *  - a tenant may have an MRAM quota: a put that could take it over is
+ *    refused. Usage is measured on the store (compressed size), the
+ *    admission check assumes new pages are stored raw.
+ *
+ * Page ids are per tenant: tenant t's page p is QOS_PAGE_ID(t, p) in the
+ * store, so tenants cannot see each other's pages.
+ *
+ * With fifo set the dispatcher serves requests in arrival order with no
+ * priority, weight, cap or quota: the store as it is without arbitration.
+ */
+
+#define QOS_MAX_TENANTS 16
+#define QOS_PAGE_ID(t, p) (((uint64_t)(t) << 48) | ((p) & 0xFFFFFFFFFFFFULL))
+
+/* Request classes */
+#define QOS_DEMAND    0         /* a thread is blocked on the fault */
+#define QOS_PREFETCH  1
+#define QOS_WRITEBACK 2
+#define QOS_NR_CLASSES 3
+
+/* Priority levels: demand alone, then everything else */
+#define QOS_NR_LEVELS 2
+#define QOS_LEVEL(cls) ((cls) == QOS_DEMAND ? 0 : 1)
+
+#define QOS_OP_PUT        0
+#define QOS_OP_GET        1
+#define QOS_OP_INVALIDATE 2
+
+typedef struct {
+    uint32_t weight;            /* share within a level, relative (0 = 1) */
+    uint64_t bw_cap;            /* bytes/s, 0 = none */
+    uint64_t mram_quota;        /* bytes of MRAM, 0 = none */
+} qos_tenant_config_t;
+
+typedef struct {
+    uint64_t requests[QOS_NR_CLASSES];
+    uint64_t pages;
+    uint64_t bytes;             /* page bytes moved (puts and gets) */
+    uint64_t wait_ns;           /* time queued, summed */
+    uint64_t throttled;         /* requests held back by the cap */
+    uint64_t quota_rejects;     /* puts refused by the quota */
+    uint64_t errors;
+    uint64_t mram_used;         /* bytes of MRAM held */
+} qos_tenant_stats_t;
+
+typedef struct qos_req {
+    /* Filled by the caller */
+    int op;
+    int cls;
+    const uint64_t* page_ids;   /* the tenant's own ids */
+    uint8_t* const* pages;      /* PUT: read, GET: written, INVALIDATE: unused */
+    size_t n;
+
+    /* Filled by the scheduler */
+    int tenant;
+    int status;                 /* 0, or -1 (store error, quota) */
+    int done;
+    int throttled;
+    uint64_t seq;               /* arrival order */
+    double finish;              /* WFQ finish tag */
+    uint64_t submit_ns, start_ns, done_ns;
+    struct qos_req* next;
+} qos_req_t;
+
+typedef struct {
+    qos_tenant_config_t cfg;
+    qos_req_t* head[QOS_NR_CLASSES];
+    qos_req_t* tail[QOS_NR_CLASSES];
+    double last_finish[QOS_NR_CLASSES];
+    double tokens;              /* bw_cap: bytes that may go now (< 0: debt) */
+    uint64_t refill_ns;
+    qos_tenant_stats_t stats;
+} qos_tenant_t;
+
+typedef struct {
+    swap_store_t* store;
+    int fifo;
+
+    qos_tenant_t tenants[QOS_MAX_TENANTS];
+    int nr_tenants;
+    double vtime[QOS_NR_LEVELS];
+    uint64_t seq;
+
+    uint64_t* ids;              /* store ids of the request in service */
+    size_t ids_cap;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;     /* dispatcher: a request arrived */
+    pthread_cond_t done_cv;     /* submitters: a request completed */
+    pthread_t thread;
+    int started;
+    int stop;
+} qos_sched_t;
+
+/* The scheduler takes over the store until qos_sched_destroy(): nothing
+ * else may call it meanwhile. 0, or -1. */
+int qos_sched_init(qos_sched_t* sched, swap_store_t* store, int fifo);
+void qos_sched_destroy(qos_sched_t* sched);
+
+/* Register a tenant before submitting anything. Returns its index, or -1. */
+int qos_sched_add_tenant(qos_sched_t* sched, const qos_tenant_config_t* cfg);
+
+/* Queue req for tenant and block until it is served. Returns req->status.
+ * Any number of threads may submit at once. */
+int qos_sched_submit(qos_sched_t* sched, int tenant, qos_req_t* req);
+
+/* Snapshot of a tenant's counters */
+void qos_sched_tenant_stats(qos_sched_t* sched, int tenant, qos_tenant_stats_t* stats);
+
+#endif /* __UPMEM_SWAP_QOS_SCHED_H__ */
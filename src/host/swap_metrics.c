@@ -0,0 +1,486 @@
+/**
+ * UPMEM Swap - Live metrics
+ *
+ * Shared-memory counters, histograms and gauges of the stores, and their
+ * Prometheus and JSON exports. See swap_metrics.h.
+ */
+
+#include "swap_metrics.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "swap_protocol.h"
+
+const char* const swap_metrics_op_names[SWAP_METRICS_NR_OPS] = {
+    "put", "get", "invalidate", "huge_put", "huge_get",
+};
+
+/* Slot of the calling thread in the segment it last used */
+static __thread swap_metrics_shm_t* cached_shm;
+static __thread swap_metrics_thread_t* cached_slot;
+
+static uint64_t realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t load(const uint64_t* v) {
+    return __atomic_load_n(v, __ATOMIC_RELAXED);
+}
+
+/* ========================================================================
+ * Segment
+ * ======================================================================== */
+
+int swap_metrics_create(swap_metrics_t* mx, const char* name) {
+    size_t size = sizeof(swap_metrics_shm_t);
+    int fd;
+
+    memset(mx, 0, sizeof(*mx));
+    snprintf(mx->name, sizeof(mx->name), "%s", name);
+    fd = shm_open(mx->name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: shm_open %s: %s\n", mx->name, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        fprintf(stderr, "ERROR: sizing %s: %s\n", mx->name, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    mx->shm = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mx->shm == MAP_FAILED) {
+        fprintf(stderr, "ERROR: mmap of %s failed: %s\n", mx->name, strerror(errno));
+        mx->shm = NULL;
+        return -1;
+    }
+    mx->owner = 1;
+
+    /* A segment left by an earlier run starts over */
+    __atomic_store_n(&mx->shm->magic, 0, __ATOMIC_RELAXED);
+    memset((uint8_t*)mx->shm + sizeof(uint64_t), 0, size - sizeof(uint64_t));
+    mx->shm->version = SWAP_METRICS_VERSION;
+    mx->shm->size = (uint32_t)size;
+    mx->shm->pid = (uint64_t)getpid();
+    mx->shm->start_ns = realtime_ns();
+    mx->shm->threads[SWAP_METRICS_MAX_THREADS - 1].shared = 1;
+    __atomic_store_n(&mx->shm->magic, SWAP_METRICS_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int swap_metrics_open(swap_metrics_t* mx, const char* name) {
+    struct stat st;
+    int fd;
+
+    memset(mx, 0, sizeof(*mx));
+    snprintf(mx->name, sizeof(mx->name), "%s", name);
+    fd = shm_open(mx->name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: shm_open %s: %s\n", mx->name, strerror(errno));
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(swap_metrics_shm_t)) {
+        fprintf(stderr, "ERROR: %s is not a metrics segment\n", mx->name);
+        close(fd);
+        return -1;
+    }
+    mx->shm = mmap(NULL, sizeof(swap_metrics_shm_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mx->shm == MAP_FAILED) {
+        fprintf(stderr, "ERROR: mmap of %s failed: %s\n", mx->name, strerror(errno));
+        mx->shm = NULL;
+        return -1;
+    }
+    if (__atomic_load_n(&mx->shm->magic, __ATOMIC_ACQUIRE) != SWAP_METRICS_MAGIC ||
+        mx->shm->version != SWAP_METRICS_VERSION ||
+        mx->shm->size != sizeof(swap_metrics_shm_t)) {
+        fprintf(stderr, "ERROR: %s is not a metrics segment of this version\n", mx->name);
+        swap_metrics_close(mx);
+        return -1;
+    }
+    return 0;
+}
+
+void swap_metrics_close(swap_metrics_t* mx) {
+    if (mx->shm) {
+        if (cached_shm == mx->shm) {
+            cached_shm = NULL;
+            cached_slot = NULL;
+        }
+        munmap(mx->shm, sizeof(swap_metrics_shm_t));
+    }
+    if (mx->owner) {
+        shm_unlink(mx->name);
+    }
+    memset(mx, 0, sizeof(*mx));
+}
+
+swap_metrics_store_t* swap_metrics_add_store(swap_metrics_t* mx) {
+    for (uint32_t i = 0; i < SWAP_METRICS_MAX_STORES; i++) {
+        swap_metrics_store_t* slot = &mx->shm->stores[i];
+        uint64_t free_slot = SWAP_METRICS_STORE_FREE;
+        uint32_t n;
+
+        if (!__atomic_compare_exchange_n(&slot->active, &free_slot, SWAP_METRICS_STORE_CLAIMED,
+                                         0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        /* A slot given back by an earlier store starts over */
+        memset((uint8_t*)slot + sizeof(slot->active), 0, sizeof(*slot) - sizeof(slot->active));
+        n = __atomic_load_n(&mx->shm->nr_stores, __ATOMIC_RELAXED);
+        while (n < i + 1 &&
+               !__atomic_compare_exchange_n(&mx->shm->nr_stores, &n, i + 1, 0,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+        return slot;
+    }
+    fprintf(stderr, "WARNING: metrics for %d stores at most\n", SWAP_METRICS_MAX_STORES);
+    return NULL;
+}
+
+void swap_metrics_remove_store(swap_metrics_store_t* slot) {
+    __atomic_store_n(&slot->active, SWAP_METRICS_STORE_FREE, __ATOMIC_RELEASE);
+}
+
+/* ========================================================================
+ * Data path
+ * ======================================================================== */
+
+static swap_metrics_thread_t* thread_slot(swap_metrics_t* mx) {
+    uint32_t i;
+
+    if (cached_shm == mx->shm) {
+        return cached_slot;
+    }
+    i = __atomic_fetch_add(&mx->shm->nr_threads, 1, __ATOMIC_RELAXED);
+    if (i >= SWAP_METRICS_MAX_THREADS - 1) {
+        i = SWAP_METRICS_MAX_THREADS - 1;
+    } else {
+        __atomic_store_n(&mx->shm->threads[i].owner, (uint32_t)syscall(SYS_gettid),
+                         __ATOMIC_RELAXED);
+    }
+    cached_shm = mx->shm;
+    cached_slot = &mx->shm->threads[i];
+    return cached_slot;
+}
+
+/* Single writer: a plain read-modify-write, published atomically */
+static inline void bump(const swap_metrics_thread_t* t, uint64_t* counter, uint64_t v) {
+    if (t->shared) {
+        __atomic_fetch_add(counter, v, __ATOMIC_RELAXED);
+    } else {
+        __atomic_store_n(counter, load(counter) + v, __ATOMIC_RELAXED);
+    }
+}
+
+static int latency_bucket(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int b = us ? 64 - __builtin_clzll(us) : 0;
+    return b < SWAP_METRICS_NR_BUCKETS ? b : SWAP_METRICS_NR_BUCKETS - 1;
+}
+
+void swap_metrics_op(swap_metrics_t* mx, int op, uint64_t pages, uint64_t bytes,
+                     uint64_t ns, int error) {
+    swap_metrics_thread_t* t;
+
+    if (!mx || op < 0 || op >= SWAP_METRICS_NR_OPS) {
+        return;
+    }
+    t = thread_slot(mx);
+    bump(t, &t->calls[op], 1);
+    bump(t, &t->latency_ns[op], ns);
+    bump(t, &t->latency[op][latency_bucket(ns)], 1);
+    if (error) {
+        bump(t, &t->errors[op], 1);
+    } else {
+        bump(t, &t->pages[op], pages);
+        bump(t, &t->bytes[op], bytes);
+    }
+}
+
+void swap_metrics_cache(swap_metrics_t* mx, uint64_t lookups, uint64_t hits) {
+    swap_metrics_thread_t* t;
+
+    if (!mx) {
+        return;
+    }
+    t = thread_slot(mx);
+    bump(t, &t->cache_lookups, lookups);
+    bump(t, &t->cache_hits, hits);
+}
+
+/* ========================================================================
+ * Reader
+ * ======================================================================== */
+
+void swap_metrics_sum(const swap_metrics_t* mx, swap_metrics_totals_t* totals) {
+    uint32_t nr = __atomic_load_n(&mx->shm->nr_threads, __ATOMIC_RELAXED);
+
+    memset(totals, 0, sizeof(*totals));
+    totals->nr_threads = nr < SWAP_METRICS_MAX_THREADS ? nr : SWAP_METRICS_MAX_THREADS;
+    for (int i = 0; i < SWAP_METRICS_MAX_THREADS; i++) {
+        const swap_metrics_thread_t* t = &mx->shm->threads[i];
+
+        for (int op = 0; op < SWAP_METRICS_NR_OPS; op++) {
+            totals->calls[op] += load(&t->calls[op]);
+            totals->pages[op] += load(&t->pages[op]);
+            totals->bytes[op] += load(&t->bytes[op]);
+            totals->errors[op] += load(&t->errors[op]);
+            totals->latency_ns[op] += load(&t->latency_ns[op]);
+            for (int b = 0; b < SWAP_METRICS_NR_BUCKETS; b++) {
+                totals->latency[op][b] += load(&t->latency[op][b]);
+            }
+        }
+        totals->cache_lookups += load(&t->cache_lookups);
+        totals->cache_hits += load(&t->cache_hits);
+    }
+}
+
+/* Gauges and counters of a store slot, exported one by one */
+typedef struct {
+    const char* name;
+    const char* type;
+    const char* help;
+    size_t offset;
+} store_metric_t;
+
+#define STORE_METRIC(field, name, type, help) \
+    {name, type, help, offsetof(swap_metrics_store_t, field)}
+
+static const store_metric_t store_metrics[] = {
+    STORE_METRIC(dpu_backed, "dpu_backed", "gauge",
+                 "1 if the store runs on DPUs, 0 on the host memory fallback"),
+    STORE_METRIC(nr_dpus, "dpus", "gauge", "DPUs of the store"),
+    STORE_METRIC(pages, "pages_stored", "gauge", "Pages in the store"),
+    STORE_METRIC(mram_used, "mram_used_bytes", "gauge", "MRAM allocated to records"),
+    STORE_METRIC(mram_capacity, "mram_capacity_bytes", "gauge", "MRAM the store may use"),
+    STORE_METRIC(page_bytes, "page_bytes_total", "counter", "Uncompressed bytes put"),
+    STORE_METRIC(record_bytes, "record_bytes_total", "counter", "Record bytes stored for them"),
+    STORE_METRIC(zero_pages, "zero_pages_total", "counter", "Puts of all-zero pages (no slot)"),
+    STORE_METRIC(compressed_pages, "compressed_pages_total", "counter",
+                 "Puts stored compressed by the HOST"),
+    STORE_METRIC(dpu_compressed_pages, "dpu_compressed_pages_total", "counter",
+                 "Pages compressed in MRAM by the DPUs"),
+    STORE_METRIC(delta_pages, "delta_pages_total", "counter", "Re-puts sent as a delta"),
+    STORE_METRIC(delta_saved_bytes, "delta_saved_bytes_total", "counter",
+                 "Page bytes not sent thanks to deltas"),
+    STORE_METRIC(bus_bytes_to_dpu, "bus_bytes_to_dpu_total", "counter", "Bytes pushed to MRAM"),
+    STORE_METRIC(bus_bytes_from_dpu, "bus_bytes_from_dpu_total", "counter",
+                 "Bytes read back from MRAM"),
+    STORE_METRIC(pushes, "pushes_total", "counter", "HOST<->MRAM transfer calls"),
+    STORE_METRIC(kernel_launches, "kernel_launches_total", "counter", "DPU kernel launches"),
+    STORE_METRIC(spilled_pages, "spilled_pages_total", "counter",
+                 "Pages put to host memory while ranks came up"),
+    STORE_METRIC(ranks_failed, "ranks_failed", "gauge", "Ranks that failed to come up"),
+    STORE_METRIC(errors, "store_errors_total", "counter", "Errors counted by the store"),
+};
+
+#define NR_STORE_METRICS (sizeof(store_metrics) / sizeof(store_metrics[0]))
+
+typedef struct {
+    const char* name;
+    const char* help;
+    size_t offset;
+} rank_metric_t;
+
+static const rank_metric_t rank_metrics[] = {
+    {"rank_dpus", "DPUs of the rank", offsetof(swap_metrics_rank_t, nr_dpus)},
+    {"rank_state", "Bring-up state (3 = online)", offsetof(swap_metrics_rank_t, state)},
+    {"rank_queue_depth", "Records queued for the launch or push in progress",
+     offsetof(swap_metrics_rank_t, queue_depth)},
+    {"rank_mram_used_bytes", "MRAM allocated on the rank", offsetof(swap_metrics_rank_t, mram_used)},
+    {"rank_mram_capacity_bytes", "MRAM of the rank",
+     offsetof(swap_metrics_rank_t, mram_capacity)},
+};
+
+#define NR_RANK_METRICS (sizeof(rank_metrics) / sizeof(rank_metrics[0]))
+
+static uint64_t field(const void* base, size_t offset) {
+    return load((const uint64_t*)((const uint8_t*)base + offset));
+}
+
+static double ratio(uint64_t num, uint64_t den) {
+    return den ? (double)num / den : 0.0;
+}
+
+static uint32_t nr_stores(const swap_metrics_t* mx) {
+    uint32_t n = __atomic_load_n(&mx->shm->nr_stores, __ATOMIC_RELAXED);
+    return n < SWAP_METRICS_MAX_STORES ? n : SWAP_METRICS_MAX_STORES;
+}
+
+static uint32_t nr_ranks(const swap_metrics_store_t* s) {
+    uint64_t n = load(&s->nr_ranks);
+    return n < SWAP_METRICS_MAX_RANKS ? (uint32_t)n : SWAP_METRICS_MAX_RANKS;
+}
+
+int swap_metrics_write_prometheus(const swap_metrics_t* mx, FILE* f) {
+    swap_metrics_totals_t tot;
+    uint32_t stores = nr_stores(mx);
+
+    swap_metrics_sum(mx, &tot);
+    fprintf(f, "# HELP upmem_swap_start_time_seconds Creation time of the metrics segment\n");
+    fprintf(f, "# TYPE upmem_swap_start_time_seconds gauge\n");
+    fprintf(f, "upmem_swap_start_time_seconds %.3f\n", mx->shm->start_ns / 1e9);
+    fprintf(f, "# HELP upmem_swap_threads Threads that used the stores\n");
+    fprintf(f, "# TYPE upmem_swap_threads gauge\n");
+    fprintf(f, "upmem_swap_threads %u\n", tot.nr_threads);
+
+    static const struct {
+        const char* name;
+        const char* help;
+        size_t offset;
+    } op_counters[] = {
+        {"ops_total", "Store calls", offsetof(swap_metrics_totals_t, calls)},
+        {"op_pages_total", "Pages moved by successful calls", offsetof(swap_metrics_totals_t, pages)},
+        {"op_bytes_total", "Page bytes moved by successful calls",
+         offsetof(swap_metrics_totals_t, bytes)},
+        {"op_errors_total", "Failed calls", offsetof(swap_metrics_totals_t, errors)},
+    };
+    for (size_t c = 0; c < sizeof(op_counters) / sizeof(op_counters[0]); c++) {
+        const uint64_t* values = (const uint64_t*)((const uint8_t*)&tot + op_counters[c].offset);
+        fprintf(f, "# HELP upmem_swap_%s %s\n", op_counters[c].name, op_counters[c].help);
+        fprintf(f, "# TYPE upmem_swap_%s counter\n", op_counters[c].name);
+        for (int op = 0; op < SWAP_METRICS_NR_OPS; op++) {
+            fprintf(f, "upmem_swap_%s{op=\"%s\"} %llu\n", op_counters[c].name,
+                    swap_metrics_op_names[op], (unsigned long long)values[op]);
+        }
+    }
+
+    fprintf(f, "# HELP upmem_swap_op_latency_seconds Latency of store calls\n");
+    fprintf(f, "# TYPE upmem_swap_op_latency_seconds histogram\n");
+    for (int op = 0; op < SWAP_METRICS_NR_OPS; op++) {
+        uint64_t cumulative = 0;
+        for (int b = 0; b < SWAP_METRICS_NR_BUCKETS - 1; b++) {
+            cumulative += tot.latency[op][b];
+            fprintf(f, "upmem_swap_op_latency_seconds_bucket{op=\"%s\",le=\"%.9g\"} %llu\n",
+                    swap_metrics_op_names[op], swap_metrics_bucket_us(b) / 1e6,
+                    (unsigned long long)cumulative);
+        }
+        cumulative += tot.latency[op][SWAP_METRICS_NR_BUCKETS - 1];
+        fprintf(f, "upmem_swap_op_latency_seconds_bucket{op=\"%s\",le=\"+Inf\"} %llu\n",
+                swap_metrics_op_names[op], (unsigned long long)cumulative);
+        fprintf(f, "upmem_swap_op_latency_seconds_sum{op=\"%s\"} %.9f\n",
+                swap_metrics_op_names[op], tot.latency_ns[op] / 1e9);
+        fprintf(f, "upmem_swap_op_latency_seconds_count{op=\"%s\"} %llu\n",
+                swap_metrics_op_names[op], (unsigned long long)cumulative);
+    }
+
+    fprintf(f, "# HELP upmem_swap_cache_lookups_total Lookups of caches over the store\n");
+    fprintf(f, "# TYPE upmem_swap_cache_lookups_total counter\n");
+    fprintf(f, "upmem_swap_cache_lookups_total %llu\n", (unsigned long long)tot.cache_lookups);
+    fprintf(f, "# HELP upmem_swap_cache_hits_total ... that hit\n");
+    fprintf(f, "# TYPE upmem_swap_cache_hits_total counter\n");
+    fprintf(f, "upmem_swap_cache_hits_total %llu\n", (unsigned long long)tot.cache_hits);
+    fprintf(f, "# HELP upmem_swap_cache_hit_ratio Hits per lookup\n");
+    fprintf(f, "# TYPE upmem_swap_cache_hit_ratio gauge\n");
+    fprintf(f, "upmem_swap_cache_hit_ratio %.4f\n", ratio(tot.cache_hits, tot.cache_lookups));
+
+    for (size_t m = 0; m < NR_STORE_METRICS; m++) {
+        fprintf(f, "# HELP upmem_swap_%s %s\n", store_metrics[m].name, store_metrics[m].help);
+        fprintf(f, "# TYPE upmem_swap_%s %s\n", store_metrics[m].name, store_metrics[m].type);
+        for (uint32_t s = 0; s < stores; s++) {
+            const swap_metrics_store_t* st = &mx->shm->stores[s];
+            if (load(&st->active) != SWAP_METRICS_STORE_LIVE) continue;
+            fprintf(f, "upmem_swap_%s{store=\"%u\"} %llu\n", store_metrics[m].name, s,
+                    (unsigned long long)field(st, store_metrics[m].offset));
+        }
+    }
+    fprintf(f, "# HELP upmem_swap_compression_ratio Page bytes per record byte\n");
+    fprintf(f, "# TYPE upmem_swap_compression_ratio gauge\n");
+    for (uint32_t s = 0; s < stores; s++) {
+        const swap_metrics_store_t* st = &mx->shm->stores[s];
+        if (load(&st->active) != SWAP_METRICS_STORE_LIVE) continue;
+        fprintf(f, "upmem_swap_compression_ratio{store=\"%u\"} %.4f\n", s,
+                ratio(load(&st->page_bytes), load(&st->record_bytes)));
+    }
+    fprintf(f, "# HELP upmem_swap_dedup_ratio Share of puts deduplicated (zero pages, deltas)\n");
+    fprintf(f, "# TYPE upmem_swap_dedup_ratio gauge\n");
+    for (uint32_t s = 0; s < stores; s++) {
+        const swap_metrics_store_t* st = &mx->shm->stores[s];
+        if (load(&st->active) != SWAP_METRICS_STORE_LIVE) continue;
+        fprintf(f, "upmem_swap_dedup_ratio{store=\"%u\"} %.4f\n", s,
+                ratio((load(&st->zero_pages) + load(&st->delta_pages)) * STORE_PAGE_SIZE,
+                      load(&st->page_bytes)));
+    }
+
+    for (size_t m = 0; m < NR_RANK_METRICS; m++) {
+        fprintf(f, "# HELP upmem_swap_%s %s\n", rank_metrics[m].name, rank_metrics[m].help);
+        fprintf(f, "# TYPE upmem_swap_%s gauge\n", rank_metrics[m].name);
+        for (uint32_t s = 0; s < stores; s++) {
+            const swap_metrics_store_t* st = &mx->shm->stores[s];
+            if (load(&st->active) != SWAP_METRICS_STORE_LIVE) continue;
+            for (uint32_t r = 0; r < nr_ranks(st); r++) {
+                fprintf(f, "upmem_swap_%s{store=\"%u\",rank=\"%u\"} %llu\n", rank_metrics[m].name,
+                        s, r, (unsigned long long)field(&st->ranks[r], rank_metrics[m].offset));
+            }
+        }
+    }
+    return ferror(f) ? -1 : 0;
+}
+
+int swap_metrics_write_json(const swap_metrics_t* mx, FILE* f) {
+    swap_metrics_totals_t tot;
+    uint32_t stores = nr_stores(mx);
+    int first = 1;
+
+    swap_metrics_sum(mx, &tot);
+    fprintf(f, "{\n  \"pid\": %llu,\n  \"start_time\": %.3f,\n  \"threads\": %u,\n",
+            (unsigned long long)mx->shm->pid, mx->shm->start_ns / 1e9, tot.nr_threads);
+
+    fprintf(f, "  \"ops\": {");
+    for (int op = 0; op < SWAP_METRICS_NR_OPS; op++) {
+        fprintf(f, "%s\n    \"%s\": {\"calls\": %llu, \"pages\": %llu, \"bytes\": %llu, "
+                "\"errors\": %llu, \"latency_ns_sum\": %llu, \"latency_us_buckets\": [",
+                op ? "," : "", swap_metrics_op_names[op], (unsigned long long)tot.calls[op],
+                (unsigned long long)tot.pages[op], (unsigned long long)tot.bytes[op],
+                (unsigned long long)tot.errors[op], (unsigned long long)tot.latency_ns[op]);
+        for (int b = 0; b < SWAP_METRICS_NR_BUCKETS; b++) {
+            fprintf(f, "%s%llu", b ? ", " : "", (unsigned long long)tot.latency[op][b]);
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n  },\n");
+    fprintf(f, "  \"cache\": {\"lookups\": %llu, \"hits\": %llu, \"hit_ratio\": %.4f},\n",
+            (unsigned long long)tot.cache_lookups, (unsigned long long)tot.cache_hits,
+            ratio(tot.cache_hits, tot.cache_lookups));
+
+    fprintf(f, "  \"stores\": [");
+    for (uint32_t s = 0; s < stores; s++) {
+        const swap_metrics_store_t* st = &mx->shm->stores[s];
+        if (load(&st->active) != SWAP_METRICS_STORE_LIVE) continue;
+
+        fprintf(f, "%s\n    {\"store\": %u", first ? "" : ",", s);
+        first = 0;
+        for (size_t m = 0; m < NR_STORE_METRICS; m++) {
+            fprintf(f, ", \"%s\": %llu", store_metrics[m].name,
+                    (unsigned long long)field(st, store_metrics[m].offset));
+        }
+        fprintf(f, ", \"compression_ratio\": %.4f, \"dedup_ratio\": %.4f",
+                ratio(load(&st->page_bytes), load(&st->record_bytes)),
+                ratio((load(&st->zero_pages) + load(&st->delta_pages)) * STORE_PAGE_SIZE,
+                      load(&st->page_bytes)));
+        fprintf(f, ", \"updated\": %.3f,\n     \"ranks\": [", load(&st->updated_ns) / 1e9);
+        for (uint32_t r = 0; r < nr_ranks(st); r++) {
+            fprintf(f, "%s{", r ? ", " : "");
+            for (size_t m = 0; m < NR_RANK_METRICS; m++) {
+                /* "rank_" prefix dropped inside a rank */
+                fprintf(f, "%s\"%s\": %llu", m ? ", " : "", rank_metrics[m].name + 5,
+                        (unsigned long long)field(&st->ranks[r], rank_metrics[m].offset));
+            }
+            fprintf(f, "}");
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+    return ferror(f) ? -1 : 0;
+}
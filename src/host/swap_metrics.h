@@ -0,0 +1,169 @@
+#ifndef __UPMEM_SWAP_METRICS_H__
+#define __UPMEM_SWAP_METRICS_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Live metrics of the swap tier in a POSIX shared-memory segment
+ * (/dev/shm), for a reader in another process (metrics_dump) to export as
+ * Prometheus text or JSON while the stores keep running.
+ *
+ * Nothing on the data path takes a lock or waits for the reader:
+ *
+ *  - counters and latency histograms live in per-thread slots, one cache
+ *    line aligned block each. A thread claims a slot on its first
+ *    operation and is the only one writing it (relaxed atomic stores, no
+ *    lock prefix). Slots are not given back: threads past the first
+ *    SWAP_METRICS_MAX_THREADS - 1 share the last slot with atomic adds.
+ *  - gauges (pages stored, MRAM occupancy, queue depth per rank, copies of
+ *    the store's own counters) live in per-store slots, written by the
+ *    thread calling that store, at most every SWAP_METRICS_PUBLISH_NS.
+ *
+ * A reader sums the slots. A snapshot is not atomic across counters, but
+ * every counter only moves forward.
+ */
+
+#define SWAP_METRICS_MAGIC 0x5352544D50534D55ULL   /* "UMSPMTRS" */
+#define SWAP_METRICS_VERSION 1
+#define SWAP_METRICS_DEFAULT_NAME "/upmem_swap"
+
+#define SWAP_METRICS_MAX_THREADS 64
+#define SWAP_METRICS_MAX_STORES 16
+#define SWAP_METRICS_MAX_RANKS 64           /* per store; more are folded into the last */
+#define SWAP_METRICS_PUBLISH_NS 1000000ULL  /* gauges refreshed at most every 1ms */
+
+/* Latency buckets: bucket b counts operations under 2^b us, the last one
+ * everything slower */
+#define SWAP_METRICS_NR_BUCKETS 24
+
+/* Operations */
+#define SWAP_METRICS_PUT        0
+#define SWAP_METRICS_GET        1
+#define SWAP_METRICS_INVALIDATE 2
+#define SWAP_METRICS_HUGE_PUT   3
+#define SWAP_METRICS_HUGE_GET   4
+#define SWAP_METRICS_NR_OPS     5
+
+typedef struct {
+    uint32_t owner;                 /* tid, 0 = free */
+    uint32_t shared;                /* overflow slot: atomic adds */
+    uint64_t calls[SWAP_METRICS_NR_OPS];
+    uint64_t pages[SWAP_METRICS_NR_OPS];
+    uint64_t bytes[SWAP_METRICS_NR_OPS];
+    uint64_t errors[SWAP_METRICS_NR_OPS];
+    uint64_t latency_ns[SWAP_METRICS_NR_OPS];       /* summed */
+    uint64_t latency[SWAP_METRICS_NR_OPS][SWAP_METRICS_NR_BUCKETS];
+    uint64_t cache_lookups;         /* caches over the store (bpx) */
+    uint64_t cache_hits;
+} __attribute__((aligned(64))) swap_metrics_thread_t;
+
+typedef struct {
+    uint64_t nr_dpus;
+    uint64_t state;                 /* RANK_* of swap_store.h */
+    uint64_t queue_depth;           /* records queued for the launch or push in progress */
+    uint64_t mram_used;             /* bytes of slots and huge stripes allocated */
+    uint64_t mram_capacity;
+} swap_metrics_rank_t;
+
+/* swap_metrics_store_t.active */
+#define SWAP_METRICS_STORE_FREE    0
+#define SWAP_METRICS_STORE_CLAIMED 1    /* being set up, not exported yet */
+#define SWAP_METRICS_STORE_LIVE    2
+
+typedef struct {
+    uint64_t active;
+    uint64_t dpu_backed;            /* 0: host memory fallback, transfers simulated */
+    uint64_t nr_dpus;
+    uint64_t nr_ranks;
+    uint64_t updated_ns;            /* CLOCK_REALTIME of the last publish */
+    uint64_t pages;                 /* stored */
+    uint64_t mram_used;
+    uint64_t mram_capacity;
+    /* Copies of swap_store_stats_t */
+    uint64_t page_bytes;
+    uint64_t record_bytes;
+    uint64_t zero_pages;
+    uint64_t compressed_pages;
+    uint64_t dpu_compressed_pages;
+    uint64_t delta_pages;
+    uint64_t delta_saved_bytes;
+    uint64_t bus_bytes_to_dpu;
+    uint64_t bus_bytes_from_dpu;
+    uint64_t pushes;
+    uint64_t kernel_launches;
+    uint64_t spilled_pages;         /* put to host memory while ranks came up */
+    uint64_t ranks_failed;
+    uint64_t errors;
+    swap_metrics_rank_t ranks[SWAP_METRICS_MAX_RANKS];
+} swap_metrics_store_t;
+
+/* The segment */
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint64_t pid;
+    uint64_t start_ns;              /* CLOCK_REALTIME at creation */
+    uint32_t nr_stores;
+    uint32_t nr_threads;            /* slots ever claimed */
+    swap_metrics_store_t stores[SWAP_METRICS_MAX_STORES];
+    swap_metrics_thread_t threads[SWAP_METRICS_MAX_THREADS];
+} swap_metrics_shm_t;
+
+typedef struct {
+    swap_metrics_shm_t* shm;
+    char name[64];
+    int owner;                      /* created it: unlinked on close */
+} swap_metrics_t;
+
+/* Create (or take over) segment name, e.g. SWAP_METRICS_DEFAULT_NAME.
+ * 0, or -1. */
+int swap_metrics_create(swap_metrics_t* mx, const char* name);
+
+/* Map an existing segment read-only. 0, or -1. */
+int swap_metrics_open(swap_metrics_t* mx, const char* name);
+
+void swap_metrics_close(swap_metrics_t* mx);
+
+/* Data path. mx may be NULL (metrics off). */
+void swap_metrics_op(swap_metrics_t* mx, int op, uint64_t pages, uint64_t bytes,
+                     uint64_t ns, int error);
+void swap_metrics_cache(swap_metrics_t* mx, uint64_t lookups, uint64_t hits);
+
+/* Gauge slot for one more store (CLAIMED, the store makes it LIVE), NULL
+ * once they are all taken. Slots given back are reused. */
+swap_metrics_store_t* swap_metrics_add_store(swap_metrics_t* mx);
+void swap_metrics_remove_store(swap_metrics_store_t* slot);
+
+static inline void swap_metrics_set(uint64_t* gauge, uint64_t v) {
+    __atomic_store_n(gauge, v, __ATOMIC_RELAXED);
+}
+
+/* Reader: every thread slot summed */
+typedef struct {
+    uint64_t calls[SWAP_METRICS_NR_OPS];
+    uint64_t pages[SWAP_METRICS_NR_OPS];
+    uint64_t bytes[SWAP_METRICS_NR_OPS];
+    uint64_t errors[SWAP_METRICS_NR_OPS];
+    uint64_t latency_ns[SWAP_METRICS_NR_OPS];
+    uint64_t latency[SWAP_METRICS_NR_OPS][SWAP_METRICS_NR_BUCKETS];
+    uint64_t cache_lookups;
+    uint64_t cache_hits;
+    uint32_t nr_threads;
+} swap_metrics_totals_t;
+
+void swap_metrics_sum(const swap_metrics_t* mx, swap_metrics_totals_t* totals);
+
+/* Upper bound of latency bucket b in us (the last one is unbounded) */
+static inline uint64_t swap_metrics_bucket_us(int b) {
+    return 1ULL << b;
+}
+
+extern const char* const swap_metrics_op_names[SWAP_METRICS_NR_OPS];
+
+/* Exports of the whole segment. 0, or -1 on a write error. */
+int swap_metrics_write_prometheus(const swap_metrics_t* mx, FILE* f);
+int swap_metrics_write_json(const swap_metrics_t* mx, FILE* f);
+
+#endif /* __UPMEM_SWAP_METRICS_H__ */
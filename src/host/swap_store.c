@@ -0,0 +1,3044 @@
+/**
+ * UPMEM Swap - Page store
+ *
+ * HOST side of the DPU swap tier: metadata table, MRAM slot allocation
+ * and the put/get transfer paths. See swap_store.h.
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include "swap_store.h"
+#ifdef HAVE_DPU_H
+#include <dpu_management.h>
+#endif
+#include "page_compress.h"
+#include "page_codec.h"
+#include "page_delta.h"
+#include "page_scan.h"
+#include "numa_topo.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* ========================================================================
+ * Metadata table (open addressing, linear probing)
+ * ======================================================================== */
+
+#define ENTRY_EMPTY   0
+#define ENTRY_USED    1
+#define ENTRY_DELETED 2
+
+static inline uint32_t hash_page_id(uint64_t page_id) {
+    return (uint32_t)((page_id * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static page_entry_t* table_find(const swap_store_t* store, uint64_t page_id) {
+    uint32_t i = hash_page_id(page_id) & store->table_mask;
+    for (;;) {
+        page_entry_t* e = &store->table[i];
+        if (e->state == ENTRY_EMPTY) return NULL;
+        if (e->state == ENTRY_USED && e->page_id == page_id) return e;
+        i = (i + 1) & store->table_mask;
+    }
+}
+
+static page_entry_t* table_insert(swap_store_t* store, uint64_t page_id) {
+    uint32_t i = hash_page_id(page_id) & store->table_mask;
+    page_entry_t* slot = NULL;
+    for (;;) {
+        page_entry_t* e = &store->table[i];
+        if (e->state == ENTRY_USED && e->page_id == page_id) return e;
+        if (e->state != ENTRY_USED && !slot) slot = e;
+        if (e->state == ENTRY_EMPTY) break;
+        i = (i + 1) & store->table_mask;
+    }
+    if (store->nr_pages >= store->cfg.max_pages) {
+        return NULL;
+    }
+    if (slot->state == ENTRY_DELETED) {
+        store->nr_deleted--;
+    }
+    slot->state = ENTRY_USED;
+    slot->page_id = page_id;
+    memset(&slot->loc, 0, sizeof(slot->loc));
+    slot->line_hashes = NULL;
+    slot->seen_batch = 0;
+    store->nr_pages++;
+    return slot;
+}
+
+static void table_remove(swap_store_t* store, page_entry_t* e) {
+    free(e->line_hashes);
+    e->line_hashes = NULL;
+    e->state = ENTRY_DELETED;
+    store->nr_pages--;
+    store->nr_deleted++;
+}
+
+/* Drop tombstones once they take a quarter of the table, so probes stay short
+ * and there is always an empty entry to stop on */
+static int table_rebuild(swap_store_t* store) {
+    uint32_t size = store->table_mask + 1;
+    page_entry_t* old = store->table;
+
+    store->table = calloc(size, sizeof(page_entry_t));
+    if (!store->table) {
+        store->table = old;
+        return -1;
+    }
+    store->nr_pages = 0;
+    store->nr_deleted = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        if (old[i].state == ENTRY_USED) {
+            page_entry_t* e = table_insert(store, old[i].page_id);
+            e->loc = old[i].loc;
+            e->line_hashes = old[i].line_hashes;
+        }
+    }
+    free(old);
+    return 0;
+}
+
+/* ========================================================================
+ * MRAM slot allocation
+ * ======================================================================== */
+
+static uint8_t size_class_of(uint32_t length) {
+    return (uint8_t)((STORE_ALIGN_UP(length) + STORE_CLASS_SIZE - 1) / STORE_CLASS_SIZE - 1);
+}
+
+static int space_alloc(dpu_space_t* space, uint8_t cls, uint32_t mram_size, uint32_t* offset) {
+    if (space->nr_free[cls] > 0) {
+        *offset = space->free_slots[cls][--space->nr_free[cls]];
+    } else if (space->top + STORE_CLASS_BYTES(cls) <= mram_size) {
+        *offset = space->top;
+        space->top += STORE_CLASS_BYTES(cls);
+    } else {
+        return -1;
+    }
+    space->used_bytes += STORE_CLASS_BYTES(cls);
+    return 0;
+}
+
+static void free_list_push(dpu_space_t* space, uint8_t cls, uint32_t offset) {
+    if (space->nr_free[cls] == space->cap_free[cls]) {
+        uint32_t cap = space->cap_free[cls] ? space->cap_free[cls] * 2 : 64;
+        uint32_t* slots = realloc(space->free_slots[cls], cap * sizeof(uint32_t));
+        if (!slots) {
+            /* Slot is leaked until the DPU is compacted or reset */
+            return;
+        }
+        space->free_slots[cls] = slots;
+        space->cap_free[cls] = cap;
+    }
+    space->free_slots[cls][space->nr_free[cls]++] = offset;
+}
+
+static void space_release(dpu_space_t* space, uint8_t cls, uint32_t offset) {
+    free_list_push(space, cls, offset);
+    space->used_bytes -= STORE_CLASS_BYTES(cls);
+}
+
+static int place_on(swap_store_t* store, uint32_t d, uint8_t cls, page_loc_t* loc) {
+    if (space_alloc(&store->space[d], cls, store->cfg.mram_size, &loc->offset) != 0) {
+        return -1;
+    }
+    loc->dpu = d;
+    loc->size_class = cls;
+    if (store->cfg.numa) {
+        if (store->dpu_node[d] == store->home_node) store->stats.local_puts++;
+        else store->stats.remote_puts++;
+    }
+    return 0;
+}
+
+/* Online, and not the spill DPU of a lazy store */
+static int dpu_placeable(const swap_store_t* store, uint32_t d) {
+    return (!store->dpu_online || store->dpu_online[d]) && d != store->spill_dpu;
+}
+
+/* Round-robin placement over the DPUs that still have room. With numa,
+ * the DPUs on the home node are tried first. */
+static int place_online(swap_store_t* store, uint8_t cls, page_loc_t* loc) {
+    for (uint32_t n = 0; n < store->nr_local_dpus; n++) {
+        uint32_t l = (store->next_local + n) % store->nr_local_dpus;
+        if (!dpu_placeable(store, store->local_dpus[l])) continue;
+        if (place_on(store, store->local_dpus[l], cls, loc) == 0) {
+            store->next_local = (l + 1) % store->nr_local_dpus;
+            return 0;
+        }
+    }
+    for (uint32_t n = 0; n < store->nr_dpus; n++) {
+        uint32_t d = (store->next_dpu + n) % store->nr_dpus;
+        if (!dpu_placeable(store, d)) continue;
+        if (place_on(store, d, cls, loc) == 0) {
+            store->next_dpu = (d + 1) % store->nr_dpus;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int place_record(swap_store_t* store, uint8_t cls, page_loc_t* loc) {
+    if (place_online(store, cls, loc) == 0) {
+        return 0;
+    }
+    /* Lazy store: host memory while ranks are still coming up (or if none did) */
+    if (store->spill_dpu != UINT32_MAX &&
+        (store->ranks_absorbed < store->nr_ranks || store->nr_online_dpus == 0) &&
+        place_on(store, store->spill_dpu, cls, loc) == 0) {
+        store->nr_spilled++;
+        store->stats.spilled_pages++;
+        return 0;
+    }
+    fprintf(stderr, "ERROR: page store full (class %u)\n", cls);
+    return -1;
+}
+
+/* Huge pages: stripes at the same offset on the DPUs of one rank, one
+ * allocator per rank */
+
+/* Rank g of the huge allocators, NULL while it is not online */
+static const store_rank_t* huge_rank(const swap_store_t* store, uint32_t g) {
+    if (!store->ranks) return &store->huge_ranks[g];
+    return store->ranks[g].state == RANK_ONLINE ? &store->ranks[g] : NULL;
+}
+
+/* Stripe over the largest power of two of the rank's DPUs */
+static int huge_setup(swap_store_t* store, huge_space_t* space, const store_rank_t* rank) {
+    uint32_t nr = 1;
+
+    while (2 * nr <= rank->nr_dpus && STORE_HUGE_PAGE_SIZE / (2 * nr) >= STORE_XFER_ALIGN) {
+        nr *= 2;
+    }
+    space->stripe = STORE_HUGE_PAGE_SIZE / nr;
+    space->free_slots = malloc((store->cfg.huge_mram_size / space->stripe + 1) *
+                               sizeof(uint32_t));
+    if (!space->free_slots) {
+        return -1;
+    }
+    space->nr_dpus = nr;
+    return 0;
+}
+
+/* Round-robin over the ranks online that still have a free stripe */
+static int huge_place(swap_store_t* store, page_loc_t* loc) {
+    for (uint32_t n = 0; n < store->nr_huge; n++) {
+        uint32_t g = (store->next_huge + n) % store->nr_huge;
+        const store_rank_t* rank = huge_rank(store, g);
+        huge_space_t* space = &store->huge[g];
+
+        if (!rank || rank->nr_dpus == 0) continue;
+        if (space->nr_dpus == 0 && huge_setup(store, space, rank) != 0) {
+            return -1;
+        }
+        if (space->nr_free > 0) {
+            loc->offset = space->free_slots[--space->nr_free];
+        } else if (space->top + space->stripe <= store->cfg.huge_mram_size) {
+            loc->offset = space->top;
+            space->top += space->stripe;
+        } else {
+            continue;
+        }
+        space->nr_pages++;
+        loc->dpu = g;
+        loc->flags = PAGE_HUGE;
+        store->next_huge = (g + 1) % store->nr_huge;
+        return 0;
+    }
+    fprintf(stderr, "ERROR: no rank has room for a huge page\n");
+    return -1;
+}
+
+static void release_record(swap_store_t* store, const page_loc_t* loc) {
+    if (loc->flags & PAGE_HUGE) {
+        huge_space_t* space = &store->huge[loc->dpu];
+        space->free_slots[space->nr_free++] = loc->offset;
+        space->nr_pages--;
+    } else if (!(loc->flags & PAGE_ZERO)) {
+        space_release(&store->space[loc->dpu], loc->size_class, loc->offset);
+        if (loc->dpu == store->spill_dpu) store->nr_spilled--;
+    }
+}
+
+/* ========================================================================
+ * HOST <-> MRAM transfers
+ * ======================================================================== */
+
+/* Host memory standing in for a kernel symbol (fallback mode) */
+static uint8_t* ram_symbol(swap_store_t* store, uint32_t d, const char* symbol) {
+    if (strcmp(symbol, STORE_MRAM_SYMBOL) == 0) return store->ram_mram[d];
+    if (strcmp(symbol, STORE_STAGING_SYMBOL) == 0) return store->ram_staging[d];
+    if (strcmp(symbol, STORE_DELTA_SYMBOL) == 0) return store->ram_delta[d];
+    if (strcmp(symbol, STORE_LANDING_SYMBOL) == 0 && store->ram_landing) return store->ram_landing[d];
+    if (strcmp(symbol, STORE_SHARED_SYMBOL) == 0) return store->ram_shared[d];
+    if (strcmp(symbol, STORE_HUGE_SYMBOL) == 0 && store->ram_huge) return store->ram_huge[d];
+    return NULL;
+}
+
+/* DPU d lives in host memory: fallback mode, or the spill DPU */
+static int dpu_emulated(const swap_store_t* store, uint32_t d) {
+    return !store->dpu_backed || d == store->spill_dpu;
+}
+
+/* Emulated DPU d stands for a DPU of the cost model (the spill DPU is host
+ * memory for real, and free) */
+static int dpu_modeled(const swap_store_t* store, uint32_t d) {
+    return store->modeled && d != store->spill_dpu;
+}
+
+static uint32_t model_rank(const swap_store_t* store, uint32_t d) {
+    uint32_t per_rank = store->cfg.dpus_per_rank ? store->cfg.dpus_per_rank
+                                                 : STORE_DPUS_PER_RANK;
+    return d / per_rank;
+}
+
+/* Charge a transfer or a launch of shape s */
+static void model_xfer(swap_store_t* store, const cost_shape_t* s) {
+    uint64_t ns = cost_model_xfer_ns(&store->model, s);
+
+    store->stats.model_xfer_ns += ns;
+    if (store->model.inject) cost_model_delay(ns);
+}
+
+static void model_launch(swap_store_t* store, const cost_shape_t* s) {
+    uint64_t ns = cost_model_launch_ns(&store->model, s);
+
+    store->stats.model_launch_ns += ns;
+    if (store->model.inject) cost_model_delay(ns);
+}
+
+/* The same bytes to or from each of DPUs first..first+count-1 */
+static void model_xfer_range(swap_store_t* store, uint32_t first, uint32_t count,
+                             uint64_t bytes) {
+    cost_shape_t s;
+
+    cost_shape_init(&s);
+    for (uint32_t d = first; d < first + count; d++) {
+        if (dpu_modeled(store, d)) cost_shape_add(&s, model_rank(store, d), bytes);
+    }
+    model_xfer(store, &s);
+}
+
+/* Copy length bytes between buf and a symbol of DPU d */
+static int dpu_xfer_symbol(swap_store_t* store, uint32_t d, int to_dpu, const char* symbol,
+                           uint32_t offset, void* buf, uint32_t length) {
+    store->stats.pushes++;
+#ifdef HAVE_DPU_H
+    if (!dpu_emulated(store, d)) {
+        dpu_error_t err = dpu_prepare_xfer(store->dpus[d], buf);
+        if (err == DPU_OK) {
+            err = dpu_push_xfer(store->dpus[d], to_dpu ? DPU_XFER_TO_DPU : DPU_XFER_FROM_DPU,
+                                symbol, offset, length, DPU_XFER_DEFAULT);
+        }
+        if (err != DPU_OK) {
+            fprintf(stderr, "dpu_push_xfer (%s) failed: %s\n",
+                    to_dpu ? "TO_DPU" : "FROM_DPU", dpu_error_to_string(err));
+            store->stats.errors++;
+            return -1;
+        }
+        return 0;
+    }
+#endif
+    uint8_t* base = ram_symbol(store, d, symbol);
+    if (!base) {
+        fprintf(stderr, "ERROR: no host fallback for symbol %s\n", symbol);
+        return -1;
+    }
+    if (to_dpu) {
+        memcpy(base + offset, buf, length);
+    } else {
+        memcpy(buf, base + offset, length);
+    }
+    if (store->modeled) {
+        model_xfer_range(store, d, 1, length);
+    }
+    return 0;
+}
+
+static int mram_write_record(swap_store_t* store, uint32_t d, uint32_t offset,
+                             const uint8_t* src, uint32_t length) {
+    uint8_t padded[STORE_PAGE_SIZE];
+    uint32_t xfer = STORE_ALIGN_UP(length);
+
+    /* The bus only moves multiples of 8 bytes */
+    if (xfer != length) {
+        memcpy(padded, src, length);
+        memset(padded + length, 0, xfer - length);
+        src = padded;
+    }
+    if (dpu_xfer_symbol(store, d, 1, STORE_MRAM_SYMBOL, offset, (void*)src, xfer) != 0) {
+        return -1;
+    }
+    store->stats.bus_bytes_to_dpu += xfer;
+    return 0;
+}
+
+static int mram_read_record(swap_store_t* store, uint32_t d, uint32_t offset,
+                            uint8_t* dst, uint32_t length) {
+    uint8_t padded[STORE_PAGE_SIZE];
+    uint32_t xfer = STORE_ALIGN_UP(length);
+    uint8_t* buf = (xfer != length) ? padded : dst;
+
+    if (dpu_xfer_symbol(store, d, 0, STORE_MRAM_SYMBOL, offset, buf, xfer) != 0) {
+        return -1;
+    }
+    if (buf != dst) {
+        memcpy(dst, buf, length);
+    }
+    store->stats.bus_bytes_from_dpu += xfer;
+    return 0;
+}
+
+#ifdef HAVE_DPU_H
+/* The same length bytes to symbol on all nr_dpus DPUs of set */
+static int replicate_set(swap_store_t* store, struct dpu_set_t set, uint32_t nr_dpus,
+                         const char* symbol, uint32_t offset, const void* buf, uint32_t length) {
+    dpu_error_t err = DPU_OK;
+
+    if (store->cfg.broadcast_xfer) {
+        err = dpu_broadcast_to(set, symbol, offset, buf, length, DPU_XFER_DEFAULT);
+        store->stats.broadcasts++;
+    } else {
+        struct dpu_set_t dpu;
+        DPU_FOREACH(set, dpu) {
+            err = dpu_prepare_xfer(dpu, (void*)buf);
+            if (err != DPU_OK) break;
+        }
+        if (err == DPU_OK) {
+            err = dpu_push_xfer(set, DPU_XFER_TO_DPU, symbol, offset, length, DPU_XFER_DEFAULT);
+        }
+        store->stats.pushes++;
+    }
+    if (err != DPU_OK) {
+        fprintf(stderr, "replicated transfer (%s) failed: %s\n", symbol, dpu_error_to_string(err));
+        store->stats.errors++;
+        return -1;
+    }
+    store->stats.replicated_bytes += (uint64_t)nr_dpus * length;
+    return 0;
+}
+#endif
+
+/* The same length bytes to symbol on every DPU of rank (NULL: the whole
+ * store) */
+static int replicate_group(swap_store_t* store, const store_rank_t* rank, const char* symbol,
+                           uint32_t offset, const void* buf, uint32_t length) {
+    uint32_t first = rank ? rank->first : 0;
+    uint32_t count = rank ? rank->nr_dpus : store->nr_dpus;
+
+#ifdef HAVE_DPU_H
+    if (!dpu_emulated(store, first)) {
+        return replicate_set(store, rank ? rank->set : store->dpu_set, count, symbol, offset,
+                             buf, length);
+    }
+#endif
+    for (uint32_t d = first; d < first + count; d++) {
+        uint8_t* base = ram_symbol(store, d, symbol);
+        if (!base) {
+            fprintf(stderr, "ERROR: no host fallback for symbol %s\n", symbol);
+            return -1;
+        }
+        memcpy(base + offset, buf, length);
+    }
+    if (store->modeled) {
+        model_xfer_range(store, first, count, length);
+    }
+    if (store->cfg.broadcast_xfer) store->stats.broadcasts++;
+    else store->stats.pushes++;
+    store->stats.replicated_bytes += (uint64_t)count * length;
+    return 0;
+}
+
+/* Move huge page buf between the HOST and its stripes, with one push over
+ * the rank */
+static int huge_xfer(swap_store_t* store, const page_loc_t* loc, uint8_t* buf, int to_dpu) {
+    const store_rank_t* rank = huge_rank(store, loc->dpu);
+    const huge_space_t* space = &store->huge[loc->dpu];
+
+    store->stats.pushes++;
+    if (to_dpu) store->stats.bus_bytes_to_dpu += STORE_HUGE_PAGE_SIZE;
+    else store->stats.bus_bytes_from_dpu += STORE_HUGE_PAGE_SIZE;
+
+#ifdef HAVE_DPU_H
+    if (!dpu_emulated(store, rank->first)) {
+        struct dpu_set_t set = rank->set;
+        struct dpu_set_t dpu;
+        dpu_error_t err = DPU_OK;
+        uint32_t i;
+
+        /* DPUs past the stripes are left out of the transfer */
+        DPU_FOREACH(set, dpu, i) {
+            if (err != DPU_OK || i >= space->nr_dpus) continue;
+            err = dpu_prepare_xfer(dpu, buf + (size_t)i * space->stripe);
+        }
+        if (err == DPU_OK) {
+            err = dpu_push_xfer(set, to_dpu ? DPU_XFER_TO_DPU : DPU_XFER_FROM_DPU,
+                                STORE_HUGE_SYMBOL, loc->offset, space->stripe,
+                                DPU_XFER_DEFAULT);
+        }
+        if (err != DPU_OK) {
+            fprintf(stderr, "dpu_push_xfer (huge page) failed: %s\n", dpu_error_to_string(err));
+            store->stats.errors++;
+            return -1;
+        }
+        return 0;
+    }
+#endif
+    for (uint32_t i = 0; i < space->nr_dpus; i++) {
+        uint8_t* stripe = store->ram_huge[rank->first + i] + loc->offset;
+        if (to_dpu) memcpy(stripe, buf + (size_t)i * space->stripe, space->stripe);
+        else memcpy(buf + (size_t)i * space->stripe, stripe, space->stripe);
+    }
+    if (store->modeled) {
+        model_xfer_range(store, rank->first, space->nr_dpus, space->stripe);
+    }
+    return 0;
+}
+
+/* ========================================================================
+ * Live metrics
+ * ======================================================================== */
+
+/* Jobs of the launch about to start, per rank; zeros once it is over */
+static void publish_queue(swap_store_t* store, int launching) {
+    swap_metrics_store_t* slot = store->metrics_slot;
+    uint64_t depth[SWAP_METRICS_MAX_RANKS] = {0};
+
+    if (!slot) {
+        return;
+    }
+    for (uint32_t d = 0; launching && d < store->nr_dpus; d++) {
+        uint32_t r = store->metrics_rank[d];
+        if (r != UINT32_MAX) depth[r] += store->nr_jobs[d];
+    }
+    for (uint32_t r = 0; r < store->metrics_nr_ranks; r++) {
+        swap_metrics_set(&slot->ranks[r].queue_depth, depth[r]);
+    }
+}
+
+static void publish_gauges(swap_store_t* store) {
+    swap_metrics_store_t* slot = store->metrics_slot;
+    uint64_t used[SWAP_METRICS_MAX_RANKS] = {0}, capacity[SWAP_METRICS_MAX_RANKS] = {0};
+    uint64_t dpus[SWAP_METRICS_MAX_RANKS] = {0};
+    uint64_t total_used = 0, total_capacity = 0;
+    struct timespec ts;
+
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        uint32_t r = store->metrics_rank[d];
+
+        total_used += store->space[d].used_bytes;
+        if (r == UINT32_MAX || (store->dpu_online && !store->dpu_online[d])) continue;
+        used[r] += store->space[d].used_bytes;
+        capacity[r] += (uint64_t)store->cfg.mram_size + store->cfg.huge_mram_size;
+        dpus[r]++;
+    }
+    for (uint32_t g = 0; g < store->nr_huge; g++) {
+        uint32_t r = g < SWAP_METRICS_MAX_RANKS ? g : SWAP_METRICS_MAX_RANKS - 1;
+        used[r] += (uint64_t)store->huge[g].nr_pages * STORE_HUGE_PAGE_SIZE;
+        total_used += (uint64_t)store->huge[g].nr_pages * STORE_HUGE_PAGE_SIZE;
+    }
+    for (uint32_t r = 0; r < store->metrics_nr_ranks; r++) {
+        int state = store->ranks && r < store->nr_ranks
+                    ? __atomic_load_n(&store->ranks[r].state, __ATOMIC_ACQUIRE) : RANK_ONLINE;
+        swap_metrics_set(&slot->ranks[r].nr_dpus, dpus[r]);
+        swap_metrics_set(&slot->ranks[r].state, (uint64_t)state);
+        swap_metrics_set(&slot->ranks[r].mram_used, used[r]);
+        swap_metrics_set(&slot->ranks[r].mram_capacity, capacity[r]);
+        total_capacity += capacity[r];
+    }
+
+    swap_metrics_set(&slot->pages, store->nr_pages);
+    swap_metrics_set(&slot->mram_used, total_used);
+    swap_metrics_set(&slot->mram_capacity, total_capacity);
+    swap_metrics_set(&slot->page_bytes, store->stats.page_bytes);
+    swap_metrics_set(&slot->record_bytes, store->stats.record_bytes);
+    swap_metrics_set(&slot->zero_pages, store->stats.zero_pages);
+    swap_metrics_set(&slot->compressed_pages, store->stats.compressed_pages);
+    swap_metrics_set(&slot->dpu_compressed_pages, store->stats.dpu_compressed_pages);
+    swap_metrics_set(&slot->delta_pages, store->stats.delta_pages);
+    swap_metrics_set(&slot->delta_saved_bytes, store->stats.delta_saved_bytes);
+    swap_metrics_set(&slot->bus_bytes_to_dpu, store->stats.bus_bytes_to_dpu);
+    swap_metrics_set(&slot->bus_bytes_from_dpu, store->stats.bus_bytes_from_dpu);
+    swap_metrics_set(&slot->pushes, store->stats.pushes);
+    swap_metrics_set(&slot->kernel_launches, store->stats.kernel_launches);
+    swap_metrics_set(&slot->spilled_pages, store->stats.spilled_pages);
+    swap_metrics_set(&slot->ranks_failed, store->stats.ranks_failed);
+    swap_metrics_set(&slot->errors, __atomic_load_n(&store->stats.errors, __ATOMIC_RELAXED));
+    clock_gettime(CLOCK_REALTIME, &ts);
+    swap_metrics_set(&slot->updated_ns, (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+/* Count one API call in the caller's slot; refresh the gauges now and then */
+static uint64_t metrics_start(const swap_store_t* store) {
+    return store->metrics ? now_ns() : 0;
+}
+
+static void metrics_end(swap_store_t* store, int op, uint64_t pages, uint64_t bytes,
+                        uint64_t start, int ret) {
+    uint64_t now;
+
+    if (!store->metrics) {
+        return;
+    }
+    now = now_ns();
+    swap_metrics_op(store->metrics, op, pages, bytes, now - start, ret != 0);
+    if (store->metrics_slot && now - store->metrics_ns >= SWAP_METRICS_PUBLISH_NS) {
+        publish_gauges(store);
+        store->metrics_ns = now;
+    }
+}
+
+/* Rank of every DPU, as the store groups them: its lazy ranks, its huge
+ * page ranks, the SDK's ranks, or dpus_per_rank emulated DPUs */
+static uint32_t map_metrics_ranks(swap_store_t* store) {
+    const store_rank_t* groups = store->ranks ? store->ranks : store->huge_ranks;
+    uint32_t nr_groups = store->ranks ? store->nr_ranks : store->nr_huge;
+    uint32_t per_rank = store->cfg.dpus_per_rank ? store->cfg.dpus_per_rank
+                                                 : STORE_DPUS_PER_RANK;
+    uint32_t nr_ranks = 0;
+
+    memset(store->metrics_rank, 0xff, store->nr_dpus * sizeof(uint32_t));
+    if (groups) {
+        for (uint32_t r = 0; r < nr_groups; r++) {
+            uint32_t slots = groups[r].nr_slots ? groups[r].nr_slots : groups[r].nr_dpus;
+            for (uint32_t d = groups[r].first; d < groups[r].first + slots; d++) {
+                store->metrics_rank[d] = r;
+            }
+        }
+        nr_ranks = nr_groups;
+    }
+#ifdef HAVE_DPU_H
+    else if (store->dpu_backed) {
+        struct dpu_set_t rank;
+        uint32_t d = 0;
+
+        DPU_RANK_FOREACH(store->dpu_set, rank) {
+            uint32_t n;
+            DPU_ASSERT(dpu_get_nr_dpus(rank, &n));
+            for (uint32_t i = 0; i < n && d < store->nr_dpus; i++) {
+                store->metrics_rank[d++] = nr_ranks;
+            }
+            nr_ranks++;
+        }
+    }
+#endif
+    else {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            store->metrics_rank[d] = d / per_rank;
+        }
+        nr_ranks = (store->nr_dpus + per_rank - 1) / per_rank;
+    }
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        uint32_t r = store->metrics_rank[d];
+        if (r != UINT32_MAX && r >= SWAP_METRICS_MAX_RANKS) {
+            store->metrics_rank[d] = SWAP_METRICS_MAX_RANKS - 1;
+        }
+    }
+    return nr_ranks < SWAP_METRICS_MAX_RANKS ? nr_ranks : SWAP_METRICS_MAX_RANKS;
+}
+
+int swap_store_set_metrics(swap_store_t* store, swap_metrics_t* mx) {
+    if (store->metrics_slot) {
+        swap_metrics_remove_store(store->metrics_slot);
+    }
+    store->metrics = NULL;
+    store->metrics_slot = NULL;
+    if (!mx) {
+        return 0;
+    }
+    if (!store->metrics_rank) {
+        store->metrics_rank = malloc(store->nr_dpus * sizeof(uint32_t));
+        if (!store->metrics_rank) {
+            fprintf(stderr, "ERROR: Failed to allocate metrics ranks\n");
+            return -1;
+        }
+    }
+    store->metrics_nr_ranks = map_metrics_ranks(store);
+    store->metrics_slot = swap_metrics_add_store(mx);
+    store->metrics = mx;
+    if (store->metrics_slot) {
+        swap_metrics_store_t* slot = store->metrics_slot;
+        swap_metrics_set(&slot->dpu_backed, (uint64_t)store->dpu_backed);
+        swap_metrics_set(&slot->nr_dpus, store->nr_dpus - (store->spill_dpu != UINT32_MAX));
+        swap_metrics_set(&slot->nr_ranks, store->metrics_nr_ranks);
+        publish_gauges(store);
+        store->metrics_ns = now_ns();
+        swap_metrics_set(&slot->active, SWAP_METRICS_STORE_LIVE);
+    }
+    return 0;
+}
+
+/* ========================================================================
+ * Kernel launches
+ * ======================================================================== */
+
+/* Host memory version of one kernel job (fallback mode) */
+static void emulate_job(swap_store_t* store, uint32_t d, const store_args_t* args,
+                        store_job_t* job) {
+    uint8_t record[STORE_PAGE_SIZE];
+
+    job->status = 0;
+    switch (args->command) {
+    case STORE_CMD_COMPRESS:
+        job->length = codec_compress_page(store->ram_mram[d] + job->src, record, args->threshold);
+        if (job->length) {
+            memcpy(store->ram_mram[d] + job->src, record, job->length);
+        }
+        break;
+    case STORE_CMD_DECOMPRESS:
+        if (codec_decompress_page(store->ram_mram[d] + job->src,
+                                  store->ram_staging[d] + job->dst) != 0) {
+            job->status = 1;
+        }
+        break;
+    case STORE_CMD_MOVE:
+        memcpy(store->ram_mram[d] + job->dst, store->ram_mram[d] + job->src, job->length);
+        break;
+    case STORE_CMD_SCATTER:
+        memcpy(store->ram_mram[d] + job->dst, store->ram_landing[d] + job->src, job->length);
+        break;
+    case STORE_CMD_GATHER:
+        memcpy(store->ram_landing[d] + job->dst, store->ram_mram[d] + job->src, job->length);
+        break;
+    case STORE_CMD_SCAN: {
+        const uint8_t* page = store->ram_mram[d] + job->src;
+        uint32_t out = job->dst & ~(uint32_t)STORE_SCAN_COMPRESSED;
+
+        if (job->dst & STORE_SCAN_COMPRESSED) {
+            if (codec_decompress_page(page, record) != 0) {
+                job->status = 1;
+                break;
+            }
+            page = record;
+        }
+        job->length = scan_page(&store->scan, page,
+                                store->scan.want_records ? store->ram_staging[d] + out : NULL);
+        break;
+    }
+    case STORE_CMD_APPLY_DELTA:
+        if (job->src + job->length > STORE_DELTA_AREA_SIZE) {
+            job->status = 1;
+            break;
+        }
+        delta_apply_patch(store->ram_mram[d] + job->dst, store->ram_delta[d] + job->src);
+        break;
+    default:
+        job->status = 1;
+        break;
+    }
+}
+
+#ifdef HAVE_DPU_H
+/* Launch the DPUs of set, slots first.., if any of them has jobs */
+static int launch_set(swap_store_t* store, struct dpu_set_t set, uint32_t first,
+                      uint32_t nr_dpus) {
+    struct dpu_set_t dpu;
+    dpu_error_t err = DPU_OK;
+    uint32_t i, max_jobs = 0;
+
+    for (i = 0; i < nr_dpus; i++) {
+        if (store->nr_jobs[first + i] > max_jobs) max_jobs = store->nr_jobs[first + i];
+    }
+    if (max_jobs == 0) {
+        return 0;
+    }
+    size_t jobs_bytes = max_jobs * sizeof(store_job_t);
+
+    /* Every DPU with as many jobs: the same args for all, one broadcast */
+    for (i = 1; i < nr_dpus; i++) {
+        if (store->nr_jobs[first + i] != store->nr_jobs[first]) break;
+    }
+    if (store->cfg.broadcast_xfer && i == nr_dpus) {
+        if (replicate_set(store, set, nr_dpus, STORE_ARGS_SYMBOL, 0, &store->args[first],
+                          sizeof(store_args_t)) != 0) {
+            return -1;
+        }
+    } else {
+        DPU_FOREACH(set, dpu, i) {
+            if (err == DPU_OK) err = dpu_prepare_xfer(dpu, &store->args[first + i]);
+        }
+        if (err == DPU_OK) {
+            err = dpu_push_xfer(set, DPU_XFER_TO_DPU, STORE_ARGS_SYMBOL, 0,
+                                sizeof(store_args_t), DPU_XFER_DEFAULT);
+        }
+        if (err != DPU_OK) {
+            fprintf(stderr, "dpu_push_xfer (args) failed: %s\n", dpu_error_to_string(err));
+            store->stats.errors++;
+            return -1;
+        }
+    }
+
+    /* Job lists are pushed at the longest length so one push covers all DPUs */
+    DPU_FOREACH(set, dpu, i) {
+        if (err == DPU_OK) err = dpu_prepare_xfer(dpu, store->jobs[first + i]);
+    }
+    if (err == DPU_OK) {
+        err = dpu_push_xfer(set, DPU_XFER_TO_DPU, STORE_JOBS_SYMBOL, 0, jobs_bytes,
+                            DPU_XFER_DEFAULT);
+    }
+    if (err != DPU_OK) {
+        fprintf(stderr, "dpu_push_xfer (jobs) failed: %s\n", dpu_error_to_string(err));
+        store->stats.errors++;
+        return -1;
+    }
+
+    err = dpu_launch(set, DPU_SYNCHRONOUS);
+    if (err != DPU_OK) {
+        fprintf(stderr, "dpu_launch failed: %s\n", dpu_error_to_string(err));
+        store->stats.errors++;
+        return -1;
+    }
+
+    DPU_FOREACH(set, dpu, i) {
+        if (err == DPU_OK) err = dpu_prepare_xfer(dpu, store->jobs[first + i]);
+    }
+    if (err == DPU_OK) {
+        err = dpu_push_xfer(set, DPU_XFER_FROM_DPU, STORE_JOBS_SYMBOL, 0, jobs_bytes,
+                            DPU_XFER_DEFAULT);
+    }
+    if (err != DPU_OK) {
+        fprintf(stderr, "dpu_push_xfer (job status) failed: %s\n", dpu_error_to_string(err));
+        store->stats.errors++;
+        return -1;
+    }
+
+    store->stats.control_bytes += nr_dpus * (sizeof(store_args_t) + 2 * jobs_bytes);
+    return 0;
+}
+#endif
+
+/* What launch_set() costs over the emulated DPUs first..first+count-1:
+ * args and job lists pushed, launch, job lists read back */
+static void model_launch_set(swap_store_t* store, uint32_t first, uint32_t count) {
+    uint32_t max_jobs = 0;
+    cost_shape_t shape;
+
+    for (uint32_t d = first; d < first + count; d++) {
+        if (dpu_modeled(store, d) && store->nr_jobs[d] > max_jobs) max_jobs = store->nr_jobs[d];
+    }
+    if (max_jobs == 0) {
+        return;
+    }
+    model_xfer_range(store, first, count, sizeof(store_args_t));
+    model_xfer_range(store, first, count, max_jobs * sizeof(store_job_t));
+    cost_shape_init(&shape);
+    for (uint32_t d = first; d < first + count; d++) {
+        if (dpu_modeled(store, d)) cost_shape_add(&shape, model_rank(store, d), 0);
+    }
+    model_launch(store, &shape);
+    model_xfer_range(store, first, count, max_jobs * sizeof(store_job_t));
+}
+
+/* Run command on every DPU over its job list (store->jobs / nr_jobs) */
+static int run_kernel(swap_store_t* store, uint32_t command, uint32_t threshold) {
+    uint32_t max_jobs = 0;
+    int ret = 0;
+
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        store->args[d].command = command;
+        store->args[d].nr_jobs = store->nr_jobs[d];
+        store->args[d].threshold = threshold;
+        if (store->nr_jobs[d] > max_jobs) max_jobs = store->nr_jobs[d];
+    }
+    if (max_jobs == 0) {
+        return 0;
+    }
+    store->stats.kernel_launches++;
+    publish_queue(store, 1);
+
+#ifdef HAVE_DPU_H
+    if (store->dpu_backed && !store->ranks) {
+        ret = launch_set(store, store->dpu_set, 0, store->nr_dpus);
+    } else if (store->dpu_backed) {
+        /* Lazy store: one set per rank */
+        for (uint32_t r = 0; r < store->nr_ranks && ret == 0; r++) {
+            const store_rank_t* rank = &store->ranks[r];
+            if (rank->state != RANK_ONLINE) continue;
+            ret = launch_set(store, rank->set, rank->first, rank->nr_dpus);
+        }
+    }
+#endif
+
+    for (uint32_t d = 0; d < store->nr_dpus && ret == 0; d++) {
+        if (!dpu_emulated(store, d)) continue;
+        for (uint32_t j = 0; j < store->nr_jobs[d]; j++) {
+            emulate_job(store, d, &store->args[d], &store->jobs[d][j]);
+        }
+    }
+    if (ret == 0 && store->modeled && !store->ranks) {
+        model_launch_set(store, 0, store->nr_dpus);
+    } else if (ret == 0 && store->modeled) {
+        /* Lazy store: one set per rank, launched one after the other */
+        for (uint32_t r = 0; r < store->nr_ranks; r++) {
+            const store_rank_t* rank = &store->ranks[r];
+            if (rank->state != RANK_ONLINE) continue;
+            model_launch_set(store, rank->first, rank->nr_dpus);
+        }
+    }
+    publish_queue(store, 0);
+    return ret;
+}
+
+/* ========================================================================
+ * Init / teardown
+ * ======================================================================== */
+
+void swap_store_default_config(swap_store_config_t* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->nr_dpus = 8;
+    cfg->profile = getenv("DPU_PROFILE");
+    if (!cfg->profile) {
+        cfg->profile = "backend=simulator";
+    }
+    cfg->dpu_binary = "build/dpu_tasklets";
+    cfg->mram_size = STORE_MRAM_SIZE;
+    cfg->max_pages = 65536;
+    cfg->compress = 0;
+    cfg->compress_threshold = STORE_DEFAULT_THRESHOLD;
+    cfg->nr_workers = 4;
+    cfg->delta = 0;
+    cfg->delta_max_lines = STORE_DEFAULT_DELTA_LINES;
+    cfg->compact_budget_us = 1000;
+    cfg->numa = 0;
+    cfg->numa_node = -1;
+    cfg->dpus_per_rank = STORE_DPUS_PER_RANK;
+    cfg->lazy_ranks = 0;
+    cfg->rank_threads = 8;
+    cfg->rank_load_us = 0;
+}
+
+/* Zeroed host buffer, bound to a node with numa */
+static void* store_buffer(const swap_store_t* store, size_t size, int node) {
+    if (store->cfg.numa) {
+        return numa_topo_alloc(size, node);
+    }
+    return calloc(1, size);
+}
+
+static void free_buffer(const swap_store_t* store, void* buf, size_t size) {
+    if (store->cfg.numa) {
+        numa_topo_free(buf, size);
+    } else {
+        free(buf);
+    }
+}
+
+/* Node of rank r: UPMEM_SWAP_RANK_NODES ("0,0,1,1": one node per rank)
+ * overrides what the driver or the emulation says */
+static int rank_node(uint32_t r, int node, int nr_nodes) {
+    const char* env = getenv("UPMEM_SWAP_RANK_NODES");
+
+    for (uint32_t i = 0; env && *env; i++) {
+        char* end;
+        long v = strtol(env, &end, 10);
+        if (end == env) break;
+        if (i == r) {
+            node = (int)v;
+            break;
+        }
+        env = (*end == ',') ? end + 1 : end;
+    }
+    return (node >= 0 && node < nr_nodes) ? node : -1;
+}
+
+/* Find the node of every DPU, pick the home node and keep the workers on
+ * it. Without the driver's word, ranks of dpus_per_rank DPUs are spread
+ * over the nodes round-robin, which also gives the host memory fallback
+ * a rank layout to test against (e.g. under numa=fake). */
+static int init_numa(swap_store_t* store) {
+    int nr_nodes = numa_topo_nr_nodes();
+    uint32_t* per_node;
+    uint32_t best = 0;
+
+    store->home_node = -1;
+    if (!store->cfg.numa) {
+        return 0;
+    }
+    store->dpu_node = malloc(store->nr_dpus * sizeof(int));
+    store->local_dpus = malloc(store->nr_dpus * sizeof(uint32_t));
+    per_node = calloc(nr_nodes, sizeof(uint32_t));
+    if (!store->dpu_node || !store->local_dpus || !per_node) {
+        free(per_node);
+        return -1;
+    }
+
+    if (store->ranks) {
+        /* Lazy store: every rank is a dpu_alloc_ranks() of its own, so which
+         * driver rank sits behind slot r is only known once it is up
+         * (place_rank). Emulated ranks are spread as below. */
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            store->dpu_node[d] = -1;
+        }
+        for (uint32_t r = 0; r < store->nr_ranks; r++) {
+            store_rank_t* rank = &store->ranks[r];
+            rank->node = store->dpu_backed ? -1 : rank_node(r, (int)(r % nr_nodes), nr_nodes);
+            for (uint32_t i = 0; i < rank->nr_slots; i++) {
+                store->dpu_node[rank->first + i] = rank->node;
+            }
+        }
+    }
+#ifdef HAVE_DPU_H
+    else if (store->dpu_backed) {
+        /* Ranks come in allocation order, taken as the driver's order */
+        struct dpu_set_t rank, dpu;
+        uint32_t r = 0, i = 0, each;
+
+        DPU_RANK_FOREACH(store->dpu_set, rank) {
+            int node = rank_node(r, numa_topo_rank_node(r), nr_nodes);
+            DPU_FOREACH(rank, dpu, each) {
+                if (i < store->nr_dpus) store->dpu_node[i++] = node;
+            }
+            r++;
+        }
+    }
+#endif
+    else {
+        uint32_t per_rank = store->cfg.dpus_per_rank ? store->cfg.dpus_per_rank
+                                                     : STORE_DPUS_PER_RANK;
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            uint32_t r = d / per_rank;
+            store->dpu_node[d] = rank_node(r, (int)(r % nr_nodes), nr_nodes);
+        }
+    }
+
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        if (store->dpu_node[d] >= 0) per_node[store->dpu_node[d]]++;
+    }
+    store->home_node = store->cfg.numa_node;
+    if (store->home_node < 0) {
+        for (int n = 0; n < nr_nodes; n++) {
+            if (per_node[n] > best) {
+                best = per_node[n];
+                store->home_node = n;
+            }
+        }
+    }
+    free(per_node);
+
+    if (store->spill_dpu != UINT32_MAX) {
+        store->dpu_node[store->spill_dpu] = store->home_node;
+    }
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        if (d != store->spill_dpu && store->dpu_node[d] == store->home_node) {
+            store->local_dpus[store->nr_local_dpus++] = d;
+        }
+    }
+    for (int t = 0; t < store->pool.nr_threads && store->home_node >= 0; t++) {
+        numa_topo_bind_thread(store->pool.threads[t], store->home_node);
+    }
+    return 0;
+}
+
+#ifdef HAVE_DPU_H
+static int init_dpus(swap_store_t* store) {
+    struct dpu_set_t dpu;
+    dpu_error_t err;
+    uint32_t i;
+
+    err = dpu_alloc(store->cfg.nr_dpus, store->cfg.profile, &store->dpu_set);
+    if (err != DPU_OK) {
+        fprintf(stderr, "DPU allocation failed: %s\n", dpu_error_to_string(err));
+        return -1;
+    }
+    err = dpu_load(store->dpu_set, store->cfg.dpu_binary, NULL);
+    if (err != DPU_OK) {
+        fprintf(stderr, "DPU load failed: %s\n", dpu_error_to_string(err));
+        dpu_free(store->dpu_set);
+        return -1;
+    }
+    DPU_ASSERT(dpu_get_nr_dpus(store->dpu_set, &store->nr_dpus));
+
+    store->dpus = malloc(store->nr_dpus * sizeof(struct dpu_set_t));
+    if (!store->dpus) {
+        dpu_free(store->dpu_set);
+        return -1;
+    }
+    DPU_FOREACH(store->dpu_set, dpu, i) {
+        store->dpus[i] = dpu;
+    }
+    store->dpu_backed = 1;
+    return 0;
+}
+#endif
+
+static int alloc_ram_arrays(swap_store_t* store) {
+    store->ram_mram = calloc(store->nr_dpus, sizeof(uint8_t*));
+    store->ram_staging = calloc(store->nr_dpus, sizeof(uint8_t*));
+    store->ram_delta = calloc(store->nr_dpus, sizeof(uint8_t*));
+    store->ram_shared = calloc(store->nr_dpus, sizeof(uint8_t*));
+    if (!store->ram_mram || !store->ram_staging || !store->ram_delta || !store->ram_shared) {
+        return -1;
+    }
+    if (store->cfg.uniform_xfer) {
+        store->ram_landing = calloc(store->nr_dpus, sizeof(uint8_t*));
+        if (!store->ram_landing) return -1;
+    }
+    if (store->cfg.huge_mram_size) {
+        store->ram_huge = calloc(store->nr_dpus, sizeof(uint8_t*));
+        if (!store->ram_huge) return -1;
+    }
+    return 0;
+}
+
+/* Host memory standing in for the symbols of DPU d */
+static int alloc_ram_dpu(swap_store_t* store, uint32_t d) {
+    int node = store->cfg.numa ? store->dpu_node[d] : -1;
+
+    /* Emulated MRAM sits on the node of its rank, like the DIMMs */
+    store->ram_mram[d] = store_buffer(store, store->cfg.mram_size, node);
+    store->ram_staging[d] = store_buffer(store, STORE_STAGING_PAGES * STORE_PAGE_SIZE, node);
+    store->ram_delta[d] = store_buffer(store, STORE_DELTA_AREA_SIZE, node);
+    store->ram_shared[d] = store_buffer(store, STORE_SHARED_SIZE, node);
+    if (!store->ram_mram[d] || !store->ram_staging[d] || !store->ram_delta[d] ||
+        !store->ram_shared[d]) {
+        fprintf(stderr, "ERROR: Failed to allocate fallback page_store\n");
+        return -1;
+    }
+    if (store->ram_landing) {
+        store->ram_landing[d] = store_buffer(store, STORE_LANDING_SIZE, node);
+        if (!store->ram_landing[d]) return -1;
+    }
+    if (store->ram_huge && d != store->spill_dpu) {
+        store->ram_huge[d] = store_buffer(store, store->cfg.huge_mram_size, node);
+        if (!store->ram_huge[d]) return -1;
+    }
+    return 0;
+}
+
+static void sleep_us(uint64_t us) {
+    struct timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+}
+
+/* Host memory store: the cost model to charge, if any */
+static int init_model(swap_store_t* store) {
+    const char* path = getenv("UPMEM_SWAP_COST_MODEL");
+
+    if (store->dpu_backed) {
+        return 0;
+    }
+    if (store->cfg.cost_model) {
+        store->model = *store->cfg.cost_model;
+        store->modeled = 1;
+    } else if (path && *path) {
+        if (cost_model_load(&store->model, path) != 0) {
+            return -1;
+        }
+        store->modeled = 1;
+    }
+    return 0;
+}
+
+static int init_ram_fallback(swap_store_t* store) {
+    uint32_t per_rank = store->cfg.dpus_per_rank ? store->cfg.dpus_per_rank
+                                                 : STORE_DPUS_PER_RANK;
+
+    if (alloc_ram_arrays(store) != 0) {
+        return -1;
+    }
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        if (alloc_ram_dpu(store, d) != 0) return -1;
+    }
+    /* dpu_alloc + dpu_load bring the ranks up one after the other */
+    sleep_us((uint64_t)store->cfg.rank_load_us * ((store->nr_dpus + per_rank - 1) / per_rank));
+    return 0;
+}
+
+/* One huge page allocator per rank. A lazy store has its ranks already;
+ * otherwise they are those of dpu_set, or of dpus_per_rank emulated DPUs. */
+static int init_huge(swap_store_t* store) {
+    uint32_t per_rank = store->cfg.dpus_per_rank ? store->cfg.dpus_per_rank
+                                                 : STORE_DPUS_PER_RANK;
+
+    if (store->ranks) {
+        store->nr_huge = store->nr_ranks;
+    }
+#ifdef HAVE_DPU_H
+    else if (store->dpu_backed) {
+        struct dpu_set_t rank;
+        uint32_t nr_ranks = 0, first = 0;
+
+        DPU_RANK_FOREACH(store->dpu_set, rank) {
+            nr_ranks++;
+        }
+        store->huge_ranks = calloc(nr_ranks, sizeof(store_rank_t));
+        if (!store->huge_ranks) {
+            return -1;
+        }
+        DPU_RANK_FOREACH(store->dpu_set, rank) {
+            store_rank_t* r = &store->huge_ranks[store->nr_huge++];
+            r->set = rank;
+            r->first = first;
+            DPU_ASSERT(dpu_get_nr_dpus(rank, &r->nr_dpus));
+            r->nr_slots = r->nr_dpus;
+            r->state = RANK_ONLINE;
+            first += r->nr_dpus;
+        }
+    }
+#endif
+    else {
+        store->nr_huge = (store->nr_dpus + per_rank - 1) / per_rank;
+        store->huge_ranks = calloc(store->nr_huge, sizeof(store_rank_t));
+        if (!store->huge_ranks) {
+            return -1;
+        }
+        for (uint32_t r = 0; r < store->nr_huge; r++) {
+            store->huge_ranks[r].first = r * per_rank;
+            store->huge_ranks[r].nr_dpus = store->nr_dpus - r * per_rank < per_rank
+                                           ? store->nr_dpus - r * per_rank : per_rank;
+            store->huge_ranks[r].nr_slots = store->huge_ranks[r].nr_dpus;
+            store->huge_ranks[r].state = RANK_ONLINE;
+        }
+    }
+    store->huge = calloc(store->nr_huge, sizeof(huge_space_t));
+    return store->huge ? 0 : -1;
+}
+
+/* ========================================================================
+ * Lazy rank bring-up
+ * ======================================================================== */
+
+#define STORE_MIGRATE_PAGES 64      /* spilled pages moved to ranks per call */
+#define STORE_MIGRATE_SCAN 4096     /* table entries looked at per call */
+
+#ifdef HAVE_DPU_H
+/* The binary is parsed by the SDK once per rank, but read only once */
+static int read_program(swap_store_t* store) {
+    FILE* f = fopen(store->cfg.dpu_binary, "rb");
+    long size;
+
+    if (!f) {
+        fprintf(stderr, "DPU load failed: cannot open %s\n", store->cfg.dpu_binary);
+        return -1;
+    }
+    if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) <= 0 || fseek(f, 0, SEEK_SET) != 0) {
+        fclose(f);
+        return -1;
+    }
+    store->program = malloc(size);
+    if (!store->program || fread(store->program, 1, size, f) != (size_t)size) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    store->program_size = size;
+    return 0;
+}
+
+/* Node of a rank just allocated, from the driver's id of that rank. The
+ * host buffers of its slots were allocated before it was known: they
+ * move there. The store adopts the DPUs in absorb_ranks(). */
+static void place_rank(swap_store_t* store, store_rank_t* rank) {
+    uint32_t id = dpu_get_rank_id(rank->set.list.ranks[0]);
+    int node = rank_node(id, numa_topo_rank_node(id), numa_topo_nr_nodes());
+
+    rank->node = node;
+    if (node < 0) {
+        return;
+    }
+    for (uint32_t d = rank->first; d < rank->first + rank->nr_slots; d++) {
+        store->dpu_node[d] = node;
+        numa_topo_move(store->jobs[d], STORE_MAX_JOBS * sizeof(store_job_t), node);
+        if (store->delta_bufs) numa_topo_move(store->delta_bufs[d], STORE_DELTA_AREA_SIZE, node);
+        if (store->landing_bufs) numa_topo_move(store->landing_bufs[d], STORE_LANDING_SIZE, node);
+    }
+}
+
+static int bring_up_dpus(swap_store_t* store, store_rank_t* rank) {
+    struct dpu_set_t dpu;
+    dpu_error_t err;
+    uint32_t i;
+
+    err = dpu_alloc_ranks(1, store->cfg.profile, &rank->set);
+    if (err != DPU_OK) {
+        fprintf(stderr, "DPU allocation failed: %s\n", dpu_error_to_string(err));
+        return -1;
+    }
+    err = dpu_load_from_memory(rank->set, store->program, store->program_size, NULL);
+    if (err != DPU_OK) {
+        fprintf(stderr, "DPU load failed: %s\n", dpu_error_to_string(err));
+        dpu_free(rank->set);
+        return -1;
+    }
+    rank->nr_dpus = 0;
+    DPU_FOREACH(rank->set, dpu, i) {
+        if (i < rank->nr_slots) {
+            store->dpus[rank->first + i] = dpu;
+            rank->nr_dpus++;
+        }
+    }
+    if (store->cfg.numa) {
+        place_rank(store, rank);
+    }
+    return 0;
+}
+#endif
+
+static int bring_up_emulated(swap_store_t* store, store_rank_t* rank) {
+    sleep_us(store->cfg.rank_load_us);
+    for (uint32_t i = 0; i < rank->nr_slots; i++) {
+        if (alloc_ram_dpu(store, rank->first + i) != 0) return -1;
+    }
+    rank->nr_dpus = rank->nr_slots;
+    return 0;
+}
+
+/* Bring-up thread: takes ranks until there are none left. Only touches
+ * the rank and its DPU slots; the store picks them up in absorb_ranks(). */
+static void* rank_thread(void* arg) {
+    swap_store_t* store = arg;
+
+    for (;;) {
+        if (__atomic_load_n(&store->stop_ranks, __ATOMIC_RELAXED)) break;
+        uint32_t r = __atomic_fetch_add(&store->next_rank, 1, __ATOMIC_RELAXED);
+        if (r >= store->nr_ranks) break;
+
+        store_rank_t* rank = &store->ranks[r];
+        if (store->cfg.numa && store->dpu_node[rank->first] >= 0) {
+            numa_topo_bind_thread(pthread_self(), store->dpu_node[rank->first]);
+        }
+#ifdef HAVE_DPU_H
+        int ret = store->dpu_backed ? bring_up_dpus(store, rank) : bring_up_emulated(store, rank);
+#else
+        int ret = bring_up_emulated(store, rank);
+#endif
+        rank->ready_ns = now_ns() - store->init_start_ns;
+        __atomic_store_n(&rank->state, ret == 0 ? RANK_READY : RANK_FAILED, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&store->ranks_settled, 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/* Slots for every rank now, the ranks themselves later. The spill DPU
+ * comes last. */
+static int init_lazy(swap_store_t* store) {
+    uint32_t per_rank = store->cfg.dpus_per_rank ? store->cfg.dpus_per_rank
+                                                 : STORE_DPUS_PER_RANK;
+    uint32_t nr_slots = store->cfg.nr_dpus;
+
+#ifdef HAVE_DPU_H
+    if (read_program(store) == 0) {
+        /* Whole ranks: a rank may have fewer DPUs than slots, never more */
+        store->dpu_backed = 1;
+        per_rank = STORE_DPUS_PER_RANK;
+        nr_slots = (nr_slots + per_rank - 1) / per_rank * per_rank;
+    } else {
+        fprintf(stderr, "Falling back to host memory page store.\n");
+    }
+#endif
+    store->nr_ranks = (nr_slots + per_rank - 1) / per_rank;
+    store->nr_dpus = nr_slots + 1;
+    store->spill_dpu = nr_slots;
+    store->ranks = calloc(store->nr_ranks, sizeof(store_rank_t));
+    store->dpu_online = calloc(store->nr_dpus, sizeof(uint8_t));
+    if (!store->ranks || !store->dpu_online) {
+        return -1;
+    }
+#ifdef HAVE_DPU_H
+    store->dpus = calloc(store->nr_dpus, sizeof(struct dpu_set_t));
+    if (!store->dpus) {
+        return -1;
+    }
+#endif
+    for (uint32_t r = 0; r < store->nr_ranks; r++) {
+        store->ranks[r].first = r * per_rank;
+        store->ranks[r].nr_slots = nr_slots - r * per_rank < per_rank ? nr_slots - r * per_rank
+                                                                      : per_rank;
+    }
+    return alloc_ram_arrays(store);
+}
+
+static int start_rank_threads(swap_store_t* store) {
+    int n = store->cfg.rank_threads > 0 ? store->cfg.rank_threads : 1;
+
+    if ((uint32_t)n > store->nr_ranks) n = (int)store->nr_ranks;
+    store->rank_threads = calloc(n, sizeof(pthread_t));
+    if (!store->rank_threads) {
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        if (pthread_create(&store->rank_threads[i], NULL, rank_thread, store) != 0) {
+            fprintf(stderr, "ERROR: Failed to start rank bring-up thread %d\n", i);
+            break;
+        }
+        store->nr_rank_threads++;
+    }
+    return store->nr_rank_threads > 0 ? 0 : -1;
+}
+
+static void join_rank_threads(swap_store_t* store, int stop) {
+    if (stop) {
+        __atomic_store_n(&store->stop_ranks, 1, __ATOMIC_RELAXED);
+    }
+    for (int i = 0; i < store->nr_rank_threads; i++) {
+        pthread_join(store->rank_threads[i], NULL);
+    }
+    free(store->rank_threads);
+    store->rank_threads = NULL;
+    store->nr_rank_threads = 0;
+}
+
+/* Move a few spilled pages to the ranks online */
+static void migrate_spill(swap_store_t* store) {
+    uint32_t moved = 0;
+
+    for (uint32_t n = 0; n < STORE_MIGRATE_SCAN && moved < STORE_MIGRATE_PAGES &&
+                         store->nr_spilled > 0; n++) {
+        page_entry_t* e = &store->table[store->migrate_pos];
+        page_loc_t loc;
+
+        store->migrate_pos = (store->migrate_pos + 1) & store->table_mask;
+        if (e->state != ENTRY_USED || (e->loc.flags & (PAGE_ZERO | PAGE_HUGE)) ||
+            e->loc.dpu != store->spill_dpu) {
+            continue;
+        }
+        loc = e->loc;
+        if (place_online(store, loc.size_class, &loc) != 0) {
+            return;     /* ranks full */
+        }
+        if (mram_write_record(store, loc.dpu, loc.offset,
+                              store->ram_mram[store->spill_dpu] + e->loc.offset,
+                              loc.length) != 0) {
+            release_record(store, &loc);
+            return;
+        }
+        release_record(store, &e->loc);
+        e->loc = loc;
+        moved++;
+        store->stats.migrated_pages++;
+    }
+}
+
+/* Bring the ranks the threads finished into placement. Called at the start
+ * of puts, gets and DPU compression, so the store only changes in the
+ * caller's thread. */
+/* NUMA placement of a DPU rank that came up lazily: the first one with a
+ * known node is home unless cfg.numa_node says otherwise, and its DPUs
+ * are local if they sit on the home node */
+static void adopt_rank_node(swap_store_t* store, const store_rank_t* rank) {
+    if (!store->cfg.numa || !store->dpu_backed || rank->node < 0) {
+        return;
+    }
+    if (store->home_node < 0) {
+        store->home_node = rank->node;
+        store->dpu_node[store->spill_dpu] = store->home_node;
+        for (int t = 0; t < store->pool.nr_threads; t++) {
+            numa_topo_bind_thread(store->pool.threads[t], store->home_node);
+        }
+    }
+    if (rank->node != store->home_node) {
+        return;
+    }
+    for (uint32_t d = rank->first; d < rank->first + rank->nr_dpus; d++) {
+        store->local_dpus[store->nr_local_dpus++] = d;
+    }
+}
+
+static void absorb_ranks(swap_store_t* store) {
+    if (!store->ranks) {
+        return;
+    }
+    if (__atomic_load_n(&store->ranks_settled, __ATOMIC_ACQUIRE) != store->ranks_absorbed) {
+        for (uint32_t r = 0; r < store->nr_ranks; r++) {
+            store_rank_t* rank = &store->ranks[r];
+            int state = __atomic_load_n(&rank->state, __ATOMIC_ACQUIRE);
+
+            if (state == RANK_READY) {
+                memset(store->dpu_online + rank->first, 1, rank->nr_dpus);
+                store->nr_online_dpus += rank->nr_dpus;
+                rank->state = RANK_ONLINE;
+                adopt_rank_node(store, rank);
+                if (store->shared_used > 0) {
+                    /* Catch up on what was broadcast before the rank came up */
+                    replicate_group(store, rank, STORE_SHARED_SYMBOL, 0, store->shared,
+                                    store->shared_used);
+                }
+                store->stats.ranks_online++;
+                if (!store->stats.first_rank_ns || rank->ready_ns < store->stats.first_rank_ns) {
+                    store->stats.first_rank_ns = rank->ready_ns;
+                }
+            } else if (state == RANK_FAILED) {
+                rank->state = RANK_OFFLINE;
+                store->stats.ranks_failed++;
+            } else {
+                continue;
+            }
+            if (rank->ready_ns > store->stats.full_capacity_ns) {
+                store->stats.full_capacity_ns = rank->ready_ns;
+            }
+            store->ranks_absorbed++;
+        }
+        if (store->ranks_absorbed == store->nr_ranks && store->nr_online_dpus == 0) {
+            fprintf(stderr, "ERROR: no rank came up, pages stay in host memory\n");
+        }
+    }
+    if (store->nr_online_dpus > 0) {
+        migrate_spill(store);
+    }
+}
+
+uint32_t swap_store_wait_ranks(swap_store_t* store) {
+    if (!store->ranks) {
+        return store->nr_dpus;
+    }
+    join_rank_threads(store, 0);
+    absorb_ranks(store);
+    return store->nr_online_dpus;
+}
+
+int swap_store_init(swap_store_t* store, const swap_store_config_t* cfg) {
+    uint32_t table_size = 1;
+
+    memset(store, 0, sizeof(*store));
+    store->cfg = *cfg;
+    store->spill_dpu = UINT32_MAX;
+    store->init_start_ns = now_ns();
+    if (work_pool_init(&store->pool, cfg->compress ? cfg->nr_workers : 0) != 0) {
+        return -1;
+    }
+    if (store->cfg.mram_size > STORE_MRAM_SIZE) {
+        store->cfg.mram_size = STORE_MRAM_SIZE;
+    }
+    if (store->cfg.huge_mram_size > STORE_HUGE_AREA_SIZE) {
+        store->cfg.huge_mram_size = STORE_HUGE_AREA_SIZE;
+    }
+
+    if (cfg->lazy_ranks) {
+        if (init_lazy(store) != 0) {
+            fprintf(stderr, "ERROR: Failed to allocate rank slots\n");
+            swap_store_free(store);
+            return -1;
+        }
+    } else {
+#ifdef HAVE_DPU_H
+        if (init_dpus(store) != 0) {
+            fprintf(stderr, "Falling back to host memory page store.\n");
+        }
+#endif
+        if (!store->dpu_backed) {
+            store->nr_dpus = cfg->nr_dpus;
+        }
+    }
+    if (init_numa(store) != 0) {
+        fprintf(stderr, "ERROR: Failed to allocate NUMA placement\n");
+        swap_store_free(store);
+        return -1;
+    }
+    if (init_model(store) != 0) {
+        swap_store_free(store);
+        return -1;
+    }
+    if (store->ranks) {
+        if (alloc_ram_dpu(store, store->spill_dpu) != 0) {
+            swap_store_free(store);
+            return -1;
+        }
+    } else if (!store->dpu_backed && init_ram_fallback(store) != 0) {
+        swap_store_free(store);
+        return -1;
+    }
+
+    while (table_size < 2 * cfg->max_pages) {
+        table_size <<= 1;
+    }
+    store->table = calloc(table_size, sizeof(page_entry_t));
+    store->table_mask = table_size - 1;
+    store->space = calloc(store->nr_dpus, sizeof(dpu_space_t));
+    store->args = calloc(store->nr_dpus, sizeof(store_args_t));
+    store->jobs = calloc(store->nr_dpus, sizeof(store_job_t*));
+    store->job_refs = calloc(store->nr_dpus, sizeof(uint32_t*));
+    store->nr_jobs = calloc(store->nr_dpus, sizeof(uint32_t));
+    if (!store->table || !store->space || !store->args || !store->jobs ||
+        !store->job_refs || !store->nr_jobs) {
+        fprintf(stderr, "ERROR: Failed to allocate page store metadata\n");
+        swap_store_free(store);
+        return -1;
+    }
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        int node = store->cfg.numa ? store->dpu_node[d] : -1;
+
+        /* Staged for DPU d: near its rank */
+        store->jobs[d] = store_buffer(store, STORE_MAX_JOBS * sizeof(store_job_t), node);
+        store->job_refs[d] = calloc(STORE_MAX_JOBS, sizeof(uint32_t));
+        if (!store->jobs[d] || !store->job_refs[d]) {
+            fprintf(stderr, "ERROR: Failed to allocate kernel job lists\n");
+            swap_store_free(store);
+            return -1;
+        }
+    }
+    if (cfg->delta) {
+        store->delta_bufs = calloc(store->nr_dpus, sizeof(uint8_t*));
+        store->delta_used = calloc(store->nr_dpus, sizeof(uint32_t));
+        if (!store->delta_bufs || !store->delta_used) {
+            swap_store_free(store);
+            return -1;
+        }
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            int node = store->cfg.numa ? store->dpu_node[d] : -1;
+            store->delta_bufs[d] = store_buffer(store, STORE_DELTA_AREA_SIZE, node);
+            if (!store->delta_bufs[d]) {
+                fprintf(stderr, "ERROR: Failed to allocate delta buffers\n");
+                swap_store_free(store);
+                return -1;
+            }
+        }
+    }
+    if (cfg->uniform_xfer) {
+        store->landing_bufs = calloc(store->nr_dpus, sizeof(uint8_t*));
+        if (!store->landing_bufs ||
+            xfer_plan_init(&store->plan, store->nr_dpus, STORE_LANDING_SIZE, STORE_MAX_JOBS) != 0) {
+            swap_store_free(store);
+            return -1;
+        }
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            int node = store->cfg.numa ? store->dpu_node[d] : -1;
+            store->landing_bufs[d] = store_buffer(store, STORE_LANDING_SIZE, node);
+            if (!store->landing_bufs[d]) {
+                fprintf(stderr, "ERROR: Failed to allocate landing buffers\n");
+                swap_store_free(store);
+                return -1;
+            }
+        }
+    }
+    if (cfg->huge_mram_size && init_huge(store) != 0) {
+        fprintf(stderr, "ERROR: Failed to allocate huge page space\n");
+        swap_store_free(store);
+        return -1;
+    }
+    if (store->ranks && start_rank_threads(store) != 0) {
+        swap_store_free(store);
+        return -1;
+    }
+    return 0;
+}
+
+void swap_store_free(swap_store_t* store) {
+    join_rank_threads(store, 1);
+    work_pool_destroy(&store->pool);
+    free_buffer(store, store->items, store->items_cap * sizeof(store_item_t));
+
+#ifdef HAVE_DPU_H
+    if (store->dpu_backed && store->ranks) {
+        for (uint32_t r = 0; r < store->nr_ranks; r++) {
+            if (store->ranks[r].state == RANK_READY || store->ranks[r].state == RANK_ONLINE) {
+                dpu_free(store->ranks[r].set);
+            }
+        }
+        free(store->dpus);
+    } else if (store->dpu_backed) {
+        dpu_free(store->dpu_set);
+        free(store->dpus);
+    }
+#endif
+    if (store->ram_mram) {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            free_buffer(store, store->ram_mram[d], store->cfg.mram_size);
+        }
+        free(store->ram_mram);
+    }
+    if (store->ram_staging) {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            free_buffer(store, store->ram_staging[d], STORE_STAGING_PAGES * STORE_PAGE_SIZE);
+        }
+        free(store->ram_staging);
+    }
+    if (store->ram_delta) {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            free_buffer(store, store->ram_delta[d], STORE_DELTA_AREA_SIZE);
+        }
+        free(store->ram_delta);
+    }
+    if (store->ram_shared) {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            free_buffer(store, store->ram_shared[d], STORE_SHARED_SIZE);
+        }
+        free(store->ram_shared);
+    }
+    free(store->shared);
+    if (store->delta_bufs) {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            free_buffer(store, store->delta_bufs[d], STORE_DELTA_AREA_SIZE);
+        }
+        free(store->delta_bufs);
+    }
+    free(store->delta_used);
+    if (store->ram_landing) {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            free_buffer(store, store->ram_landing[d], STORE_LANDING_SIZE);
+        }
+        free(store->ram_landing);
+    }
+    if (store->landing_bufs) {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            free_buffer(store, store->landing_bufs[d], STORE_LANDING_SIZE);
+        }
+        free(store->landing_bufs);
+    }
+    if (store->ram_huge) {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            free_buffer(store, store->ram_huge[d], store->cfg.huge_mram_size);
+        }
+        free(store->ram_huge);
+    }
+    if (store->huge) {
+        for (uint32_t g = 0; g < store->nr_huge; g++) {
+            free(store->huge[g].free_slots);
+        }
+        free(store->huge);
+    }
+    free(store->huge_ranks);
+    xfer_plan_free(&store->plan);
+    free(store->reqs);
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        if (store->jobs) free_buffer(store, store->jobs[d], STORE_MAX_JOBS * sizeof(store_job_t));
+        if (store->job_refs) free(store->job_refs[d]);
+    }
+    free(store->jobs);
+    free(store->job_refs);
+    free(store->nr_jobs);
+    free(store->args);
+    if (store->space) {
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            for (int c = 0; c < STORE_NR_CLASSES; c++) {
+                free(store->space[d].free_slots[c]);
+            }
+        }
+        free(store->space);
+    }
+    if (store->table) {
+        for (uint32_t i = 0; i <= store->table_mask; i++) {
+            free(store->table[i].line_hashes);
+        }
+    }
+    free(store->table);
+    free(store->dpu_node);
+    free(store->local_dpus);
+    free(store->ranks);
+    free(store->dpu_online);
+    free(store->program);
+    if (store->metrics_slot) {
+        swap_metrics_remove_store(store->metrics_slot);
+    }
+    free(store->metrics_rank);
+    memset(store, 0, sizeof(*store));
+}
+
+/* ========================================================================
+ * Put / get
+ * ======================================================================== */
+
+static int reserve_items(swap_store_t* store, size_t n) {
+    store_item_t* items;
+
+    if (n <= store->items_cap) {
+        return 0;
+    }
+    if (store->cfg.numa) {
+        /* Scratch only, nothing to carry over: staged on the home node */
+        items = numa_topo_alloc(n * sizeof(store_item_t), store->home_node);
+        if (items) numa_topo_free(store->items, store->items_cap * sizeof(store_item_t));
+    } else {
+        items = realloc(store->items, n * sizeof(store_item_t));
+    }
+    if (!items) {
+        fprintf(stderr, "ERROR: Failed to allocate batch of %zu pages\n", n);
+        return -1;
+    }
+    store->items = items;
+    store->items_cap = n;
+    return 0;
+}
+
+/* Worker: pick the representation of one page */
+static void encode_item(void* ctx, size_t i) {
+    swap_store_t* store = ctx;
+    store_item_t* it = &store->items[i];
+    size_t csize;
+
+    if (it->delta_done) {
+        return;
+    }
+    if (page_is_zero(it->src, STORE_PAGE_SIZE)) {
+        it->flags = PAGE_ZERO;
+        it->length = 0;
+        return;
+    }
+    csize = page_compress(it->src, STORE_PAGE_SIZE, it->record, store->cfg.compress_threshold);
+    if (csize > 0) {
+        it->flags = PAGE_COMPRESSED;
+        it->length = (uint16_t)csize;
+    } else {
+        it->flags = PAGE_RAW;
+        it->length = STORE_PAGE_SIZE;
+    }
+}
+
+/* Worker: rebuild the page from the record fetched by the main thread */
+static void decode_item(void* ctx, size_t i) {
+    swap_store_t* store = ctx;
+    store_item_t* it = &store->items[i];
+
+    if (it->flags & PAGE_COMPRESSED) {
+        if (page_decompress(it->record, it->length, it->dst, STORE_PAGE_SIZE) != STORE_PAGE_SIZE) {
+            fprintf(stderr, "ERROR: corrupted compressed page\n");
+            memset(it->dst, 0, STORE_PAGE_SIZE);
+            __atomic_add_fetch(&store->stats.errors, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/* Remember the line hashes of a page stored plain, forget them otherwise */
+static void set_line_hashes(page_entry_t* e, const uint64_t* hashes) {
+    if (!hashes) {
+        free(e->line_hashes);
+        e->line_hashes = NULL;
+        return;
+    }
+    if (!e->line_hashes) {
+        e->line_hashes = malloc(STORE_LINES_PER_PAGE * sizeof(uint64_t));
+        if (!e->line_hashes) return;    /* no delta for this page next time */
+    }
+    memcpy(e->line_hashes, hashes, STORE_LINES_PER_PAGE * sizeof(uint64_t));
+}
+
+static inline const uint8_t* item_record(const store_item_t* it) {
+    return (it->flags & PAGE_COMPRESSED) ? it->record : it->src;
+}
+
+/* Point page_id at loc, already in MRAM, dropping what it held */
+static page_entry_t* publish_loc(swap_store_t* store, uint64_t page_id, const page_loc_t* loc) {
+    page_entry_t* e = table_find(store, page_id);
+
+    /* The old copy is only dropped once the new one is in MRAM */
+    if (e) {
+        release_record(store, &e->loc);
+    } else {
+        if (store->nr_deleted > (store->table_mask + 1) / 4) {
+            table_rebuild(store);
+        }
+        e = table_insert(store, page_id);
+        if (!e) {
+            fprintf(stderr, "ERROR: page table full (%u pages)\n", store->cfg.max_pages);
+            release_record(store, loc);
+            return NULL;
+        }
+    }
+    e->loc = *loc;
+    return e;
+}
+
+/* Point page_id at a record already in MRAM (or a zero page) */
+static int publish_item(swap_store_t* store, uint64_t page_id, const store_item_t* it,
+                        page_loc_t loc) {
+    page_entry_t* e = publish_loc(store, page_id, &loc);
+
+    if (!e) {
+        return -1;
+    }
+    if (store->cfg.delta) {
+        set_line_hashes(e, loc.flags == PAGE_RAW ? it->line_hashes : NULL);
+    }
+
+    store->stats.puts++;
+    store->stats.page_bytes += STORE_PAGE_SIZE;
+    store->stats.record_bytes += loc.length;
+    if (loc.flags & PAGE_ZERO) store->stats.zero_pages++;
+    else if (loc.flags & PAGE_COMPRESSED) store->stats.compressed_pages++;
+    else store->stats.raw_pages++;
+    return 0;
+}
+
+/* Allocate a slot for an encoded page, send it and publish the metadata */
+static int store_item(swap_store_t* store, uint64_t page_id, const store_item_t* it) {
+    page_loc_t loc = {0};
+
+    loc.flags = it->flags;
+    loc.length = it->length;
+    if (!(it->flags & PAGE_ZERO)) {
+        if (place_record(store, size_class_of(it->length), &loc) != 0) {
+            return -1;
+        }
+        if (mram_write_record(store, loc.dpu, loc.offset, item_record(it), it->length) != 0) {
+            release_record(store, &loc);
+            return -1;
+        }
+    }
+    return publish_item(store, page_id, it, loc);
+}
+
+static void count_delta_put(swap_store_t* store, uint32_t patch_bytes) {
+    store->stats.puts++;
+    store->stats.page_bytes += STORE_PAGE_SIZE;
+    store->stats.record_bytes += STORE_PAGE_SIZE;
+    store->stats.delta_pages++;
+    store->stats.delta_bytes += patch_bytes;
+    store->stats.delta_saved_bytes += STORE_PAGE_SIZE - patch_bytes;
+}
+
+/* Re-puts of pages stored plain whose content barely changed are patched
+ * in MRAM by the kernel: the changed lines of every such page go into its
+ * DPU's delta_area, one launch applies them all. Pages that don't qualify
+ * (or whose patch failed) are left to the regular put path. */
+static void put_deltas(swap_store_t* store, const uint64_t* page_ids, size_t n) {
+    uint32_t seq = ++store->batch_seq;
+    uint32_t nr_patches = 0;
+
+    /* A page named twice in one batch must be written in order: no delta */
+    for (size_t i = 0; i < n; i++) {
+        page_entry_t* e = table_find(store, page_ids[i]);
+        delta_hash_page(store->items[i].src, store->items[i].line_hashes);
+        if (!e) continue;
+        if (e->seen_batch != seq) {
+            e->seen_batch = seq;
+            e->seen_count = 0;
+        }
+        e->seen_count++;
+    }
+
+    memset(store->nr_jobs, 0, store->nr_dpus * sizeof(uint32_t));
+    memset(store->delta_used, 0, store->nr_dpus * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++) {
+        store_item_t* it = &store->items[i];
+        page_entry_t* e = table_find(store, page_ids[i]);
+        if (!e || !e->line_hashes || e->seen_count != 1) continue;
+        store->stats.delta_candidates++;
+
+        uint64_t mask = delta_changed_lines(e->line_hashes, it->line_hashes);
+        if ((uint32_t)__builtin_popcountll(mask) > store->cfg.delta_max_lines) continue;
+
+        if (mask == 0) {
+            /* Clean page: MRAM already holds it */
+            it->delta_done = 1;
+            count_delta_put(store, 0);
+            continue;
+        }
+
+        uint32_t d = e->loc.dpu;
+        uint32_t j = store->nr_jobs[d];
+        uint32_t size = delta_patch_size(mask);
+        if (j == STORE_MAX_JOBS || store->delta_used[d] + size > STORE_DELTA_AREA_SIZE) continue;
+
+        delta_build_patch(it->src, mask, store->delta_bufs[d] + store->delta_used[d]);
+        store->jobs[d][j].src = store->delta_used[d];
+        store->jobs[d][j].dst = e->loc.offset;
+        store->jobs[d][j].length = size;
+        store->jobs[d][j].status = 0;
+        store->job_refs[d][j] = (uint32_t)i;
+        store->nr_jobs[d]++;
+        store->delta_used[d] += size;
+        nr_patches++;
+    }
+    if (nr_patches == 0) {
+        return;
+    }
+
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        if (store->delta_used[d] == 0) continue;
+        if (dpu_xfer_symbol(store, d, 1, STORE_DELTA_SYMBOL, 0, store->delta_bufs[d],
+                            store->delta_used[d]) != 0) {
+            store->nr_jobs[d] = 0;
+            continue;
+        }
+        store->stats.bus_bytes_to_dpu += store->delta_used[d];
+    }
+    if (run_kernel(store, STORE_CMD_APPLY_DELTA, 0) != 0) {
+        return;
+    }
+
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        for (uint32_t j = 0; j < store->nr_jobs[d]; j++) {
+            store_item_t* it = &store->items[store->job_refs[d][j]];
+            page_entry_t* e = table_find(store, page_ids[store->job_refs[d][j]]);
+
+            if (store->jobs[d][j].status != 0) {
+                /* The slot may be half patched, the full put rewrites it elsewhere */
+                store->stats.errors++;
+                continue;
+            }
+            it->delta_done = 1;
+            memcpy(e->line_hashes, it->line_hashes, STORE_LINES_PER_PAGE * sizeof(uint64_t));
+            e->loc.flags = PAGE_RAW;    /* new content, worth another compression try */
+            count_delta_put(store, store->jobs[d][j].length);
+        }
+    }
+}
+
+/* Uniform transfers
+ *
+ * With cfg.uniform_xfer a batch goes through the landing area of every
+ * DPU (xfer_plan.h): records are packed on the HOST, moved with one push
+ * per DPU set and round, and scattered to their slots by the kernel (or
+ * gathered from them, for gets). Sets are the whole store, or one rank at
+ * a time with lazy_ranks; the spill DPU is host memory and is copied. */
+
+/* store_item_t.failed */
+#define ITEM_NO_SLOT  1
+#define ITEM_NOT_SENT 2
+
+static int reserve_reqs(swap_store_t* store, size_t n) {
+    if (n <= store->reqs_cap) return 0;
+    xfer_req_t* reqs = realloc(store->reqs, n * sizeof(xfer_req_t));
+    if (!reqs) {
+        fprintf(stderr, "ERROR: Failed to allocate transfer plan of %zu pages\n", n);
+        return -1;
+    }
+    store->reqs = reqs;
+    store->reqs_cap = n;
+    return 0;
+}
+
+/* One push of round over the DPUs of rank (NULL: the whole store), at the
+ * length of the fullest landing area among them */
+static int push_group(swap_store_t* store, const store_rank_t* rank, uint32_t round,
+                      int to_dpu) {
+    uint32_t first = rank ? rank->first : 0;
+    uint32_t count = rank ? rank->nr_dpus : store->nr_dpus;
+    uint32_t extent = xfer_plan_extent(&store->plan, round, first, count);
+    uint64_t bus = 0;
+
+    if (extent == 0) {
+        return 0;
+    }
+    for (uint32_t d = first; d < first + count; d++) {
+        uint32_t used = xfer_plan_used(&store->plan, round, d);
+        if (used == 0) continue;
+        store->stats.padding_bytes += extent - used;
+        bus += extent;
+    }
+    store->stats.pushes++;
+    if (to_dpu) store->stats.bus_bytes_to_dpu += bus;
+    else store->stats.bus_bytes_from_dpu += bus;
+
+#ifdef HAVE_DPU_H
+    if (!dpu_emulated(store, first)) {
+        struct dpu_set_t set = rank ? rank->set : store->dpu_set;
+        struct dpu_set_t dpu;
+        dpu_error_t err = DPU_OK;
+        uint32_t i;
+
+        /* DPUs with nothing this round are left out of the transfer */
+        DPU_FOREACH(set, dpu, i) {
+            if (err != DPU_OK || xfer_plan_used(&store->plan, round, first + i) == 0) continue;
+            err = dpu_prepare_xfer(dpu, store->landing_bufs[first + i]);
+        }
+        if (err == DPU_OK) {
+            err = dpu_push_xfer(set, to_dpu ? DPU_XFER_TO_DPU : DPU_XFER_FROM_DPU,
+                                STORE_LANDING_SYMBOL, 0, extent, DPU_XFER_DEFAULT);
+        }
+        if (err != DPU_OK) {
+            fprintf(stderr, "dpu_push_xfer (landing) failed: %s\n", dpu_error_to_string(err));
+            store->stats.errors++;
+            return -1;
+        }
+        return 0;
+    }
+#endif
+    cost_shape_t shape;
+    cost_shape_init(&shape);
+    for (uint32_t d = first; d < first + count; d++) {
+        if (xfer_plan_used(&store->plan, round, d) == 0) continue;
+        if (to_dpu) memcpy(store->ram_landing[d], store->landing_bufs[d], extent);
+        else memcpy(store->landing_bufs[d], store->ram_landing[d], extent);
+        if (dpu_modeled(store, d)) cost_shape_add(&shape, model_rank(store, d), extent);
+    }
+    if (store->modeled) {
+        model_xfer(store, &shape);
+    }
+    return 0;
+}
+
+/* Move the landing areas of round between the HOST and every DPU */
+static int push_landing(swap_store_t* store, uint32_t round, int to_dpu) {
+    int ret = 0;
+
+    if (!store->ranks) {
+        return push_group(store, NULL, round, to_dpu);
+    }
+    for (uint32_t r = 0; r < store->nr_ranks; r++) {
+        if (store->ranks[r].state != RANK_ONLINE) continue;
+        if (push_group(store, &store->ranks[r], round, to_dpu) != 0) ret = -1;
+    }
+    if (store->spill_dpu != UINT32_MAX) {
+        store_rank_t spill;
+        memset(&spill, 0, sizeof(spill));
+        spill.first = store->spill_dpu;
+        spill.nr_dpus = 1;
+        if (push_group(store, &spill, round, to_dpu) != 0) ret = -1;
+    }
+    return ret;
+}
+
+/* Jobs of round for the kernel: job j of DPU d is request job_refs[d][j] */
+static void round_jobs(swap_store_t* store, size_t n, uint32_t round, int scatter) {
+    memset(store->nr_jobs, 0, store->nr_dpus * sizeof(uint32_t));
+    for (size_t k = 0; k < n; k++) {
+        const xfer_req_t* req = &store->reqs[k];
+        if (req->round != round) continue;
+
+        uint32_t d = req->dpu;
+        store_job_t* job = &store->jobs[d][store->nr_jobs[d]];
+        job->src = scatter ? req->landing : req->slot;
+        job->dst = scatter ? req->slot : req->landing;
+        job->length = STORE_ALIGN_UP(req->length);
+        job->status = 0;
+        store->job_refs[d][store->nr_jobs[d]++] = (uint32_t)k;
+    }
+}
+
+/* Give back the slots placed for a put batch that is abandoned before
+ * anything was sent */
+static void release_placed(swap_store_t* store, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        store_item_t* it = &store->items[i];
+        if (it->delta_done || (it->flags & PAGE_ZERO) || it->failed) continue;
+        release_record(store, &it->loc);
+    }
+}
+
+/* Put the encoded items: place every record, send them round by round,
+ * then publish. Old copies are only released at the end, so no slot is
+ * the target of two scatter jobs of the same batch. */
+static int put_uniform(swap_store_t* store, const uint64_t* page_ids, size_t n) {
+    size_t nr_reqs = 0;
+    int ret = 0;
+
+    if (reserve_reqs(store, n) != 0) return -1;
+    for (size_t i = 0; i < n; i++) {
+        store_item_t* it = &store->items[i];
+        if (it->delta_done) continue;
+
+        memset(&it->loc, 0, sizeof(it->loc));
+        it->loc.flags = it->flags;
+        it->loc.length = it->length;
+        it->failed = 0;
+        if (it->flags & PAGE_ZERO) continue;
+        if (place_record(store, size_class_of(it->length), &it->loc) != 0) {
+            it->failed = ITEM_NO_SLOT;
+            continue;
+        }
+        store->reqs[nr_reqs].dpu = it->loc.dpu;
+        store->reqs[nr_reqs].slot = it->loc.offset;
+        store->reqs[nr_reqs].length = it->length;
+        nr_reqs++;
+    }
+    if (xfer_plan_build(&store->plan, store->reqs, nr_reqs) != 0) {
+        fprintf(stderr, "ERROR: Failed to plan uniform transfer\n");
+        release_placed(store, n);
+        return -1;
+    }
+
+    /* reqs[k] belongs to the k-th placed item */
+    size_t* req_item = malloc((nr_reqs + 1) * sizeof(size_t));
+    if (!req_item) {
+        release_placed(store, n);
+        return -1;
+    }
+    for (size_t i = 0, k = 0; i < n; i++) {
+        const store_item_t* it = &store->items[i];
+        if (it->delta_done || (it->flags & PAGE_ZERO) || it->failed) continue;
+        req_item[k++] = i;
+    }
+
+    for (uint32_t r = 0; r < store->plan.nr_rounds; r++) {
+        for (size_t k = 0; k < nr_reqs; k++) {
+            const xfer_req_t* req = &store->reqs[k];
+            const store_item_t* it = &store->items[req_item[k]];
+            if (req->round != r) continue;
+            memcpy(store->landing_bufs[req->dpu] + req->landing, item_record(it), req->length);
+        }
+        round_jobs(store, nr_reqs, r, 1);
+        int sent = push_landing(store, r, 1) == 0 && run_kernel(store, STORE_CMD_SCATTER, 0) == 0;
+
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            for (uint32_t j = 0; j < store->nr_jobs[d]; j++) {
+                if (sent && store->jobs[d][j].status == 0) continue;
+                store->items[req_item[store->job_refs[d][j]]].failed = ITEM_NOT_SENT;
+            }
+        }
+        store->stats.uniform_rounds++;
+    }
+    store->stats.uniform_batches++;
+    free(req_item);
+
+    for (size_t i = 0; i < n; i++) {
+        store_item_t* it = &store->items[i];
+        if (it->delta_done) continue;
+        if (it->failed) {
+            if (it->failed == ITEM_NOT_SENT) release_record(store, &it->loc);
+            ret = -1;
+            continue;
+        }
+        if (publish_item(store, page_ids[i], it, it->loc) != 0) ret = -1;
+    }
+    return ret;
+}
+
+/* Read back the records of a get batch through the landing areas: the
+ * kernel gathers them, one push per set and round brings them over. */
+static int get_uniform(swap_store_t* store, const uint64_t* page_ids, uint8_t* const* pages,
+                       size_t n) {
+    size_t nr_reqs = 0;
+    int ret = 0;
+
+    if (reserve_reqs(store, n) != 0) return -1;
+    size_t* req_item = malloc((n + 1) * sizeof(size_t));
+    if (!req_item) return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        const page_entry_t* e = table_find(store, page_ids[i]);
+
+        store->items[i].fetched = 0;
+        if (!e || (e->loc.flags & (PAGE_ZERO | PAGE_DPU_COMPRESSED | PAGE_HUGE))) continue;
+        store->reqs[nr_reqs].dpu = e->loc.dpu;
+        store->reqs[nr_reqs].slot = e->loc.offset;
+        store->reqs[nr_reqs].length = e->loc.length;
+        req_item[nr_reqs++] = i;
+    }
+    if (nr_reqs == 0) {
+        free(req_item);
+        return 0;
+    }
+    if (xfer_plan_build(&store->plan, store->reqs, nr_reqs) != 0) {
+        fprintf(stderr, "ERROR: Failed to plan uniform transfer\n");
+        free(req_item);
+        return -1;
+    }
+
+    for (uint32_t r = 0; r < store->plan.nr_rounds; r++) {
+        round_jobs(store, nr_reqs, r, 0);
+        if (run_kernel(store, STORE_CMD_GATHER, 0) != 0 || push_landing(store, r, 0) != 0) {
+            ret = -1;
+            continue;
+        }
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            for (uint32_t j = 0; j < store->nr_jobs[d]; j++) {
+                const xfer_req_t* req = &store->reqs[store->job_refs[d][j]];
+                size_t i = req_item[store->job_refs[d][j]];
+                store_item_t* it = &store->items[i];
+
+                if (store->jobs[d][j].status != 0) {
+                    store->stats.errors++;
+                    ret = -1;
+                    continue;
+                }
+                const page_entry_t* e = table_find(store, page_ids[i]);
+                uint8_t* buf = (e->loc.flags & PAGE_COMPRESSED) ? it->record : pages[i];
+                memcpy(buf, store->landing_bufs[d] + req->landing, req->length);
+                it->fetched = 1;
+            }
+        }
+        store->stats.uniform_rounds++;
+    }
+    store->stats.uniform_batches++;
+    free(req_item);
+    return ret;
+}
+
+static int put_batch(swap_store_t* store, const uint64_t* page_ids,
+                     const uint8_t* const* pages, size_t n) {
+    int ret = 0;
+
+    if (n == 0) return 0;
+    absorb_ranks(store);
+    if (reserve_items(store, n) != 0) return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        store->items[i].src = pages[i];
+        store->items[i].flags = PAGE_RAW;
+        store->items[i].length = STORE_PAGE_SIZE;
+        store->items[i].delta_done = 0;
+    }
+    if (store->cfg.delta) {
+        put_deltas(store, page_ids, n);
+    }
+
+    if (store->cfg.uniform_xfer) {
+        /* The whole batch is planned at once: encode everything first */
+        if (store->cfg.compress) {
+            if (work_pool_start(&store->pool, encode_item, store, n, n) != 0) {
+                return -1;
+            }
+            for (size_t i = 0; i < n; i++) {
+                work_pool_wait_item(&store->pool, i);
+            }
+            work_pool_finish(&store->pool);
+        }
+        return put_uniform(store, page_ids, n);
+    }
+
+    if (!store->cfg.compress) {
+        for (size_t i = 0; i < n; i++) {
+            if (store->items[i].delta_done) continue;
+            if (store_item(store, page_ids[i], &store->items[i]) != 0) ret = -1;
+        }
+        return ret;
+    }
+
+    /* Workers encode ahead while this thread ships finished pages */
+    if (work_pool_start(&store->pool, encode_item, store, n, n) != 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        work_pool_wait_item(&store->pool, i);
+        if (store->items[i].delta_done) continue;
+        if (store_item(store, page_ids[i], &store->items[i]) != 0) ret = -1;
+    }
+    work_pool_finish(&store->pool);
+    return ret;
+}
+
+/* Pages compressed by the DPUs are decompressed into page_staging by the
+ * kernel and read back plain, STORE_STAGING_PAGES per DPU per launch. */
+static int get_dpu_compressed(swap_store_t* store, const uint64_t* page_ids,
+                              uint8_t* const* pages, size_t n) {
+    size_t next = 0;
+    int ret = 0;
+
+    while (next < n) {
+        size_t i;
+
+        memset(store->nr_jobs, 0, store->nr_dpus * sizeof(uint32_t));
+        for (i = next; i < n; i++) {
+            page_entry_t* e = table_find(store, page_ids[i]);
+            if (!e || !(e->loc.flags & PAGE_DPU_COMPRESSED)) continue;
+
+            uint32_t d = e->loc.dpu;
+            uint32_t j = store->nr_jobs[d];
+            if (j == STORE_STAGING_PAGES) break;
+
+            store->jobs[d][j].src = e->loc.offset;
+            store->jobs[d][j].dst = j * STORE_PAGE_SIZE;
+            store->jobs[d][j].length = e->loc.length;
+            store->jobs[d][j].status = 0;
+            store->job_refs[d][j] = (uint32_t)i;
+            store->nr_jobs[d]++;
+        }
+        next = i;
+
+        if (run_kernel(store, STORE_CMD_DECOMPRESS, 0) != 0) {
+            return -1;
+        }
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            for (uint32_t j = 0; j < store->nr_jobs[d]; j++) {
+                uint8_t* dst = pages[store->job_refs[d][j]];
+                if (store->jobs[d][j].status != 0 ||
+                    dpu_xfer_symbol(store, d, 0, STORE_STAGING_SYMBOL, j * STORE_PAGE_SIZE,
+                                    dst, STORE_PAGE_SIZE) != 0) {
+                    fprintf(stderr, "ERROR: DPU decompression failed\n");
+                    memset(dst, 0, STORE_PAGE_SIZE);
+                    store->stats.errors++;
+                    ret = -1;
+                    continue;
+                }
+                store->stats.bus_bytes_from_dpu += STORE_PAGE_SIZE;
+                store->stats.dpu_decompressed_pages++;
+            }
+        }
+    }
+    return ret;
+}
+
+static int get_batch(swap_store_t* store, const uint64_t* page_ids,
+                     uint8_t* const* pages, size_t n) {
+    int ret = 0;
+    size_t nr_dpu_compressed = 0;
+
+    if (n == 0) return 0;
+    absorb_ranks(store);
+    if (reserve_items(store, n) != 0) return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        const page_entry_t* e = table_find(store, page_ids[i]);
+        if (e && (e->loc.flags & PAGE_DPU_COMPRESSED)) nr_dpu_compressed++;
+    }
+    if (nr_dpu_compressed > 0 && get_dpu_compressed(store, page_ids, pages, n) != 0) {
+        ret = -1;
+    }
+    if (store->cfg.uniform_xfer && get_uniform(store, page_ids, pages, n) != 0) {
+        ret = -1;
+    }
+
+    /* Items are released to the decompression workers as they arrive */
+    if (work_pool_start(&store->pool, decode_item, store, n, 0) != 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        store_item_t* it = &store->items[i];
+        page_entry_t* e = table_find(store, page_ids[i]);
+
+        it->dst = pages[i];
+        it->flags = PAGE_RAW;
+        if (!e) {
+            fprintf(stderr, "ERROR: page %llu not in store\n", (unsigned long long)page_ids[i]);
+            memset(pages[i], 0, STORE_PAGE_SIZE);
+            ret = -1;
+        } else if (e->loc.flags & PAGE_HUGE) {
+            fprintf(stderr, "ERROR: page %llu is a huge page\n", (unsigned long long)page_ids[i]);
+            memset(pages[i], 0, STORE_PAGE_SIZE);
+            ret = -1;
+        } else if (e->loc.flags & PAGE_ZERO) {
+            memset(pages[i], 0, STORE_PAGE_SIZE);
+        } else if (e->loc.flags & PAGE_DPU_COMPRESSED) {
+            /* Already read back by get_dpu_compressed() */
+        } else if (store->cfg.uniform_xfer && it->fetched) {
+            /* Already read back by get_uniform() */
+            it->flags = e->loc.flags;
+            it->length = e->loc.length;
+        } else {
+            uint8_t* buf = (e->loc.flags & PAGE_COMPRESSED) ? it->record : pages[i];
+            if (mram_read_record(store, e->loc.dpu, e->loc.offset, buf, e->loc.length) != 0) {
+                ret = -1;
+            } else {
+                it->flags = e->loc.flags;
+                it->length = e->loc.length;
+            }
+        }
+        store->stats.gets++;
+        work_pool_open_gate(&store->pool, i + 1);
+    }
+    work_pool_finish(&store->pool);
+    return ret;
+}
+
+static int invalidate(swap_store_t* store, uint64_t page_id) {
+    page_entry_t* e = table_find(store, page_id);
+    if (!e) {
+        return -1;
+    }
+    release_record(store, &e->loc);
+    table_remove(store, e);
+    return 0;
+}
+
+static int put_huge(swap_store_t* store, uint64_t page_id, const uint8_t* page) {
+    page_loc_t loc = {0};
+    page_entry_t* e;
+
+    if (!store->huge) {
+        fprintf(stderr, "ERROR: huge pages need cfg.huge_mram_size\n");
+        return -1;
+    }
+    absorb_ranks(store);
+    if (huge_place(store, &loc) != 0) {
+        return -1;
+    }
+    if (huge_xfer(store, &loc, (uint8_t*)page, 1) != 0) {
+        release_record(store, &loc);
+        return -1;
+    }
+    e = publish_loc(store, page_id, &loc);
+    if (!e) {
+        return -1;
+    }
+    set_line_hashes(e, NULL);
+    store->stats.huge_puts++;
+    return 0;
+}
+
+static int get_huge(swap_store_t* store, uint64_t page_id, uint8_t* page) {
+    const page_entry_t* e;
+
+    absorb_ranks(store);
+    e = table_find(store, page_id);
+    if (!e || !(e->loc.flags & PAGE_HUGE)) {
+        fprintf(stderr, "ERROR: huge page %llu not in store\n", (unsigned long long)page_id);
+        return -1;
+    }
+    if (huge_xfer(store, &e->loc, page, 0) != 0) {
+        return -1;
+    }
+    store->stats.huge_gets++;
+    return 0;
+}
+
+/* API calls, timed into the metrics */
+
+int swap_store_put_batch(swap_store_t* store, const uint64_t* page_ids,
+                         const uint8_t* const* pages, size_t n) {
+    uint64_t start = metrics_start(store);
+    int ret = put_batch(store, page_ids, pages, n);
+
+    metrics_end(store, SWAP_METRICS_PUT, n, (uint64_t)n * STORE_PAGE_SIZE, start, ret);
+    return ret;
+}
+
+int swap_store_get_batch(swap_store_t* store, const uint64_t* page_ids,
+                         uint8_t* const* pages, size_t n) {
+    uint64_t start = metrics_start(store);
+    int ret = get_batch(store, page_ids, pages, n);
+
+    metrics_end(store, SWAP_METRICS_GET, n, (uint64_t)n * STORE_PAGE_SIZE, start, ret);
+    return ret;
+}
+
+int swap_store_put(swap_store_t* store, uint64_t page_id, const uint8_t* page) {
+    return swap_store_put_batch(store, &page_id, &page, 1);
+}
+
+int swap_store_get(swap_store_t* store, uint64_t page_id, uint8_t* page) {
+    return swap_store_get_batch(store, &page_id, &page, 1);
+}
+
+int swap_store_invalidate(swap_store_t* store, uint64_t page_id) {
+    uint64_t start = metrics_start(store);
+    int ret = invalidate(store, page_id);
+
+    metrics_end(store, SWAP_METRICS_INVALIDATE, 1, 0, start, ret);
+    return ret;
+}
+
+int swap_store_put_huge(swap_store_t* store, uint64_t page_id, const uint8_t* page) {
+    uint64_t start = metrics_start(store);
+    int ret = put_huge(store, page_id, page);
+
+    metrics_end(store, SWAP_METRICS_HUGE_PUT, 1, STORE_HUGE_PAGE_SIZE, start, ret);
+    return ret;
+}
+
+int swap_store_get_huge(swap_store_t* store, uint64_t page_id, uint8_t* page) {
+    uint64_t start = metrics_start(store);
+    int ret = get_huge(store, page_id, page);
+
+    metrics_end(store, SWAP_METRICS_HUGE_GET, 1, STORE_HUGE_PAGE_SIZE, start, ret);
+    return ret;
+}
+
+int swap_store_broadcast(swap_store_t* store, uint32_t offset, const void* buf,
+                         uint32_t length) {
+    int ret = 0;
+
+    if (offset % STORE_XFER_ALIGN || length % STORE_XFER_ALIGN ||
+        offset + (uint64_t)length > STORE_SHARED_SIZE) {
+        fprintf(stderr, "ERROR: shared_area write of %u bytes at %u out of bounds\n", length,
+                offset);
+        return -1;
+    }
+    if (length == 0) return 0;
+    absorb_ranks(store);
+
+    if (!store->ranks) {
+        return replicate_group(store, NULL, STORE_SHARED_SYMBOL, offset, buf, length);
+    }
+    if (!store->shared) {
+        store->shared = calloc(1, STORE_SHARED_SIZE);
+        if (!store->shared) return -1;
+    }
+    memcpy(store->shared + offset, buf, length);
+    if (offset + length > store->shared_used) store->shared_used = offset + length;
+
+    for (uint32_t r = 0; r < store->nr_ranks; r++) {
+        if (store->ranks[r].state != RANK_ONLINE) continue;
+        if (replicate_group(store, &store->ranks[r], STORE_SHARED_SYMBOL, offset, buf,
+                            length) != 0) {
+            ret = -1;
+        }
+    }
+    memcpy(store->ram_shared[store->spill_dpu] + offset, buf, length);
+    return ret;
+}
+
+int swap_store_read_shared(swap_store_t* store, uint32_t d, uint32_t offset, void* buf,
+                           uint32_t length) {
+    if (d >= store->nr_dpus || offset % STORE_XFER_ALIGN || length % STORE_XFER_ALIGN ||
+        offset + (uint64_t)length > STORE_SHARED_SIZE) {
+        return -1;
+    }
+    if (store->ranks && d != store->spill_dpu && !store->dpu_online[d]) {
+        return -1;
+    }
+    return dpu_xfer_symbol(store, d, 0, STORE_SHARED_SYMBOL, offset, buf, length);
+}
+
+/* Give the tail of a slot whose record shrank back to the allocator */
+static void shrink_record(swap_store_t* store, page_loc_t* loc, uint32_t length) {
+    uint8_t cls = size_class_of(length);
+    uint32_t old_bytes = STORE_CLASS_BYTES(loc->size_class);
+    uint32_t new_bytes = STORE_CLASS_BYTES(cls);
+
+    if (new_bytes < old_bytes) {
+        dpu_space_t* space = &store->space[loc->dpu];
+        /* The tail is itself a valid slot: offsets are multiples of the class size */
+        space_release(space, (uint8_t)((old_bytes - new_bytes) / STORE_CLASS_SIZE - 1),
+                      loc->offset + new_bytes);
+        loc->size_class = cls;
+    }
+    loc->length = (uint16_t)length;
+}
+
+int swap_store_dpu_compress(swap_store_t* store, uint32_t max_per_dpu,
+                            uint32_t* nr_compressed) {
+    uint32_t total = 0;
+    uint32_t compressed = 0;
+
+    if (nr_compressed) *nr_compressed = 0;
+    if (max_per_dpu > STORE_MAX_JOBS) max_per_dpu = STORE_MAX_JOBS;
+    absorb_ranks(store);
+    memset(store->nr_jobs, 0, store->nr_dpus * sizeof(uint32_t));
+
+    /* Candidates: raw pages the kernel has not tried yet */
+    for (uint32_t i = 0; i <= store->table_mask; i++) {
+        const page_entry_t* e = &store->table[i];
+        if (e->state != ENTRY_USED || e->loc.flags != PAGE_RAW) continue;
+
+        uint32_t d = e->loc.dpu;
+        uint32_t j = store->nr_jobs[d];
+        if (j == max_per_dpu) continue;
+
+        store->jobs[d][j].src = e->loc.offset;
+        store->jobs[d][j].dst = 0;
+        store->jobs[d][j].length = 0;
+        store->jobs[d][j].status = 0;
+        store->job_refs[d][j] = i;
+        store->nr_jobs[d]++;
+        total++;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    if (run_kernel(store, STORE_CMD_COMPRESS, store->cfg.compress_threshold) != 0) {
+        return -1;
+    }
+
+    /* The kernel is done with the slots: publish the new metadata */
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        for (uint32_t j = 0; j < store->nr_jobs[d]; j++) {
+            page_entry_t* e = &store->table[store->job_refs[d][j]];
+            const store_job_t* job = &store->jobs[d][j];
+
+            if (job->status == 0 && job->length > 0) {
+                shrink_record(store, &e->loc, job->length);
+                e->loc.flags = PAGE_DPU_COMPRESSED;
+                set_line_hashes(e, NULL);
+                compressed++;
+            } else {
+                e->loc.flags |= PAGE_INCOMPRESSIBLE;
+            }
+        }
+    }
+    store->stats.dpu_compressed_pages += compressed;
+    if (nr_compressed) *nr_compressed = compressed;
+    return (int)total;
+}
+
+/* ========================================================================
+ * MRAM compaction
+ * ======================================================================== */
+
+#define COMPACT_FIRST_ROUND 16      /* moves per DPU before any timing is known */
+
+typedef struct {
+    uint32_t dpu;
+    uint32_t offset;
+    uint32_t bytes;                 /* slot size */
+    uint32_t entry;                 /* index in store->table */
+} slot_ref_t;
+
+/* One stable pass of the radix sort, on a byte of the slot index */
+static void radix_pass(const slot_ref_t* in, slot_ref_t* out, uint32_t n, uint32_t shift) {
+    uint32_t pos[256] = {0};
+    uint32_t sum = 0;
+
+    for (uint32_t k = 0; k < n; k++) {
+        pos[(in[k].offset / STORE_CLASS_SIZE >> shift) & 0xFF]++;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+        uint32_t c = pos[b];
+        pos[b] = sum;
+        sum += c;
+    }
+    for (uint32_t k = 0; k < n; k++) {
+        out[pos[(in[k].offset / STORE_CLASS_SIZE >> shift) & 0xFF]++] = in[k];
+    }
+}
+
+/* Live slots of every DPU, in table order */
+static uint32_t collect_slots(const swap_store_t* store, slot_ref_t* refs) {
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i <= store->table_mask; i++) {
+        const page_entry_t* e = &store->table[i];
+        if (e->state != ENTRY_USED || (e->loc.flags & (PAGE_ZERO | PAGE_HUGE))) continue;
+        refs[n].dpu = e->loc.dpu;
+        refs[n].offset = e->loc.offset;
+        refs[n].bytes = STORE_CLASS_BYTES(e->loc.size_class);
+        refs[n].entry = i;
+        n++;
+    }
+    return n;
+}
+
+/* Sort refs by (dpu, offset); DPU d then owns refs[first[d] .. first[d + 1]).
+ * Radix sort: slot indexes fit in 16 bits (STORE_MRAM_SIZE / STORE_CLASS_SIZE),
+ * and the last pass, by DPU, gives each DPU's range. */
+static void sort_slots(const swap_store_t* store, slot_ref_t* refs, slot_ref_t* tmp,
+                       uint32_t n, uint32_t* first, uint32_t* pos) {
+    radix_pass(refs, tmp, n, 0);
+    radix_pass(tmp, refs, n, 8);
+
+    memset(first, 0, (store->nr_dpus + 1) * sizeof(uint32_t));
+    for (uint32_t k = 0; k < n; k++) {
+        first[refs[k].dpu + 1]++;
+    }
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        first[d + 1] += first[d];
+        pos[d] = first[d];
+    }
+    for (uint32_t k = 0; k < n; k++) {
+        tmp[pos[refs[k].dpu]++] = refs[k];
+    }
+    memcpy(refs, tmp, n * sizeof(slot_ref_t));
+}
+
+/* Rebuild the free lists of a DPU from its live slots: every gap is cut
+ * into the largest slots that fit, and top drops to the last live slot */
+static void rebuild_space(dpu_space_t* space, const slot_ref_t* refs, uint32_t n) {
+    uint32_t pos = 0;
+
+    memset(space->nr_free, 0, sizeof(space->nr_free));
+    for (uint32_t k = 0; k <= n; k++) {
+        uint32_t end = (k < n) ? refs[k].offset : pos;
+        while (pos < end) {
+            uint32_t classes = (end - pos) / STORE_CLASS_SIZE;
+            uint8_t cls = (uint8_t)((classes > STORE_NR_CLASSES ? STORE_NR_CLASSES : classes) - 1);
+            free_list_push(space, cls, pos);
+            pos += STORE_CLASS_BYTES(cls);
+        }
+        if (k < n) pos = refs[k].offset + refs[k].bytes;
+    }
+    space->top = pos;
+}
+
+/* Plan up to max_moves moves for DPU d, whose slots are refs[base .. base + n):
+ * from the highest slot down, each record goes to the lowest gap below it
+ * that fits. Destinations are free and sources are only released after the
+ * launch, so jobs never overlap. job_refs holds the index in refs. */
+static uint32_t plan_moves(swap_store_t* store, uint32_t d, const slot_ref_t* refs,
+                           uint32_t base, uint32_t n, uint32_t max_moves,
+                           uint32_t* gap_start, uint32_t* gap_end) {
+    uint32_t nr_gaps = 0, pos = 0, first_gap = 0;
+    uint32_t nr_moves = 0;
+
+    refs += base;
+    for (uint32_t k = 0; k < n; k++) {
+        if (refs[k].offset > pos) {
+            gap_start[nr_gaps] = pos;
+            gap_end[nr_gaps] = refs[k].offset;
+            nr_gaps++;
+        }
+        pos = refs[k].offset + refs[k].bytes;
+    }
+
+    for (uint32_t k = n; k-- > 0 && nr_moves < max_moves;) {
+        const slot_ref_t* r = &refs[k];
+
+        while (first_gap < nr_gaps && gap_start[first_gap] == gap_end[first_gap]) {
+            first_gap++;
+        }
+        if (first_gap == nr_gaps || gap_start[first_gap] >= r->offset) {
+            break;      /* everything below is packed */
+        }
+        for (uint32_t g = first_gap; g < nr_gaps && gap_start[g] < r->offset; g++) {
+            if (gap_end[g] - gap_start[g] < r->bytes) continue;
+
+            store_job_t* job = &store->jobs[d][nr_moves];
+            job->src = r->offset;
+            job->dst = gap_start[g];
+            job->length = STORE_ALIGN_UP(store->table[r->entry].loc.length);
+            job->status = 0;
+            store->job_refs[d][nr_moves] = base + k;
+            nr_moves++;
+            gap_start[g] += r->bytes;
+            break;
+        }
+    }
+    return nr_moves;
+}
+
+/* The table is scanned once per call; after each round the moved slots
+ * are patched in refs and re-sorted, which is O(n) without the scan. The
+ * first round always runs so every call makes progress. */
+int swap_store_compact(swap_store_t* store) {
+    uint64_t budget_ns = (uint64_t)store->cfg.compact_budget_us * 1000;
+    uint64_t start = now_ns();
+    uint32_t moves_per_dpu = budget_ns ? COMPACT_FIRST_ROUND : STORE_MAX_JOBS;
+    uint32_t slots = store->nr_pages + 1;
+    slot_ref_t* refs = malloc(slots * sizeof(slot_ref_t));
+    slot_ref_t* tmp = malloc(slots * sizeof(slot_ref_t));
+    uint32_t* gap_start = malloc(slots * sizeof(uint32_t));
+    uint32_t* gap_end = malloc(slots * sizeof(uint32_t));
+    uint32_t* first = malloc((store->nr_dpus + 1) * sizeof(uint32_t));
+    uint32_t* pos = malloc(store->nr_dpus * sizeof(uint32_t));
+    int total = 0;
+
+    if (!refs || !tmp || !gap_start || !gap_end || !first || !pos) {
+        fprintf(stderr, "ERROR: Failed to allocate compaction plan\n");
+        total = -1;
+        goto out;
+    }
+
+    uint32_t n = collect_slots(store, refs);
+    sort_slots(store, refs, tmp, n, first, pos);
+    for (;;) {
+        uint32_t max_jobs = 0;
+
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            rebuild_space(&store->space[d], refs + first[d], first[d + 1] - first[d]);
+        }
+        if (moves_per_dpu == 0) {
+            break;
+        }
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            store->nr_jobs[d] = plan_moves(store, d, refs, first[d], first[d + 1] - first[d],
+                                           moves_per_dpu, gap_start, gap_end);
+            if (store->nr_jobs[d] > max_jobs) max_jobs = store->nr_jobs[d];
+        }
+        if (max_jobs == 0) {
+            break;
+        }
+
+        uint64_t t_launch = now_ns();
+        if (run_kernel(store, STORE_CMD_MOVE, 0) != 0) {
+            total = -1;
+            break;      /* no metadata changed, the rebuilt free lists stand */
+        }
+        store->stats.compact_rounds++;
+        store->stats.compact_ns += now_ns() - t_launch;
+
+        /* Completion: a record only changes place once its move succeeded */
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            for (uint32_t j = 0; j < store->nr_jobs[d]; j++) {
+                const store_job_t* job = &store->jobs[d][j];
+                slot_ref_t* r = &refs[store->job_refs[d][j]];
+                if (job->status != 0) {
+                    store->stats.errors++;
+                    continue;
+                }
+                store->table[r->entry].loc.offset = job->dst;
+                r->offset = job->dst;
+                store->stats.compact_moves++;
+                store->stats.compact_bytes += job->length;
+                total++;
+            }
+        }
+        sort_slots(store, refs, tmp, n, first, pos);
+
+        /* Size the next round to what is left of the budget */
+        if (budget_ns) {
+            uint64_t t_done = now_ns();
+            uint64_t per_move = (t_done - t_launch) / max_jobs + 1;
+            uint64_t elapsed = t_done - start;
+            uint64_t moves = elapsed < budget_ns ? (budget_ns - elapsed) / per_move : 0;
+            moves_per_dpu = moves > STORE_MAX_JOBS ? STORE_MAX_JOBS : (uint32_t)moves;
+        }
+    }
+
+out:
+    free(refs);
+    free(tmp);
+    free(gap_start);
+    free(gap_end);
+    free(first);
+    free(pos);
+    return total;
+}
+
+/* ========================================================================
+ * Near-data scan
+ * ======================================================================== */
+
+/* The predicate goes to every DPU before the launch */
+static int send_scan(swap_store_t* store) {
+#ifdef HAVE_DPU_H
+    if (store->dpu_backed && !store->ranks) {
+        return replicate_set(store, store->dpu_set, store->nr_dpus, STORE_SCAN_SYMBOL, 0,
+                             &store->scan, sizeof(store_scan_t));
+    }
+    if (store->dpu_backed) {
+        for (uint32_t r = 0; r < store->nr_ranks; r++) {
+            const store_rank_t* rank = &store->ranks[r];
+            if (rank->state != RANK_ONLINE) continue;
+            if (replicate_set(store, rank->set, rank->nr_dpus, STORE_SCAN_SYMBOL, 0,
+                              &store->scan, sizeof(store_scan_t)) != 0) {
+                return -1;
+            }
+        }
+    }
+#else
+    (void)store;
+#endif
+    return 0;
+}
+
+/* Add a matching page to res, with its records: host_records, or read
+ * back from page_staging of DPU d at offset */
+static int add_match(swap_store_t* store, swap_scan_result_t* res, uint64_t page_id,
+                     uint32_t matches, const uint8_t* host_records, uint32_t d, uint32_t offset) {
+    size_t bytes = (size_t)matches * scan_record_size(&store->scan);
+
+    res->page_ids[res->nr_pages] = page_id;
+    res->matches[res->nr_pages] = matches;
+    res->nr_pages++;
+    if (!store->scan.want_records) {
+        return 0;
+    }
+    if (!res->records || res->records_bytes + bytes > res->records_cap) {
+        res->truncated = 1;
+        return 0;
+    }
+    uint8_t* dst = res->records + res->records_bytes;
+    if (host_records) {
+        memcpy(dst, host_records, bytes);
+    } else {
+        if (dpu_xfer_symbol(store, d, 0, STORE_STAGING_SYMBOL, offset, dst, bytes) != 0) {
+            return -1;
+        }
+        store->stats.bus_bytes_from_dpu += bytes;
+        store->stats.scan_returned_bytes += bytes;
+    }
+    res->records_bytes += bytes;
+    return 0;
+}
+
+/* Pages the DPUs cannot read: all zero, or compressed by the HOST */
+static int scan_on_host(swap_store_t* store, uint64_t page_id, const page_loc_t* loc,
+                        swap_scan_result_t* res) {
+    uint8_t page[STORE_PAGE_SIZE], out[STORE_PAGE_SIZE];
+    uint8_t record[STORE_PAGE_SIZE];
+
+    if (loc->flags & PAGE_ZERO) {
+        memset(page, 0, STORE_PAGE_SIZE);
+    } else {
+        if (mram_read_record(store, loc->dpu, loc->offset, record, loc->length) != 0) {
+            return -1;
+        }
+        store->stats.scan_returned_bytes += STORE_ALIGN_UP(loc->length);
+        if (page_decompress(record, loc->length, page, STORE_PAGE_SIZE) != STORE_PAGE_SIZE) {
+            fprintf(stderr, "ERROR: corrupted compressed page\n");
+            store->stats.errors++;
+            return -1;
+        }
+    }
+    store->stats.scan_host_pages++;
+
+    uint32_t matches = scan_page(&store->scan, page, store->scan.want_records ? out : NULL);
+    return matches ? add_match(store, res, page_id, matches, out, 0, 0) : 0;
+}
+
+int swap_store_scan(swap_store_t* store, const store_scan_t* scan, const uint64_t* page_ids,
+                    size_t n, swap_scan_result_t* res) {
+    /* Matching records of job j land at j * STORE_PAGE_SIZE in page_staging */
+    uint32_t per_launch = scan->want_records ? STORE_STAGING_PAGES : STORE_MAX_JOBS;
+    size_t next = 0;
+    int ret = 0;
+
+    res->nr_pages = 0;
+    res->records_bytes = 0;
+    res->truncated = 0;
+    if (scan_check(scan) != 0) {
+        fprintf(stderr, "ERROR: invalid scan predicate\n");
+        return -1;
+    }
+    absorb_ranks(store);
+    store->scan = *scan;
+    if (send_scan(store) != 0) {
+        return -1;
+    }
+    store->stats.scans++;
+
+    while (next < n) {
+        size_t i;
+
+        memset(store->nr_jobs, 0, store->nr_dpus * sizeof(uint32_t));
+        for (i = next; i < n; i++) {
+            const page_entry_t* e = table_find(store, page_ids[i]);
+            if (!e || (e->loc.flags & PAGE_HUGE)) continue;     /* not scanned */
+
+            if (e->loc.flags & (PAGE_ZERO | PAGE_COMPRESSED)) {
+                store->stats.scan_pages++;
+                if (scan_on_host(store, page_ids[i], &e->loc, res) != 0) ret = -1;
+                continue;
+            }
+            uint32_t d = e->loc.dpu;
+            uint32_t j = store->nr_jobs[d];
+            if (j == per_launch) break;
+
+            store->jobs[d][j].src = e->loc.offset;
+            store->jobs[d][j].dst = scan->want_records ? j * STORE_PAGE_SIZE : 0;
+            if (e->loc.flags & PAGE_DPU_COMPRESSED) {
+                store->jobs[d][j].dst |= STORE_SCAN_COMPRESSED;
+            }
+            store->jobs[d][j].length = e->loc.length;
+            store->jobs[d][j].status = 0;
+            store->job_refs[d][j] = (uint32_t)i;
+            store->nr_jobs[d]++;
+            store->stats.scan_pages++;
+        }
+        next = i;
+
+        if (run_kernel(store, STORE_CMD_SCAN, 0) != 0) {
+            return -1;
+        }
+        for (uint32_t d = 0; d < store->nr_dpus; d++) {
+            for (uint32_t j = 0; j < store->nr_jobs[d]; j++) {
+                const store_job_t* job = &store->jobs[d][j];
+
+                /* The job entry itself is the answer */
+                store->stats.scan_returned_bytes += sizeof(store_job_t);
+                if (job->status != 0) {
+                    fprintf(stderr, "ERROR: DPU scan failed\n");
+                    store->stats.errors++;
+                    ret = -1;
+                    continue;
+                }
+                if (job->length > 0 &&
+                    add_match(store, res, page_ids[store->job_refs[d][j]], job->length, NULL,
+                              d, j * STORE_PAGE_SIZE) != 0) {
+                    ret = -1;
+                }
+            }
+        }
+    }
+    return ret < 0 ? -1 : (int)res->nr_pages;
+}
+
+double swap_store_fragmentation(const swap_store_t* store) {
+    uint64_t free_bytes = 0, usable = 0;
+    const uint32_t full = STORE_CLASS_BYTES(STORE_NR_CLASSES - 1);
+
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        const dpu_space_t* space = &store->space[d];
+        free_bytes += store->cfg.mram_size - space->used_bytes;
+        usable += (uint64_t)space->nr_free[STORE_NR_CLASSES - 1] * full;
+        usable += (uint64_t)((store->cfg.mram_size - space->top) / full) * full;
+    }
+    return free_bytes ? 1.0 - (double)usable / free_bytes : 0.0;
+}
+
+int swap_store_bind_thread(const swap_store_t* store) {
+    if (!store->cfg.numa || store->home_node < 0) {
+        return -1;
+    }
+    return numa_topo_bind_thread(pthread_self(), store->home_node);
+}
+
+const page_loc_t* swap_store_lookup(const swap_store_t* store, uint64_t page_id) {
+    const page_entry_t* e = table_find(store, page_id);
+    return e ? &e->loc : NULL;
+}
+
+uint64_t swap_store_mram_used(const swap_store_t* store) {
+    uint64_t total = 0;
+    for (uint32_t d = 0; d < store->nr_dpus; d++) {
+        total += store->space[d].used_bytes;
+    }
+    for (uint32_t g = 0; g < store->nr_huge; g++) {
+        total += (uint64_t)store->huge[g].nr_pages * STORE_HUGE_PAGE_SIZE;
+    }
+    return total;
+}
@@ -0,0 +1,394 @@
+#ifndef __UPMEM_SWAP_STORE_H__
+#define __UPMEM_SWAP_STORE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cost_model.h"
+#include "swap_metrics.h"
+#include "swap_protocol.h"
+#include "work_pool.h"
+#include "xfer_plan.h"
+
+#ifdef HAVE_DPU_H
+#include <dpu.h>
+#endif
+
+/*
+ * Page store: keeps 4KB pages in the MRAM of a set of DPUs.
+ *
+ * The HOST owns all metadata (page id -> DPU, MRAM offset, length). MRAM
+ * is carved into size-classed slots so that compressed pages only use
+ * the space they need. Without the SDK, or when DPU allocation fails,
+ * the store runs on host memory (same fallback as main.c), optionally
+ * charging the time the DPUs would have taken (cfg.cost_model).
+ */
+
+/* Slot size classes: 512B steps up to a full page */
+#define STORE_NR_CLASSES 8
+#define STORE_CLASS_SIZE (STORE_PAGE_SIZE / STORE_NR_CLASSES)
+#define STORE_CLASS_BYTES(c) (((uint32_t)(c) + 1) * STORE_CLASS_SIZE)
+
+/* Default: only keep the compressed form if it saves at least 25% */
+#define STORE_DEFAULT_THRESHOLD (STORE_PAGE_SIZE * 3 / 4)
+
+/* DPUs of a full UPMEM DIMM rank */
+#define STORE_DPUS_PER_RANK 64
+
+/* Default: a re-put is sent as a delta if at most a quarter of its lines changed */
+#define STORE_DEFAULT_DELTA_LINES (STORE_LINES_PER_PAGE / 4)
+
+/* page_loc_t.flags */
+#define PAGE_RAW        0x0
+#define PAGE_COMPRESSED 0x1
+#define PAGE_ZERO       0x2     /* all zero: no slot, nothing on the bus */
+#define PAGE_DPU_COMPRESSED 0x4 /* compressed in MRAM by the DPU kernel */
+#define PAGE_INCOMPRESSIBLE 0x8 /* DPU kernel tried and gave up */
+#define PAGE_HUGE       0x10    /* 2MB page striped over a rank: dpu is the rank,
+                                 * offset the stripe offset in huge_store */
+
+typedef struct {
+    uint32_t dpu;           /* index into the store's DPU array */
+    uint32_t offset;        /* byte offset in page_store */
+    uint16_t length;        /* record length (compressed size or 4096) */
+    uint8_t size_class;
+    uint8_t flags;
+} page_loc_t;
+
+typedef struct {
+    uint64_t page_id;
+    page_loc_t loc;
+    uint8_t state;          /* 0 = empty, 1 = used, 2 = deleted */
+    uint64_t* line_hashes;  /* hashes of the plain page in MRAM (delta puts) */
+    uint32_t seen_batch;    /* last put batch naming this page */
+    uint32_t seen_count;    /* times it appears in that batch */
+} page_entry_t;
+
+/* Free stripes of one rank's huge_store: a huge page takes stripe bytes
+ * at the same offset on each of the rank's first nr_dpus DPUs */
+typedef struct {
+    uint32_t nr_dpus;               /* power of two, 0 = rank not set up yet */
+    uint32_t stripe;
+    uint32_t top;                   /* bump allocator */
+    uint32_t* free_slots;           /* recycled stripe offsets */
+    uint32_t nr_free;
+    uint32_t nr_pages;              /* huge pages stored */
+} huge_space_t;
+
+/* Free space of one DPU's page_store */
+typedef struct {
+    uint32_t top;                               /* bump allocator */
+    uint32_t* free_slots[STORE_NR_CLASSES];     /* recycled slots per class */
+    uint32_t nr_free[STORE_NR_CLASSES];
+    uint32_t cap_free[STORE_NR_CLASSES];
+    uint64_t used_bytes;
+} dpu_space_t;
+
+typedef struct {
+    uint64_t puts;
+    uint64_t gets;
+    uint64_t raw_pages;
+    uint64_t compressed_pages;
+    uint64_t zero_pages;
+    uint64_t page_bytes;            /* uncompressed bytes put */
+    uint64_t record_bytes;          /* bytes of the records produced for them */
+    uint64_t bus_bytes_to_dpu;
+    uint64_t bus_bytes_from_dpu;
+    uint64_t control_bytes;         /* kernel arguments and job lists */
+    uint64_t kernel_launches;
+    uint64_t dpu_compressed_pages;
+    uint64_t dpu_decompressed_pages;
+    uint64_t delta_candidates;      /* re-puts of a page stored plain */
+    uint64_t delta_pages;           /* ... sent as a delta */
+    uint64_t delta_bytes;           /* patch bytes sent for them */
+    uint64_t delta_saved_bytes;     /* full-page bytes not sent */
+    uint64_t compact_rounds;        /* compaction kernel launches */
+    uint64_t compact_moves;         /* records moved inside MRAM */
+    uint64_t compact_bytes;
+    uint64_t compact_ns;            /* time spent in those launches */
+    uint64_t local_puts;            /* numa: pages placed on a home node rank */
+    uint64_t remote_puts;           /* ... on another node, home ranks full */
+    uint64_t ranks_online;          /* lazy_ranks: ranks brought up */
+    uint64_t ranks_failed;
+    uint64_t first_rank_ns;         /* swap_store_init() to the first rank online */
+    uint64_t full_capacity_ns;      /* ... to the last rank settled */
+    uint64_t spilled_pages;         /* pages put to host memory before ranks had room */
+    uint64_t migrated_pages;        /* ... moved to a rank since */
+    uint64_t pushes;                /* HOST<->MRAM transfer calls (one per set when uniform) */
+    uint64_t uniform_batches;       /* uniform_xfer: batches through the landing area */
+    uint64_t uniform_rounds;        /* ... landing areas filled */
+    uint64_t padding_bytes;         /* ... pushed past the end of a DPU's records */
+    uint64_t broadcasts;            /* broadcast_xfer: dpu_broadcast_to calls */
+    uint64_t replicated_bytes;      /* same bytes written to several DPUs, summed per DPU */
+    uint64_t scans;                 /* swap_store_scan() calls */
+    uint64_t scan_pages;            /* pages evaluated */
+    uint64_t scan_host_pages;       /* ... by the HOST (zero pages, HOST-compressed pages) */
+    uint64_t scan_returned_bytes;   /* bytes read back for scans: results, records */
+    uint64_t huge_puts;             /* 2MB pages put (not counted in puts) */
+    uint64_t huge_gets;
+    uint64_t model_xfer_ns;         /* cost model: modeled time of the transfers */
+    uint64_t model_launch_ns;       /* ... of the kernel launches */
+    uint64_t errors;
+} swap_store_stats_t;
+
+typedef struct {
+    uint32_t nr_dpus;
+    const char* profile;
+    const char* dpu_binary;
+    uint32_t mram_size;             /* bytes of page_store used per DPU */
+    uint32_t max_pages;
+    int compress;                   /* enable the compression stage */
+    uint32_t compress_threshold;    /* max compressed size worth keeping */
+    int nr_workers;                 /* compression threads (0 = inline) */
+    int delta;                      /* send re-puts of raw pages as deltas */
+    uint32_t delta_max_lines;       /* max changed lines for a delta */
+    uint32_t compact_budget_us;     /* max time of one compaction call (0 = none) */
+    int numa;                       /* place buffers, workers and pages by rank node */
+    int numa_node;                  /* node requests come from, -1 = where most DPUs are */
+    uint32_t dpus_per_rank;         /* fallback: DPUs per emulated rank */
+    int lazy_ranks;                 /* bring ranks up in the background */
+    int rank_threads;               /* ... this many at a time */
+    uint32_t rank_load_us;          /* fallback: emulated alloc + load time of a rank */
+    int uniform_xfer;               /* batches as one same-length push per rank */
+    int broadcast_xfer;             /* replicated payloads with dpu_broadcast_to */
+    uint32_t huge_mram_size;        /* bytes of huge_store used per DPU (0 = no huge pages) */
+    const cost_model_t* cost_model; /* fallback: charge transfers and launches with it
+                                     * (NULL: UPMEM_SWAP_COST_MODEL file, if set) */
+} swap_store_config_t;
+
+/* Bring-up state of a rank (lazy_ranks) */
+#define RANK_PENDING 0
+#define RANK_READY   1          /* set by the bring-up thread */
+#define RANK_FAILED  2
+#define RANK_ONLINE  3          /* set by the store once it placed the rank */
+#define RANK_OFFLINE 4
+
+typedef struct {
+#ifdef HAVE_DPU_H
+    struct dpu_set_t set;
+#endif
+    uint32_t first;                 /* first DPU slot of the rank */
+    uint32_t nr_slots;
+    uint32_t nr_dpus;               /* DPUs that came up (a rank may have fewer) */
+    int state;
+    int node;                       /* NUMA node (cfg.numa), -1 if unknown */
+    uint64_t ready_ns;              /* since swap_store_init() */
+} store_rank_t;
+
+/* Per-page state of a batch in flight */
+typedef struct {
+    const uint8_t* src;
+    uint8_t* dst;
+    uint8_t record[STORE_PAGE_SIZE];
+    uint16_t length;
+    uint8_t flags;
+    uint8_t delta_done;                     /* already applied in MRAM */
+    uint8_t fetched;                        /* uniform get: record already read back */
+    uint8_t failed;                         /* uniform put: no slot, or record not sent */
+    page_loc_t loc;                         /* uniform put: slot of the new record */
+    uint64_t line_hashes[STORE_LINES_PER_PAGE];
+} store_item_t;
+
+typedef struct {
+    swap_store_config_t cfg;
+    int dpu_backed;                 /* 0 = host memory fallback */
+    uint32_t nr_dpus;
+
+#ifdef HAVE_DPU_H
+    struct dpu_set_t dpu_set;
+    struct dpu_set_t* dpus;
+#endif
+    uint8_t** ram_mram;             /* fallback page_store per DPU */
+    uint8_t** ram_staging;          /* fallback page_staging per DPU */
+    uint8_t** ram_delta;            /* fallback delta_area per DPU */
+    uint8_t** ram_landing;          /* fallback page_landing per DPU */
+    uint8_t** ram_shared;           /* fallback shared_area per DPU */
+    uint8_t** ram_huge;             /* fallback huge_store per DPU */
+
+    /* Kernel job lists, one per DPU */
+    store_args_t* args;
+    store_job_t** jobs;
+    uint32_t** job_refs;            /* what each job refers to on the HOST */
+    uint32_t* nr_jobs;
+
+    /* Delta patches being built, one delta_area image per DPU */
+    uint8_t** delta_bufs;
+    uint32_t* delta_used;
+    uint32_t batch_seq;
+
+    /* Uniform transfers (cfg.uniform_xfer): landing area images per DPU */
+    xfer_plan_t plan;
+    xfer_req_t* reqs;
+    size_t reqs_cap;
+    uint8_t** landing_bufs;
+
+    /* shared_area as last broadcast, for ranks that come online later */
+    uint8_t* shared;
+    uint32_t shared_used;
+
+    store_scan_t scan;              /* predicate of the scan in progress */
+
+    /* Huge pages (cfg.huge_mram_size): stripe space per rank. Ranks are
+     * those of a lazy store, else huge_ranks, found at init. */
+    store_rank_t* huge_ranks;
+    huge_space_t* huge;
+    uint32_t nr_huge;
+    uint32_t next_huge;
+
+    dpu_space_t* space;
+    uint32_t next_dpu;
+
+    /* NUMA placement (cfg.numa) */
+    int* dpu_node;                  /* node of each DPU's rank, -1 = unknown */
+    int home_node;
+    uint32_t* local_dpus;           /* DPUs on the home node */
+    uint32_t nr_local_dpus;
+    uint32_t next_local;
+
+    /* Lazy rank bring-up (cfg.lazy_ranks). Slots of ranks not yet online
+     * hold nothing; until they are, pages go to the spill DPU, which lives
+     * in host memory, and move to the ranks afterwards. */
+    store_rank_t* ranks;
+    uint32_t nr_ranks;
+    uint32_t next_rank;             /* next rank for a bring-up thread */
+    uint32_t ranks_settled;         /* ready or failed, bumped by bring-up threads */
+    uint32_t ranks_absorbed;        /* ... and taken into account by the store */
+    pthread_t* rank_threads;
+    int nr_rank_threads;
+    int stop_ranks;
+    uint8_t* dpu_online;
+    uint32_t nr_online_dpus;
+    uint32_t spill_dpu;             /* UINT32_MAX: none */
+    uint32_t nr_spilled;            /* pages on the spill DPU */
+    uint32_t migrate_pos;           /* table cursor of the spill migration */
+    uint64_t init_start_ns;
+    uint8_t* program;               /* DPU binary, read once for every rank */
+    size_t program_size;
+
+    page_entry_t* table;
+    uint32_t table_mask;
+    uint32_t nr_pages;
+    uint32_t nr_deleted;
+
+    work_pool_t pool;
+    store_item_t* items;
+    size_t items_cap;
+
+    /* Cost model of the emulated DPUs (cfg.cost_model) */
+    cost_model_t model;
+    int modeled;
+
+    /* Live metrics (swap_store_set_metrics), NULL = off */
+    swap_metrics_t* metrics;
+    swap_metrics_store_t* metrics_slot;     /* gauges, NULL if none was left */
+    uint32_t* metrics_rank;                 /* rank of each DPU, UINT32_MAX: spill */
+    uint32_t metrics_nr_ranks;
+    uint64_t metrics_ns;                    /* last gauge refresh */
+
+    swap_store_stats_t stats;
+} swap_store_t;
+
+void swap_store_default_config(swap_store_config_t* cfg);
+
+int swap_store_init(swap_store_t* store, const swap_store_config_t* cfg);
+void swap_store_free(swap_store_t* store);
+
+/* Single page operations. Return 0 on success, -1 on error. */
+int swap_store_put(swap_store_t* store, uint64_t page_id, const uint8_t* page);
+int swap_store_get(swap_store_t* store, uint64_t page_id, uint8_t* page);
+int swap_store_invalidate(swap_store_t* store, uint64_t page_id);
+
+/* Batched operations: compression/decompression of one page overlaps
+ * with the transfer of its neighbours. Pages stay in the store after a
+ * get; with cfg.delta, putting one back with few changed lines only
+ * sends those lines. With cfg.uniform_xfer a batch is planned as a whole
+ * and moved with one same-length push per DPU set (stats.pushes,
+ * stats.padding_bytes). */
+int swap_store_put_batch(swap_store_t* store, const uint64_t* page_ids,
+                         const uint8_t* const* pages, size_t n);
+int swap_store_get_batch(swap_store_t* store, const uint64_t* page_ids,
+                         uint8_t* const* pages, size_t n);
+
+/* Huge pages: page holds STORE_HUGE_PAGE_SIZE bytes, striped over the
+ * DPUs of one rank (the largest power of two of them, 64 on a full rank)
+ * and moved with one push per direction. The page id shares the page
+ * table with 4KB pages: a put replaces whatever the id held, and
+ * swap_store_get() of a huge page fails. Needs cfg.huge_mram_size. Return
+ * 0 on success, -1 on error. */
+int swap_store_put_huge(swap_store_t* store, uint64_t page_id, const uint8_t* page);
+int swap_store_get_huge(swap_store_t* store, uint64_t page_id, uint8_t* page);
+
+/* Data every DPU needs a copy of (dedup reference pages, compression
+ * dictionaries, configuration) goes to offset in the shared_area of all
+ * DPUs, ranks brought up later included. With cfg.broadcast_xfer it is
+ * sent with one dpu_broadcast_to per DPU set, else the buffer is prepared
+ * for each DPU and pushed. Offset and length are multiples of 8. Return
+ * 0 on success, -1 on error. */
+int swap_store_broadcast(swap_store_t* store, uint32_t offset, const void* buf,
+                         uint32_t length);
+int swap_store_read_shared(swap_store_t* store, uint32_t d, uint32_t offset, void* buf,
+                           uint32_t length);
+
+/* Result of swap_store_scan(), arrays provided by the caller */
+typedef struct {
+    uint64_t* page_ids;             /* matching pages, room for n: those evaluated on the
+                                     * HOST first, then those scanned by the DPUs (not
+                                     * the order of the input page_ids) */
+    uint32_t* matches;              /* records matched in each, room for n */
+    uint8_t* records;               /* want_records: matching records, in res->page_ids order */
+    size_t records_cap;
+    size_t nr_pages;                /* out */
+    size_t records_bytes;           /* out */
+    int truncated;                  /* out: records did not all fit */
+} swap_scan_result_t;
+
+/* Near-data scan: evaluate scan (see store_scan_t) over the stored pages
+ * among page_ids[0..n) without swapping them in. Raw and DPU-compressed
+ * pages are scanned by the DPUs in MRAM, so only matching page ids (and,
+ * with want_records, matching records) cross the bus; zero pages and
+ * pages compressed by the HOST are evaluated here. Pages not in the store
+ * and huge pages are skipped. Returns the number of matching pages, or -1. */
+int swap_store_scan(swap_store_t* store, const store_scan_t* scan, const uint64_t* page_ids,
+                    size_t n, swap_scan_result_t* res);
+
+/* Idle-time MRAM compaction: the DPUs try to compress up to max_per_dpu
+ * raw pages each, in place, and decompress them again on get. Returns the
+ * number of pages tried (0 once there is nothing left), or -1. */
+int swap_store_dpu_compress(swap_store_t* store, uint32_t max_per_dpu,
+                            uint32_t* nr_compressed);
+
+/* Idle-time MRAM defragmentation: coalesces free slots, then the DPUs move
+ * the highest records of their page_store into lower holes (MRAM to MRAM,
+ * no HOST round trip) so that full-page slots open up again. Returns within
+ * about cfg.compact_budget_us with the number of records moved (0 once
+ * nothing can move down), or -1. */
+int swap_store_compact(swap_store_t* store);
+
+/* Share of free MRAM that cannot hold a full page, 0.0 to 1.0 */
+double swap_store_fragmentation(const swap_store_t* store);
+
+/* cfg.numa: pin the calling thread to the store's home node, so that its
+ * transfers and staging buffers stay local. 0, or -1 (thread unchanged). */
+int swap_store_bind_thread(const swap_store_t* store);
+
+/* cfg.lazy_ranks: block until every rank is online or failed, then take
+ * them all into placement. Returns the number of DPUs online. */
+uint32_t swap_store_wait_ranks(swap_store_t* store);
+
+/* Metadata lookup, NULL if the page is not stored */
+const page_loc_t* swap_store_lookup(const swap_store_t* store, uint64_t page_id);
+
+/* Bytes of MRAM slots currently allocated, over all DPUs (huge stripes
+ * included) */
+uint64_t swap_store_mram_used(const swap_store_t* store);
+
+/* Publish live metrics into mx (NULL: stop): every call counts in the
+ * calling thread's slot, and the store's gauges (occupancy and queue depth
+ * per rank, compression, fallbacks) are refreshed at most every
+ * SWAP_METRICS_PUBLISH_NS. mx must outlive the store. 0, or -1 (metrics
+ * stay off). */
+int swap_store_set_metrics(swap_store_t* store, swap_metrics_t* mx);
+
+#endif /* __UPMEM_SWAP_STORE_H__ */
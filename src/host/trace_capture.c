@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "page_trace.h"
+
+/*
+ * Convert perf mem samples of a running process to a page trace.
+ *
+ *   perf mem record -p <pid> -- sleep 10
+ *   perf script -F time,event,addr > samples.txt
+ *   trace_capture samples.txt app.trace
+ *
+ * scripts/capture_trace.sh does all three. Each sample line gives a
+ * timestamp ("seconds.micros:"), the event (stores are writes, everything
+ * else reads) and the data address; lines without an address are skipped.
+ * Samples are a subset of the accesses (one per perf period), so replaying
+ * them shows the shape of the workload rather than its exact volume.
+ *
+ * Processes whose memory is a userfaultfd region record their faults
+ * directly with uffd_region_set_trace() (see benchmark_psi).
+ *
+ * Usage: trace_capture <perf_script_output|-> <trace_file> [page_size]
+ */
+
+#define LINE_MAX_LEN 4096
+
+typedef struct {
+    uint64_t lines;
+    uint64_t samples;
+    uint64_t reads, writes;
+    uint64_t skipped;
+    uint64_t min_page, max_page;
+} capture_stats_t;
+
+/* Timestamp in ns of a "12345.678901:" token: 1, or 0 if the token is not one */
+static int parse_time(const char* tok, uint64_t* ns) {
+    char* end;
+    double s = strtod(tok, &end);
+
+    if (end == tok || *end != ':' || end[1] != '\0' || !strchr(tok, '.')) return 0;
+    *ns = (uint64_t)(s * 1e9);
+    return 1;
+}
+
+/* One sample: 1 and its fields, 0 for a line that is not a sample */
+static int parse_sample(char* line, uint64_t* ts_ns, uint64_t* addr, uint8_t* op) {
+    char* save = NULL;
+    char* last = NULL;
+    int have_time = 0, is_store = 0;
+
+    *ts_ns = 0;
+    *addr = 0;
+    *op = PAGE_TRACE_READ;
+    for (char* tok = strtok_r(line, " \t\n", &save); tok; tok = strtok_r(NULL, " \t\n", &save)) {
+        if (!have_time && parse_time(tok, ts_ns)) {
+            have_time = 1;
+        } else if (strstr(tok, "store")) {
+            is_store = 1;
+        }
+        last = tok;
+    }
+    if (!have_time || !last) return 0;
+
+    char* end;
+    *addr = strtoull(last, &end, 16);
+    if (end == last || *end != '\0' || *addr == 0) return 0;
+    *op = is_store ? PAGE_TRACE_WRITE : PAGE_TRACE_READ;
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    const char* in_path = argc > 1 ? argv[1] : NULL;
+    const char* out_path = argc > 2 ? argv[2] : NULL;
+    uint32_t page_size = argc > 3 ? strtoul(argv[3], NULL, 0) : 4096;
+    capture_stats_t st = {0};
+    uint64_t first_ts = 0;
+    page_trace_t trace;
+    char line[LINE_MAX_LEN];
+    FILE* in;
+
+    if (!in_path || !out_path || page_size == 0) {
+        fprintf(stderr, "Usage: %s <perf_script_output|-> <trace_file> [page_size]\n", argv[0]);
+        return 1;
+    }
+    in = strcmp(in_path, "-") == 0 ? stdin : fopen(in_path, "r");
+    if (!in) {
+        fprintf(stderr, "Cannot open %s\n", in_path);
+        return 1;
+    }
+    if (page_trace_create(&trace, out_path, page_size, PAGE_TRACE_SRC_PERF,
+                          (uint64_t)time(NULL) * 1000000000ULL) != 0) {
+        if (in != stdin) fclose(in);
+        return 1;
+    }
+
+    st.min_page = UINT64_MAX;
+    while (fgets(line, sizeof(line), in)) {
+        uint64_t ts = 0, addr = 0;
+        uint8_t op = PAGE_TRACE_READ;
+
+        st.lines++;
+        if (!parse_sample(line, &ts, &addr, &op)) {
+            st.skipped++;
+            continue;
+        }
+        if (st.samples == 0) first_ts = ts;
+        uint64_t page = addr / page_size;
+        if (page_trace_append(&trace, ts > first_ts ? ts - first_ts : 0, page, op) != 0) {
+            fprintf(stderr, "Write to %s failed\n", out_path);
+            break;
+        }
+        st.samples++;
+        if (op == PAGE_TRACE_WRITE) st.writes++;
+        else st.reads++;
+        if (page < st.min_page) st.min_page = page;
+        if (page > st.max_page) st.max_page = page;
+    }
+    if (in != stdin) fclose(in);
+
+    uint64_t duration_ns = trace.last_ts, bytes = trace.bytes;
+    int ok = page_trace_close(&trace) == 0 && st.samples > 0;
+
+    printf("=== PAGE TRACE CAPTURE (perf mem) ===\n");
+    printf("Lines:    %llu (%llu not samples)\n", (unsigned long long)st.lines,
+           (unsigned long long)st.skipped);
+    printf("Samples:  %llu (%llu reads, %llu writes) over %.3f s\n",
+           (unsigned long long)st.samples, (unsigned long long)st.reads,
+           (unsigned long long)st.writes, duration_ns / 1e9);
+    if (st.samples > 0) {
+        printf("Pages:    0x%llx - 0x%llx (%u-byte pages)\n", (unsigned long long)st.min_page,
+               (unsigned long long)st.max_page, page_size);
+        printf("Encoding: %.2f bytes per record\n", (double)bytes / st.samples);
+    }
+    printf("%s %s\n", ok ? "✓ Trace written to" : "✗ No trace in", out_path);
+    return ok ? 0 : 1;
+}
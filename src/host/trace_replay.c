@@ -0,0 +1,682 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "page_trace.h"
+#include "swap_store.h"
+
+/*
+ * Replay a page access trace (trace_capture, uffd_region_set_trace)
+ * against the page store.
+ *
+ * The replayer plays the host: an LRU page cache of cache_mb sits in front
+ * of the store. A hit costs nothing; a miss gets the page from the store
+ * (plus up to `prefetch` following pages that are in the store too), or
+ * zero-fills it on first touch. When the cache is full the coldest pages
+ * are evicted in batches, and put only if dirty or never stored. Every
+ * page carries its id and version, checked on every get.
+ *
+ *   asap   records are replayed back to back (store-bound throughput)
+ *   timed  records are replayed at their captured time divided by speed;
+ *          lag is how late each one starts
+ *
+ * By default EVICT records are ignored and the replayer's own LRU decides;
+ * with -e they drop the page from the cache as the capturing side did.
+ * -c and -P take comma-separated lists, every combination is replayed.
+ *
+ * Usage: trace_replay [-m asap|timed] [-x speed] [-c cache_mb] [-P prefetch]
+ *                     [-d dpus] [-b evict_batch] [-e] [-z] <trace_file>
+ */
+
+#define MAX_LIST 16
+#define NO_SLOT UINT32_MAX
+#define PAGE_STORED 1               /* page_state bits */
+
+typedef struct {
+    long min, max, mean, p50, p99, p999;
+} stats_t;
+
+typedef struct {
+    long* ns;
+    size_t n, cap;
+} samples_t;
+
+/* Trace page ids (often addresses / page size) to dense indexes */
+typedef struct {
+    uint64_t* keys;
+    uint32_t* vals;                 /* index + 1, 0 = empty */
+    uint32_t mask;
+    uint32_t n;
+} page_index_t;
+
+typedef struct {
+    uint32_t page;                  /* dense index */
+    uint32_t prev, next;            /* LRU list, head = most recent */
+    uint8_t dirty;
+    uint8_t prefetched;             /* brought in by prefetch, not used yet */
+} cache_slot_t;
+
+typedef struct {
+    const char* mode;
+    double speed;
+    uint32_t cache_pages;
+    uint32_t prefetch;
+    uint32_t nr_dpus;
+    uint64_t records;
+    uint64_t accesses, reads, writes, trace_evicts;
+    uint64_t hits, misses, first_touches;
+    uint64_t gets, puts;            /* pages moved */
+    uint64_t get_calls, put_calls;
+    uint64_t prefetched, prefetch_hits;
+    double seconds;
+    stats_t get_lat, put_lat, lag;
+    int ok;
+} replay_result_t;
+
+typedef struct {
+    swap_store_t* store;
+    page_index_t* index;
+    uint64_t* page_ids;             /* dense index -> trace page id */
+    uint32_t* versions;
+    uint8_t* page_state;
+    uint32_t* slot_of;              /* dense index -> cache slot */
+
+    cache_slot_t* slots;
+    uint8_t* data;
+    uint32_t nr_slots;
+    uint32_t nr_used;
+    uint32_t head, tail;
+    uint32_t* free_slots;
+    uint32_t nr_free;
+    uint32_t evict_batch;
+
+    uint64_t* ids;                  /* transfer batch */
+    uint8_t** bufs;
+    uint32_t* batch_pages;
+
+    samples_t get_ns, put_ns, lag_ns;
+    replay_result_t* r;
+} replayer_t;
+
+struct timespec diff_time(struct timespec start, struct timespec end) {
+    struct timespec temp;
+    if ((end.tv_nsec - start.tv_nsec) < 0) {
+        temp.tv_sec = end.tv_sec - start.tv_sec - 1;
+        temp.tv_nsec = 1000000000 + end.tv_nsec - start.tv_nsec;
+    } else {
+        temp.tv_sec = end.tv_sec - start.tv_sec;
+        temp.tv_nsec = end.tv_nsec - start.tv_nsec;
+    }
+    return temp;
+}
+
+long timespec_to_ns(struct timespec ts) {
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+stats_t calculate_stats(long* latencies, size_t n) {
+    stats_t s;
+    double sum = 0;
+
+    memset(&s, 0, sizeof(s));
+    if (n == 0) return s;
+    qsort(latencies, n, sizeof(long), cmp_long);
+    for (size_t i = 0; i < n; i++) {
+        sum += latencies[i];
+    }
+    s.min = latencies[0];
+    s.max = latencies[n - 1];
+    s.mean = (long)(sum / n);
+    s.p50 = latencies[n / 2];
+    s.p99 = latencies[n * 99 / 100];
+    s.p999 = latencies[n * 999 / 1000];
+    return s;
+}
+
+static void add_sample(samples_t* s, long ns) {
+    if (s->n == s->cap) {
+        size_t cap = s->cap ? 2 * s->cap : 4096;
+        long* ns_new = realloc(s->ns, cap * sizeof(long));
+        if (!ns_new) return;
+        s->ns = ns_new;
+        s->cap = cap;
+    }
+    s->ns[s->n++] = ns;
+}
+
+static long elapsed_ns(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespec_to_ns(diff_time(start, now));
+}
+
+/* ========================================================================
+ * Page index
+ * ======================================================================== */
+
+static inline uint32_t hash_id(uint64_t id) {
+    return (uint32_t)((id * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static int index_grow(page_index_t* ix) {
+    uint32_t size = ix->mask ? 2 * (ix->mask + 1) : 4096;
+    uint64_t* keys = calloc(size, sizeof(uint64_t));
+    uint32_t* vals = calloc(size, sizeof(uint32_t));
+
+    if (!keys || !vals) {
+        free(keys);
+        free(vals);
+        return -1;
+    }
+    for (uint32_t i = 0; ix->mask && i <= ix->mask; i++) {
+        if (!ix->vals[i]) continue;
+        uint32_t j = hash_id(ix->keys[i]) & (size - 1);
+        while (vals[j]) j = (j + 1) & (size - 1);
+        keys[j] = ix->keys[i];
+        vals[j] = ix->vals[i];
+    }
+    free(ix->keys);
+    free(ix->vals);
+    ix->keys = keys;
+    ix->vals = vals;
+    ix->mask = size - 1;
+    return 0;
+}
+
+/* Dense index of a page id, NO_SLOT if unknown and !add */
+static uint32_t index_get(page_index_t* ix, uint64_t id, int add) {
+    if (add && (ix->mask == 0 || ix->n >= (ix->mask + 1) / 2) && index_grow(ix) != 0) {
+        return NO_SLOT;
+    }
+    if (ix->mask == 0) return NO_SLOT;
+    for (uint32_t i = hash_id(id) & ix->mask;; i = (i + 1) & ix->mask) {
+        if (!ix->vals[i]) {
+            if (!add) return NO_SLOT;
+            ix->keys[i] = id;
+            ix->vals[i] = ++ix->n;
+            return ix->n - 1;
+        }
+        if (ix->keys[i] == id) return ix->vals[i] - 1;
+    }
+}
+
+/* ========================================================================
+ * Cache
+ * ======================================================================== */
+
+static uint8_t* slot_data(const replayer_t* rp, uint32_t s) {
+    return rp->data + (size_t)s * STORE_PAGE_SIZE;
+}
+
+static void lru_unlink(replayer_t* rp, uint32_t s) {
+    cache_slot_t* c = &rp->slots[s];
+    if (c->prev != NO_SLOT) rp->slots[c->prev].next = c->next;
+    else rp->head = c->next;
+    if (c->next != NO_SLOT) rp->slots[c->next].prev = c->prev;
+    else rp->tail = c->prev;
+}
+
+static void lru_push(replayer_t* rp, uint32_t s) {
+    cache_slot_t* c = &rp->slots[s];
+    c->prev = NO_SLOT;
+    c->next = rp->head;
+    if (rp->head != NO_SLOT) rp->slots[rp->head].prev = s;
+    rp->head = s;
+    if (rp->tail == NO_SLOT) rp->tail = s;
+}
+
+static void stamp(const replayer_t* rp, uint8_t* page, uint32_t idx) {
+    memcpy(page, &rp->page_ids[idx], sizeof(uint64_t));
+    memcpy(page + sizeof(uint64_t), &rp->versions[idx], sizeof(uint32_t));
+}
+
+static int stamp_ok(const replayer_t* rp, const uint8_t* page, uint32_t idx) {
+    uint64_t id;
+    uint32_t version;
+    memcpy(&id, page, sizeof(id));
+    memcpy(&version, page + sizeof(uint64_t), sizeof(version));
+    return id == rp->page_ids[idx] && version == rp->versions[idx];
+}
+
+static void release_slot(replayer_t* rp, uint32_t s) {
+    lru_unlink(rp, s);
+    rp->slot_of[rp->slots[s].page] = NO_SLOT;
+    rp->free_slots[rp->nr_free++] = s;
+    rp->nr_used--;
+}
+
+/* Put the given slots (those that need it) to the store and free them */
+static int evict_slots(replayer_t* rp, const uint32_t* victims, uint32_t n) {
+    struct timespec t_start;
+    uint32_t nr_put = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        cache_slot_t* c = &rp->slots[victims[i]];
+        if (!c->dirty && (rp->page_state[c->page] & PAGE_STORED)) continue;
+        rp->ids[nr_put] = rp->page_ids[c->page];
+        rp->bufs[nr_put] = slot_data(rp, victims[i]);
+        nr_put++;
+    }
+    if (nr_put > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &t_start);
+        if (swap_store_put_batch(rp->store, rp->ids, (const uint8_t* const*)rp->bufs, nr_put) != 0) {
+            return -1;
+        }
+        add_sample(&rp->put_ns, elapsed_ns(t_start));
+        rp->r->puts += nr_put;
+        rp->r->put_calls++;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        cache_slot_t* c = &rp->slots[victims[i]];
+        rp->page_state[c->page] |= PAGE_STORED;
+        release_slot(rp, victims[i]);
+    }
+    return 0;
+}
+
+/* Make room for `need` pages, evicting from the cold end in batches */
+static int make_room(replayer_t* rp, uint32_t need) {
+    uint32_t victims[256];
+
+    while (rp->nr_free < need) {
+        uint32_t n = 0, want = rp->evict_batch;
+        if (want < need - rp->nr_free) want = need - rp->nr_free;
+        if (want > 256) want = 256;
+        for (uint32_t s = rp->tail; s != NO_SLOT && n < want; s = rp->slots[s].prev) {
+            victims[n++] = s;
+        }
+        if (n == 0 || evict_slots(rp, victims, n) != 0) return -1;
+    }
+    return 0;
+}
+
+static uint32_t take_slot(replayer_t* rp, uint32_t idx) {
+    uint32_t s = rp->free_slots[--rp->nr_free];
+    rp->slots[s].page = idx;
+    rp->slots[s].dirty = 0;
+    rp->slots[s].prefetched = 0;
+    rp->slot_of[idx] = s;
+    rp->nr_used++;
+    lru_push(rp, s);
+    return s;
+}
+
+/* Miss on a stored page: get it with its prefetch window in one batch */
+static int fetch(replayer_t* rp, uint32_t idx) {
+    replay_result_t* r = rp->r;
+    struct timespec t_start;
+    uint32_t n = 0;
+
+    rp->batch_pages[n++] = idx;
+    for (uint32_t i = 1; i <= r->prefetch && n < rp->nr_slots; i++) {
+        uint32_t next = index_get(rp->index, rp->page_ids[idx] + i, 0);
+        if (next == NO_SLOT || !(rp->page_state[next] & PAGE_STORED) ||
+            rp->slot_of[next] != NO_SLOT) {
+            continue;
+        }
+        rp->batch_pages[n++] = next;
+    }
+    if (make_room(rp, n) != 0) return -1;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t s = take_slot(rp, rp->batch_pages[i]);
+        rp->slots[s].prefetched = i > 0;
+        rp->ids[i] = rp->page_ids[rp->batch_pages[i]];
+        rp->bufs[i] = slot_data(rp, s);
+    }
+    /* The demand page ends up most recent */
+    lru_unlink(rp, rp->slot_of[idx]);
+    lru_push(rp, rp->slot_of[idx]);
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    if (swap_store_get_batch(rp->store, rp->ids, rp->bufs, n) != 0) return -1;
+    add_sample(&rp->get_ns, elapsed_ns(t_start));
+    for (uint32_t i = 0; i < n; i++) {
+        if (!stamp_ok(rp, rp->bufs[i], rp->batch_pages[i])) return -1;
+    }
+    r->gets += n;
+    r->get_calls++;
+    r->prefetched += n - 1;
+    return 0;
+}
+
+static int access_page(replayer_t* rp, uint32_t idx, uint8_t op) {
+    replay_result_t* r = rp->r;
+    uint32_t s = rp->slot_of[idx];
+
+    if (op == PAGE_TRACE_EVICT) {
+        r->trace_evicts++;
+        return s == NO_SLOT ? 0 : evict_slots(rp, &s, 1);
+    }
+
+    r->accesses++;
+    if (op == PAGE_TRACE_WRITE) r->writes++;
+    else r->reads++;
+
+    if (s != NO_SLOT) {
+        r->hits++;
+        if (rp->slots[s].prefetched) {
+            r->prefetch_hits++;
+            rp->slots[s].prefetched = 0;
+        }
+        lru_unlink(rp, s);
+        lru_push(rp, s);
+    } else if (rp->page_state[idx] & PAGE_STORED) {
+        r->misses++;
+        if (fetch(rp, idx) != 0) return -1;
+        s = rp->slot_of[idx];
+    } else {
+        r->misses++;
+        r->first_touches++;
+        if (make_room(rp, 1) != 0) return -1;
+        s = take_slot(rp, idx);
+        memset(slot_data(rp, s), 0, STORE_PAGE_SIZE);
+        stamp(rp, slot_data(rp, s), idx);
+    }
+
+    if (op == PAGE_TRACE_WRITE) {
+        rp->versions[idx]++;
+        stamp(rp, slot_data(rp, s), idx);
+        rp->slots[s].dirty = 1;
+    }
+    return 0;
+}
+
+/* ========================================================================
+ * Replay
+ * ======================================================================== */
+
+/* First pass: distinct pages. Leaves the trace at its end. */
+static int index_trace(page_trace_t* trace, page_index_t* ix, uint64_t** page_ids) {
+    page_trace_rec_t rec;
+    uint32_t cap = 0;
+    int ret;
+
+    while ((ret = page_trace_next(trace, &rec)) == 1) {
+        uint32_t before = ix->n;
+        uint32_t idx = index_get(ix, rec.page_id, 1);
+        if (idx == NO_SLOT) return -1;
+        if (ix->n == before) continue;
+        if (idx >= cap) {
+            cap = cap ? 2 * cap : 4096;
+            uint64_t* ids = realloc(*page_ids, cap * sizeof(uint64_t));
+            if (!ids) return -1;
+            *page_ids = ids;
+        }
+        (*page_ids)[idx] = rec.page_id;
+    }
+    if (ret < 0) {
+        fprintf(stderr, "ERROR: corrupt trace record %llu\n", (unsigned long long)trace->records);
+        return -1;
+    }
+    return 0;
+}
+
+static int replay(page_trace_t* trace, page_index_t* ix, uint64_t* page_ids, int timed,
+                  int follow_evicts, uint32_t evict_batch, int compress, replay_result_t* r) {
+    uint32_t nr_pages = ix->n;
+    uint32_t nr_slots = r->cache_pages;
+    uint32_t batch_cap = (r->prefetch + 1 > evict_batch ? r->prefetch + 1 : evict_batch) + 256;
+    swap_store_config_t cfg;
+    swap_store_t store;
+    replayer_t rp;
+    struct timespec t_start;
+    page_trace_rec_t rec;
+    int ret = 0;
+
+    memset(&rp, 0, sizeof(rp));
+    swap_store_default_config(&cfg);
+    cfg.nr_dpus = r->nr_dpus;
+    cfg.max_pages = nr_pages + 1024;
+    cfg.compress = compress;
+    if (swap_store_init(&store, &cfg) != 0) {
+        fprintf(stderr, "Failed to initialize page store\n");
+        return -1;
+    }
+
+    rp.store = &store;
+    rp.index = ix;
+    rp.page_ids = page_ids;
+    rp.r = r;
+    rp.nr_slots = nr_slots;
+    rp.evict_batch = evict_batch;
+    rp.head = rp.tail = NO_SLOT;
+    rp.versions = calloc(nr_pages, sizeof(uint32_t));
+    rp.page_state = calloc(nr_pages, sizeof(uint8_t));
+    rp.slot_of = malloc(nr_pages * sizeof(uint32_t));
+    rp.slots = calloc(nr_slots, sizeof(cache_slot_t));
+    rp.data = malloc((size_t)nr_slots * STORE_PAGE_SIZE);
+    rp.free_slots = malloc(nr_slots * sizeof(uint32_t));
+    rp.ids = malloc(batch_cap * sizeof(uint64_t));
+    rp.bufs = malloc(batch_cap * sizeof(uint8_t*));
+    rp.batch_pages = malloc(batch_cap * sizeof(uint32_t));
+    if (!rp.versions || !rp.page_state || !rp.slot_of || !rp.slots || !rp.data ||
+        !rp.free_slots || !rp.ids || !rp.bufs || !rp.batch_pages) {
+        fprintf(stderr, "Failed to allocate a %u-page cache\n", nr_slots);
+        ret = -1;
+        goto out;
+    }
+    memset(rp.slot_of, 0xff, nr_pages * sizeof(uint32_t));
+    for (uint32_t s = 0; s < nr_slots; s++) {
+        rp.free_slots[rp.nr_free++] = nr_slots - 1 - s;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    while ((ret = page_trace_next(trace, &rec)) == 1) {
+        if (rec.op == PAGE_TRACE_EVICT && !follow_evicts) {
+            r->trace_evicts++;
+            continue;
+        }
+        if (timed) {
+            long due = (long)(rec.ts_ns / r->speed);
+            long now = elapsed_ns(t_start);
+            if (now < due) {
+                struct timespec wake = t_start;
+                wake.tv_sec += due / 1000000000L;
+                wake.tv_nsec += due % 1000000000L;
+                if (wake.tv_nsec >= 1000000000L) {
+                    wake.tv_sec++;
+                    wake.tv_nsec -= 1000000000L;
+                }
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+                now = due;
+            }
+            add_sample(&rp.lag_ns, now - due);
+        }
+        uint32_t idx = index_get(ix, rec.page_id, 0);
+        if (idx == NO_SLOT || access_page(&rp, idx, rec.op) != 0) {
+            fprintf(stderr, "ERROR: replay failed at record %llu (page 0x%llx)\n",
+                    (unsigned long long)trace->records, (unsigned long long)rec.page_id);
+            ret = -1;
+            break;
+        }
+    }
+    r->seconds = elapsed_ns(t_start) / 1e9;
+    r->records = trace->records;
+    r->ok = ret == 0;
+    r->get_lat = calculate_stats(rp.get_ns.ns, rp.get_ns.n);
+    r->put_lat = calculate_stats(rp.put_ns.ns, rp.put_ns.n);
+    r->lag = calculate_stats(rp.lag_ns.ns, rp.lag_ns.n);
+
+out:
+    free(rp.versions);
+    free(rp.page_state);
+    free(rp.slot_of);
+    free(rp.slots);
+    free(rp.data);
+    free(rp.free_slots);
+    free(rp.ids);
+    free(rp.bufs);
+    free(rp.batch_pages);
+    free(rp.get_ns.ns);
+    free(rp.put_ns.ns);
+    free(rp.lag_ns.ns);
+    swap_store_free(&store);
+    return ret < 0 ? -1 : 0;
+}
+
+/* ========================================================================
+ * Command line
+ * ======================================================================== */
+
+static int split_list(const char* arg, double* items) {
+    int n = 0;
+    while (*arg && n < MAX_LIST) {
+        char* end;
+        items[n++] = strtod(arg, &end);
+        if (end == arg) return -1;
+        arg = *end == ',' ? end + 1 : end;
+    }
+    return n;
+}
+
+static void print_result(const replay_result_t* r) {
+    double mb = STORE_PAGE_SIZE / (1024.0 * 1024.0);
+
+    printf("cache %u pages (%.1f MB), prefetch %u:\n", r->cache_pages, r->cache_pages * mb,
+           r->prefetch);
+    printf("  Accesses:     %llu (%llu reads, %llu writes), %llu evict records, %.0f/s\n",
+           (unsigned long long)r->accesses, (unsigned long long)r->reads,
+           (unsigned long long)r->writes, (unsigned long long)r->trace_evicts,
+           r->seconds > 0 ? r->accesses / r->seconds : 0.0);
+    printf("  Hit rate:     %.2f%% (%llu misses: %llu from the store, %llu first touches)\n",
+           r->accesses ? 100.0 * r->hits / r->accesses : 0.0, (unsigned long long)r->misses,
+           (unsigned long long)(r->misses - r->first_touches),
+           (unsigned long long)r->first_touches);
+    printf("  Prefetch:     %llu pages, %llu used (%.1f%%)\n",
+           (unsigned long long)r->prefetched, (unsigned long long)r->prefetch_hits,
+           r->prefetched ? 100.0 * r->prefetch_hits / r->prefetched : 0.0);
+    printf("  Transfers:    %.2f MB in (%llu get calls), %.2f MB out (%llu put calls)\n",
+           r->gets * mb, (unsigned long long)r->get_calls, r->puts * mb,
+           (unsigned long long)r->put_calls);
+    printf("  Get latency:  mean %.2f µs, p50 %.2f µs, p99 %.2f µs, p99.9 %.2f µs\n",
+           r->get_lat.mean / 1e3, r->get_lat.p50 / 1e3, r->get_lat.p99 / 1e3,
+           r->get_lat.p999 / 1e3);
+    printf("  Put latency:  mean %.2f µs, p50 %.2f µs, p99 %.2f µs, p99.9 %.2f µs\n",
+           r->put_lat.mean / 1e3, r->put_lat.p50 / 1e3, r->put_lat.p99 / 1e3,
+           r->put_lat.p999 / 1e3);
+    if (strcmp(r->mode, "timed") == 0) {
+        printf("  Lag:          p50 %.2f µs, p99 %.2f µs, max %.2f ms\n",
+               r->lag.p50 / 1e3, r->lag.p99 / 1e3, r->lag.max / 1e6);
+    }
+    printf("  Verification: %s\n\n", r->ok ? "✓ OK" : "✗ FAIL");
+}
+
+static void write_csv(const char* path, const char* trace_file, const replay_result_t* results,
+                      int n) {
+    FILE* f = fopen(path, "w");
+    if (!f) return;
+    fprintf(f, "trace,mode,speed,nr_dpus,cache_pages,prefetch,records,accesses,reads,writes,hit_rate,first_touches,gets,puts,get_calls,put_calls,prefetched,prefetch_hits,mb_in,mb_out,get_mean_us,get_p50_us,get_p99_us,get_p999_us,put_mean_us,put_p50_us,put_p99_us,put_p999_us,lag_p99_us,seconds,ok\n");
+    for (int i = 0; i < n; i++) {
+        const replay_result_t* r = &results[i];
+        double mb = STORE_PAGE_SIZE / (1024.0 * 1024.0);
+        fprintf(f, "%s,%s,%.2f,%u,%u,%u,%llu,%llu,%llu,%llu,%.4f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,"
+                   "%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f,%d\n",
+                trace_file, r->mode, r->speed, r->nr_dpus, r->cache_pages, r->prefetch,
+                (unsigned long long)r->records, (unsigned long long)r->accesses,
+                (unsigned long long)r->reads, (unsigned long long)r->writes,
+                r->accesses ? (double)r->hits / r->accesses : 0.0,
+                (unsigned long long)r->first_touches, (unsigned long long)r->gets,
+                (unsigned long long)r->puts, (unsigned long long)r->get_calls,
+                (unsigned long long)r->put_calls, (unsigned long long)r->prefetched,
+                (unsigned long long)r->prefetch_hits, r->gets * mb, r->puts * mb,
+                r->get_lat.mean / 1e3, r->get_lat.p50 / 1e3, r->get_lat.p99 / 1e3,
+                r->get_lat.p999 / 1e3, r->put_lat.mean / 1e3, r->put_lat.p50 / 1e3,
+                r->put_lat.p99 / 1e3, r->put_lat.p999 / 1e3, r->lag.p99 / 1e3, r->seconds, r->ok);
+    }
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    static const char* const source_names[] = {"unknown", "userfaultfd", "perf mem"};
+    const char* mode = "asap";
+    double speed = 1.0;
+    double cache_mb[MAX_LIST] = {16}, prefetch[MAX_LIST] = {0};
+    int nr_cache = 1, nr_prefetch = 1;
+    uint32_t nr_dpus = 8, evict_batch = 16;
+    int follow_evicts = 0, compress = 0, ok = 1, opt;
+
+    while ((opt = getopt(argc, argv, "m:x:c:P:d:b:ezh")) != -1) {
+        switch (opt) {
+        case 'm': mode = optarg; break;
+        case 'x': speed = atof(optarg); break;
+        case 'c': nr_cache = split_list(optarg, cache_mb); break;
+        case 'P': nr_prefetch = split_list(optarg, prefetch); break;
+        case 'd': nr_dpus = strtoul(optarg, NULL, 0); break;
+        case 'b': evict_batch = strtoul(optarg, NULL, 0); break;
+        case 'e': follow_evicts = 1; break;
+        case 'z': compress = 1; break;
+        default: nr_cache = -1; break;
+        }
+    }
+    if (optind >= argc || nr_cache <= 0 || nr_prefetch <= 0 || speed <= 0 || nr_dpus == 0 ||
+        evict_batch == 0 || evict_batch > 256 ||
+        (strcmp(mode, "asap") != 0 && strcmp(mode, "timed") != 0)) {
+        fprintf(stderr, "Usage: %s [-m asap|timed] [-x speed] [-c cache_mb] [-P prefetch]\n"
+                        "          [-d dpus] [-b evict_batch] [-e] [-z] <trace_file>\n", argv[0]);
+        return 1;
+    }
+    const char* trace_file = argv[optind];
+
+    page_trace_t trace;
+    page_index_t ix = {0};
+    uint64_t* page_ids = NULL;
+    if (page_trace_open(&trace, trace_file) != 0) return 1;
+    if (trace.page_size != STORE_PAGE_SIZE) {
+        fprintf(stderr, "WARNING: trace pages are %u bytes, replayed as %d-byte pages\n",
+                trace.page_size, STORE_PAGE_SIZE);
+    }
+    if (index_trace(&trace, &ix, &page_ids) != 0 || ix.n == 0) {
+        fprintf(stderr, "Failed to read %s\n", trace_file);
+        page_trace_close(&trace);
+        return 1;
+    }
+
+    printf("=== UPMEM PAGE TRACE REPLAY ===\n");
+    printf("Trace: %s (%s), %llu records over %.3f s, %u distinct pages (%.1f MB)\n",
+           trace_file, source_names[trace.source <= PAGE_TRACE_SRC_PERF ? trace.source : 0],
+           (unsigned long long)trace.records, trace.last_ts / 1e9, ix.n,
+           ix.n * (STORE_PAGE_SIZE / (1024.0 * 1024.0)));
+    printf("Mode: %s", mode);
+    if (strcmp(mode, "timed") == 0) printf(" (x%.2f)", speed);
+    printf(", %u DPUs, evict batches of %u%s%s\n\n", nr_dpus, evict_batch,
+           follow_evicts ? ", following trace evictions" : "", compress ? ", compression" : "");
+
+    replay_result_t results[MAX_LIST * MAX_LIST];
+    int nr_results = 0;
+    for (int ci = 0; ci < nr_cache; ci++)
+    for (int pi = 0; pi < nr_prefetch; pi++) {
+        replay_result_t* r = &results[nr_results];
+        memset(r, 0, sizeof(*r));
+        r->mode = mode;
+        r->speed = speed;
+        r->nr_dpus = nr_dpus;
+        r->cache_pages = (uint32_t)(cache_mb[ci] * 1024 * 1024 / STORE_PAGE_SIZE);
+        r->prefetch = (uint32_t)prefetch[pi];
+        if (r->cache_pages == 0) r->cache_pages = 1;
+
+        if (page_trace_rewind(&trace) != 0 ||
+            replay(&trace, &ix, page_ids, strcmp(mode, "timed") == 0, follow_evicts,
+                   evict_batch, compress, r) != 0) {
+            r->ok = 0;
+        }
+        print_result(r);
+        ok &= r->ok;
+        nr_results++;
+    }
+
+    write_csv("replay_results.csv", trace_file, results, nr_results);
+    printf("✓ Results saved to replay_results.csv\n");
+
+    page_trace_close(&trace);
+    free(ix.keys);
+    free(ix.vals);
+    free(page_ids);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+/**
+ * UPMEM Swap - userfaultfd region
+ *
+ * Fault serving and eviction for a store-backed anonymous region, see
+ * uffd_region.h.
+ */
+
+#include "uffd_region.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/userfaultfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PAGEMAP_PRESENT (1ULL << 63)
+#define PAGEMAP_PFN_MASK ((1ULL << 55) - 1)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Idle page tracking needs both files and real PFNs in pagemap */
+static void open_idle_tracking(uffd_region_t* r) {
+    r->pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    r->idle_fd = open("/sys/kernel/mm/page_idle/bitmap", O_RDWR | O_CLOEXEC);
+    if (r->pagemap_fd < 0 || r->idle_fd < 0) {
+        if (r->pagemap_fd >= 0) close(r->pagemap_fd);
+        if (r->idle_fd >= 0) close(r->idle_fd);
+        r->pagemap_fd = -1;
+        r->idle_fd = -1;
+    }
+}
+
+int uffd_region_init(uffd_region_t* r, size_t size, uint64_t first_page_id) {
+    struct uffdio_api api = {.api = UFFD_API, .features = UFFD_FEATURE_PAGEFAULT_FLAG_WP};
+    struct uffdio_register reg;
+
+    memset(r, 0, sizeof(*r));
+    r->uffd = -1;
+    r->pagemap_fd = -1;
+    r->idle_fd = -1;
+    r->size = (size + STORE_PAGE_SIZE - 1) & ~(size_t)(STORE_PAGE_SIZE - 1);
+    r->nr_pages = (uint32_t)(r->size / STORE_PAGE_SIZE);
+    r->first_page_id = first_page_id;
+
+    r->base = mmap(NULL, r->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (r->base == MAP_FAILED) {
+        fprintf(stderr, "ERROR: mmap of %zu bytes failed: %s\n", r->size, strerror(errno));
+        r->base = NULL;
+        return -1;
+    }
+    r->state = calloc(r->nr_pages, sizeof(uint8_t));
+    r->touched = calloc(r->nr_pages, sizeof(uint32_t));
+    if (!r->state || !r->touched || posix_memalign((void**)&r->bounce, STORE_PAGE_SIZE, STORE_PAGE_SIZE) != 0) {
+        fprintf(stderr, "ERROR: Failed to allocate region metadata\n");
+        uffd_region_free(r);
+        return -1;
+    }
+
+    /* Unprivileged processes only get faults from user mode */
+    r->uffd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+    if (r->uffd < 0 && errno == EPERM) {
+        r->uffd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+    }
+    if (r->uffd < 0) {
+        fprintf(stderr, "ERROR: userfaultfd: %s\n", strerror(errno));
+        uffd_region_free(r);
+        return -1;
+    }
+    if (ioctl(r->uffd, UFFDIO_API, &api) != 0) {
+        fprintf(stderr, "ERROR: UFFDIO_API: %s\n", strerror(errno));
+        uffd_region_free(r);
+        return -1;
+    }
+    r->wp = (api.features & UFFD_FEATURE_PAGEFAULT_FLAG_WP) != 0;
+
+    reg.range.start = (uintptr_t)r->base;
+    reg.range.len = r->size;
+    reg.mode = UFFDIO_REGISTER_MODE_MISSING | (r->wp ? UFFDIO_REGISTER_MODE_WP : 0);
+    if (ioctl(r->uffd, UFFDIO_REGISTER, &reg) != 0) {
+        fprintf(stderr, "ERROR: UFFDIO_REGISTER: %s\n", strerror(errno));
+        uffd_region_free(r);
+        return -1;
+    }
+    if (!r->wp) {
+        fprintf(stderr, "WARNING: no uffd write-protect, region pages cannot be evicted\n");
+    }
+    open_idle_tracking(r);
+    return 0;
+}
+
+void uffd_region_free(uffd_region_t* r) {
+    if (r->uffd >= 0) close(r->uffd);
+    if (r->pagemap_fd >= 0) close(r->pagemap_fd);
+    if (r->idle_fd >= 0) close(r->idle_fd);
+    if (r->base) munmap(r->base, r->size);
+    free(r->state);
+    free(r->touched);
+    free(r->bounce);
+    free(r->ids);
+    free(r->srcs);
+    memset(r, 0, sizeof(*r));
+    r->uffd = -1;
+    r->pagemap_fd = -1;
+    r->idle_fd = -1;
+}
+
+void uffd_region_set_trace(uffd_region_t* r, page_trace_t* trace) {
+    r->trace = trace;
+    r->trace_start_ns = now_ns();
+}
+
+static void trace_page(uffd_region_t* r, uint32_t p, uint8_t op) {
+    if (r->trace && page_trace_append(r->trace, now_ns() - r->trace_start_ns,
+                                      r->first_page_id + p, op) != 0) {
+        fprintf(stderr, "WARNING: trace write failed, recording stopped\n");
+        r->trace = NULL;
+    }
+}
+
+static uint8_t* page_addr(const uffd_region_t* r, uint32_t p) {
+    return r->base + (size_t)p * STORE_PAGE_SIZE;
+}
+
+static void wake_page(uffd_region_t* r, uint32_t p) {
+    struct uffdio_range range = {.start = (uintptr_t)page_addr(r, p), .len = STORE_PAGE_SIZE};
+    ioctl(r->uffd, UFFDIO_WAKE, &range);
+}
+
+static int write_protect(uffd_region_t* r, uint32_t p, int protect) {
+    struct uffdio_writeprotect wp;
+    wp.range.start = (uintptr_t)page_addr(r, p);
+    wp.range.len = STORE_PAGE_SIZE;
+    wp.mode = protect ? UFFDIO_WRITEPROTECT_MODE_WP : 0;   /* unprotect also wakes */
+    return ioctl(r->uffd, UFFDIO_WRITEPROTECT, &wp);
+}
+
+/* Map the page back: from the store if it was evicted, zeros otherwise */
+static void serve_missing(uffd_region_t* r, swap_store_t* store, uint32_t p) {
+    uint64_t start = now_ns();
+    int ret;
+
+    if (r->state[p] == REGION_EVICTED) {
+        if (swap_store_get(store, r->first_page_id + p, r->bounce) != 0) {
+            /* The faulting thread cannot be left waiting */
+            memset(r->bounce, 0, STORE_PAGE_SIZE);
+            r->stats.errors++;
+        }
+        struct uffdio_copy copy = {
+            .dst = (uintptr_t)page_addr(r, p),
+            .src = (uintptr_t)r->bounce,
+            .len = STORE_PAGE_SIZE,
+            .mode = 0,
+        };
+        ret = ioctl(r->uffd, UFFDIO_COPY, &copy);
+        r->stats.swapins++;
+    } else {
+        struct uffdio_zeropage zero = {
+            .range = {.start = (uintptr_t)page_addr(r, p), .len = STORE_PAGE_SIZE},
+            .mode = 0,
+        };
+        ret = ioctl(r->uffd, UFFDIO_ZEROPAGE, &zero);
+        r->stats.zero_fills++;
+    }
+    if (ret != 0 && errno == EEXIST) {
+        wake_page(r, p);    /* raced with another fault on the same page */
+    } else if (ret != 0) {
+        fprintf(stderr, "ERROR: resolving fault on page %u: %s\n", p, strerror(errno));
+        r->stats.errors++;
+    }
+
+    if (r->state[p] != REGION_RESIDENT) r->nr_resident++;
+    r->state[p] = REGION_RESIDENT;
+    r->touched[p] = r->tick;
+    r->stats.faults++;
+    r->stats.fault_ns += now_ns() - start;
+}
+
+int uffd_region_handle_faults(uffd_region_t* r, swap_store_t* store) {
+    struct uffd_msg msg;
+    int served = 0;
+
+    while (read(r->uffd, &msg, sizeof(msg)) == (ssize_t)sizeof(msg)) {
+        if (msg.event != UFFD_EVENT_PAGEFAULT) continue;
+
+        uintptr_t addr = (uintptr_t)msg.arg.pagefault.address;
+        uint32_t p = (uint32_t)((addr - (uintptr_t)r->base) / STORE_PAGE_SIZE);
+        if (p >= r->nr_pages) continue;
+
+        if (msg.arg.pagefault.flags & UFFD_PAGEFAULT_FLAG_WP) {
+            /* The eviction that protected the page is over: retry the write */
+            r->stats.wp_faults++;
+            wake_page(r, p);
+            continue;
+        }
+        trace_page(r, p, (msg.arg.pagefault.flags & UFFD_PAGEFAULT_FLAG_WRITE)
+                             ? PAGE_TRACE_WRITE : PAGE_TRACE_READ);
+        serve_missing(r, store, p);
+        served++;
+    }
+    return served;
+}
+
+/* Idle page tracking: returns 1 if the page was not accessed since the last
+ * call, and marks it idle again for the next one */
+static int page_idle(uffd_region_t* r, uint32_t p) {
+    uint64_t entry, word, bit;
+    off_t vpage = (off_t)((uintptr_t)page_addr(r, p) / STORE_PAGE_SIZE);
+
+    if (pread(r->pagemap_fd, &entry, sizeof(entry), vpage * 8) != sizeof(entry) ||
+        !(entry & PAGEMAP_PRESENT) || (entry & PAGEMAP_PFN_MASK) == 0) {
+        return 0;
+    }
+    uint64_t pfn = entry & PAGEMAP_PFN_MASK;
+    off_t off = (off_t)(pfn / 64) * 8;
+    bit = 1ULL << (pfn % 64);
+    if (pread(r->idle_fd, &word, sizeof(word), off) != sizeof(word)) {
+        return 0;
+    }
+    int idle = (word & bit) != 0;
+    word = bit;     /* writes only set bits */
+    if (pwrite(r->idle_fd, &word, sizeof(word), off) != sizeof(word)) {
+        return 0;
+    }
+    return idle;
+}
+
+uint32_t uffd_region_pick_cold(uffd_region_t* r, uint32_t* pages, uint32_t max) {
+    uint32_t n = 0;
+
+    /* At most one turn of the clock per call */
+    for (uint32_t scanned = 0; scanned < r->nr_pages && n < max; scanned++) {
+        uint32_t p = r->hand;
+        r->hand = (r->hand + 1) % r->nr_pages;
+
+        if (r->state[p] != REGION_RESIDENT) continue;
+        if (r->idle_fd >= 0) {
+            if (!page_idle(r, p)) continue;
+        } else if (r->tick - r->touched[p] < REGION_HOT_TICKS) {
+            continue;
+        }
+        pages[n++] = p;
+    }
+    r->tick++;
+    return n;
+}
+
+int uffd_region_evict(uffd_region_t* r, swap_store_t* store,
+                      const uint32_t* pages, uint32_t n) {
+    uint32_t nr_protected = 0;
+    int ret = 0;
+
+    if (!r->wp || n == 0) {
+        return r->wp ? 0 : -1;
+    }
+    if (n > r->batch_cap) {
+        uint64_t* ids = realloc(r->ids, n * sizeof(uint64_t));
+        const uint8_t** srcs = ids ? realloc(r->srcs, n * sizeof(uint8_t*)) : NULL;
+        if (ids) r->ids = ids;
+        if (!ids || !srcs) {
+            fprintf(stderr, "ERROR: Failed to allocate eviction batch\n");
+            return -1;
+        }
+        r->srcs = srcs;
+        r->batch_cap = n;
+    }
+
+    /* Writers block from here until the page is unprotected */
+    for (uint32_t i = 0; i < n; i++) {
+        if (r->state[pages[i]] != REGION_RESIDENT || write_protect(r, pages[i], 1) != 0) {
+            continue;
+        }
+        r->ids[nr_protected] = r->first_page_id + pages[i];
+        r->srcs[nr_protected] = page_addr(r, pages[i]);
+        nr_protected++;
+    }
+
+    if (swap_store_put_batch(store, r->ids, r->srcs, nr_protected) != 0) {
+        r->stats.errors++;
+        ret = -1;
+    }
+    for (uint32_t i = 0; i < nr_protected; i++) {
+        uint32_t p = (uint32_t)(r->ids[i] - r->first_page_id);
+        if (ret == 0) {
+            madvise(page_addr(r, p), STORE_PAGE_SIZE, MADV_DONTNEED);
+            r->state[p] = REGION_EVICTED;
+            r->nr_resident--;
+            trace_page(r, p, PAGE_TRACE_EVICT);
+        }
+        write_protect(r, p, 0);
+    }
+    if (ret == 0) {
+        r->stats.evicted_pages += nr_protected;
+        r->stats.evict_batches++;
+    }
+    return ret;
+}
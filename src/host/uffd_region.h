@@ -0,0 +1,92 @@
+#ifndef __UPMEM_SWAP_UFFD_REGION_H__
+#define __UPMEM_SWAP_UFFD_REGION_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "page_trace.h"
+#include "swap_store.h"
+
+/*
+ * Anonymous memory region backed by the page store through userfaultfd.
+ *
+ * Evicted pages are dropped from memory after a put; touching one again
+ * raises a missing fault that the owner of the region serves from the
+ * store. Pages are write-protected (uffd-wp) while they are copied out,
+ * so a concurrent writer blocks until the eviction is done instead of
+ * losing its write.
+ *
+ * Cold pages are found with idle page tracking when the kernel exposes
+ * it (/sys/kernel/mm/page_idle, needs CAP_SYS_ADMIN); otherwise a page
+ * counts as cold once it has not faulted in for REGION_HOT_TICKS ticks.
+ *
+ * With a trace attached, every missing fault (read or write, from the
+ * fault flags) and every eviction is appended to it, so a service running
+ * on a region can record how it actually swaps (see trace_replay).
+ *
+ * Not thread-safe: one thread serves the faults and evicts.
+ */
+
+#define REGION_ABSENT   0   /* never touched */
+#define REGION_RESIDENT 1
+#define REGION_EVICTED  2   /* in the store */
+
+#define REGION_HOT_TICKS 2
+
+typedef struct {
+    uint64_t faults;            /* missing faults served */
+    uint64_t zero_fills;        /* ... for never-touched pages */
+    uint64_t swapins;           /* ... from the store */
+    uint64_t wp_faults;         /* writes that hit a page being evicted */
+    uint64_t evicted_pages;
+    uint64_t evict_batches;
+    uint64_t fault_ns;          /* time spent serving missing faults */
+    uint64_t errors;
+} uffd_region_stats_t;
+
+typedef struct {
+    uint8_t* base;
+    size_t size;
+    uint32_t nr_pages;
+    uint64_t first_page_id;     /* store id of page 0 */
+
+    uint8_t* state;             /* REGION_* per page */
+    uint32_t* touched;          /* tick of the last fault-in */
+    uint32_t nr_resident;
+    uint32_t hand;              /* clock hand of the cold page scan */
+    uint32_t tick;
+
+    int uffd;
+    int wp;                     /* uffd-wp available: eviction allowed */
+    int pagemap_fd;             /* idle page tracking, -1 if unavailable */
+    int idle_fd;
+
+    uint8_t* bounce;            /* page-aligned source of UFFDIO_COPY */
+    uint64_t* ids;              /* eviction batch */
+    const uint8_t** srcs;
+    uint32_t batch_cap;
+
+    page_trace_t* trace;        /* NULL: not recording */
+    uint64_t trace_start_ns;
+
+    uffd_region_stats_t stats;
+} uffd_region_t;
+
+int uffd_region_init(uffd_region_t* r, size_t size, uint64_t first_page_id);
+void uffd_region_free(uffd_region_t* r);
+
+/* Start (trace != NULL) or stop recording faults and evictions. The
+ * trace stays owned by the caller. */
+void uffd_region_set_trace(uffd_region_t* r, page_trace_t* trace);
+
+/* Serve the pending faults without blocking. Returns the number served. */
+int uffd_region_handle_faults(uffd_region_t* r, swap_store_t* store);
+
+/* Pick up to max cold resident pages (indexes into the region) */
+uint32_t uffd_region_pick_cold(uffd_region_t* r, uint32_t* pages, uint32_t max);
+
+/* Put pages into the store and drop them from memory. Returns 0 or -1. */
+int uffd_region_evict(uffd_region_t* r, swap_store_t* store,
+                      const uint32_t* pages, uint32_t n);
+
+#endif /* __UPMEM_SWAP_UFFD_REGION_H__ */
@@ -0,0 +1,157 @@
+/**
+ * UPMEM Swap - Worker pool
+ *
+ * Used to overlap CPU work (compression, decompression) with HOST<->DPU
+ * transfers. See work_pool.h for the gate/wait model.
+ */
+
+#include "work_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Claim the next runnable item, or return 0. Called with the lock held. */
+static int claim_item(work_pool_t* pool, size_t* item) {
+    if (pool->fn && pool->next < pool->gate) {
+        *item = pool->next++;
+        return 1;
+    }
+    return 0;
+}
+
+/* Run one item outside the lock and publish its completion */
+static void run_item(work_pool_t* pool, size_t item) {
+    work_fn_t fn = pool->fn;
+    void* ctx = pool->ctx;
+
+    pthread_mutex_unlock(&pool->lock);
+    fn(ctx, item);
+    pthread_mutex_lock(&pool->lock);
+
+    pool->done[item] = 1;
+    pool->nr_done++;
+    pthread_cond_broadcast(&pool->done_cv);
+}
+
+static void* worker_main(void* arg) {
+    work_pool_t* pool = arg;
+    size_t item;
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stop) {
+        if (claim_item(pool, &item)) {
+            run_item(pool, item);
+        } else {
+            pthread_cond_wait(&pool->work_cv, &pool->lock);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int work_pool_init(work_pool_t* pool, int nr_threads) {
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cv, NULL);
+    pthread_cond_init(&pool->done_cv, NULL);
+
+    if (nr_threads <= 0) {
+        return 0;
+    }
+
+    pool->threads = malloc(nr_threads * sizeof(pthread_t));
+    if (!pool->threads) {
+        fprintf(stderr, "ERROR: Failed to allocate worker pool\n");
+        return -1;
+    }
+    for (int i = 0; i < nr_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            fprintf(stderr, "ERROR: Failed to start worker %d\n", i);
+            break;
+        }
+        pool->nr_threads++;
+    }
+    return 0;
+}
+
+void work_pool_destroy(work_pool_t* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->nr_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    free(pool->threads);
+    free(pool->done);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cv);
+    pthread_cond_destroy(&pool->done_cv);
+}
+
+int work_pool_start(work_pool_t* pool, work_fn_t fn, void* ctx, size_t n, size_t gate) {
+    pthread_mutex_lock(&pool->lock);
+    if (n > pool->done_cap) {
+        uint8_t* done = realloc(pool->done, n);
+        if (!done) {
+            pthread_mutex_unlock(&pool->lock);
+            fprintf(stderr, "ERROR: Failed to allocate job state (%zu items)\n", n);
+            return -1;
+        }
+        pool->done = done;
+        pool->done_cap = n;
+    }
+    memset(pool->done, 0, n);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->n = n;
+    pool->next = 0;
+    pool->gate = gate < n ? gate : n;
+    pool->nr_done = 0;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void work_pool_open_gate(work_pool_t* pool, size_t gate) {
+    pthread_mutex_lock(&pool->lock);
+    if (gate > pool->n) gate = pool->n;
+    if (gate > pool->gate) {
+        pool->gate = gate;
+        pthread_cond_broadcast(&pool->work_cv);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void work_pool_wait_item(work_pool_t* pool, size_t i) {
+    size_t item;
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->done[i]) {
+        /* Help instead of sleeping when the item is still queued */
+        if (claim_item(pool, &item)) {
+            run_item(pool, item);
+        } else {
+            pthread_cond_wait(&pool->done_cv, &pool->lock);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void work_pool_finish(work_pool_t* pool) {
+    size_t item;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->gate = pool->n;
+    pthread_cond_broadcast(&pool->work_cv);
+    while (pool->nr_done < pool->n) {
+        if (claim_item(pool, &item)) {
+            run_item(pool, item);
+        } else {
+            pthread_cond_wait(&pool->done_cv, &pool->lock);
+        }
+    }
+    pool->fn = NULL;
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,57 @@
+#ifndef __UPMEM_SWAP_WORK_POOL_H__
+#define __UPMEM_SWAP_WORK_POOL_H__
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Fixed pool of worker threads running one job at a time.
+ *
+ * A job is a function applied to items 0..n-1. Items are only handed to
+ * workers once they are below the "gate", which lets a producer (e.g. the
+ * thread reading pages back from MRAM) release items as they arrive while
+ * workers process the earlier ones. The consumer can wait for a single
+ * item to finish (pipelining) or for the whole job.
+ *
+ * With nr_threads == 0 everything runs inline in the calling thread.
+ */
+
+typedef void (*work_fn_t)(void* ctx, size_t item);
+
+typedef struct {
+    pthread_t* threads;
+    int nr_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;   /* workers: new items available */
+    pthread_cond_t done_cv;   /* consumer: an item finished */
+
+    /* Current job */
+    work_fn_t fn;
+    void* ctx;
+    size_t n;
+    size_t next;              /* next item to hand out */
+    size_t gate;              /* items < gate may be processed */
+    uint8_t* done;
+    size_t done_cap;
+    size_t nr_done;
+    int stop;
+} work_pool_t;
+
+int work_pool_init(work_pool_t* pool, int nr_threads);
+void work_pool_destroy(work_pool_t* pool);
+
+/* Start a job over n items, with items < gate immediately runnable */
+int work_pool_start(work_pool_t* pool, work_fn_t fn, void* ctx, size_t n, size_t gate);
+
+/* Allow items < gate to run */
+void work_pool_open_gate(work_pool_t* pool, size_t gate);
+
+/* Block until item i is done (runs it inline if nobody picked it up) */
+void work_pool_wait_item(work_pool_t* pool, size_t i);
+
+/* Block until the whole job is done */
+void work_pool_finish(work_pool_t* pool);
+
+#endif /* __UPMEM_SWAP_WORK_POOL_H__ */
@@ -0,0 +1,95 @@
+/**
+ * UPMEM Swap - Uniform transfer planner
+ *
+ * Packing of ragged per-DPU requests into landing areas, see xfer_plan.h.
+ */
+
+#include "xfer_plan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "swap_protocol.h"
+
+int xfer_plan_init(xfer_plan_t* plan, uint32_t nr_dpus, uint32_t landing_size,
+                   uint32_t max_jobs) {
+    memset(plan, 0, sizeof(*plan));
+    plan->nr_dpus = nr_dpus;
+    plan->landing_size = landing_size;
+    plan->max_jobs = max_jobs;
+    plan->cur_round = calloc(nr_dpus, sizeof(uint32_t));
+    return plan->cur_round ? 0 : -1;
+}
+
+void xfer_plan_free(xfer_plan_t* plan) {
+    free(plan->used);
+    free(plan->jobs);
+    free(plan->cur_round);
+    memset(plan, 0, sizeof(*plan));
+}
+
+/* Make room for rounds 0..round, zeroed */
+static int reserve_rounds(xfer_plan_t* plan, uint32_t round) {
+    uint32_t cap = plan->rounds_cap;
+
+    if (round < cap) return 0;
+    while (cap <= round) cap = cap ? 2 * cap : 4;
+
+    uint32_t* used = realloc(plan->used, (size_t)cap * plan->nr_dpus * sizeof(uint32_t));
+    if (!used) return -1;
+    plan->used = used;
+    uint32_t* jobs = realloc(plan->jobs, (size_t)cap * plan->nr_dpus * sizeof(uint32_t));
+    if (!jobs) return -1;
+    plan->jobs = jobs;
+
+    size_t old = (size_t)plan->rounds_cap * plan->nr_dpus;
+    size_t added = (size_t)(cap - plan->rounds_cap) * plan->nr_dpus;
+    memset(plan->used + old, 0, added * sizeof(uint32_t));
+    memset(plan->jobs + old, 0, added * sizeof(uint32_t));
+    plan->rounds_cap = cap;
+    return 0;
+}
+
+int xfer_plan_build(xfer_plan_t* plan, xfer_req_t* reqs, size_t n) {
+    if (plan->rounds_cap > 0) {
+        size_t cells = (size_t)plan->rounds_cap * plan->nr_dpus;
+        memset(plan->used, 0, cells * sizeof(uint32_t));
+        memset(plan->jobs, 0, cells * sizeof(uint32_t));
+    }
+    memset(plan->cur_round, 0, plan->nr_dpus * sizeof(uint32_t));
+    plan->nr_rounds = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        xfer_req_t* req = &reqs[i];
+        uint32_t size = STORE_ALIGN_UP(req->length);
+
+        if (req->dpu >= plan->nr_dpus || size > plan->landing_size) {
+            return -1;
+        }
+        uint32_t r = plan->cur_round[req->dpu];
+        if (reserve_rounds(plan, r) != 0) return -1;
+        size_t cell = (size_t)r * plan->nr_dpus + req->dpu;
+        if (plan->used[cell] + size > plan->landing_size || plan->jobs[cell] == plan->max_jobs) {
+            r = ++plan->cur_round[req->dpu];
+            if (reserve_rounds(plan, r) != 0) return -1;
+            cell = (size_t)r * plan->nr_dpus + req->dpu;
+        }
+        req->round = r;
+        req->landing = plan->used[cell];
+        plan->used[cell] += size;
+        plan->jobs[cell]++;
+        if (r + 1 > plan->nr_rounds) plan->nr_rounds = r + 1;
+    }
+    return 0;
+}
+
+uint32_t xfer_plan_extent(const xfer_plan_t* plan, uint32_t round, uint32_t first,
+                          uint32_t count) {
+    uint32_t extent = 0;
+
+    for (uint32_t d = first; d < first + count && d < plan->nr_dpus; d++) {
+        uint32_t used = xfer_plan_used(plan, round, d);
+        if (used > extent) extent = used;
+    }
+    return extent;
+}
@@ -0,0 +1,64 @@
+#ifndef __UPMEM_SWAP_XFER_PLAN_H__
+#define __UPMEM_SWAP_XFER_PLAN_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Uniform-shape transfer planning.
+ *
+ * dpu_push_xfer takes one symbol offset and one length for a whole set,
+ * but a swap batch is ragged: each DPU gets a different number of pages,
+ * of different lengths, for slots all over its page_store. The planner
+ * packs the requests of every DPU back to back (8-byte aligned) into a
+ * landing area of landing_size bytes, so one push per set moves all of
+ * them: offset 0, length = the fullest landing area of the set. A DPU
+ * kernel then scatters the records to their slots (or gathers them, for
+ * reads). Requests that do not fit go to the DPU's next round.
+ *
+ * The difference between the push length and what a DPU actually has is
+ * padding: bytes on the bus for nothing.
+ */
+
+typedef struct {
+    uint32_t dpu;
+    uint32_t slot;              /* final MRAM offset in page_store */
+    uint32_t length;            /* record bytes */
+    uint32_t round;             /* out: round the request goes in */
+    uint32_t landing;           /* out: offset in the landing area */
+} xfer_req_t;
+
+typedef struct {
+    uint32_t nr_dpus;
+    uint32_t landing_size;
+    uint32_t max_jobs;          /* requests per DPU per round */
+
+    uint32_t nr_rounds;
+    uint32_t rounds_cap;
+    uint32_t* used;             /* [round * nr_dpus + dpu]: bytes packed */
+    uint32_t* jobs;             /* [round * nr_dpus + dpu]: requests */
+    uint32_t* cur_round;        /* per DPU, while building */
+} xfer_plan_t;
+
+int xfer_plan_init(xfer_plan_t* plan, uint32_t nr_dpus, uint32_t landing_size,
+                   uint32_t max_jobs);
+void xfer_plan_free(xfer_plan_t* plan);
+
+/* Assign a round and a landing offset to every request, in order per DPU.
+ * Returns 0, or -1 on allocation failure or a request larger than the
+ * landing area. */
+int xfer_plan_build(xfer_plan_t* plan, xfer_req_t* reqs, size_t n);
+
+static inline uint32_t xfer_plan_used(const xfer_plan_t* plan, uint32_t round, uint32_t dpu) {
+    return plan->used[(size_t)round * plan->nr_dpus + dpu];
+}
+
+static inline uint32_t xfer_plan_jobs(const xfer_plan_t* plan, uint32_t round, uint32_t dpu) {
+    return plan->jobs[(size_t)round * plan->nr_dpus + dpu];
+}
+
+/* Push length of one round over DPUs first..first+count-1 (0: nothing to move) */
+uint32_t xfer_plan_extent(const xfer_plan_t* plan, uint32_t round, uint32_t first,
+                          uint32_t count);
+
+#endif /* __UPMEM_SWAP_XFER_PLAN_H__ */